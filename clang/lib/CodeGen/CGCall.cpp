@@ -3360,6 +3360,12 @@ RValue CodeGenFunction::EmitCall(const CGFunctionInfo &CallInfo,
   if (callOrInvoke)
     *callOrInvoke = CS.getInstruction();
 
+  // Profile the targets of indirect calls.
+  if (!isa<llvm::Function>(Callee->stripPointerCasts()) &&
+      !isa<llvm::InlineAsm>(Callee))
+    PGO.valueProfile(Builder, llvm::IPVK_IndirectCallTarget,
+                     CS.getInstruction(), Callee);
+
   if (CurCodeDecl && CurCodeDecl->hasAttr<FlattenAttr>() &&
       !CS.hasFnAttr(llvm::Attribute::NoInline))
     Attrs =
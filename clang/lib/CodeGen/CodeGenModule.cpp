@@ -352,6 +352,11 @@ void CodeGenModule::Release() {
       AddGlobalCtor(ObjCInitFunction);
   if (PGOReader && PGOStats.hasDiagnostics())
     PGOStats.reportDiagnostics(getDiags(), getCodeGenOpts().MainFileName);
+  if (PGOReader)
+    // The backend compares the entry counts of the functions to this one to
+    // place the hot and cold functions.
+    getModule().setMaximumFunctionCount(
+        PGOReader->getMaximumFunctionCount());
   EmitCtorList(GlobalCtors, "llvm.global_ctors");
   EmitCtorList(GlobalDtors, "llvm.global_dtors");
   EmitGlobalAnnotations();
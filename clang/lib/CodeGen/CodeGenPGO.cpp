@@ -19,10 +19,16 @@
 #include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/MDBuilder.h"
 #include "llvm/ProfileData/InstrProfReader.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MD5.h"
 
+static llvm::cl::opt<bool> EnableValueProfiling(
+    "enable-value-profiling", llvm::cl::ZeroOrMore,
+    llvm::cl::desc("Profile the targets of indirect calls"),
+    llvm::cl::init(true));
+
 using namespace clang;
 using namespace CodeGen;
 
@@ -677,6 +683,7 @@ void CodeGenPGO::assignRegionCounters(const Decl *D, llvm::Function *Fn) {
     return;
   CGM.ClearUnusedCoverageMapping(D);
   setFuncName(Fn);
+  std::fill(std::begin(NumValueSites), std::end(NumValueSites), 0);
 
   mapRegionCounters(D);
   if (CGM.getCodeGenOpts().CoverageMapping)
@@ -775,6 +782,7 @@ CodeGenPGO::applyFunctionAttributes(llvm::IndexedInstrProfReader *PGOReader,
 
   uint64_t MaxFunctionCount = PGOReader->getMaximumFunctionCount();
   uint64_t FunctionCount = getRegionCount(0);
+  Fn->setEntryCount(FunctionCount);
   if (FunctionCount >= (uint64_t)(0.3 * (double)MaxFunctionCount))
     // Turn on InlineHint attribute for hot functions.
     // FIXME: 30% is from preliminary tuning on SPEC, it may not be optimal.
@@ -798,12 +806,48 @@ void CodeGenPGO::emitCounterIncrement(CGBuilderTy &Builder, unsigned Counter) {
                       Builder.getInt32(Counter));
 }
 
+void CodeGenPGO::valueProfile(CGBuilderTy &Builder,
+                              llvm::InstrProfValueKind ValueKind,
+                              llvm::Instruction *ValueSite,
+                              llvm::Value *ValuePtr) {
+  if (!EnableValueProfiling || !ValueSite || !ValuePtr)
+    return;
+
+  if (CGM.getCodeGenOpts().ProfileInstrGenerate) {
+    if (!RegionCounterMap)
+      return;
+    // Count the value just before the site.
+    CGBuilderTy::InsertPointGuard Guard(Builder);
+    Builder.SetInsertPoint(ValueSite);
+    auto *I8PtrTy = llvm::Type::getInt8PtrTy(CGM.getLLVMContext());
+    llvm::Value *Args[] = {
+        llvm::ConstantExpr::getBitCast(FuncNameVar, I8PtrTy),
+        Builder.getInt64(FunctionHash),
+        Builder.CreatePtrToInt(ValuePtr, Builder.getInt64Ty()),
+        Builder.getInt32(ValueKind),
+        Builder.getInt32(NumValueSites[ValueKind]++)};
+    Builder.CreateCall(
+        CGM.getIntrinsic(llvm::Intrinsic::instrprof_value_profile), Args);
+    return;
+  }
+
+  if (!ProfRecord || !haveRegionCounts())
+    return;
+  unsigned Index = NumValueSites[ValueKind]++;
+  // A site count mismatch is caught by the reader, but be safe.
+  if (Index >= ProfRecord->getNumValueSites(ValueKind))
+    return;
+  llvm::annotateValueSite(*ValueSite, ProfRecord->ValueSites[ValueKind][Index],
+                          ValueKind);
+}
+
 void CodeGenPGO::loadRegionCounts(llvm::IndexedInstrProfReader *PGOReader,
                                   bool IsInMainFile) {
   CGM.getPGOStats().addVisited(IsInMainFile);
   RegionCounts.clear();
+  ProfRecord.reset(new llvm::InstrProfRecord());
   if (std::error_code EC =
-          PGOReader->getFunctionCounts(FuncName, FunctionHash, RegionCounts)) {
+          PGOReader->getFunctionRecord(FuncName, FunctionHash, *ProfRecord)) {
     if (EC == llvm::instrprof_error::unknown_function)
       CGM.getPGOStats().addMissing(IsInMainFile);
     else if (EC == llvm::instrprof_error::hash_mismatch)
@@ -811,8 +855,10 @@ void CodeGenPGO::loadRegionCounts(llvm::IndexedInstrProfReader *PGOReader,
     else if (EC == llvm::instrprof_error::malformed)
       // TODO: Consider a more specific warning for this case.
       CGM.getPGOStats().addMismatched(IsInMainFile);
-    RegionCounts.clear();
+    ProfRecord.reset();
+    return;
   }
+  RegionCounts = ProfRecord->Counts;
 }
 
 /// \brief Calculate what to divide by to scale weights.
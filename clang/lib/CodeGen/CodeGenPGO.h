@@ -19,6 +19,8 @@
 #include "CodeGenTypes.h"
 #include "clang/Frontend/CodeGenOptions.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/ProfileData/InstrProf.h"
+#include "llvm/ProfileData/InstrProfReader.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include <memory>
 
@@ -39,6 +41,10 @@ private:
   std::unique_ptr<llvm::DenseMap<const Stmt *, unsigned>> RegionCounterMap;
   std::unique_ptr<llvm::DenseMap<const Stmt *, uint64_t>> StmtCountMap;
   std::vector<uint64_t> RegionCounts;
+  /// The profile of the function, with its value sites.
+  std::unique_ptr<llvm::InstrProfRecord> ProfRecord;
+  /// The number of value sites of each kind emitted so far.
+  unsigned NumValueSites[llvm::IPVK_Last + 1];
   uint64_t CurrentRegionCount;
   /// \brief A flag that is set to true when this function doesn't need
   /// to have coverage mapping data.
@@ -47,7 +53,9 @@ private:
 public:
   CodeGenPGO(CodeGenModule &CGM)
       : CGM(CGM), NumRegionCounters(0), FunctionHash(0), CurrentRegionCount(0),
-        SkipCoverageMapping(false) {}
+        SkipCoverageMapping(false) {
+    std::fill(std::begin(NumValueSites), std::end(NumValueSites), 0);
+  }
 
   /// Whether or not we have PGO region data for the current function. This is
   /// false both when we have no data at all and when our data has been
@@ -100,6 +108,12 @@ public:
   /// generates global variables or associates PGO data with each of the
   /// counters depending on whether we are generating or using instrumentation.
   void assignRegionCounters(const Decl *D, llvm::Function *Fn);
+  /// Profile the values of the next value site of kind \p ValueKind, at
+  /// \p ValueSite.  When generating instrumentation, this counts the values of
+  /// \p ValuePtr at run time; when using a profile, this attaches the values
+  /// seen to \p ValueSite.
+  void valueProfile(CGBuilderTy &Builder, llvm::InstrProfValueKind ValueKind,
+                    llvm::Instruction *ValueSite, llvm::Value *ValuePtr);
   /// Emit a coverage mapping range with a counter zero
   /// for an unused declaration.
   void emitEmptyCounterMapping(const Decl *D, StringRef FuncName,
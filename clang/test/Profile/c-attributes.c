@@ -5,13 +5,13 @@
 
 extern int atoi(const char *);
 
-// CHECK: hot_100_percent(i32{{.*}}%i) [[HOT:#[0-9]+]]
+// CHECK: hot_100_percent(i32{{.*}}%i) [[HOT100:#[0-9]+]]
 void hot_100_percent(int i) {
   while (i > 0)
     i--;
 }
 
-// CHECK: hot_40_percent(i32{{.*}}%i) [[HOT]]
+// CHECK: hot_40_percent(i32{{.*}}%i) [[HOT40:#[0-9]+]]
 void hot_40_percent(int i) {
   while (i > 0)
     i--;
@@ -29,9 +29,11 @@ void cold_func(int i) {
     i--;
 }
 
-// CHECK: attributes [[HOT]] = { inlinehint nounwind {{.*}} }
-// CHECK: attributes [[NORMAL]] = { nounwind {{.*}} }
-// CHECK: attributes [[COLD]] = { cold nounwind {{.*}} }
+// CHECK: attributes [[HOT100]] = { inlinehint nounwind {{.*}}"function-entry-count"="100000"{{.*}} }
+// CHECK: attributes [[HOT40]] = { inlinehint nounwind {{.*}}"function-entry-count"="40000"{{.*}} }
+// CHECK: attributes [[NORMAL]] = { nounwind {{.*}}"function-entry-count"="20000"{{.*}} }
+// CHECK: attributes [[COLD]] = { cold nounwind {{.*}}"function-entry-count"="500"{{.*}} }
+// CHECK: !{i32 2, !"MaxFunctionCount", i64 100000}
 
 int main(int argc, const char *argv[]) {
   int max = atoi(argv[1]);
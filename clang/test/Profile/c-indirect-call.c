@@ -0,0 +1,32 @@
+// Check the value profiling of indirect calls.
+
+// RUN: %clang_cc1 -triple x86_64-apple-macosx10.9 -main-file-name c-indirect-call.c %s -o - -emit-llvm -fprofile-instr-generate | FileCheck -check-prefix=PGOGEN %s
+
+// RUN: llvm-profdata merge %S/Inputs/c-indirect-call.proftext -o %t.profdata
+// RUN: %clang_cc1 -triple x86_64-apple-macosx10.9 -main-file-name c-indirect-call.c %s -o - -emit-llvm -fprofile-instr-use=%t.profdata | FileCheck -check-prefix=PGOUSE %s
+
+void target1(void) {}
+void target2(void) {}
+void (*foo)(void);
+
+// PGOGEN-LABEL: @main
+// PGOUSE-LABEL: @main
+int main(void) {
+  // PGOGEN: [[FOO:%[0-9]+]] = load void ()*, void ()** @foo
+  // PGOGEN-NEXT: [[VALUE:%[0-9]+]] = ptrtoint void ()* [[FOO]] to i64
+  // PGOGEN-NEXT: call void @llvm.instrprof.value.profile(i8* getelementptr inbounds ([4 x i8], [4 x i8]* @__llvm_profile_name_main, i32 0, i32 0), i64 0, i64 [[VALUE]], i32 0, i32 0)
+  // PGOGEN-NEXT: call void [[FOO]]()
+  // PGOUSE: call void {{%[0-9]+}}(), !prof [[VP:![0-9]+]]
+  foo();
+  // Direct calls are not profiled.
+  // PGOGEN-NOT: @llvm.instrprof.value.profile
+  // PGOGEN: call void @target1()
+  // PGOUSE: call void @target1()
+  // PGOUSE-NOT: !prof
+  target1();
+  return 0;
+}
+
+// PGOGEN: declare void @llvm.instrprof.value.profile(i8*, i64, i64, i32, i32)
+
+// PGOUSE: [[VP]] = !{!"VP", i32 0, i64 1500, i64 {{-?[0-9]+}}, i64 1000, i64 {{-?[0-9]+}}, i64 500}
@@ -8,6 +8,7 @@
 \*===----------------------------------------------------------------------===*/
 
 #include "InstrProfiling.h"
+#include "InstrProfilingInternal.h"
 #include <string.h>
 
 __attribute__((visibility("hidden")))
@@ -36,13 +37,72 @@ uint64_t __llvm_profile_get_magic(void) {
 __attribute__((visibility("hidden")))
 uint64_t __llvm_profile_get_version(void) {
   /* This should be bumped any time the output format changes. */
-  return 1;
+  return 2;
+}
+
+__attribute__((visibility("hidden")))
+uint32_t __llvm_profile_get_num_value_sites(const __llvm_profile_data *Data) {
+  uint32_t NumSites = 0, Kind;
+  if (!Data->Values)
+    return 0;
+  for (Kind = 0; Kind < PROFILE_NUM_VALUE_KINDS; ++Kind)
+    NumSites += Data->NumValueSites[Kind];
+  return NumSites;
 }
 
 __attribute__((visibility("hidden")))
 void __llvm_profile_reset_counters(void) {
   uint64_t *I = __llvm_profile_begin_counters();
   uint64_t *E = __llvm_profile_end_counters();
+  const __llvm_profile_data *DataBegin = __llvm_profile_begin_data();
+  const __llvm_profile_data *DataEnd = __llvm_profile_end_data();
+  const __llvm_profile_data *Data;
 
   memset(I, 0, sizeof(uint64_t)*(E - I));
+
+  for (Data = DataBegin; Data != DataEnd; ++Data) {
+    uint32_t NumSites = __llvm_profile_get_num_value_sites(Data), S;
+    for (S = 0; S < NumSites; ++S) {
+      __llvm_profile_value_node *Node;
+      for (Node = Data->Values[S]; Node; Node = Node->Next)
+        Node->Count = 0;
+    }
+  }
+}
+
+__attribute__((visibility("hidden")))
+uint64_t __llvm_profile_get_value_data_size(
+    const __llvm_profile_data *DataBegin, const __llvm_profile_data *DataEnd) {
+  uint64_t NumWords = 0;
+  const __llvm_profile_data *Data;
+  for (Data = DataBegin; Data != DataEnd; ++Data) {
+    uint32_t NumSites = __llvm_profile_get_num_value_sites(Data), S;
+    for (S = 0; S < NumSites; ++S) {
+      __llvm_profile_value_node *Node;
+      ++NumWords;
+      for (Node = Data->Values[S]; Node; Node = Node->Next)
+        NumWords += 2;
+    }
+  }
+  return NumWords * sizeof(uint64_t);
+}
+
+__attribute__((visibility("hidden")))
+void __llvm_profile_write_value_data(uint64_t *Buffer,
+                                     const __llvm_profile_data *DataBegin,
+                                     const __llvm_profile_data *DataEnd) {
+  const __llvm_profile_data *Data;
+  for (Data = DataBegin; Data != DataEnd; ++Data) {
+    uint32_t NumSites = __llvm_profile_get_num_value_sites(Data), S;
+    for (S = 0; S < NumSites; ++S) {
+      __llvm_profile_value_node *Node;
+      uint64_t *NumValues = Buffer++;
+      *NumValues = 0;
+      for (Node = Data->Values[S]; Node; Node = Node->Next) {
+        *Buffer++ = Node->Value;
+        *Buffer++ = Node->Count;
+        ++*NumValues;
+      }
+    }
+  }
 }
@@ -27,7 +27,25 @@ typedef uint32_t uintptr_t;
 
 #endif /* defined(__FreeBSD__) && defined(__i386__) */
 
-#define PROFILE_HEADER_SIZE 7
+#define PROFILE_HEADER_SIZE 8
+
+/* The kinds of values profiled, see InstrProfValueKind in LLVM. */
+#define PROFILE_NUM_VALUE_KINDS 2
+
+/* The most values recorded at a value site.  Later values are not counted. */
+#define PROFILE_MAX_NUM_VALUES_PER_SITE 8
+
+/*!
+ * \brief A value seen at a value site, and how often.
+ *
+ * The values of a site are kept in a list, appended to as new values are
+ * seen.
+ */
+typedef struct __llvm_profile_value_node {
+  uint64_t Value;
+  uint64_t Count;
+  struct __llvm_profile_value_node *Next;
+} __llvm_profile_value_node;
 
 typedef struct __llvm_profile_data {
   const uint32_t NameSize;
@@ -35,6 +53,9 @@ typedef struct __llvm_profile_data {
   const uint64_t FuncHash;
   const char *const Name;
   uint64_t *const Counters;
+  const void *const FunctionPointer;
+  __llvm_profile_value_node **const Values;
+  const uint16_t NumValueSites[PROFILE_NUM_VALUE_KINDS];
 } __llvm_profile_data;
 
 /*!
@@ -57,6 +78,16 @@ const char *__llvm_profile_end_names(void);
 uint64_t *__llvm_profile_begin_counters(void);
 uint64_t *__llvm_profile_end_counters(void);
 
+/*!
+ * \brief Count the value \c TargetValue at the value site \c CounterIndex of
+ * the function of \c Data.
+ *
+ * The sites of all the kinds of values of a function are numbered together,
+ * in the order of the kinds.
+ */
+void __llvm_profile_instrument_target(uint64_t TargetValue, void *Data,
+                                      uint32_t CounterIndex);
+
 /*!
  * \brief Write instrumentation data to the current file.
  *
@@ -39,7 +39,8 @@ uint64_t __llvm_profile_get_size_for_buffer_internal(
   return sizeof(uint64_t) * PROFILE_HEADER_SIZE +
       PROFILE_RANGE_SIZE(Data) * sizeof(__llvm_profile_data) +
       PROFILE_RANGE_SIZE(Counters) * sizeof(uint64_t) +
-      NamesSize + Padding;
+      NamesSize + Padding +
+      __llvm_profile_get_value_data_size(DataBegin, DataEnd);
 }
 
 __attribute__((visibility("hidden")))
@@ -73,6 +74,8 @@ int __llvm_profile_write_buffer_internal(
   const uint64_t CountersSize = CountersEnd - CountersBegin;
   const uint64_t NamesSize = NamesEnd - NamesBegin;
   const uint64_t Padding = sizeof(uint64_t) - NamesSize % sizeof(uint64_t);
+  const uint64_t ValueDataSize =
+      __llvm_profile_get_value_data_size(DataBegin, DataEnd);
 
   /* Enough zeroes for padding. */
   const char Zeroes[sizeof(uint64_t)] = {0};
@@ -86,6 +89,7 @@ int __llvm_profile_write_buffer_internal(
   Header[4] = NamesSize;
   Header[5] = (uintptr_t)CountersBegin;
   Header[6] = (uintptr_t)NamesBegin;
+  Header[7] = ValueDataSize;
 
   /* Write the data. */
 #define UPDATE_memcpy(Data, Size) \
@@ -100,5 +104,8 @@ int __llvm_profile_write_buffer_internal(
   UPDATE_memcpy(Zeroes,        Padding       * sizeof(char));
 #undef UPDATE_memcpy
 
+  /* The value data follows, as 64-bit words. */
+  __llvm_profile_write_value_data((uint64_t *)Buffer, DataBegin, DataEnd);
+
   return 0;
 }
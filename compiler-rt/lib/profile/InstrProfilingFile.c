@@ -8,6 +8,7 @@
 \*===----------------------------------------------------------------------===*/
 
 #include "InstrProfiling.h"
+#include "InstrProfilingInternal.h"
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -29,10 +30,21 @@ static int writeFile(FILE *File) {
   const uint64_t CountersSize = CountersEnd - CountersBegin;
   const uint64_t NamesSize = NamesEnd - NamesBegin;
   const uint64_t Padding = sizeof(uint64_t) - NamesSize % sizeof(uint64_t);
+  const uint64_t ValueDataSize =
+      __llvm_profile_get_value_data_size(DataBegin, DataEnd);
+  uint64_t *ValueData = NULL;
 
   /* Enough zeroes for padding. */
   const char Zeroes[sizeof(uint64_t)] = {0};
 
+  /* Gather the value data before writing anything. */
+  if (ValueDataSize) {
+    ValueData = (uint64_t *)malloc(ValueDataSize);
+    if (!ValueData)
+      return -1;
+    __llvm_profile_write_value_data(ValueData, DataBegin, DataEnd);
+  }
+
   /* Create the header. */
   uint64_t Header[PROFILE_HEADER_SIZE];
   Header[0] = __llvm_profile_get_magic();
@@ -42,18 +54,25 @@ static int writeFile(FILE *File) {
   Header[4] = NamesSize;
   Header[5] = (uintptr_t)CountersBegin;
   Header[6] = (uintptr_t)NamesBegin;
+  Header[7] = ValueDataSize;
 
   /* Write the data. */
 #define CHECK_fwrite(Data, Size, Length, File) \
-  do { if (fwrite(Data, Size, Length, File) != Length) return -1; } while (0)
+  do { if (fwrite(Data, Size, Length, File) != Length) goto Fail; } while (0)
   CHECK_fwrite(Header,        sizeof(uint64_t), PROFILE_HEADER_SIZE, File);
   CHECK_fwrite(DataBegin,     sizeof(__llvm_profile_data), DataSize, File);
   CHECK_fwrite(CountersBegin, sizeof(uint64_t), CountersSize, File);
   CHECK_fwrite(NamesBegin,    sizeof(char), NamesSize, File);
   CHECK_fwrite(Zeroes,        sizeof(char), Padding, File);
+  CHECK_fwrite(ValueData,     sizeof(char), ValueDataSize, File);
 #undef CHECK_fwrite
 
+  free(ValueData);
   return 0;
+
+Fail:
+  free(ValueData);
+  return -1;
 }
 
 static int writeFileWithName(const char *OutputName) {
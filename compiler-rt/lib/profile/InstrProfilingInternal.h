@@ -37,4 +37,31 @@ int __llvm_profile_write_buffer_internal(
     const __llvm_profile_data *DataEnd, const uint64_t *CountersBegin,
     const uint64_t *CountersEnd, const char *NamesBegin, const char *NamesEnd);
 
+/*!
+ * \brief Get the number of value sites of all kinds of the function of
+ * \c Data.
+ */
+uint32_t __llvm_profile_get_num_value_sites(const __llvm_profile_data *Data);
+
+/*!
+ * \brief Get the size in bytes of the value profile data of the functions
+ * in [\c DataBegin, \c DataEnd).
+ */
+uint64_t __llvm_profile_get_value_data_size(
+    const __llvm_profile_data *DataBegin, const __llvm_profile_data *DataEnd);
+
+/*!
+ * \brief Write the value profile data of the functions in [\c DataBegin,
+ * \c DataEnd) to \c Buffer.
+ *
+ * For each function with value sites, and for each of its sites, the data is
+ * the number of values followed by the pairs of value and count.
+ *
+ * \pre \c Buffer is at least as big as \a
+ * __llvm_profile_get_value_data_size().
+ */
+void __llvm_profile_write_value_data(uint64_t *Buffer,
+                                     const __llvm_profile_data *DataBegin,
+                                     const __llvm_profile_data *DataEnd);
+
 #endif
@@ -0,0 +1,49 @@
+/*===- InstrProfilingValue.c - Support library for value profiling -------===*\
+|*
+|*                     The LLVM Compiler Infrastructure
+|*
+|* This file is distributed under the University of Illinois Open Source
+|* License. See LICENSE.TXT for details.
+|*
+\*===----------------------------------------------------------------------===*/
+
+#include "InstrProfiling.h"
+#include <stdlib.h>
+
+/* Walk the list of the values of a site, and count TargetValue in it.  The
+ * nodes are only ever appended, so readers and other writers see a
+ * consistent list; counts may be lost to races, like the counters.
+ */
+__attribute__((visibility("hidden")))
+void __llvm_profile_instrument_target(uint64_t TargetValue, void *Data,
+                                      uint32_t CounterIndex) {
+  __llvm_profile_data *PData = (__llvm_profile_data *)Data;
+  __llvm_profile_value_node **Next;
+  __llvm_profile_value_node *NewNode;
+  uint32_t NumValues = 0;
+
+  if (!PData || !PData->Values)
+    return;
+
+  for (Next = &PData->Values[CounterIndex]; *Next; Next = &(*Next)->Next) {
+    if ((*Next)->Value == TargetValue) {
+      ++(*Next)->Count;
+      return;
+    }
+    ++NumValues;
+  }
+  if (NumValues >= PROFILE_MAX_NUM_VALUES_PER_SITE)
+    return;
+
+  NewNode = (__llvm_profile_value_node *)calloc(1, sizeof(*NewNode));
+  if (!NewNode)
+    return;
+  NewNode->Value = TargetValue;
+  NewNode->Count = 1;
+
+  /* Another thread may have appended a node meanwhile; keep going to the end
+   * of the list.  The value may then appear twice, which the reader merges.
+   */
+  while (!__sync_bool_compare_and_swap(Next, 0, NewNode))
+    Next = &(*Next)->Next;
+}
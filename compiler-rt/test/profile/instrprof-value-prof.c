@@ -0,0 +1,22 @@
+// RUN: %clang_profgen -O2 -o %t %s
+// RUN: env LLVM_PROFILE_FILE=%t.profraw %run %t
+// RUN: llvm-profdata merge -o %t.profdata %t.profraw
+// RUN: llvm-profdata show -ic-targets -function=main %t.profdata | FileCheck %s
+
+void callee1(void) {}
+void callee2(void) {}
+
+void (*volatile Targets[2])(void) = {callee1, callee2};
+
+int main(int argc, const char *argv[]) {
+  int I;
+  for (I = 0; I < 10; ++I)
+    Targets[I % 5 == 0]();
+  return 0;
+}
+
+// CHECK: Indirect Call Site Count: 1
+// CHECK: Indirect Target Results:
+// CHECK-NEXT: [ 0, callee1, 8 ]
+// CHECK-NEXT: [ 0, callee2, 2 ]
+// CHECK: Total number of indirect call sites: 1
@@ -40,7 +40,7 @@ typedef bool lto_bool_t;
  * @{
  */
 
-#define LTO_API_VERSION 13
+#define LTO_API_VERSION 15
 
 /**
  * \since prior to LTO_API_VERSION=3
@@ -523,6 +523,69 @@ lto_codegen_optimize(lto_code_gen_t cg);
 extern const void*
 lto_codegen_compile_optimized(lto_code_gen_t cg, size_t* length);
 
+/**
+ * Generates code for the optimized merged module into parallelism native
+ * object files. The module is split into parallelism partitions which are
+ * code generated on separate threads. It will not run any IR optimizations on
+ * the merged module. For a given value of parallelism the generated code is
+ * always the same.
+ *
+ * The names of the files are written to an array of parallelism elements
+ * pointed to by names; all of the files must be linked. The array is owned by
+ * the lto_code_gen_t and will be freed when lto_codegen_dispose() is called.
+ * The merged module cannot be compiled again after a call with parallelism
+ * greater than 1. Returns true on error.
+ *
+ * \since LTO_API_VERSION=14
+ */
+extern lto_bool_t
+lto_codegen_compile_optimized_to_files(lto_code_gen_t cg, unsigned parallelism,
+                                       const char ***names);
+
+/**
+ * Sets the directory in which lto_codegen_compile(),
+ * lto_codegen_compile_to_file() and lto_codegen_compile_optimized_to_files()
+ * cache the object files they generate. The files are keyed by a hash of the
+ * merged module, of the target and of the code generation options, so that
+ * relinking unchanged inputs reuses the object files of the previous link.
+ * A NULL or empty path disables the cache, which is the default.
+ *
+ * \since LTO_API_VERSION=15
+ */
+extern void
+lto_codegen_set_cache_dir(lto_code_gen_t cg, const char *cache_dir);
+
+/**
+ * Sets the minimum interval, in seconds, between two prunings of the cache
+ * directory. A value of 0 prunes the cache after every link. The default is
+ * 1200 seconds.
+ *
+ * \since LTO_API_VERSION=15
+ */
+extern void
+lto_codegen_set_cache_pruning_interval(lto_code_gen_t cg, int interval);
+
+/**
+ * Sets the time, in seconds, after which an unused object file is removed
+ * from the cache. A value of 0 disables the expiration. The default is one
+ * week.
+ *
+ * \since LTO_API_VERSION=15
+ */
+extern void
+lto_codegen_set_cache_entry_expiration(lto_code_gen_t cg, unsigned expiration);
+
+/**
+ * Sets the maximum size of the cache directory, in bytes. When the cache
+ * grows larger, the least recently used object files are removed. A value of
+ * 0, the default, does not limit the size of the cache.
+ *
+ * \since LTO_API_VERSION=15
+ */
+extern void
+lto_codegen_set_cache_size_bytes(lto_code_gen_t cg,
+                                 unsigned long long max_size_bytes);
+
 /**
  * Returns the runtime API version.
  *
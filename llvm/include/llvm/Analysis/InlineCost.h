@@ -23,6 +23,7 @@ class AssumptionCacheTracker;
 class CallSite;
 class DataLayout;
 class Function;
+class TargetTransformInfo;
 class TargetTransformInfoWrapperPass;
 
 namespace InlineConstants {
@@ -98,6 +99,23 @@ public:
   int getCostDelta() const { return Threshold - getCost(); }
 };
 
+/// \brief Get an InlineCost object representing the cost of inlining the call
+/// site \p CS to \p Callee.
+///
+/// This is the analysis behind InlineCostAnalysis, for the passes that are not
+/// call graph SCC passes: \p CalleeTTI is the TargetTransformInfo of the
+/// callee.  Like InlineCostAnalysis::getInlineCost, it is an expensive call.
+InlineCost getInlineCost(CallSite CS, Function *Callee, int Threshold,
+                         const TargetTransformInfo &CalleeTTI,
+                         AssumptionCacheTracker *ACT);
+
+/// \brief Minimal filter to detect invalid constructs for inlining.
+bool isInlineViable(Function &Callee);
+
+/// \brief Return the default inlining threshold of the optimization level
+/// \p OptLevel and the size optimization level \p SizeOptLevel.
+int computeThresholdFromOptLevels(unsigned OptLevel, unsigned SizeOptLevel);
+
 /// \brief Cost analyzer used by inliner.
 class InlineCostAnalysis : public CallGraphSCCPass {
   TargetTransformInfoWrapperPass *TTIWP;
@@ -0,0 +1,446 @@
+//===- llvm/Analysis/MemorySSA.h - SSA form for memory ----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file exposes an interface to building and using memory SSA to walk
+// memory instructions using a use/def graph.
+//
+// Memory SSA gives every instruction that touches memory a MemoryAccess and
+// links them into an SSA form of their own, built once per function:
+//
+//  - A MemoryDef stands for an instruction that may write memory (a store, a
+//    call that is not readonly, a fence, ...).  It creates a new version of
+//    all of memory, and uses the previous version.
+//  - A MemoryUse stands for an instruction that only reads memory.  It uses
+//    the version of memory it reads.
+//  - A MemoryPhi merges the versions of memory reaching a join point of the
+//    CFG, like a PHINode does for registers.
+//
+// All of memory is treated as a single variable, so a MemoryUse or MemoryDef
+// is linked to the closest preceding MemoryDef or MemoryPhi, whether or not it
+// may alias.  Finding the write that actually clobbers a location is the job
+// of a MemorySSAWalker, which skips the writes that do not alias it, and
+// caches its answers so that repeated queries are cheap.  A special MemoryDef,
+// liveOnEntry, stands for the state of memory on entry to the function.
+//
+// Unlike MemoryDependenceAnalysis, memory SSA is not recomputed lazily on each
+// query: transforms that change memory instructions keep it up to date with
+// removeMemoryAccess and createMemoryAccess*.
+//
+// For example, given:
+//
+//   define i32 @main() {
+//   entry:
+//     %call = call noalias i8* @_Znwm(i64 4)
+//     %0 = bitcast i8* %call to i32*
+//     store i32 0, i32* %0, align 4
+//     %1 = load i32, i32* %0, align 4
+//     ret i32 %1
+//   }
+//
+// opt -basicaa -memoryssa -analyze prints:
+//
+//   define i32 @main() {
+//   entry:
+//   ; 1 = MemoryDef(liveOnEntry)
+//     %call = call noalias i8* @_Znwm(i64 4)
+//     %0 = bitcast i8* %call to i32*
+//   ; 2 = MemoryDef(1)
+//     store i32 0, i32* %0, align 4
+//   ; MemoryUse(2)
+//     %1 = load i32, i32* %0, align 4
+//     ret i32 %1
+//   }
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_MEMORYSSA_H
+#define LLVM_ANALYSIS_MEMORYSSA_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/ilist.h"
+#include "llvm/ADT/ilist_node.h"
+#include "llvm/ADT/iterator_range.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Pass.h"
+#include <memory>
+#include <utility>
+
+namespace llvm {
+
+class BasicBlock;
+class DominatorTree;
+class Function;
+class Instruction;
+class MemorySSA;
+class MemorySSAWalker;
+class raw_ostream;
+
+/// MemoryAccess - The base class of the memory accesses of memory SSA.
+class MemoryAccess : public ilist_node<MemoryAccess> {
+public:
+  enum MemoryAccessKind { MemoryUseKind, MemoryDefKind, MemoryPhiKind };
+
+  virtual ~MemoryAccess() {}
+
+  MemoryAccessKind getKind() const { return Kind; }
+
+  /// getBlock - Return the block the access lives in.
+  BasicBlock *getBlock() const { return Block; }
+
+  typedef SmallPtrSetImpl<MemoryAccess *>::const_iterator user_iterator;
+
+  /// users - The MemoryUses, MemoryDefs and MemoryPhis using this access, in
+  /// no particular order.
+  iterator_range<user_iterator> users() const {
+    return iterator_range<user_iterator>(Users.begin(), Users.end());
+  }
+  bool hasUsers() const { return !Users.empty(); }
+  unsigned getNumUsers() const { return Users.size(); }
+
+  void print(raw_ostream &OS) const;
+  void dump() const;
+
+protected:
+  MemoryAccess(MemoryAccessKind Kind, BasicBlock *BB) : Kind(Kind), Block(BB) {}
+
+  void addUser(MemoryAccess *User) { Users.insert(User); }
+  void removeUser(MemoryAccess *User) { Users.erase(User); }
+
+private:
+  friend class MemorySSA;
+  friend class MemoryUseOrDef;
+  friend class MemoryPhi;
+  friend struct ilist_sentinel_traits<MemoryAccess>;
+
+  /// Only used to create the sentinel of the access lists.
+  MemoryAccess() : Kind(MemoryDefKind), Block(nullptr) {}
+  MemoryAccess(const MemoryAccess &) = delete;
+  void operator=(const MemoryAccess &) = delete;
+
+  MemoryAccessKind Kind;
+  BasicBlock *Block;
+  SmallPtrSet<MemoryAccess *, 4> Users;
+};
+
+inline raw_ostream &operator<<(raw_ostream &OS, const MemoryAccess &MA) {
+  MA.print(OS);
+  return OS;
+}
+
+/// MemoryUseOrDef - The common base of MemoryUse and MemoryDef: an access
+/// made by an instruction, linked to the access defining the memory it sees.
+class MemoryUseOrDef : public MemoryAccess {
+public:
+  /// getMemoryInst - Return the instruction making the access, or null for
+  /// liveOnEntry.
+  Instruction *getMemoryInst() const { return MemoryInst; }
+
+  /// getDefiningAccess - Return the MemoryDef or MemoryPhi this access
+  /// depends on.  This is not necessarily the closest access that may alias;
+  /// see MemorySSAWalker for that.
+  MemoryAccess *getDefiningAccess() const { return DefiningAccess; }
+
+  /// setDefiningAccess - Link this access to another version of memory.
+  /// Transforms use it to make the accesses below a new MemoryDef use it.
+  void setDefiningAccess(MemoryAccess *DMA) {
+    if (DefiningAccess)
+      DefiningAccess->removeUser(this);
+    DefiningAccess = DMA;
+    if (DMA)
+      DMA->addUser(this);
+  }
+
+  static bool classof(const MemoryAccess *MA) {
+    return MA->getKind() == MemoryUseKind || MA->getKind() == MemoryDefKind;
+  }
+
+protected:
+  MemoryUseOrDef(MemoryAccessKind Kind, Instruction *MI, MemoryAccess *DMA,
+                 BasicBlock *BB)
+      : MemoryAccess(Kind, BB), MemoryInst(MI), DefiningAccess(nullptr) {
+    setDefiningAccess(DMA);
+  }
+
+private:
+  Instruction *MemoryInst;
+  MemoryAccess *DefiningAccess;
+};
+
+/// MemoryUse - An instruction that reads memory without writing it.
+class MemoryUse : public MemoryUseOrDef {
+public:
+  MemoryUse(Instruction *MI, MemoryAccess *DMA, BasicBlock *BB)
+      : MemoryUseOrDef(MemoryUseKind, MI, DMA, BB) {}
+
+  static bool classof(const MemoryAccess *MA) {
+    return MA->getKind() == MemoryUseKind;
+  }
+};
+
+/// MemoryDef - An instruction that may write memory, and so starts a new
+/// version of it.  Such an instruction may read memory as well.
+class MemoryDef : public MemoryUseOrDef {
+public:
+  MemoryDef(Instruction *MI, MemoryAccess *DMA, BasicBlock *BB, unsigned ID)
+      : MemoryUseOrDef(MemoryDefKind, MI, DMA, BB), ID(ID) {}
+
+  /// getID - Return the number naming this version of memory in dumps.
+  unsigned getID() const { return ID; }
+
+  static bool classof(const MemoryAccess *MA) {
+    return MA->getKind() == MemoryDefKind;
+  }
+
+private:
+  unsigned ID;
+};
+
+/// MemoryPhi - Merges the versions of memory flowing into a block from its
+/// predecessors.  There is at most one per block, and it comes before every
+/// other access of the block.
+class MemoryPhi : public MemoryAccess {
+public:
+  MemoryPhi(BasicBlock *BB, unsigned ID)
+      : MemoryAccess(MemoryPhiKind, BB), ID(ID) {}
+
+  unsigned getID() const { return ID; }
+
+  unsigned getNumIncomingValues() const { return Operands.size(); }
+  MemoryAccess *getIncomingValue(unsigned I) const { return Operands[I].first; }
+  BasicBlock *getIncomingBlock(unsigned I) const { return Operands[I].second; }
+
+  /// getIncomingValueForBlock - Return the version of memory coming from the
+  /// predecessor BB, or null if BB is not an incoming block.
+  MemoryAccess *getIncomingValueForBlock(const BasicBlock *BB) const;
+
+  void addIncoming(MemoryAccess *MA, BasicBlock *BB) {
+    Operands.push_back(std::make_pair(MA, BB));
+    MA->addUser(this);
+  }
+
+  void setIncomingValue(unsigned I, MemoryAccess *MA);
+
+  static bool classof(const MemoryAccess *MA) {
+    return MA->getKind() == MemoryPhiKind;
+  }
+
+private:
+  friend class MemorySSA;
+
+  unsigned ID;
+  SmallVector<std::pair<MemoryAccess *, BasicBlock *>, 4> Operands;
+};
+
+/// MemorySSA - The memory SSA form of a function.
+class MemorySSA {
+public:
+  typedef iplist<MemoryAccess> AccessListType;
+
+  /// Where to insert a new access in a block with createMemoryAccessInBB.
+  enum InsertionPlace { Beginning, End };
+
+  MemorySSA(Function &F, AliasAnalysis *AA, DominatorTree *DT);
+  ~MemorySSA();
+
+  /// getWalker - Return the caching walker of this function.
+  MemorySSAWalker *getWalker() const { return Walker.get(); }
+
+  /// getMemoryAccess - Return the MemoryUse or MemoryDef of I, or null if I
+  /// does not touch memory.
+  MemoryUseOrDef *getMemoryAccess(const Instruction *I) const;
+
+  /// getMemoryAccess - Return the MemoryPhi of BB, if it has one.
+  MemoryPhi *getMemoryAccess(const BasicBlock *BB) const;
+
+  /// getLiveOnEntryDef - Return the MemoryDef standing for the memory state
+  /// on entry to the function.  It is not part of any block.
+  MemoryAccess *getLiveOnEntryDef() const { return LiveOnEntryDef.get(); }
+
+  bool isLiveOnEntryDef(const MemoryAccess *MA) const {
+    return MA == LiveOnEntryDef.get();
+  }
+
+  /// getBlockAccesses - Return the accesses of BB in program order, or null
+  /// if it has none.
+  const AccessListType *getBlockAccesses(const BasicBlock *BB) const {
+    auto It = PerBlockAccesses.find(BB);
+    return It == PerBlockAccesses.end() ? nullptr : It->second.get();
+  }
+
+  /// dominates - Return true if the access Dominator dominates Dominatee.
+  /// Every access dominates itself, and liveOnEntry dominates everything.
+  bool dominates(const MemoryAccess *Dominator,
+                 const MemoryAccess *Dominatee) const;
+
+  /// locallyDominates - Like dominates, for two accesses of the same block.
+  bool locallyDominates(const MemoryAccess *Dominator,
+                        const MemoryAccess *Dominatee) const;
+
+  /// removeMemoryAccess - Remove MA from memory SSA and delete it, making its
+  /// users use its defining access instead.  This must be called before the
+  /// instruction of a MemoryUse or MemoryDef is erased.  A MemoryPhi may only
+  /// be removed once all of its incoming values are the same.
+  void removeMemoryAccess(MemoryAccess *MA);
+
+  /// createMemoryAccessInBB - Create the access of I, a new instruction that
+  /// touches memory, at the beginning or end of the accesses of BB (after its
+  /// MemoryPhi, if any).  Definition is the version of memory I sees.  When I
+  /// writes memory, the caller is responsible for making the later accesses
+  /// use the new MemoryDef where needed, with setDefiningAccess.
+  MemoryUseOrDef *createMemoryAccessInBB(Instruction *I,
+                                         MemoryAccess *Definition,
+                                         BasicBlock *BB, InsertionPlace Point);
+
+  /// createMemoryAccessBefore/After - Create the access of I right before or
+  /// after InsertPt, an existing access of the same block.
+  MemoryUseOrDef *createMemoryAccessBefore(Instruction *I,
+                                           MemoryAccess *Definition,
+                                           MemoryUseOrDef *InsertPt);
+  MemoryUseOrDef *createMemoryAccessAfter(Instruction *I,
+                                          MemoryAccess *Definition,
+                                          MemoryAccess *InsertPt);
+
+  /// verifyMemorySSA - Check that the accesses are in program order, that
+  /// every access is dominated by the accesses it uses, and that the use
+  /// lists are consistent.  Aborts on failure.
+  void verifyMemorySSA() const;
+
+  void print(raw_ostream &OS) const;
+  void dump() const;
+
+  AliasAnalysis &getAliasAnalysis() const { return *AA; }
+  DominatorTree &getDomTree() const { return *DT; }
+
+private:
+  void buildMemorySSA();
+  MemoryUseOrDef *createNewAccess(Instruction *I);
+  MemoryPhi *createMemoryPhi(BasicBlock *BB);
+  AccessListType *getOrCreateAccessList(const BasicBlock *BB);
+  AccessListType *getWritableBlockAccesses(const BasicBlock *BB) const;
+  MemoryAccess *renameBlock(BasicBlock *BB, MemoryAccess *Incoming);
+  void renamePass(SmallPtrSetImpl<BasicBlock *> &Visited);
+  void markUnreachableAsLiveOnEntry(BasicBlock *BB);
+
+  Function &F;
+  AliasAnalysis *AA;
+  DominatorTree *DT;
+
+  DenseMap<const Instruction *, MemoryUseOrDef *> InstructionToMemoryAccess;
+  DenseMap<const BasicBlock *, MemoryPhi *> BlockToMemoryPhi;
+  DenseMap<const BasicBlock *, std::unique_ptr<AccessListType>>
+      PerBlockAccesses;
+  std::unique_ptr<MemoryAccess> LiveOnEntryDef;
+  std::unique_ptr<MemorySSAWalker> Walker;
+  unsigned NextID;
+};
+
+/// MemorySSAWalker - Answers clobber queries on memory SSA.
+class MemorySSAWalker {
+public:
+  explicit MemorySSAWalker(MemorySSA *MSSA) : MSSA(MSSA) {}
+  virtual ~MemorySSAWalker() {}
+
+  /// getClobberingMemoryAccess - Return the closest MemoryDef or MemoryPhi
+  /// above the access of I that may write the memory I accesses.  The result
+  /// dominates I; it is a MemoryPhi when the paths reaching I disagree, and
+  /// liveOnEntry when nothing in the function clobbers the memory.
+  virtual MemoryAccess *getClobberingMemoryAccess(const Instruction *I) = 0;
+
+  /// getClobberingMemoryAccess - Return the closest access at or above
+  /// StartingAccess that may write Loc.
+  virtual MemoryAccess *
+  getClobberingMemoryAccess(MemoryAccess *StartingAccess,
+                            const AliasAnalysis::Location &Loc) = 0;
+
+  /// invalidateInfo - Forget what is known about MA, which is about to be
+  /// removed from memory SSA.
+  virtual void invalidateInfo(MemoryAccess *MA) {}
+
+  /// clearCache - Forget everything.  Called when a MemoryDef is created,
+  /// since it may clobber any walk that went past its place.
+  virtual void clearCache() {}
+
+protected:
+  MemorySSA *MSSA;
+};
+
+/// DoNothingMemorySSAWalker - A walker that does no alias analysis and just
+/// returns the defining access.
+class DoNothingMemorySSAWalker : public MemorySSAWalker {
+public:
+  explicit DoNothingMemorySSAWalker(MemorySSA *MSSA) : MemorySSAWalker(MSSA) {}
+
+  MemoryAccess *getClobberingMemoryAccess(const Instruction *I) override;
+  MemoryAccess *
+  getClobberingMemoryAccess(MemoryAccess *StartingAccess,
+                            const AliasAnalysis::Location &Loc) override;
+};
+
+/// CachingMemorySSAWalker - The default walker.  It walks up the defining
+/// accesses, asking alias analysis about each MemoryDef, and through the
+/// incoming values of MemoryPhis, and remembers the clobber found for each
+/// (access, location) pair it starts from or crosses.  Removing an access
+/// only drops the entries mentioning it, so the cache survives the deletions
+/// made by transforms; creating a MemoryDef empties it.
+class CachingMemorySSAWalker : public MemorySSAWalker {
+public:
+  CachingMemorySSAWalker(MemorySSA *MSSA, AliasAnalysis *AA);
+  ~CachingMemorySSAWalker() override;
+
+  MemoryAccess *getClobberingMemoryAccess(const Instruction *I) override;
+  MemoryAccess *
+  getClobberingMemoryAccess(MemoryAccess *StartingAccess,
+                            const AliasAnalysis::Location &Loc) override;
+  void invalidateInfo(MemoryAccess *MA) override;
+  void clearCache() override;
+
+private:
+  struct UpwardsWalkState;
+
+  MemoryAccess *walkUpwards(MemoryAccess *Current, UpwardsWalkState &State,
+                            unsigned &CutDepth);
+  MemoryAccess *lookupCache(const MemoryAccess *MA,
+                            const AliasAnalysis::Location &Loc) const;
+  void addCacheEntry(const MemoryAccess *MA,
+                     const AliasAnalysis::Location &Loc, MemoryAccess *Result);
+
+  AliasAnalysis *AA;
+
+  typedef std::pair<const MemoryAccess *, AliasAnalysis::Location> CacheKey;
+  DenseMap<CacheKey, MemoryAccess *> CachedClobbers;
+  /// The number of cache entries each access appears in, as key or result.
+  DenseMap<const MemoryAccess *, unsigned> CacheRefs;
+};
+
+/// MemorySSAWrapperPass - Legacy pass manager wrapper building memory SSA for
+/// a function.  Transforms that preserve it must keep it up to date.
+class MemorySSAWrapperPass : public FunctionPass {
+public:
+  static char ID; // Pass identification, replacement for typeid
+
+  MemorySSAWrapperPass();
+
+  MemorySSA &getMSSA() { return *MSSA; }
+  const MemorySSA &getMSSA() const { return *MSSA; }
+
+  bool runOnFunction(Function &F) override;
+  void releaseMemory() override;
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+  void verifyAnalysis() const override;
+  void print(raw_ostream &OS, const Module *M = nullptr) const override;
+
+private:
+  std::unique_ptr<MemorySSA> MSSA;
+};
+
+} // End llvm namespace
+
+#endif
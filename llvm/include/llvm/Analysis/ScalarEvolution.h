@@ -23,6 +23,7 @@
 
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/IR/ConstantRange.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instructions.h"
@@ -346,9 +347,10 @@ namespace llvm {
       /// getMax - Get the max backedge taken count for the loop.
       const SCEV *getMax(ScalarEvolution *SE) const;
 
-      /// Return true if any backedge taken count expressions refer to the given
-      /// subexpression.
-      bool hasOperand(const SCEV *S, ScalarEvolution *SE) const;
+      /// getExprs - Append the computable expressions of this result, the
+      /// exact count of every exit and the max count, to \p Exprs.
+      void getExprs(SmallVectorImpl<const SCEV *> &Exprs,
+                    ScalarEvolution *SE) const;
 
       /// clear - Invalidate this result and free associated memory.
       void clear();
@@ -358,6 +360,22 @@ namespace llvm {
     /// this function as they are computed.
     DenseMap<const Loop*, BackedgeTakenInfo> BackedgeTakenCounts;
 
+    /// BECountUsers - For each expression, the loops whose cached
+    /// backedge-taken count refers to it, directly or indirectly.  This
+    /// lets forgetMemoizedResults drop only the counts that depend on an
+    /// expression, instead of searching every count in the function.
+    DenseMap<const SCEV *, SmallPtrSet<const Loop *, 2>> BECountUsers;
+
+    /// BECountQueryDepth - The number of getBackedgeTakenInfo calls that are
+    /// computing a count, including the outermost one.  Zero outside of a
+    /// backedge-taken count query.
+    unsigned BECountQueryDepth;
+
+    /// BECountQueryCost - The work done so far by the current backedge-taken
+    /// count query, counted in exit conditions and implied conditions
+    /// evaluated.  See chargeBECountQuery.
+    unsigned BECountQueryCost;
+
     /// ConstantEvolutionLoopExitValue - This map contains entries for all of
     /// the PHI instructions that we attempt to compute constant evolutions for.
     /// This allows us to avoid potentially expensive recomputation of these
@@ -445,6 +463,20 @@ namespace llvm {
     /// loop will iterate.
     BackedgeTakenInfo ComputeBackedgeTakenCount(const Loop *L);
 
+    /// addBECountUsers - Record that the backedge-taken count \p BTI of
+    /// loop \p L refers to each of its subexpressions.
+    void addBECountUsers(const Loop *L, const BackedgeTakenInfo &BTI);
+
+    /// eraseBackedgeTakenInfo - Drop the cached backedge-taken count of
+    /// \p L, if there is one, and its entries in BECountUsers.
+    void eraseBackedgeTakenInfo(const Loop *L);
+
+    /// chargeBECountQuery - Account for one step of the backedge-taken count
+    /// query in progress, if any.  Return true if the query has gone over its
+    /// budget, in which case the caller should give up with the most
+    /// conservative answer.
+    bool chargeBECountQuery();
+
     /// ComputeExitLimit - Compute the number of times the backedge of the
     /// specified loop will execute if it exits via the specified block.
     ExitLimit ComputeExitLimit(const Loop *L, BasicBlock *ExitingBlock);
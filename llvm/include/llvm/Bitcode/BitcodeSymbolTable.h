@@ -0,0 +1,83 @@
+//===- llvm/Bitcode/BitcodeSymbolTable.h - Bitcode symbol table -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the in-memory form of the symbol table block that can be
+// written in bitcode files (see WriteBitcodeToFile()). The table lists the
+// symbols of a module as the linker sees them, which lets tools like linkers
+// and archivers enumerate them without reading the module.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_BITCODE_BITCODESYMBOLTABLE_H
+#define LLVM_BITCODE_BITCODESYMBOLTABLE_H
+
+#include "llvm/Bitcode/LLVMBitCodes.h"
+#include "llvm/IR/Comdat.h"
+#include "llvm/IR/GlobalValue.h"
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+/// \brief The symbol table of a bitcode module.
+struct BitcodeSymbolTable {
+  /// \brief A global value of the module.
+  struct Symbol {
+    /// The name of the symbol, mangled for the target of the module.
+    std::string Name;
+
+    /// A combination of bitc::SymtabSymbolFlags.
+    unsigned Flags;
+
+    GlobalValue::LinkageTypes Linkage;
+    GlobalValue::VisibilityTypes Visibility;
+    unsigned Alignment;
+
+    /// Index of the comdat of the symbol in Comdats, or -1.
+    int ComdatIndex;
+
+    /// The size of a common symbol, or zero.
+    uint64_t CommonSize;
+
+    Symbol()
+        : Flags(0), Linkage(GlobalValue::ExternalLinkage),
+          Visibility(GlobalValue::DefaultVisibility), Alignment(0),
+          ComdatIndex(-1), CommonSize(0) {}
+
+    bool isUndefined() const { return Flags & bitc::SYMTAB_SYMBOL_UNDEFINED; }
+    bool isFunction() const { return Flags & bitc::SYMTAB_SYMBOL_FUNCTION; }
+    bool isConstant() const { return Flags & bitc::SYMTAB_SYMBOL_CONSTANT; }
+    bool hasUnnamedAddr() const {
+      return Flags & bitc::SYMTAB_SYMBOL_UNNAMED_ADDR;
+    }
+    bool isAlias() const { return Flags & bitc::SYMTAB_SYMBOL_ALIAS; }
+    bool isFormatSpecific() const {
+      return Flags & bitc::SYMTAB_SYMBOL_FORMAT_SPECIFIC;
+    }
+  };
+
+  std::string TargetTriple;
+
+  /// The data layout of the module, which determines how the names of the
+  /// symbols were mangled.
+  std::string DataLayoutStr;
+
+  /// The comdats of the module, as pairs of a name and a selection kind.
+  std::vector<std::pair<std::string, Comdat::SelectionKind>> Comdats;
+
+  /// The symbols, in the order functions, global variables then aliases.
+  std::vector<Symbol> Symbols;
+
+  /// The strings of the "Linker Options" module flag.
+  std::vector<std::string> LinkerOptions;
+};
+
+} // End llvm namespace
+
+#endif
@@ -104,6 +104,21 @@ public:
   /// \brief Retrieve the current position in the stream, in bits.
   uint64_t GetCurrentBitNo() const { return GetBufferOffset() * 8 + CurBit; }
 
+  /// \brief Overwrite the 64 bits at bit offset \p BitNo, which need not be
+  /// aligned, with \p Val. This is used to fill in placeholders for values
+  /// known only once the data following them has been emitted. The bits must
+  /// already have been flushed to the output buffer.
+  void BackpatchWord64(uint64_t BitNo, uint64_t Val) {
+    assert(BitNo + 64 <= GetBufferOffset() * 8 && "Bits not flushed yet");
+    for (unsigned I = 0; I != 64; ++I, ++BitNo) {
+      unsigned char Mask = 1 << (BitNo & 7);
+      if ((Val >> I) & 1)
+        Out[BitNo / 8] |= Mask;
+      else
+        Out[BitNo / 8] &= ~Mask;
+    }
+  }
+
   //===--------------------------------------------------------------------===//
   // Basic Primitives for emitting bits to the stream.
   //===--------------------------------------------------------------------===//
@@ -42,7 +42,12 @@ namespace bitc {
 
     TYPE_BLOCK_ID_NEW,
 
-    USELIST_BLOCK_ID
+    USELIST_BLOCK_ID,
+
+    MODULE_STRTAB_BLOCK_ID,
+    FUNCTION_SUMMARY_BLOCK_ID,
+
+    SYMTAB_BLOCK_ID
   };
 
 
@@ -167,6 +172,8 @@ namespace bitc {
     METADATA_EXPRESSION    = 29,  // [distinct, n x element]
     METADATA_OBJC_PROPERTY = 30,  // [distinct, name, file, line, ...]
     METADATA_IMPORTED_ENTITY=31,  // [distinct, tag, scope, entity, line, name]
+    METADATA_INDEX_OFFSET  = 32,  // [offset lo32, offset hi32]
+    METADATA_INDEX         = 33,  // [n x bitpos delta]
   };
 
   // The constants block (CONSTANTS_BLOCK_ID) describes emission for each
@@ -355,6 +362,48 @@ namespace bitc {
     USELIST_CODE_BB      = 2  // BB: [index..., bb-id]
   };
 
+  /// The module path symbol table only has one code (MST_CODE_ENTRY).
+  enum ModulePathSymtabCodes {
+    MST_CODE_ENTRY = 1,  // MST_ENTRY: [modid, namechar x N]
+  };
+
+  /// The function summary block uses different codes for the per-module
+  /// summary and for the combined index. Each entry is followed by the call
+  /// and reference records of the function it describes.
+  enum FunctionSummaryCodes {
+    // PERMODULE_ENTRY: [linkage, instcount, namechar x N]
+    FS_CODE_PERMODULE_ENTRY = 1,
+    // COMBINED_ENTRY: [modid, linkage, instcount, namechar x N]
+    FS_CODE_COMBINED_ENTRY = 2,
+    // CALL: [namechar x N]
+    FS_CODE_CALL = 3,
+    // REF: [namechar x N]
+    FS_CODE_REF = 4
+  };
+
+  /// The symbol table block, when present, is the first block of the module.
+  /// It describes the symbols of the module as they are seen by the linker,
+  /// so that they can be listed without reading the module.
+  enum SymtabCodes {
+    SYMTAB_CODE_TRIPLE = 1,        // TRIPLE: [strchr x N]
+    SYMTAB_CODE_COMDAT = 2,        // COMDAT: [selection_kind, namechar x N]
+    // SYMBOL: [flags, linkage, visibility, alignment, comdat, commonsize,
+    //          namechar x N]
+    SYMTAB_CODE_SYMBOL = 3,
+    SYMTAB_CODE_LINKER_OPTION = 4, // LINKER_OPTION: [strchr x N]
+    SYMTAB_CODE_DATALAYOUT = 5     // DATALAYOUT: [strchr x N]
+  };
+
+  /// Flags of the SYMTAB_CODE_SYMBOL records.
+  enum SymtabSymbolFlags {
+    SYMTAB_SYMBOL_UNDEFINED = 1 << 0,       // isDeclarationForLinker()
+    SYMTAB_SYMBOL_FUNCTION = 1 << 1,
+    SYMTAB_SYMBOL_CONSTANT = 1 << 2,        // A constant global variable
+    SYMTAB_SYMBOL_UNNAMED_ADDR = 1 << 3,
+    SYMTAB_SYMBOL_ALIAS = 1 << 4,
+    SYMTAB_SYMBOL_FORMAT_SPECIFIC = 1 << 5  // llvm.* and llvm.metadata symbols
+  };
+
   enum AttributeKindCodes {
     // = 0 is unused
     ATTR_KIND_ALIGNMENT = 1,
@@ -22,7 +22,9 @@
 
 namespace llvm {
   class BitstreamWriter;
+  struct BitcodeSymbolTable;
   class DataStreamer;
+  class FunctionInfoIndex;
   class LLVMContext;
   class Module;
   class ModulePass;
@@ -56,10 +58,37 @@ namespace llvm {
   parseBitcodeFile(MemoryBufferRef Buffer, LLVMContext &Context,
                    DiagnosticHandlerFunction DiagnosticHandler = nullptr);
 
+  /// Parse the function summary of the specified bitcode buffer, without
+  /// parsing the module itself. The buffer may be a module written with a
+  /// function summary, whose summaries are attributed to the buffer
+  /// identifier, or a combined index written by WriteFunctionSummaryToFile().
+  /// A module without a function summary gives an empty index.
+  ErrorOr<std::unique_ptr<FunctionInfoIndex>>
+  getFunctionInfoIndex(MemoryBufferRef Buffer, LLVMContext &Context,
+                       DiagnosticHandlerFunction DiagnosticHandler = nullptr);
+
+  /// Read the symbol table of the specified bitcode buffer, without parsing
+  /// the module. Returns null if the module was written without one.
+  ErrorOr<std::unique_ptr<BitcodeSymbolTable>>
+  getBitcodeSymbolTable(MemoryBufferRef Buffer, LLVMContext &Context,
+                        DiagnosticHandlerFunction DiagnosticHandler = nullptr);
+
   /// WriteBitcodeToFile - Write the specified module to the specified
   /// raw output stream.  For streams where it matters, the given stream
-  /// should be in "binary" mode.
-  void WriteBitcodeToFile(const Module *M, raw_ostream &Out);
+  /// should be in "binary" mode. If \p EmitFunctionSummary is true, a summary
+  /// of the functions of the module is written after the module, for use in
+  /// summary-based cross-module optimization. If \p EmitSymbolTable is true,
+  /// a symbol table is written at the start of the module (see
+  /// getBitcodeSymbolTable()), unless the module has module-level inline asm,
+  /// whose symbols can only be found by parsing it for the target.
+  void WriteBitcodeToFile(const Module *M, raw_ostream &Out,
+                          bool EmitFunctionSummary = false,
+                          bool EmitSymbolTable = false);
+
+  /// Write the combined function summary index \p Index to the specified raw
+  /// output stream, as a bitcode file that only holds the index.
+  void WriteFunctionSummaryToFile(const FunctionInfoIndex &Index,
+                                  raw_ostream &Out);
 
 
   /// isBitcodeWrapper - Return true if the given bytes are the magic bytes
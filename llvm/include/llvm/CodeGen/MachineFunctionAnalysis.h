@@ -28,6 +28,10 @@ private:
   const TargetMachine &TM;
   MachineFunction *MF;
   unsigned NextFnNum;
+  /// MachineFunction given to adoptMF() for the next function, if any.
+  MachineFunction *AdoptedMF;
+  /// Whether MF is deleted when this pass releases it.
+  bool OwnsMF;
 public:
   static char ID;
   explicit MachineFunctionAnalysis(const TargetMachine &tm);
@@ -35,6 +39,16 @@ public:
 
   MachineFunction &getMF() const { return *MF; }
 
+  /// Return the MachineFunction of the current function and give up its
+  /// ownership to the caller.  Passes that run later on the function will
+  /// find no MachineFunction.
+  MachineFunction *takeMF();
+
+  /// Make the next run of this pass use \p NewMF, which was built for the
+  /// same function by another MachineFunctionAnalysis, instead of creating
+  /// a new MachineFunction.  The caller keeps ownership of \p NewMF.
+  void adoptMF(MachineFunction *NewMF);
+
   const char* getPassName() const override {
     return "Machine Function Analysis";
   }
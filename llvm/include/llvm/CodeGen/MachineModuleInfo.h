@@ -44,6 +44,7 @@
 #include "llvm/Pass.h"
 #include "llvm/Support/DataTypes.h"
 #include "llvm/Support/Dwarf.h"
+#include "llvm/Support/Mutex.h"
 
 namespace llvm {
 
@@ -111,36 +112,10 @@ class MachineModuleInfo : public ImmutablePass {
   /// want.
   MachineModuleInfoImpl *ObjFileMMI;
 
-  /// List of moves done by a function's prolog.  Used to construct frame maps
-  /// by debug and exception handling consumers.
-  std::vector<MCCFIInstruction> FrameInstructions;
-
-  /// LandingPads - List of LandingPadInfo describing the landing pad
-  /// information in the current function.
-  std::vector<LandingPadInfo> LandingPads;
-
   /// LPadToCallSiteMap - Map a landing pad's EH symbol to the call site
   /// indexes.
   DenseMap<MCSymbol*, SmallVector<unsigned, 4> > LPadToCallSiteMap;
 
-  /// CallSiteMap - Map of invoke call site index values to associated begin
-  /// EH_LABEL for the current function.
-  DenseMap<MCSymbol*, unsigned> CallSiteMap;
-
-  /// CurCallSite - The current call site index being processed, if any. 0 if
-  /// none.
-  unsigned CurCallSite;
-
-  /// TypeInfos - List of C++ TypeInfo used in the current function.
-  std::vector<const GlobalValue *> TypeInfos;
-
-  /// FilterIds - List of typeids encoding filters used in the current function.
-  std::vector<unsigned> FilterIds;
-
-  /// FilterEnds - List of the indices in FilterIds corresponding to filter
-  /// terminators.
-  std::vector<unsigned> FilterEnds;
-
   /// Personalities - Vector of all personality functions ever seen. Used to
   /// emit common EH frames.
   std::vector<const Function *> Personalities;
@@ -154,9 +129,6 @@ class MachineModuleInfo : public ImmutablePass {
   /// the specified basic block's address of label.
   MMIAddrLabelMap *AddrLabelSymbols;
 
-  bool CallsEHReturn;
-  bool CallsUnwindInit;
-
   /// DbgInfoAvailable - True if debugging information is available
   /// in this module.
   bool DbgInfoAvailable;
@@ -190,7 +162,76 @@ public:
         : Var(Var), Expr(Expr), Slot(Slot), Loc(Loc) {}
   };
   typedef SmallVector<VariableDbgInfo, 4> VariableDbgInfoMapTy;
-  VariableDbgInfoMapTy VariableDbgInfos;
+
+  /// FunctionState - The information collected about the function being
+  /// compiled, which EndFunction() discards.  When the machine passes run on
+  /// several functions at once, each function carries its own state (see
+  /// swapFunctionState() and FunctionStateScope).
+  struct FunctionState {
+    /// List of moves done by a function's prolog.  Used to construct frame
+    /// maps by debug and exception handling consumers.
+    std::vector<MCCFIInstruction> FrameInstructions;
+
+    /// LandingPads - List of LandingPadInfo describing the landing pad
+    /// information in the current function.
+    std::vector<LandingPadInfo> LandingPads;
+
+    /// CallSiteMap - Map of invoke call site index values to associated begin
+    /// EH_LABEL for the current function.
+    DenseMap<MCSymbol*, unsigned> CallSiteMap;
+
+    /// CurCallSite - The current call site index being processed, if any. 0
+    /// if none.
+    unsigned CurCallSite;
+
+    /// TypeInfos - List of C++ TypeInfo used in the current function.
+    std::vector<const GlobalValue *> TypeInfos;
+
+    /// FilterIds - List of typeids encoding filters used in the current
+    /// function.
+    std::vector<unsigned> FilterIds;
+
+    /// FilterEnds - List of the indices in FilterIds corresponding to filter
+    /// terminators.
+    std::vector<unsigned> FilterEnds;
+
+    bool CallsEHReturn;
+    bool CallsUnwindInit;
+
+    VariableDbgInfoMapTy VariableDbgInfos;
+
+    FunctionState()
+        : CurCallSite(0), CallsEHReturn(false), CallsUnwindInit(false) {}
+  };
+
+  /// FunctionStateScope - While alive, makes the MachineModuleInfo use the
+  /// given function state on the current thread instead of its own.  This
+  /// lets the machine passes of different functions run on different
+  /// threads.
+  class FunctionStateScope {
+    MachineModuleInfo *PrevMMI;
+    FunctionState *PrevState;
+    FunctionStateScope(const FunctionStateScope &) = delete;
+    void operator=(const FunctionStateScope &) = delete;
+  public:
+    FunctionStateScope(MachineModuleInfo &MMI, FunctionState &State);
+    ~FunctionStateScope();
+  };
+
+private:
+  /// CurFunction - The state of the current function, unless a
+  /// FunctionStateScope says otherwise.
+  FunctionState CurFunction;
+
+  /// IRMutex - See getIRMutex().
+  sys::SmartMutex<true> IRMutex;
+
+  FunctionState &getFunctionState();
+  const FunctionState &getFunctionState() const {
+    return const_cast<MachineModuleInfo *>(this)->getFunctionState();
+  }
+
+public:
 
   MachineModuleInfo();  // DUMMY CONSTRUCTOR, DO NOT CALL.
   // Real constructor.
@@ -206,6 +247,16 @@ public:
   ///
   void EndFunction();
 
+  /// swapFunctionState - Exchange the state of the current function with
+  /// State.  This is used to set a function aside after instruction
+  /// selection and to resume it before it is emitted.
+  void swapFunctionState(FunctionState &State);
+
+  /// getIRMutex - Return the mutex to hold while a machine function pass
+  /// creates types or constants.  These are owned by the LLVMContext, which
+  /// is shared by all the functions that may be compiled at the same time.
+  sys::SmartMutex<true> &getIRMutex() { return IRMutex; }
+
   const MCContext &getContext() const { return Context; }
   MCContext &getContext() { return Context; }
 
@@ -242,11 +293,11 @@ public:
   bool hasDebugInfo() const { return DbgInfoAvailable; }
   void setDebugInfoAvailability(bool avail) { DbgInfoAvailable = avail; }
 
-  bool callsEHReturn() const { return CallsEHReturn; }
-  void setCallsEHReturn(bool b) { CallsEHReturn = b; }
+  bool callsEHReturn() const { return getFunctionState().CallsEHReturn; }
+  void setCallsEHReturn(bool b) { getFunctionState().CallsEHReturn = b; }
 
-  bool callsUnwindInit() const { return CallsUnwindInit; }
-  void setCallsUnwindInit(bool b) { CallsUnwindInit = b; }
+  bool callsUnwindInit() const { return getFunctionState().CallsUnwindInit; }
+  void setCallsUnwindInit(bool b) { getFunctionState().CallsUnwindInit = b; }
 
   bool usesVAFloatArgument() const {
     return UsesVAFloatArgument;
@@ -268,11 +319,13 @@ public:
   /// function's prologue.  Used to construct frame maps for debug and exception
   /// handling comsumers.
   const std::vector<MCCFIInstruction> &getFrameInstructions() const {
-    return FrameInstructions;
+    return getFunctionState().FrameInstructions;
   }
 
   unsigned LLVM_ATTRIBUTE_UNUSED_RESULT
   addFrameInst(const MCCFIInstruction &Inst) {
+    std::vector<MCCFIInstruction> &FrameInstructions =
+        getFunctionState().FrameInstructions;
     FrameInstructions.push_back(Inst);
     return FrameInstructions.size() - 1;
   }
@@ -367,7 +420,7 @@ public:
   /// getLandingPads - Return a reference to the landing pad info for the
   /// current function.
   const std::vector<LandingPadInfo> &getLandingPads() const {
-    return LandingPads;
+    return getFunctionState().LandingPads;
   }
 
   /// setCallSiteLandingPad - Map the landing pad's EH symbol to the call
@@ -390,39 +443,41 @@ public:
 
   /// setCallSiteBeginLabel - Map the begin label for a call site.
   void setCallSiteBeginLabel(MCSymbol *BeginLabel, unsigned Site) {
-    CallSiteMap[BeginLabel] = Site;
+    getFunctionState().CallSiteMap[BeginLabel] = Site;
   }
 
   /// getCallSiteBeginLabel - Get the call site number for a begin label.
   unsigned getCallSiteBeginLabel(MCSymbol *BeginLabel) {
     assert(hasCallSiteBeginLabel(BeginLabel) &&
            "Missing call site number for EH_LABEL!");
-    return CallSiteMap[BeginLabel];
+    return getFunctionState().CallSiteMap[BeginLabel];
   }
 
   /// hasCallSiteBeginLabel - Return true if the begin label has a call site
   /// number associated with it.
   bool hasCallSiteBeginLabel(MCSymbol *BeginLabel) {
-    return CallSiteMap[BeginLabel] != 0;
+    return getFunctionState().CallSiteMap[BeginLabel] != 0;
   }
 
   /// setCurrentCallSite - Set the call site currently being processed.
-  void setCurrentCallSite(unsigned Site) { CurCallSite = Site; }
+  void setCurrentCallSite(unsigned Site) {
+    getFunctionState().CurCallSite = Site;
+  }
 
   /// getCurrentCallSite - Get the call site currently being processed, if any.
   /// return zero if none.
-  unsigned getCurrentCallSite() { return CurCallSite; }
+  unsigned getCurrentCallSite() { return getFunctionState().CurCallSite; }
 
   /// getTypeInfos - Return a reference to the C++ typeinfo for the current
   /// function.
   const std::vector<const GlobalValue *> &getTypeInfos() const {
-    return TypeInfos;
+    return getFunctionState().TypeInfos;
   }
 
   /// getFilterIds - Return a reference to the typeids encoding filters used in
   /// the current function.
   const std::vector<unsigned> &getFilterIds() const {
-    return FilterIds;
+    return getFunctionState().FilterIds;
   }
 
   /// getPersonality - Return a personality function if available.  The presence
@@ -436,10 +491,12 @@ public:
   /// information of a variable.
   void setVariableDbgInfo(MDNode *Var, MDNode *Expr, unsigned Slot,
                           DebugLoc Loc) {
-    VariableDbgInfos.emplace_back(Var, Expr, Slot, Loc);
+    getFunctionState().VariableDbgInfos.emplace_back(Var, Expr, Slot, Loc);
   }
 
-  VariableDbgInfoMapTy &getVariableDbgInfo() { return VariableDbgInfos; }
+  VariableDbgInfoMapTy &getVariableDbgInfo() {
+    return getFunctionState().VariableDbgInfos;
+  }
 
 }; // End class MachineModuleInfo
 
@@ -0,0 +1,47 @@
+//===-- llvm/CodeGen/ParallelCG.h - Parallel code generation ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This header declares functions that can be used for parallel code generation.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_PARALLELCG_H
+#define LLVM_CODEGEN_PARALLELCG_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Support/CodeGen.h"
+#include "llvm/Target/TargetMachine.h"
+
+namespace llvm {
+
+class Module;
+class TargetOptions;
+class raw_ostream;
+
+/// Split M into OSs.size() partitions, and generate code for each on its own
+/// thread and in its own LLVMContext. Writes OSs.size() output files to the
+/// output streams in OSs. The resulting output files if linked together are
+/// intended to be equivalent to the single output file that would have been
+/// code generated from M. The output is deterministic for a given module and
+/// number of output streams.
+///
+/// If OSs.size() is 1, M is code generated directly on the calling thread.
+/// Otherwise M is modified by the split (see SplitModule) and should not be
+/// used for code generation afterwards.
+void splitCodeGen(Module &M, ArrayRef<raw_ostream *> OSs, StringRef CPU,
+                  StringRef Features, const TargetOptions &Options,
+                  Reloc::Model RM = Reloc::Default,
+                  CodeModel::Model CM = CodeModel::Default,
+                  CodeGenOpt::Level OL = CodeGenOpt::Default,
+                  TargetMachine::CodeGenFileType FT =
+                      TargetMachine::CGFT_ObjectFile);
+
+} // End llvm namespace
+
+#endif
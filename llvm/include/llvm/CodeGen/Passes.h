@@ -187,6 +187,9 @@ public:
   /// transforms following machine independent optimization.
   virtual void addIRPasses();
 
+  /// Add the alias analysis passes used by the IR and machine passes.
+  void addAliasAnalysisPasses();
+
   /// Add passes to lower exception handling for the code generator.
   void addPassesToHandleExceptions();
 
@@ -208,6 +211,13 @@ public:
   /// Fully developed targets will not generally override this.
   virtual void addMachinePasses();
 
+  /// Add the alias analyses and the passes of addMachinePasses() to \p PassMgr
+  /// rather than to the pass manager this configuration was created for.
+  /// Unlike the other add* methods, this may be called after
+  /// setInitialized(), any number of times, to build the private pipelines
+  /// that run machine functions on other threads.
+  void addMachinePassesTo(PassManagerBase &PassMgr);
+
   /// Create an instance of ScheduleDAGInstrs to be run within the standard
   /// MachineScheduler pass for this function and target at the current
   /// optimization level.
@@ -368,10 +378,21 @@ namespace llvm {
   createMachineFunctionPrinterPass(raw_ostream &OS,
                                    const std::string &Banner ="");
 
+  /// createParallelMachinePassesPass - Run the machine passes of the target
+  /// pipeline on up to NumThreads functions at a time, then run Printer on
+  /// the functions in their original order.  The pass must follow
+  /// instruction selection and takes ownership of Printer.
+  FunctionPass *createParallelMachinePassesPass(unsigned NumThreads,
+                                                FunctionPass *Printer);
+
   /// createCodeGenPreparePass - Transform the code to expose more pattern
   /// matching during instruction selection.
   FunctionPass *createCodeGenPreparePass(const TargetMachine *TM = nullptr);
 
+  /// createInterleavedAccessPass - This pass identifies and matches interleaved
+  /// memory accesses to target specific intrinsics.
+  FunctionPass *createInterleavedAccessPass(const TargetMachine *TM);
+
   /// AtomicExpandID -- Lowers atomic operations in terms of either cmpxchg
   /// load-linked/store-conditional loops.
   extern char &AtomicExpandID;
@@ -22,6 +22,7 @@
 #include "llvm/IR/Dominators.h"
 #include "llvm/IR/ValueMap.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Target/TargetLowering.h"
 
 namespace llvm {
@@ -65,6 +66,10 @@ private:
   /// AllocaInst triggers a stack protector.
   SSPLayoutMap Layout;
 
+  /// LayoutMutex - Guards Layout, which the machine passes of functions
+  /// compiled on different threads query and update.
+  mutable sys::SmartMutex<true> LayoutMutex;
+
   /// \brief The minimum size of buffers that will receive stack smashing
   /// protection when -fstack-protection is used.
   unsigned SSPBufferSize;
@@ -18,6 +18,7 @@
 #ifndef LLVM_IR_FUNCTION_H
 #define LLVM_IR_FUNCTION_H
 
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/IR/Argument.h"
 #include "llvm/IR/Attributes.h"
@@ -28,6 +29,7 @@
 
 namespace llvm {
 
+class AssemblyAnnotationWriter;
 class FunctionType;
 class LLVMContext;
 
@@ -203,6 +205,14 @@ public:
     return AttributeSets.getStackAlignment(AttributeSet::FunctionIndex);
   }
 
+  /// \brief Set how many times the function was entered according to the
+  /// profile data.
+  void setEntryCount(uint64_t Count);
+
+  /// \brief Return how many times the function was entered according to the
+  /// profile data, if it has any.
+  Optional<uint64_t> getEntryCount() const;
+
   /// hasGC/getGC/setGC/clearGC - The name of the garbage collection algorithm
   ///                             to use during code generation.
   bool hasGC() const;
@@ -452,6 +462,10 @@ public:
   Constant *getPrologueData() const;
   void setPrologueData(Constant *PrologueData);
 
+  /// print - Print the function to an output stream, with an optional
+  /// AssemblyAnnotationWriter.
+  void print(raw_ostream &OS, AssemblyAnnotationWriter *AAW = nullptr) const;
+
   /// viewCFG - This function is meant for use from the debugger.  You can just
   /// say 'call F->viewCFG()' and a ghostview window should pop up from the
   /// program, displaying the CFG of the current function with the code for each
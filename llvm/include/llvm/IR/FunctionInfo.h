@@ -0,0 +1,131 @@
+//===-- llvm/IR/FunctionInfo.h - Function Summary Index ---------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// @file
+/// FunctionSummary and FunctionInfoIndex classes, used to perform summary-based
+/// cross-module optimization without loading every module in memory.
+///
+/// Each bitcode file may carry a summary of its function definitions. The
+/// summaries of all the modules taking part in a link are combined into a
+/// single FunctionInfoIndex, which is enough for a per-module backend to decide
+/// which functions to import from which module.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_FUNCTIONINFO_H
+#define LLVM_IR_FUNCTIONINFO_H
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/GlobalValue.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+class Function;
+
+/// \brief Summary of a function definition: its linkage, its size and the
+/// global values it references, by name.
+class FunctionSummary {
+  /// Path of the module defining the function. This is a reference to a key
+  /// of the module path table of the owning index.
+  StringRef ModulePath;
+
+  GlobalValue::LinkageTypes Linkage;
+
+  /// Number of non-debug instructions in the function body.
+  unsigned InstCount;
+
+  /// Names of the functions called directly by the function.
+  std::vector<std::string> Calls;
+
+  /// Names of the other global values the function references.
+  std::vector<std::string> Refs;
+
+public:
+  FunctionSummary(GlobalValue::LinkageTypes Linkage, unsigned InstCount)
+      : Linkage(Linkage), InstCount(InstCount) {}
+
+  /// Computes the summary of the definition \p F.
+  static std::unique_ptr<FunctionSummary> compute(const Function &F);
+
+  StringRef modulePath() const { return ModulePath; }
+  void setModulePath(StringRef Path) { ModulePath = Path; }
+
+  GlobalValue::LinkageTypes getLinkage() const { return Linkage; }
+  unsigned instCount() const { return InstCount; }
+
+  const std::vector<std::string> &calls() const { return Calls; }
+  void addCall(StringRef Callee) { Calls.push_back(Callee); }
+
+  const std::vector<std::string> &refs() const { return Refs; }
+  void addRef(StringRef Ref) { Refs.push_back(Ref); }
+};
+
+/// A list of the summaries of the definitions of a function name, one per
+/// module defining it (there may be several for linkonce and weak functions,
+/// or for local functions that happen to share a name).
+typedef std::vector<std::unique_ptr<FunctionSummary>> FunctionSummaryList;
+
+/// \brief Index of the function summaries of one or more modules, keyed by
+/// function name.
+class FunctionInfoIndex {
+  StringMap<FunctionSummaryList> FunctionMap;
+
+  /// Maps the path of each module contributing to the index to its module
+  /// identifier.
+  StringMap<uint64_t> ModulePathStringTable;
+
+public:
+  typedef StringMap<FunctionSummaryList>::const_iterator const_iterator;
+
+  const_iterator begin() const { return FunctionMap.begin(); }
+  const_iterator end() const { return FunctionMap.end(); }
+
+  /// Returns the summaries of the definitions of \p Name, or null if no module
+  /// in the index defines it.
+  const FunctionSummaryList *findFunctionSummaryList(StringRef Name) const {
+    auto I = FunctionMap.find(Name);
+    return I == FunctionMap.end() ? nullptr : &I->second;
+  }
+
+  /// Adds \p Summary as a definition of \p Name. The summary must already have
+  /// a module path from this index (see addModulePath()).
+  void addFunctionSummary(StringRef Name,
+                          std::unique_ptr<FunctionSummary> Summary) {
+    FunctionMap[Name].push_back(std::move(Summary));
+  }
+
+  /// Returns the table mapping module paths to module identifiers.
+  const StringMap<uint64_t> &modulePaths() const {
+    return ModulePathStringTable;
+  }
+
+  /// Adds \p Path to the module path table with identifier \p ModId, and
+  /// returns the copy of \p Path owned by the index.
+  StringRef addModulePath(StringRef Path, uint64_t ModId) {
+    return ModulePathStringTable.insert(std::make_pair(Path, ModId))
+        .first->first();
+  }
+
+  /// Returns the identifier of the module \p Path.
+  uint64_t getModuleId(StringRef Path) const {
+    return ModulePathStringTable.lookup(Path);
+  }
+
+  /// Moves the summaries of \p Other into this index. The modules of \p Other
+  /// are given identifiers starting at \p NextModuleId.
+  void mergeFrom(std::unique_ptr<FunctionInfoIndex> Other,
+                 uint64_t NextModuleId);
+};
+
+} // End llvm namespace
+
+#endif
@@ -0,0 +1,79 @@
+//===-- llvm/IR/IRMemoryUsage.h - Memory used by the IR ---------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the IRMemoryUsage class, which accounts for the memory
+// used by the IR of modules, by kind of IR entity.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_IRMEMORYUSAGE_H
+#define LLVM_IR_IRMEMORYUSAGE_H
+
+#include "llvm/Support/DataTypes.h"
+
+namespace llvm {
+
+class Instruction;
+class Module;
+class Value;
+class raw_ostream;
+
+/// IRMemoryUsage - Estimate the number of bytes allocated for the IR of
+/// modules, by kind of IR entity.
+///
+/// The sizes are computed from the layout of the IR classes, so they don't
+/// include the overhead of the allocator. Hash tables are counted by their
+/// entries, without their empty buckets. Constants, types and metadata nodes
+/// are owned by the LLVMContext and shared between modules, so they aren't
+/// counted.
+class IRMemoryUsage {
+public:
+  enum EntityKind {
+    GlobalVariables,
+    GlobalAliases,
+    Functions,
+    Arguments,
+    BasicBlocks,
+    Instructions,
+    Operands,            ///< The Uses of the instructions.
+    ValueNames,          ///< Names and their symbol table entries.
+    MetadataAttachments, ///< Attachments other than !dbg.
+    NumEntityKinds
+  };
+
+private:
+  uint64_t Counts[NumEntityKinds];
+  uint64_t Bytes[NumEntityKinds];
+
+  void add(EntityKind Kind, uint64_t Count, uint64_t Size) {
+    Counts[Kind] += Count;
+    Bytes[Kind] += Size;
+  }
+  void addName(const Value &V);
+  void addInstruction(const Instruction &I);
+
+public:
+  IRMemoryUsage();
+
+  /// Account for the IR of \p M.
+  void addModule(const Module &M);
+
+  uint64_t getCount(EntityKind Kind) const { return Counts[Kind]; }
+  uint64_t getBytes(EntityKind Kind) const { return Bytes[Kind]; }
+  uint64_t getTotalBytes() const;
+
+  static const char *getEntityKindName(EntityKind Kind);
+
+  /// Print a report of the memory usage in the style of -stats.
+  void print(raw_ostream &OS) const;
+};
+
+} // End llvm namespace
+
+#endif
@@ -158,6 +158,17 @@ public:
   /// any global mutex or cannot block the execution in another LLVM context.
   void yield();
 
+  /// \brief Return true if the names of the values other than GlobalValues
+  /// are dropped.
+  bool shouldDiscardValueNames() const;
+
+  /// \brief Set whether the names of the values other than GlobalValues are
+  /// dropped. Names are only needed to make the IR readable, so clients that
+  /// never print it can save the memory used by the names of instructions,
+  /// arguments and basic blocks. Names that were set before this is enabled are
+  /// kept.
+  void setDiscardValueNames(bool Discard);
+
   /// emitError - Emit an error message to the currently installed error handler
   /// with optional location information.  This function returns, so code should
   /// be prepared to drop the erroneous construct on the floor and "not crash".
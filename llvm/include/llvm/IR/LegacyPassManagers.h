@@ -474,6 +474,28 @@ public:
 
 Timer *getPassTimer(Pass *);
 
+/// PassTraceRegion - If -pass-trace is enabled, this records the execution of a
+/// pass on an IR unit as one entry of the trace: the time it took, and how the
+/// heap usage changed meanwhile. Regions for passes run by other passes (such
+/// as the passes of a loop pass manager) are nested in the enclosing one.
+class PassTraceRegion {
+  PassTraceRegion *Parent;
+  Pass *P;
+  std::string Unit;
+  unsigned Depth;
+  double StartWall, StartUser, StartSystem;
+  size_t StartHeap, PeakHeap;
+  bool Active;
+
+  static void updateHeapPeaks(size_t Heap);
+
+public:
+  /// Start recording pass P running on Unit, which names the function (or the
+  /// module, for module passes) being processed.
+  PassTraceRegion(Pass *P, StringRef Unit);
+  ~PassTraceRegion();
+};
+
 }
 
 #endif
@@ -15,6 +15,7 @@
 #ifndef LLVM_IR_MODULE_H
 #define LLVM_IR_MODULE_H
 
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/IR/Comdat.h"
 #include "llvm/IR/DataLayout.h"
@@ -673,6 +674,18 @@ public:
   /// \brief Set the PIC level (small or large model)
   void setPICLevel(PICLevel::Level PL);
 /// @}
+
+/// @name Utility functions for querying and setting profile data
+/// @{
+
+  /// \brief Set the largest function entry count of the profile data the
+  /// module is compiled with.
+  void setMaximumFunctionCount(uint64_t Count);
+
+  /// \brief Returns the largest function entry count of the profile data, if
+  /// the module is compiled with any.
+  Optional<uint64_t> getMaximumFunctionCount() const;
+/// @}
 };
 
 /// An raw_ostream inserter for modules.
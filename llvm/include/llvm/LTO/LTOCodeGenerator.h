@@ -80,6 +80,27 @@ struct LTOCodeGenerator {
 
   void addMustPreserveSymbol(const char *sym) { MustPreserveSymbols[sym] = 1; }
 
+  // Set the directory in which compile_to_file(), compile() and
+  // compileOptimizedToFiles() cache the object files they generate. The files
+  // are keyed by a hash of the merged module and of the code generation
+  // options, so that relinking unchanged inputs reuses them instead of
+  // optimizing and compiling the module again. An empty path disables the
+  // cache.
+  void setCacheDir(const char *dir) { CacheDir = dir; }
+
+  // Set the pruning policy of the cache directory, see CachePruning. The
+  // cache is pruned at most once per interval (in seconds), removing the
+  // files unused for longer than the expiration (in seconds), then the least
+  // recently used files until it is no larger than the maximum size (in
+  // bytes). A value of 0 disables the corresponding policy.
+  void setCachePruningInterval(int interval) {
+    CachePruningInterval = interval;
+  }
+  void setCacheEntryExpiration(unsigned expiration) {
+    CacheEntryExpiration = expiration;
+  }
+  void setCacheMaxSize(uint64_t maxSize) { CacheMaxSize = maxSize; }
+
   // To pass options to the driver and optimization passes. These options are
   // not necessarily for debugging purpose (The function name is misleading).
   // This function should be called before LTOCodeGenerator::compilexxx(),
@@ -130,6 +151,22 @@ struct LTOCodeGenerator {
   // if the compilation was not successful.
   const void *compileOptimized(size_t *length, std::string &errMsg);
 
+  // Compiles the merged optimized module into one object file per stream in
+  // Out. If Out has more than one element, the module is split into that many
+  // partitions which are code generated in parallel (see splitCodeGen()), and
+  // the merged module cannot be compiled again afterwards. The linker must
+  // link all of the resulting object files. Return true on success.
+  bool compileOptimized(ArrayRef<raw_ostream *> Out, std::string &errMsg);
+
+  // As with compileOptimized(ArrayRef<raw_ostream *>), this function compiles
+  // the merged optimized module into Parallelism object files in parallel. An
+  // array of the Parallelism paths to the object files is returned to the
+  // caller via argument "names". Return true on success.
+  //
+  // NOTE that it is up to the linker to remove the intermediate object files.
+  bool compileOptimizedToFiles(unsigned Parallelism, const char ***names,
+                               std::string &errMsg);
+
   void setDiagnosticHandler(lto_diagnostic_handler_t, void *);
 
   LLVMContext &getContext() { return Context; }
@@ -137,8 +174,12 @@ struct LTOCodeGenerator {
 private:
   void initializeLTOPasses();
 
-  bool compileOptimized(raw_ostream &out, std::string &errMsg);
   bool compileOptimizedToFile(const char **name, std::string &errMsg);
+  const void *readNativeObjectFile(size_t *length, std::string &errMsg);
+  std::string computeCacheKey(StringRef Pipeline);
+  bool loadFromCache(StringRef Key, unsigned NumFiles,
+                     std::vector<std::string> &Filenames);
+  void storeInCache(StringRef Key, ArrayRef<std::string> Filenames);
   void applyScopeRestrictions();
   void applyRestriction(GlobalValue &GV, ArrayRef<StringRef> Libcalls,
                         std::vector<const char *> &MustPreserveList,
@@ -168,11 +209,17 @@ private:
   std::string MCpu;
   std::string MAttr;
   std::string NativeObjectPath;
+  std::vector<std::string> NativeObjectPaths;
+  std::vector<const char *> NativeObjectPathNames;
   TargetOptions Options;
   unsigned OptLevel;
   lto_diagnostic_handler_t DiagHandler;
   void *DiagContext;
   LTOModule *OwnedModule;
+  std::string CacheDir;
+  int CachePruningInterval;
+  unsigned CacheEntryExpiration;
+  uint64_t CacheMaxSize;
 };
 }
 #endif
@@ -27,6 +27,7 @@
 
 // Forward references to llvm classes.
 namespace llvm {
+  struct BitcodeSymbolTable;
   class Function;
   class GlobalValue;
   class MemoryBuffer;
@@ -47,7 +48,10 @@ private:
 
   std::unique_ptr<LLVMContext> OwnedContext;
 
+  /// The module, which is not read when the symbols are listed from the
+  /// symbol table of the bitcode file.
   std::unique_ptr<object::IRObjectFile> IRFile;
+  std::string SymtabTargetTriple;
   std::unique_ptr<TargetMachine> _target;
   StringSet<>                             _linkeropt_strings;
   std::vector<const char *>               _deplibs;
@@ -111,16 +115,23 @@ public:
     return const_cast<LTOModule*>(this)->getModule();
   }
   Module &getModule() {
+    assert(IRFile && "Module created from a symbol table");
     return IRFile->getModule();
   }
 
   /// Return the Module's target triple.
   const std::string &getTargetTriple() {
+    if (!IRFile)
+      return SymtabTargetTriple;
     return getModule().getTargetTriple();
   }
 
   /// Set the Module's target triple.
   void setTargetTriple(StringRef Triple) {
+    if (!IRFile) {
+      SymtabTargetTriple = Triple;
+      return;
+    }
     getModule().setTargetTriple(Triple);
   }
 
@@ -176,17 +187,31 @@ private:
   // FIXME: it only parses "Linker Options" metadata at the moment
   void parseMetadata();
 
+  /// Add a linker option, or a dependent library if the option is one.
+  void addLinkerOpt(StringRef Opt);
+
   /// Parse the symbols from the module and model-level ASM and add them to
   /// either the defined or undefined lists.
   bool parseSymbols(std::string &errMsg);
 
+  /// Add the symbols and linker options of a bitcode symbol table, in place of
+  /// parseSymbols() and parseMetadata().
+  void parseSymbolTable(const BitcodeSymbolTable &Symtab);
+
+  /// Make symbols for the undefined symbols that have no definition.
+  void addUndefinedSymbols();
+
   /// Add a symbol which isn't defined just yet to a list to be resolved later.
   void addPotentialUndefinedSymbol(const object::BasicSymbolRef &Sym,
                                    bool isFunc);
+  void addPotentialUndefinedSymbol(StringRef Name, bool isExternalWeak,
+                                   bool isFunc, const GlobalValue *decl);
 
   /// Add a defined symbol to the list.
   void addDefinedSymbol(const char *Name, const GlobalValue *def,
                         bool isFunction);
+  void addDefinedSymbol(const char *Name, uint32_t attr,
+                        const GlobalValue *def, bool isFunction);
 
   /// Add a data symbol as defined to the list.
   void addDefinedDataSymbol(const object::BasicSymbolRef &Sym);
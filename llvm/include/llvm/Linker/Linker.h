@@ -60,6 +60,15 @@ public:
     bool hasType(StructType *Ty);
   };
 
+  enum Flags {
+    None = 0,
+    /// Link in the linkonce and available_externally definitions of the
+    /// source even if nothing refers to them yet. This is needed when the
+    /// composite is itself going to be linked into another module, where they
+    /// may be referenced.
+    LinkAllLinkOnce = (1 << 0)
+  };
+
   Linker(Module *M, DiagnosticHandlerFunction DiagnosticHandler);
   Linker(Module *M);
   ~Linker();
@@ -68,8 +77,9 @@ public:
   void deleteModule();
 
   /// \brief Link \p Src into the composite. The source is destroyed.
+  /// \p Flags is a combination of Linker::Flags.
   /// Returns true on error.
-  bool linkInModule(Module *Src);
+  bool linkInModule(Module *Src, unsigned Flags = None);
 
   /// \brief Set the composite to the passed-in module.
   void setModule(Module *Dst);
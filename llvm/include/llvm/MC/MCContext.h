@@ -20,6 +20,7 @@
 #include "llvm/MC/SectionKind.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/Compiler.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/raw_ostream.h"
 #include <map>
 #include <tuple>
@@ -159,6 +160,11 @@ namespace llvm {
     /// Darwin).
     bool AllowTemporaryLabels;
 
+    /// Whether symbols may be created and looked up from several threads at
+    /// once, in which case SymbolMutex guards the symbol tables.
+    bool ThreadSafeSymbols;
+    mutable sys::SmartMutex<true> SymbolMutex;
+
     /// The Compile Unit ID that we are currently processing.
     unsigned DwarfCompileUnitID;
 
@@ -225,6 +231,11 @@ namespace llvm {
 
     void setAllowTemporaryLabels(bool Value) { AllowTemporaryLabels = Value; }
 
+    /// Make the symbol functions below safe to call from several threads at
+    /// once.  Note that the names of temporary symbols then depend on the
+    /// order in which the threads happen to create them.
+    void setThreadSafeSymbols(bool Value) { ThreadSafeSymbols = Value; }
+
     /// @name Module Lifetime Management
     /// @{
 
@@ -0,0 +1,56 @@
+//===- IRSymtabFile.h - LLVM IR symbol table file ---------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the IRSymtabFile class, which lists the symbols of a
+// bitcode file from its symbol table, without reading the module.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OBJECT_IRSYMTABFILE_H
+#define LLVM_OBJECT_IRSYMTABFILE_H
+
+#include "llvm/Bitcode/BitcodeSymbolTable.h"
+#include "llvm/Object/SymbolicFile.h"
+
+namespace llvm {
+namespace object {
+
+class IRSymtabFile : public SymbolicFile {
+  std::unique_ptr<BitcodeSymbolTable> Symtab;
+
+public:
+  IRSymtabFile(MemoryBufferRef Object,
+               std::unique_ptr<BitcodeSymbolTable> Symtab);
+  ~IRSymtabFile();
+  void moveSymbolNext(DataRefImpl &Symb) const override;
+  std::error_code printSymbolName(raw_ostream &OS,
+                                  DataRefImpl Symb) const override;
+  uint32_t getSymbolFlags(DataRefImpl Symb) const override;
+  basic_symbol_iterator symbol_begin_impl() const override;
+  basic_symbol_iterator symbol_end_impl() const override;
+
+  const BitcodeSymbolTable &getSymbolTable() const { return *Symtab; }
+  const BitcodeSymbolTable::Symbol &getSymbol(DataRefImpl Symb) const {
+    return Symtab->Symbols[Symb.p];
+  }
+
+  static inline bool classof(const Binary *v) {
+    return v->isIRSymtab();
+  }
+
+  /// \brief Reads the symbol table of the bitcode in the given memory buffer
+  /// (which may be either a bitcode file or a native object file with
+  /// embedded bitcode). Returns null if the bitcode has no symbol table.
+  static ErrorOr<std::unique_ptr<IRSymtabFile>> create(MemoryBufferRef Object,
+                                                       LLVMContext &Context);
+};
+}
+}
+
+#endif
@@ -0,0 +1,86 @@
+//===- ParallelFunctionPassAdaptor.h - Run function passes on threads -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+///
+/// This file defines a module pass that runs a function pass pipeline over
+/// the functions of a module on several threads.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_PASSES_PARALLELFUNCTIONPASSADAPTOR_H
+#define LLVM_PASSES_PARALLELFUNCTIONPASSADAPTOR_H
+
+#include "llvm/IR/PassManager.h"
+#include <functional>
+
+namespace llvm {
+class TargetMachine;
+
+/// \brief A module pass that runs a function pass pipeline over every function
+/// of the module, several functions at a time.
+///
+/// An LLVMContext, and everything allocated in it, must only be touched by one
+/// thread at a time, so the functions can't simply be optimized in place. The
+/// module is instead split into one partition per thread (see SplitModule).
+/// Each partition is serialized to bitcode, read into a fresh LLVMContext and
+/// optimized on its own thread. The optimized function bodies are then linked
+/// back into the module, one partition after the other. The output is
+/// deterministic for a given module and number of threads, and the functions
+/// keep their linkage, names and order. A function pass only sees the
+/// partition of the function it runs on, where the globals and aliases of
+/// other partitions are declarations, so it may optimize a little less than
+/// it would on the whole module.
+///
+/// The pipeline can't be copied from one context to another, so every thread
+/// builds its own by calling a callback with its private pass and analysis
+/// managers. The callback must only touch state that is safe to share between
+/// threads.
+///
+/// The pipeline runs on the calling thread, directly on the module, when
+/// there is a single thread, when LLVM is built without thread support, or
+/// when the module has something that doesn't survive the split: debug
+/// information, whose distinct nodes would be duplicated, or a block address,
+/// which would be lost when the function bodies are replaced.
+class ParallelModuleToFunctionPassAdaptor {
+public:
+  /// \brief The type of the callback that builds a thread's pipeline into
+  /// \p FPM, and registers the analyses it needs with \p FAM and \p MAM. It
+  /// returns false if the pipeline can't be built.
+  typedef std::function<bool(FunctionPassManager &FPM,
+                             FunctionAnalysisManager &FAM,
+                             ModuleAnalysisManager &MAM)>
+      PipelineCallbackT;
+
+  /// \brief Run the pipeline built by \p BuildPipeline on \p NumThreads
+  /// threads, or on hardware_concurrency() threads if it is zero. If the
+  /// pipeline queries \p TM, pass it so that its subtargets are created on
+  /// the calling thread, before any other thread reads them.
+  ParallelModuleToFunctionPassAdaptor(PipelineCallbackT BuildPipeline,
+                                      unsigned NumThreads = 0,
+                                      TargetMachine *TM = nullptr)
+      : BuildPipeline(std::move(BuildPipeline)), NumThreads(NumThreads),
+        TM(TM) {}
+
+  /// \brief Runs the function pipeline across every function in the module.
+  ///
+  /// The function analyses of the module's analysis manager are not kept up
+  /// to date along the way, so none of the analyses are preserved.
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager *AM);
+
+  static StringRef name() { return "ParallelModuleToFunctionPassAdaptor"; }
+
+private:
+  PipelineCallbackT BuildPipeline;
+  unsigned NumThreads;
+  TargetMachine *TM;
+};
+
+}
+
+#endif
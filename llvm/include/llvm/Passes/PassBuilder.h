@@ -84,6 +84,10 @@ public:
   /// the sequence of passes aren't all the exact same kind of pass, it will be
   /// an error. You cannot mix different levels implicitly, you must explicitly
   /// form a pass manager in which to nest passes.
+  ///
+  /// A module pass manager may also nest 'parallel-function(...)', which runs
+  /// its function passes like 'function(...)' does, but on several threads
+  /// (see \c ParallelModuleToFunctionPassAdaptor).
   bool parsePassPipeline(ModulePassManager &MPM, StringRef PipelineText,
                          bool VerifyEachPass = true, bool DebugLogging = false);
 
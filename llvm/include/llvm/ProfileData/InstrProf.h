@@ -16,9 +16,18 @@
 #ifndef LLVM_PROFILEDATA_INSTRPROF_H_
 #define LLVM_PROFILEDATA_INSTRPROF_H_
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+#include <string>
 #include <system_error>
+#include <vector>
 
 namespace llvm {
+class Function;
+class Instruction;
+
 const std::error_category &instrprof_category();
 
 enum class instrprof_error {
@@ -34,13 +43,75 @@ enum class instrprof_error {
     unknown_function,
     hash_mismatch,
     count_mismatch,
-    counter_overflow
+    counter_overflow,
+    value_site_count_mismatch
 };
 
 inline std::error_code make_error_code(instrprof_error E) {
   return std::error_code(static_cast<int>(E), instrprof_category());
 }
 
+/// The kinds of values recorded at the value profiling sites of a function.
+/// The numbering is part of the raw and indexed profile formats.
+enum InstrProfValueKind : uint32_t {
+  IPVK_IndirectCallTarget = 0,
+  IPVK_MemOPSize = 1,
+  IPVK_First = IPVK_IndirectCallTarget,
+  IPVK_Last = IPVK_MemOPSize
+};
+
+/// A value seen at a value profiling site, and how many times it was seen.
+/// The targets of indirect calls are identified by the hash of their names,
+/// see getInstrProfNameHash.
+struct InstrProfValueData {
+  uint64_t Value;
+  uint64_t Count;
+};
+
+/// The values recorded at one value profiling site.
+struct InstrProfValueSiteRecord {
+  std::vector<InstrProfValueData> ValueData;
+
+  InstrProfValueSiteRecord() {}
+  InstrProfValueSiteRecord(std::vector<InstrProfValueData> ValueData)
+      : ValueData(std::move(ValueData)) {}
+
+  /// Sort the values by decreasing count, then by value.
+  void sortByCount();
+  /// Add the counts of \c Input to this site.  The counts of equal values
+  /// are summed.
+  instrprof_error merge(const InstrProfValueSiteRecord &Input);
+  /// Return the sum of the counts of the site.
+  uint64_t getTotalCount() const;
+};
+
+/// Return the hash identifying the function called \c Name in value
+/// profiles.  This is the hash the indexed profile uses for its keys.
+uint64_t getInstrProfNameHash(StringRef Name);
+
+/// Return the name of \c F in instrumentation profiles.  As in the frontend,
+/// functions with local linkage are prefixed by the main file name, taken
+/// here from the module identifier.
+std::string getPGOFuncName(const Function &F);
+
+/// Attach the values recorded at a value profiling site to \c Inst, as
+/// !prof metadata of the form
+///   !{!"VP", i32 Kind, i64 TotalCount, i64 Value1, i64 Count1, ...}
+/// Only the \c MaxMDCount most frequent values are kept.
+void annotateValueSite(Instruction &Inst, const InstrProfValueSiteRecord &Site,
+                       InstrProfValueKind Kind, uint32_t MaxMDCount = 3);
+/// Same as above, with the values sorted by decreasing count and the total
+/// count of the site given.
+void annotateValueSite(Instruction &Inst, ArrayRef<InstrProfValueData> VDs,
+                       uint64_t TotalCount, InstrProfValueKind Kind,
+                       uint32_t MaxMDCount = 3);
+
+/// Read the value profile of kind \c Kind attached to \c Inst by
+/// annotateValueSite.  Returns false if there is none.
+bool getValueProfDataFromInst(const Instruction &Inst, InstrProfValueKind Kind,
+                              SmallVectorImpl<InstrProfValueData> &ValueData,
+                              uint64_t &TotalCount);
+
 } // end namespace llvm
 
 namespace std {
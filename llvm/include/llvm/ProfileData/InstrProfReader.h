@@ -16,6 +16,7 @@
 #define LLVM_PROFILEDATA_INSTRPROFREADER_H
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ProfileData/InstrProf.h"
 #include "llvm/Support/EndianStream.h"
@@ -37,6 +38,25 @@ struct InstrProfRecord {
   StringRef Name;
   uint64_t Hash;
   ArrayRef<uint64_t> Counts;
+  /// The value profiling sites of the function, for each kind of value.
+  std::vector<InstrProfValueSiteRecord> ValueSites[IPVK_Last + 1];
+
+  /// Return the number of value profiling sites of kind \c Kind.
+  uint32_t getNumValueSites(InstrProfValueKind Kind) const {
+    return ValueSites[Kind].size();
+  }
+  /// Return true if the record has any value profiling site.
+  bool hasValueSites() const {
+    for (const auto &Sites : ValueSites)
+      if (!Sites.empty())
+        return true;
+    return false;
+  }
+  /// Drop the value profiling sites.
+  void clearValueSites() {
+    for (auto &Sites : ValueSites)
+      Sites.clear();
+  }
 };
 
 /// A file format agnostic iterator over profiling data.
@@ -107,7 +127,11 @@ public:
 /// new lines.
 ///
 /// Each record consists of a function name, a function hash, a number of
-/// counters, and then each counter value, in that order.
+/// counters, and then each counter value, in that order.  It may be followed
+/// by value profile data: the number of value kinds, and for each of them the
+/// kind, the number of sites, and for each site the number of values followed
+/// by one "value:count" line per value.  The values of indirect call targets
+/// are function names.
 class TextInstrProfReader : public InstrProfReader {
 private:
   /// The profile data file contents.
@@ -127,6 +151,9 @@ public:
   std::error_code readHeader() override { return success(); }
   /// Read a single record.
   std::error_code readNextRecord(InstrProfRecord &Record) override;
+
+private:
+  std::error_code readValueProfileData(InstrProfRecord &Record);
 };
 
 /// Reader for the raw instrprof binary format from runtime.
@@ -150,6 +177,14 @@ private:
     const IntPtrT NamePtr;
     const IntPtrT CounterPtr;
   };
+  /// Version 2 adds the address of the function, used to identify it in
+  /// value profiles, and the number of value sites of each kind.
+  struct ProfileDataV2 {
+    const ProfileData Common;
+    const IntPtrT FunctionPointer;
+    const IntPtrT Values;
+    const uint16_t NumValueSites[IPVK_Last + 1];
+  };
   struct RawHeader {
     const uint64_t Magic;
     const uint64_t Version;
@@ -159,15 +194,28 @@ private:
     const uint64_t CountersDelta;
     const uint64_t NamesDelta;
   };
+  /// Version 2 adds the size of the value profile data, which follows the
+  /// names.
+  struct RawHeaderV2 {
+    const RawHeader Common;
+    const uint64_t ValueDataSize;
+  };
 
   bool ShouldSwapBytes;
+  uint64_t Version;
   uint64_t CountersDelta;
   uint64_t NamesDelta;
-  const ProfileData *Data;
-  const ProfileData *DataEnd;
+  /// The profile data records, whose size depends on the version.
+  const char *Data;
+  const char *DataEnd;
+  size_t DataRecordSize;
   const uint64_t *CountersStart;
   const char *NamesStart;
+  const uint64_t *ValueDataCur;
+  const uint64_t *ValueDataEnd;
   const char *ProfileEnd;
+  /// The name hashes of the functions of the current profile, by address.
+  DenseMap<uint64_t, uint64_t> FunctionNameHashes;
 
   RawInstrProfReader(const RawInstrProfReader &) = delete;
   RawInstrProfReader &operator=(const RawInstrProfReader &) = delete;
@@ -182,6 +230,8 @@ public:
 private:
   std::error_code readNextHeader(const char *CurrentPos);
   std::error_code readHeader(const RawHeader &Header);
+  std::error_code readValueProfileData(const ProfileDataV2 &Data,
+                                       InstrProfRecord &Record);
   template <class IntT>
   IntT swap(IntT Int) const {
     return ShouldSwapBytes ? sys::getSwappedBytes(Int) : Int;
@@ -288,9 +338,21 @@ public:
   /// Read a single record.
   std::error_code readNextRecord(InstrProfRecord &Record) override;
 
+private:
+  /// Read the record of the function hash at Data[Offset] into Record, and
+  /// move Offset past it.
+  std::error_code readRecordAt(ArrayRef<uint64_t> Data, size_t &Offset,
+                               InstrProfRecord &Record);
+
+public:
   /// Fill Counts with the profile data for the given function name.
   std::error_code getFunctionCounts(StringRef FuncName, uint64_t FuncHash,
                                     std::vector<uint64_t> &Counts);
+  /// Fill Record with the profile data, counters and value sites, for the
+  /// given function name.  The counters of Record refer to storage that is
+  /// only valid until the next call.
+  std::error_code getFunctionRecord(StringRef FuncName, uint64_t FuncHash,
+                                    InstrProfRecord &Record);
   /// Return the maximum of all known function counts.
   uint64_t getMaximumFunctionCount() { return MaxFunctionCount; }
 
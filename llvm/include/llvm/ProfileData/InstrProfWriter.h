@@ -19,6 +19,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ProfileData/InstrProf.h"
+#include "llvm/ProfileData/InstrProfReader.h"
 #include "llvm/Support/DataTypes.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
@@ -29,7 +30,12 @@ namespace llvm {
 /// Writer for instrumentation based profile data.
 class InstrProfWriter {
 public:
-  typedef SmallDenseMap<uint64_t, std::vector<uint64_t>, 1> CounterData;
+  /// The counters and value sites of a function with a given hash.
+  struct FunctionRecord {
+    std::vector<uint64_t> Counts;
+    std::vector<InstrProfValueSiteRecord> ValueSites[IPVK_Last + 1];
+  };
+  typedef SmallDenseMap<uint64_t, FunctionRecord, 1> CounterData;
 private:
   StringMap<CounterData> FunctionData;
   uint64_t MaxFunctionCount;
@@ -42,6 +48,10 @@ public:
   std::error_code addFunctionCounts(StringRef FunctionName,
                                     uint64_t FunctionHash,
                                     ArrayRef<uint64_t> Counters);
+  /// Add the counts and value sites of a record.  The value sites of records
+  /// with the same name and hash are merged site by site, and must agree on
+  /// the number of sites.
+  std::error_code addRecord(const InstrProfRecord &Record);
   /// Write the profile to \c OS
   void write(raw_fd_ostream &OS);
   /// Write the profile, returning the raw data. For testing.
@@ -0,0 +1,71 @@
+//=- CachePruning.h - Helper to manage the pruning of a cache dir -*- C++ -*-=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements pruning of a directory intended for cache storage, using
+// various policies.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_CACHE_PRUNING_H
+#define LLVM_SUPPORT_CACHE_PRUNING_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+#include <string>
+
+namespace llvm {
+
+/// Handle pruning a directory provided by the user, using various policies.
+///
+/// Only the files whose name starts with "llvm-" are considered part of the
+/// cache; other files in the directory are left alone.
+class CachePruning {
+public:
+  /// Prepare to prune \p Path.
+  CachePruning(StringRef Path) : Path(Path) {}
+
+  /// Define the pruning interval, in seconds. This is intended to avoid
+  /// scanning the directory too often. It does not impact the decision of
+  /// which files to prune. A value of 0 forces the scan to occur.
+  CachePruning &setPruningInterval(int PruningInterval) {
+    Interval = PruningInterval;
+    return *this;
+  }
+
+  /// Define the expiration for a file, in seconds. When a file hasn't been
+  /// used for \p ExpireAfter seconds, it is removed from the cache. A value
+  /// of 0 disables the expiration-based pruning.
+  CachePruning &setEntryExpiration(unsigned ExpireAfter) {
+    Expiration = ExpireAfter;
+    return *this;
+  }
+
+  /// Define the maximum size of the cache, in bytes. When the cache is larger,
+  /// the least recently used files are removed until it fits. A value of 0
+  /// disables the size-based pruning.
+  CachePruning &setMaxSize(uint64_t MaxSizeInBytes) {
+    MaxSize = MaxSizeInBytes;
+    return *this;
+  }
+
+  /// Perform pruning using the supplied options. Returns true if pruning
+  /// occurred, i.e. if the pruning interval had expired.
+  bool prune();
+
+private:
+  std::string Path;
+  // Options that match the setters above.
+  unsigned Expiration = 0;
+  int Interval = 0;
+  uint64_t MaxSize = 0;
+};
+
+} // namespace llvm
+
+#endif
@@ -0,0 +1,172 @@
+//===- llvm/Support/Parallel.h - Parallel algorithms ------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines parallel versions of common algorithms. They run on the
+// default ThreadPool (see getDefaultThreadPool()) and may be nested: an
+// algorithm called from inside a task helps running the queued tasks instead
+// of blocking a worker thread.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_PARALLEL_H
+#define LLVM_SUPPORT_PARALLEL_H
+
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/ThreadPool.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+namespace llvm {
+
+namespace detail {
+/// Inputs smaller than this are sorted sequentially.
+const ptrdiff_t MinParallelSortSize = 1024;
+
+/// The most tasks a parallel algorithm splits its input into, per thread of
+/// the default pool. More tasks than threads evens out the load when the cost
+/// of the elements varies.
+const unsigned MaxTasksPerThread = 16;
+
+/// Returns the number of elements each task of a parallel algorithm over
+/// \p NumElements elements should process.
+inline size_t getParallelTaskSize(size_t NumElements) {
+  size_t MaxTasks =
+      size_t(getDefaultThreadPool().getThreadCount()) * MaxTasksPerThread;
+  return std::max<size_t>(1, (NumElements + MaxTasks - 1) / MaxTasks);
+}
+
+/// Inclusive median.
+template <class RandomAccessIterator, class Comparator>
+RandomAccessIterator medianOf3(RandomAccessIterator Start,
+                               RandomAccessIterator End,
+                               const Comparator &Comp) {
+  RandomAccessIterator Mid = Start + (std::distance(Start, End) / 2);
+  return Comp(*Start, *(End - 1))
+             ? (Comp(*Mid, *(End - 1)) ? (Comp(*Start, *Mid) ? Mid : Start)
+                                       : End - 1)
+             : (Comp(*Mid, *Start) ? (Comp(*(End - 1), *Mid) ? Mid : End - 1)
+                                   : Start);
+}
+
+template <class RandomAccessIterator, class Comparator>
+void parallel_quick_sort(RandomAccessIterator Start, RandomAccessIterator End,
+                         const Comparator &Comp, TaskGroup &TG,
+                         size_t Depth) {
+  // Do a sequential sort for small inputs.
+  if (std::distance(Start, End) < MinParallelSortSize || Depth == 0) {
+    std::sort(Start, End, Comp);
+    return;
+  }
+
+  // Partition.
+  auto Pivot = medianOf3(Start, End, Comp);
+  // Move Pivot to End.
+  std::swap(*(End - 1), *Pivot);
+  Pivot = std::partition(Start, End - 1, [&Comp, End](decltype(*Start) V) {
+    return Comp(V, *(End - 1));
+  });
+  // Move Pivot to middle of partition.
+  std::swap(*Pivot, *(End - 1));
+
+  // Recurse.
+  TG.spawn([=, &Comp, &TG] {
+    parallel_quick_sort(Start, Pivot, Comp, TG, Depth - 1);
+  });
+  parallel_quick_sort(Pivot + 1, End, Comp, TG, Depth - 1);
+}
+} // End detail namespace
+
+/// Sorts [Start, End) with \p Comp, like std::sort. The sort is not stable.
+template <class RandomAccessIterator, class Comparator>
+void parallel_sort(RandomAccessIterator Start, RandomAccessIterator End,
+                   const Comparator &Comp) {
+  TaskGroup TG;
+  detail::parallel_quick_sort(Start, End, Comp, TG,
+                              Log2_64(std::distance(Start, End)) + 1);
+}
+
+template <class RandomAccessIterator>
+void parallel_sort(RandomAccessIterator Start, RandomAccessIterator End) {
+  parallel_sort(Start, End,
+                std::less<typename std::iterator_traits<
+                    RandomAccessIterator>::value_type>());
+}
+
+/// Calls \p Fn on every element of [Begin, End), like std::for_each. The
+/// calls are made concurrently and in no particular order.
+template <class IterTy, class FuncTy>
+void parallel_for_each(IterTy Begin, IterTy End, FuncTy Fn) {
+  size_t TaskSize = detail::getParallelTaskSize(std::distance(Begin, End));
+  TaskGroup TG;
+  while (TaskSize < size_t(std::distance(Begin, End))) {
+    TG.spawn([=, &Fn] { std::for_each(Begin, Begin + TaskSize, Fn); });
+    Begin += TaskSize;
+  }
+  std::for_each(Begin, End, Fn);
+}
+
+/// Calls \p Fn on every index of [Begin, End). The calls are made concurrently
+/// and in no particular order.
+template <class IndexTy, class FuncTy>
+void parallel_for_each_n(IndexTy Begin, IndexTy End, FuncTy Fn) {
+  size_t TaskSize = detail::getParallelTaskSize(End - Begin);
+  TaskGroup TG;
+  IndexTy I = Begin;
+  for (; I + TaskSize < End; I += TaskSize) {
+    TG.spawn([=, &Fn] {
+      for (IndexTy J = I, E = I + TaskSize; J != E; ++J)
+        Fn(J);
+    });
+  }
+  for (; I < End; ++I)
+    Fn(I);
+}
+
+/// Applies \p Transform to every element of [Begin, End) and combines the
+/// results with \p Reduce, starting from \p Init. \p Init must be an identity
+/// of \p Reduce, which must be associative, as the elements are transformed
+/// and reduced in chunks that are then reduced together. The chunks only
+/// depend on the size of the input and of the default pool, and are combined
+/// in order, so the result is deterministic for a given thread count even if
+/// \p Reduce is not commutative.
+template <class IterTy, class ResultTy, class ReduceFuncTy,
+          class TransformFuncTy>
+ResultTy parallel_transform_reduce(IterTy Begin, IterTy End, ResultTy Init,
+                                   ReduceFuncTy Reduce,
+                                   TransformFuncTy Transform) {
+  size_t NumElements = std::distance(Begin, End);
+  size_t TaskSize = detail::getParallelTaskSize(NumElements);
+  size_t NumTasks = NumElements == 0 ? 0 : (NumElements - 1) / TaskSize + 1;
+
+  std::vector<ResultTy> Results(NumTasks, Init);
+  {
+    TaskGroup TG;
+    for (size_t I = 0; I != NumTasks; ++I) {
+      IterTy TaskBegin = Begin + I * TaskSize;
+      IterTy TaskEnd = I + 1 == NumTasks ? End : TaskBegin + TaskSize;
+      ResultTy &Result = Results[I];
+      TG.spawn([=, &Reduce, &Transform, &Result] {
+        for (IterTy It = TaskBegin; It != TaskEnd; ++It)
+          Result = Reduce(Result, Transform(*It));
+      });
+    }
+  }
+
+  ResultTy FinalResult = std::move(Init);
+  for (ResultTy &PartialResult : Results)
+    FinalResult = Reduce(FinalResult, std::move(PartialResult));
+  return FinalResult;
+}
+
+} // End llvm namespace
+
+#endif // LLVM_SUPPORT_PARALLEL_H
@@ -0,0 +1,172 @@
+//===-- llvm/Support/ThreadPool.h - A ThreadPool implementation -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a crude C++11 based thread pool with work stealing, and
+// the TaskGroup class for waiting on a set of related tasks.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_THREADPOOL_H
+#define LLVM_SUPPORT_THREADPOOL_H
+
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Compiler.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+
+/// A ThreadPool for asynchronous parallel execution on a defined number of
+/// threads.
+///
+/// Each worker thread owns a queue of tasks. Tasks submitted from a worker
+/// thread go to the back of that worker's queue and are run in LIFO order by
+/// the owner, which keeps recursively spawned work local and cache friendly.
+/// A worker that runs out of tasks steals from the front of the other workers'
+/// queues. Tasks submitted from outside the pool are distributed round-robin.
+///
+/// The pool keeps a vector of threads alive for the whole lifetime of the pool.
+/// It is possible to reuse the pool as many times as needed.
+///
+/// When LLVM is built without thread support (LLVM_ENABLE_THREADS=0), the pool
+/// has no worker threads and every task is run synchronously by async().
+class ThreadPool {
+public:
+  typedef std::packaged_task<void()> PackagedTaskTy;
+
+  /// Construct a pool with the number of threads found by
+  /// hardware_concurrency().
+  ThreadPool();
+
+  /// Construct a pool of \p ThreadCount threads.
+  explicit ThreadPool(unsigned ThreadCount);
+
+  /// Blocking destructor: the pool will wait for all the threads to complete.
+  ~ThreadPool();
+
+  /// Asynchronous submission of a task to the pool. The returned future can be
+  /// used to wait for the task to finish and is *non-blocking* on destruction.
+  template <typename Function, typename... Args>
+  inline std::shared_future<void> async(Function &&F, Args &&... ArgList) {
+    auto Task =
+        std::bind(std::forward<Function>(F), std::forward<Args>(ArgList)...);
+    return asyncImpl(std::move(Task));
+  }
+
+  /// Asynchronous submission of a task to the pool. The returned future can be
+  /// used to wait for the task to finish and is *non-blocking* on destruction.
+  template <typename Function>
+  inline std::shared_future<void> async(Function &&F) {
+    return asyncImpl(std::forward<Function>(F));
+  }
+
+  /// Blocking wait for all the tasks submitted so far to complete, including
+  /// the tasks they spawn. Must not be called from one of the pool's threads.
+  void wait();
+
+  /// Run queued tasks on the calling thread until \p Done returns true. When
+  /// no task is available, sleep until one is submitted or until a task
+  /// completes. This lets a task wait for work it spawned without tying up a
+  /// worker thread, so it may be called from the pool's own threads.
+  void waitUntil(const std::function<bool()> &Done);
+
+  /// Returns the number of worker threads of the pool. This is 1 if LLVM is
+  /// built without thread support.
+  unsigned getThreadCount() const { return ThreadCount; }
+
+private:
+  struct TaskQueue {
+    std::mutex Lock;
+    std::deque<PackagedTaskTy> Tasks;
+  };
+
+  /// Asynchronous submission of a task to the pool. The returned future can be
+  /// used to wait for the task to finish and is *non-blocking* on destruction.
+  std::shared_future<void> asyncImpl(std::function<void()> F);
+
+  /// Pop a task for the thread owning queue \p Index, stealing from the other
+  /// queues if that one is empty. Returns false if every queue is empty.
+  bool popTask(unsigned Index, PackagedTaskTy &Task);
+
+  /// Run \p Task and account for its completion.
+  void runTask(PackagedTaskTy &Task);
+
+  /// Main loop of the worker thread owning queue \p Index.
+  void work(unsigned Index);
+
+  /// Returns the index of the queue owned by the calling thread, or the queue
+  /// a task submitted from a non-worker thread should go to.
+  unsigned getLocalQueueIndex();
+
+  unsigned ThreadCount;
+
+  /// One queue per worker thread.
+  std::vector<std::unique_ptr<TaskQueue>> Queues;
+
+  /// Threads in flight.
+  std::vector<std::thread> Threads;
+
+  /// Locking and signaling for sleeping threads. Signaled when a task is
+  /// queued and when a task completes.
+  std::mutex SleepLock;
+  std::condition_variable SleepCondition;
+
+  /// Number of tasks sitting in the queues.
+  std::atomic<unsigned> QueuedTasks;
+
+  /// Number of tasks queued or running. wait() returns when this reaches 0.
+  std::atomic<unsigned> ActiveTasks;
+
+  /// Queue index for the next task submitted from outside the pool.
+  std::atomic<unsigned> NextQueue;
+
+  /// Signal for the destruction of the pool, asking threads to exit.
+  bool EnableFlag;
+};
+
+/// Returns the thread pool shared by the parallel algorithms and by every
+/// TaskGroup that is not given an explicit pool.
+ThreadPool &getDefaultThreadPool();
+
+/// Allows launching a number of tasks and waiting for them to finish either
+/// explicitly via sync() or implicitly on destruction. Unlike
+/// ThreadPool::wait(), sync() only waits for the group's own tasks and can be
+/// used from inside a task, so groups nest: a task may create its own group and
+/// sync it. The waiting thread runs queued tasks while it waits.
+class TaskGroup {
+  ThreadPool &Pool;
+  std::atomic<unsigned> Pending;
+
+  TaskGroup(const TaskGroup &) = delete;
+  void operator=(const TaskGroup &) = delete;
+
+public:
+  TaskGroup();
+  explicit TaskGroup(ThreadPool &Pool);
+  ~TaskGroup();
+
+  /// Run \p F asynchronously as part of this group.
+  void spawn(std::function<void()> F);
+
+  /// Wait for all the tasks spawned in this group to complete.
+  void sync();
+};
+
+} // End llvm namespace
+
+#endif // LLVM_SUPPORT_THREADPOOL_H
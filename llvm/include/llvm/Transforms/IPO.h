@@ -19,6 +19,7 @@
 
 namespace llvm {
 
+class FunctionInfoIndex;
 class ModulePass;
 class Pass;
 class Function;
@@ -91,6 +92,17 @@ Pass *createFunctionInliningPass();
 Pass *createFunctionInliningPass(int Threshold);
 Pass *createFunctionInliningPass(unsigned OptLevel, unsigned SizeOptLevel);
 
+//===----------------------------------------------------------------------===//
+/// createPriorityInlinerPass - Return a new pass object that inlines the call
+/// sites of the whole module in the order of their estimated benefit, within
+/// a budget for the growth of the module.
+///
+/// The threshold of the cost analysis is computed from the given optimization
+/// and size optimization levels.
+ModulePass *createPriorityInlinerPass();
+ModulePass *createPriorityInlinerPass(unsigned OptLevel,
+                                      unsigned SizeOptLevel);
+
 //===----------------------------------------------------------------------===//
 /// createAlwaysInlinerPass - Return a new pass object that inlines only
 /// functions that are marked as "always_inline".
@@ -103,6 +115,14 @@ Pass *createAlwaysInlinerPass(bool InsertLifetime);
 ///
 Pass *createPruneEHPass();
 
+//===----------------------------------------------------------------------===//
+/// createFunctionImportPass - This pass imports the definitions of the
+/// functions called by the module from the other modules described in the
+/// function summary index \p Index, or in the index read from the file given
+/// with -summary-file if \p Index is null.
+///
+ModulePass *createFunctionImportPass(const FunctionInfoIndex *Index = nullptr);
+
 //===----------------------------------------------------------------------===//
 /// createInternalizePass - This pass loops over all of the functions in the
 /// input module, internalizing all globals (functions and variables) it can.
@@ -149,6 +169,13 @@ ModulePass *createIPConstantPropagationPass();
 ///
 ModulePass *createIPSCCPPass();
 
+//===----------------------------------------------------------------------===//
+/// createFunctionSpecializationPass - This pass clones functions for the
+/// constant arguments that their hot call sites pass, propagates the
+/// constants through the clones, and makes those call sites call the clones.
+///
+ModulePass *createFunctionSpecializationPass();
+
 //===----------------------------------------------------------------------===//
 //
 /// createLoopExtractorPass - This pass extracts all natural loops from the
@@ -189,6 +216,12 @@ ModulePass *createMergeFunctionsPass();
 ///
 ModulePass *createPartialInliningPass();
 
+//===----------------------------------------------------------------------===//
+/// createHotColdSplittingPass - This pass outlines the regions of functions
+/// the profile says are cold into separate functions.
+///
+ModulePass *createHotColdSplittingPass();
+
 //===----------------------------------------------------------------------===//
 // createMetaRenamerPass - Rename everything with metasyntatic names.
 //
@@ -0,0 +1,62 @@
+//===- llvm/Transforms/IPO/FunctionImport.h - ThinLTO importing -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the FunctionImporter class, which imports the definitions
+// of the functions a module calls from the other modules of a link, guided by
+// a combined function summary index (see FunctionInfo.h).
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_IPO_FUNCTIONIMPORT_H
+#define LLVM_TRANSFORMS_IPO_FUNCTIONIMPORT_H
+
+#include "llvm/ADT/StringRef.h"
+#include <functional>
+#include <memory>
+
+namespace llvm {
+class FunctionInfoIndex;
+class Module;
+
+/// The function importer is automatically importing function from other
+/// modules based on the provided summary informations.
+///
+/// Only the source modules that define a function to import are loaded, lazily,
+/// and only the bodies of the imported functions are materialized, so the
+/// memory used is proportional to the destination module plus its imports.
+/// Imported functions are given available_externally linkage: they are only
+/// there to be inlined or otherwise analyzed, and the defining module still
+/// emits them.
+class FunctionImporter {
+public:
+  /// Returns a lazily loaded module for the given path, in the context of the
+  /// destination module, or null on error.
+  typedef std::function<std::unique_ptr<Module>(StringRef Path)>
+      ModuleLoaderTy;
+
+  /// Create a Function Importer.
+  FunctionImporter(const FunctionInfoIndex &Index,
+                   ModuleLoaderTy ModuleLoader)
+      : Index(Index), ModuleLoader(ModuleLoader) {}
+
+  /// Import functions in Module \p M based on the summary informations.
+  /// Returns true if any function was imported.
+  bool importFunctions(Module &M);
+
+private:
+  /// The summaries index used to trigger importing.
+  const FunctionInfoIndex &Index;
+
+  /// Factory function to load a Module for a given identifier.
+  ModuleLoaderTy ModuleLoader;
+};
+
+} // End llvm namespace
+
+#endif // LLVM_TRANSFORMS_IPO_FUNCTIONIMPORT_H
@@ -80,6 +80,10 @@ struct InstrProfOptions {
 ModulePass *createInstrProfilingPass(
     const InstrProfOptions &Options = InstrProfOptions());
 
+/// Promote the hot targets of indirect calls with value profiles to direct
+/// calls.
+ModulePass *createPGOIndirectCallPromotionPass();
+
 // Insert AddressSanitizer (address sanity checking) instrumentation
 FunctionPass *createAddressSanitizerFunctionPass();
 ModulePass *createAddressSanitizerModulePass();
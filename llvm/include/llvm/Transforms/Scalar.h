@@ -344,6 +344,12 @@ FunctionPass *createMemCpyOptPass();
 //
 Pass *createLoopDeletionPass();
 
+//===----------------------------------------------------------------------===//
+//
+// LoopDistribute - Distribute loops.
+//
+FunctionPass *createLoopDistributePass();
+
 //===----------------------------------------------------------------------===//
 //
 // ConstantHoisting - This pass prepares a function for expensive constants.
@@ -0,0 +1,52 @@
+//===- SplitModule.h - Split a module into partitions -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the function llvm::SplitModule, which splits a module
+// into multiple linkable partitions. It can be used to implement parallel code
+// generation for link-time optimization.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_UTILS_SPLITMODULE_H
+#define LLVM_TRANSFORMS_UTILS_SPLITMODULE_H
+
+#include <functional>
+#include <memory>
+
+namespace llvm {
+
+class Module;
+
+/// Splits the module M into N linkable partitions. The function ModuleCallback
+/// is called N times passing each individual partition as the MPart argument.
+///
+/// The partitioning is a pure function of the module contents and N, so the
+/// same module split the same number of ways always produces the same
+/// partitions. Globals in the same comdat, aliases and their aliasees, and
+/// functions whose block addresses are taken together with the users of those
+/// addresses are always placed in the same partition.
+///
+/// FIXME: This function does not deal with the somewhat subtle symbol
+/// visibility issues around module splitting, including (but not limited to):
+///
+/// - Internal symbols should not collide with symbols defined outside the
+///   module.
+/// - Internal symbols defined in module-level inline asm should be visible to
+///   each partition.
+///
+/// To allow the partitions to reference each other's symbols, M is modified in
+/// place: local symbols are given hidden external linkage and unnamed globals
+/// are given names. M should not be used for code generation afterwards.
+void SplitModule(Module &M, unsigned N,
+                 std::function<void(std::unique_ptr<Module> MPart)>
+                     ModuleCallback);
+
+} // End llvm namespace
+
+#endif
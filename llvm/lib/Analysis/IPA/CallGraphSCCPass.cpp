@@ -108,6 +108,15 @@ private:
 char CGPassManager::ID = 0;
 
 
+/// getSCCName - Return the name of a function of the SCC, which identifies
+/// the SCC in the pass trace.
+static StringRef getSCCName(CallGraphSCC &SCC) {
+  for (CallGraphNode *CGN : SCC)
+    if (Function *F = CGN->getFunction())
+      return F->getName();
+  return "<external node>";
+}
+
 bool CGPassManager::RunPassOnSCC(Pass *P, CallGraphSCC &CurSCC,
                                  CallGraph &CG, bool &CallGraphUpToDate,
                                  bool &DevirtualizedCall) {
@@ -123,6 +132,7 @@ bool CGPassManager::RunPassOnSCC(Pass *P, CallGraphSCC &CurSCC,
 
     {
       TimeRegion PassTimer(getPassTimer(CGSP));
+      PassTraceRegion Trace(CGSP, getSCCName(CurSCC));
       Changed = CGSP->runOnSCC(CurSCC);
     }
     
@@ -0,0 +1,882 @@
+//===-- MemorySSA.cpp - Memory SSA Builder --------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the MemorySSA class, which builds memory SSA for a
+// function, and the walkers answering clobber queries on it.
+//
+// The construction is the classic one: a MemoryPhi is placed in the iterated
+// dominance frontier of the blocks holding MemoryDefs, and a walk of the
+// dominator tree links each access to the version of memory reaching it.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/IR/AssemblyAnnotationWriter.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <climits>
+#include <queue>
+using namespace llvm;
+
+#define DEBUG_TYPE "memoryssa"
+
+STATISTIC(NumClobberCacheLookups, "Number of Memory SSA version cache lookups");
+STATISTIC(NumClobberCacheHits, "Number of Memory SSA version cache hits");
+STATISTIC(NumClobberCacheInserts, "Number of MemorySSA version cache inserts");
+
+static cl::opt<bool>
+VerifyMemorySSA("verify-memoryssa", cl::init(false), cl::Hidden,
+                cl::desc("Verify Memory SSA after building it and in the "
+                         "passes that preserve it"));
+
+static cl::opt<unsigned>
+WalkLimit("memoryssa-walk-limit", cl::init(1000), cl::Hidden,
+          cl::desc("The number of accesses a clobber query may look at "
+                   "before giving up (default = 1000)"));
+
+//===----------------------------------------------------------------------===//
+// Memory accesses
+//===----------------------------------------------------------------------===//
+
+static void printID(raw_ostream &OS, const MemoryAccess *MA) {
+  if (!MA) {
+    OS << "null";
+    return;
+  }
+  if (const MemoryDef *Def = dyn_cast<MemoryDef>(MA)) {
+    if (Def->getID() == 0)
+      OS << "liveOnEntry";
+    else
+      OS << Def->getID();
+  } else if (const MemoryPhi *Phi = dyn_cast<MemoryPhi>(MA)) {
+    OS << Phi->getID();
+  } else {
+    llvm_unreachable("A MemoryUse does not define memory");
+  }
+}
+
+void MemoryAccess::print(raw_ostream &OS) const {
+  switch (getKind()) {
+  case MemoryUseKind:
+    OS << "MemoryUse(";
+    printID(OS, cast<MemoryUse>(this)->getDefiningAccess());
+    OS << ')';
+    break;
+  case MemoryDefKind:
+    printID(OS, this);
+    OS << " = MemoryDef(";
+    printID(OS, cast<MemoryDef>(this)->getDefiningAccess());
+    OS << ')';
+    break;
+  case MemoryPhiKind: {
+    const MemoryPhi *Phi = cast<MemoryPhi>(this);
+    printID(OS, Phi);
+    OS << " = MemoryPhi(";
+    for (unsigned I = 0, E = Phi->getNumIncomingValues(); I != E; ++I) {
+      if (I)
+        OS << ',';
+      OS << '{';
+      BasicBlock *BB = Phi->getIncomingBlock(I);
+      if (BB->hasName())
+        OS << BB->getName();
+      else
+        BB->printAsOperand(OS, false);
+      OS << ',';
+      printID(OS, Phi->getIncomingValue(I));
+      OS << '}';
+    }
+    OS << ')';
+    break;
+  }
+  }
+}
+
+void MemoryAccess::dump() const {
+  print(dbgs());
+  dbgs() << '\n';
+}
+
+MemoryAccess *MemoryPhi::getIncomingValueForBlock(const BasicBlock *BB) const {
+  for (const auto &Op : Operands)
+    if (Op.second == BB)
+      return Op.first;
+  return nullptr;
+}
+
+void MemoryPhi::setIncomingValue(unsigned I, MemoryAccess *MA) {
+  MemoryAccess *Old = Operands[I].first;
+  Operands[I].first = MA;
+  MA->addUser(this);
+  // The old value may still come in along another edge.
+  for (const auto &Op : Operands)
+    if (Op.first == Old)
+      return;
+  Old->removeUser(this);
+}
+
+//===----------------------------------------------------------------------===//
+// MemorySSA construction
+//===----------------------------------------------------------------------===//
+
+MemorySSA::MemorySSA(Function &F, AliasAnalysis *AA, DominatorTree *DT)
+    : F(F), AA(AA), DT(DT), Walker(new CachingMemorySSAWalker(this, AA)),
+      NextID(0) {
+  buildMemorySSA();
+}
+
+MemorySSA::~MemorySSA() {
+  // The accesses are freed with their lists, without bothering to update the
+  // use lists of one another.
+}
+
+MemorySSA::AccessListType *
+MemorySSA::getWritableBlockAccesses(const BasicBlock *BB) const {
+  auto It = PerBlockAccesses.find(BB);
+  return It == PerBlockAccesses.end() ? nullptr : It->second.get();
+}
+
+MemorySSA::AccessListType *
+MemorySSA::getOrCreateAccessList(const BasicBlock *BB) {
+  std::unique_ptr<AccessListType> &Accesses = PerBlockAccesses[BB];
+  if (!Accesses)
+    Accesses.reset(new AccessListType());
+  return Accesses.get();
+}
+
+/// createNewAccess - Create the MemoryUse or MemoryDef of I, if it touches
+/// memory, with no defining access yet.  It is not inserted in any list.
+MemoryUseOrDef *MemorySSA::createNewAccess(Instruction *I) {
+  bool Def, Use;
+  if (ImmutableCallSite CS = ImmutableCallSite(I)) {
+    AliasAnalysis::ModRefBehavior MRB = AA->getModRefBehavior(CS);
+    if (MRB == AliasAnalysis::DoesNotAccessMemory)
+      return nullptr;
+    Def = !AliasAnalysis::onlyReadsMemory(MRB);
+    Use = !Def;
+  } else {
+    // Volatile and ordered loads write memory as far as this is concerned, so
+    // that they keep their place among the other ordered accesses.
+    Def = I->mayWriteToMemory();
+    Use = I->mayReadFromMemory();
+  }
+
+  MemoryUseOrDef *MA;
+  if (Def)
+    MA = new MemoryDef(I, nullptr, I->getParent(), NextID++);
+  else if (Use)
+    MA = new MemoryUse(I, nullptr, I->getParent());
+  else
+    return nullptr;
+  InstructionToMemoryAccess[I] = MA;
+  return MA;
+}
+
+MemoryPhi *MemorySSA::createMemoryPhi(BasicBlock *BB) {
+  assert(!BlockToMemoryPhi.count(BB) && "Block already has a MemoryPhi");
+  MemoryPhi *Phi = new MemoryPhi(BB, NextID++);
+  getOrCreateAccessList(BB)->push_front(Phi);
+  BlockToMemoryPhi[BB] = Phi;
+  return Phi;
+}
+
+/// computeIDF - Compute the iterated dominance frontier of DefBlocks, the
+/// blocks that need a MemoryPhi, and return them in function order.
+static void computeIDF(DominatorTree &DT, Function &F,
+                       const SmallPtrSetImpl<BasicBlock *> &DefBlocks,
+                       SmallVectorImpl<BasicBlock *> &PhiBlocks) {
+  DenseMap<DomTreeNode *, unsigned> DomLevels;
+  SmallVector<DomTreeNode *, 32> Worklist;
+  DomTreeNode *Root = DT.getRootNode();
+  DomLevels[Root] = 0;
+  Worklist.push_back(Root);
+  while (!Worklist.empty()) {
+    DomTreeNode *Node = Worklist.pop_back_val();
+    unsigned ChildLevel = DomLevels[Node] + 1;
+    for (DomTreeNode *Child : *Node) {
+      DomLevels[Child] = ChildLevel;
+      Worklist.push_back(Child);
+    }
+  }
+
+  // Use a priority queue keyed on dominator tree level so that inserted nodes
+  // are handled from the bottom of the dominator tree upwards.
+  typedef std::pair<DomTreeNode *, unsigned> DomTreeNodePair;
+  typedef std::priority_queue<DomTreeNodePair, SmallVector<DomTreeNodePair, 32>,
+                              less_second> IDFPriorityQueue;
+  IDFPriorityQueue PQ;
+  for (BasicBlock *BB : DefBlocks)
+    if (DomTreeNode *Node = DT.getNode(BB))
+      PQ.push(std::make_pair(Node, DomLevels[Node]));
+
+  SmallPtrSet<BasicBlock *, 32> IDF;
+  SmallPtrSet<DomTreeNode *, 32> Visited;
+  while (!PQ.empty()) {
+    DomTreeNodePair RootPair = PQ.top();
+    PQ.pop();
+    unsigned RootLevel = RootPair.second;
+
+    // Walk the dominator subtree of Root, looking at the CFG edges leaving it
+    // for a node no deeper than Root.
+    Worklist.clear();
+    Worklist.push_back(RootPair.first);
+    while (!Worklist.empty()) {
+      DomTreeNode *Node = Worklist.pop_back_val();
+      BasicBlock *BB = Node->getBlock();
+      for (succ_iterator SI = succ_begin(BB), SE = succ_end(BB); SI != SE;
+           ++SI) {
+        DomTreeNode *SuccNode = DT.getNode(*SI);
+        if (SuccNode->getIDom() == Node)
+          continue;
+        unsigned SuccLevel = DomLevels[SuccNode];
+        if (SuccLevel > RootLevel)
+          continue;
+        if (!Visited.insert(SuccNode).second)
+          continue;
+        IDF.insert(*SI);
+        if (!DefBlocks.count(*SI))
+          PQ.push(std::make_pair(SuccNode, SuccLevel));
+      }
+      for (DomTreeNode *Child : *Node)
+        if (!Visited.count(Child))
+          Worklist.push_back(Child);
+    }
+  }
+
+  for (BasicBlock &BB : F)
+    if (IDF.count(&BB))
+      PhiBlocks.push_back(&BB);
+}
+
+void MemorySSA::buildMemorySSA() {
+  // liveOnEntry gets ID 0 and is not part of any block.
+  LiveOnEntryDef.reset(
+      new MemoryDef(nullptr, nullptr, &F.getEntryBlock(), NextID++));
+
+  // Create the accesses of the instructions, and note which blocks write
+  // memory.
+  SmallPtrSet<BasicBlock *, 32> DefiningBlocks;
+  for (BasicBlock &BB : F) {
+    AccessListType *Accesses = nullptr;
+    for (Instruction &I : BB) {
+      MemoryUseOrDef *MA = createNewAccess(&I);
+      if (!MA)
+        continue;
+      if (!Accesses)
+        Accesses = getOrCreateAccessList(&BB);
+      Accesses->push_back(MA);
+      if (isa<MemoryDef>(MA))
+        DefiningBlocks.insert(&BB);
+    }
+  }
+
+  SmallVector<BasicBlock *, 32> PhiBlocks;
+  computeIDF(*DT, F, DefiningBlocks, PhiBlocks);
+  for (BasicBlock *BB : PhiBlocks)
+    createMemoryPhi(BB);
+
+  // Link every access to the version of memory reaching it.
+  SmallPtrSet<BasicBlock *, 32> Visited;
+  renamePass(Visited);
+
+  // The accesses of unreachable blocks see liveOnEntry, and so does every
+  // MemoryPhi along its edges from unreachable blocks.
+  if (Visited.size() != F.size())
+    for (BasicBlock &BB : F)
+      if (!Visited.count(&BB))
+        markUnreachableAsLiveOnEntry(&BB);
+
+  if (VerifyMemorySSA)
+    verifyMemorySSA();
+}
+
+namespace {
+/// RenameFrame - A node of the dominator tree being renamed, along with the
+/// next child to visit and the version of memory at the end of the block.
+struct RenameFrame {
+  DomTreeNode *Node;
+  DomTreeNode::iterator ChildIt;
+  MemoryAccess *Incoming;
+
+  RenameFrame(DomTreeNode *Node, MemoryAccess *Incoming)
+      : Node(Node), ChildIt(Node->begin()), Incoming(Incoming) {}
+};
+} // end anonymous namespace
+
+/// renameBlock - Link the accesses of BB to the version of memory reaching
+/// them, starting with Incoming, add the outgoing version to the MemoryPhis
+/// of the successors of BB, and return it.
+MemoryAccess *MemorySSA::renameBlock(BasicBlock *BB, MemoryAccess *Incoming) {
+  if (AccessListType *Accesses = getWritableBlockAccesses(BB))
+    for (MemoryAccess &MA : *Accesses) {
+      if (MemoryPhi *Phi = dyn_cast<MemoryPhi>(&MA)) {
+        Incoming = Phi;
+        continue;
+      }
+      MemoryUseOrDef *MUD = cast<MemoryUseOrDef>(&MA);
+      MUD->setDefiningAccess(Incoming);
+      if (isa<MemoryDef>(MUD))
+        Incoming = MUD;
+    }
+
+  for (succ_iterator SI = succ_begin(BB), SE = succ_end(BB); SI != SE; ++SI)
+    if (MemoryPhi *Phi = BlockToMemoryPhi.lookup(*SI))
+      Phi->addIncoming(Incoming, BB);
+  return Incoming;
+}
+
+void MemorySSA::renamePass(SmallPtrSetImpl<BasicBlock *> &Visited) {
+  // Walk the dominator tree with an explicit stack, as large functions have
+  // deep ones.
+  DomTreeNode *Root = DT->getRootNode();
+  BasicBlock *RootBB = Root->getBlock();
+  Visited.insert(RootBB);
+  SmallVector<RenameFrame, 32> WorkStack;
+  WorkStack.push_back(
+      RenameFrame(Root, renameBlock(RootBB, LiveOnEntryDef.get())));
+
+  while (!WorkStack.empty()) {
+    RenameFrame &Top = WorkStack.back();
+    if (Top.ChildIt == Top.Node->end()) {
+      WorkStack.pop_back();
+      continue;
+    }
+    DomTreeNode *Child = *Top.ChildIt++;
+    BasicBlock *BB = Child->getBlock();
+    Visited.insert(BB);
+    MemoryAccess *Incoming = renameBlock(BB, Top.Incoming);
+    WorkStack.push_back(RenameFrame(Child, Incoming));
+  }
+}
+
+void MemorySSA::markUnreachableAsLiveOnEntry(BasicBlock *BB) {
+  MemoryAccess *LiveOnEntry = LiveOnEntryDef.get();
+  for (succ_iterator SI = succ_begin(BB), SE = succ_end(BB); SI != SE; ++SI)
+    if (MemoryPhi *Phi = BlockToMemoryPhi.lookup(*SI))
+      Phi->addIncoming(LiveOnEntry, BB);
+
+  if (AccessListType *Accesses = getWritableBlockAccesses(BB))
+    for (MemoryAccess &MA : *Accesses)
+      cast<MemoryUseOrDef>(&MA)->setDefiningAccess(LiveOnEntry);
+}
+
+//===----------------------------------------------------------------------===//
+// Queries and updates
+//===----------------------------------------------------------------------===//
+
+MemoryUseOrDef *MemorySSA::getMemoryAccess(const Instruction *I) const {
+  return InstructionToMemoryAccess.lookup(I);
+}
+
+MemoryPhi *MemorySSA::getMemoryAccess(const BasicBlock *BB) const {
+  return BlockToMemoryPhi.lookup(BB);
+}
+
+bool MemorySSA::locallyDominates(const MemoryAccess *Dominator,
+                                 const MemoryAccess *Dominatee) const {
+  assert(Dominator->getBlock() == Dominatee->getBlock() &&
+         "Asking for local domination when accesses are in different blocks!");
+  if (Dominator == Dominatee || isLiveOnEntryDef(Dominator))
+    return true;
+  if (isLiveOnEntryDef(Dominatee))
+    return false;
+
+  // Walk forward from Dominator; the lists are short in practice.
+  const AccessListType *Accesses = getBlockAccesses(Dominator->getBlock());
+  AccessListType::const_iterator It(Dominator);
+  for (++It; It != Accesses->end(); ++It)
+    if (&*It == Dominatee)
+      return true;
+  return false;
+}
+
+bool MemorySSA::dominates(const MemoryAccess *Dominator,
+                          const MemoryAccess *Dominatee) const {
+  if (Dominator == Dominatee || isLiveOnEntryDef(Dominator))
+    return true;
+  if (isLiveOnEntryDef(Dominatee))
+    return false;
+  if (Dominator->getBlock() != Dominatee->getBlock())
+    return DT->dominates(Dominator->getBlock(), Dominatee->getBlock());
+  return locallyDominates(Dominator, Dominatee);
+}
+
+void MemorySSA::removeMemoryAccess(MemoryAccess *MA) {
+  assert(!isLiveOnEntryDef(MA) && "Trying to remove the live on entry def");
+
+  // The users of MA now see the version of memory MA saw.
+  MemoryAccess *NewDefTarget;
+  if (MemoryUseOrDef *MUD = dyn_cast<MemoryUseOrDef>(MA)) {
+    NewDefTarget = MUD->getDefiningAccess();
+  } else {
+    MemoryPhi *Phi = cast<MemoryPhi>(MA);
+    NewDefTarget = Phi->getNumIncomingValues() ? Phi->getIncomingValue(0)
+                                               : LiveOnEntryDef.get();
+#ifndef NDEBUG
+    for (unsigned I = 0, E = Phi->getNumIncomingValues(); I != E; ++I)
+      assert((Phi->getIncomingValue(I) == NewDefTarget ||
+              Phi->getIncomingValue(I) == Phi) &&
+             "Removing a MemoryPhi with different incoming values");
+#endif
+  }
+
+  Walker->invalidateInfo(MA);
+
+  if (MA->hasUsers()) {
+    assert(!isa<MemoryUse>(MA) && "A MemoryUse has users");
+    SmallVector<MemoryAccess *, 8> Users(MA->users().begin(),
+                                         MA->users().end());
+    for (MemoryAccess *U : Users) {
+      if (MemoryUseOrDef *MUD = dyn_cast<MemoryUseOrDef>(U)) {
+        MUD->setDefiningAccess(NewDefTarget);
+        continue;
+      }
+      MemoryPhi *Phi = cast<MemoryPhi>(U);
+      if (Phi == MA)
+        continue;
+      for (unsigned I = 0, E = Phi->getNumIncomingValues(); I != E; ++I)
+        if (Phi->getIncomingValue(I) == MA)
+          Phi->setIncomingValue(I, NewDefTarget);
+    }
+  }
+
+  // Drop the operands of MA.
+  if (MemoryUseOrDef *MUD = dyn_cast<MemoryUseOrDef>(MA)) {
+    MUD->setDefiningAccess(nullptr);
+    InstructionToMemoryAccess.erase(MUD->getMemoryInst());
+  } else {
+    MemoryPhi *Phi = cast<MemoryPhi>(MA);
+    for (const auto &Op : Phi->Operands)
+      Op.first->removeUser(Phi);
+    Phi->Operands.clear();
+    BlockToMemoryPhi.erase(Phi->getBlock());
+  }
+
+  auto AccessIt = PerBlockAccesses.find(MA->getBlock());
+  AccessIt->second->erase(MA);
+  if (AccessIt->second->empty())
+    PerBlockAccesses.erase(AccessIt);
+}
+
+MemoryUseOrDef *MemorySSA::createMemoryAccessInBB(Instruction *I,
+                                                  MemoryAccess *Definition,
+                                                  BasicBlock *BB,
+                                                  InsertionPlace Point) {
+  assert(I->getParent() == BB && "Instruction is not in the block");
+  MemoryUseOrDef *MA = createNewAccess(I);
+  assert(MA && "Trying to create an access for an instruction that does not "
+               "touch memory");
+  MA->setDefiningAccess(Definition);
+  AccessListType *Accesses = getOrCreateAccessList(BB);
+  if (Point == End) {
+    Accesses->push_back(MA);
+  } else {
+    AccessListType::iterator It = Accesses->begin();
+    while (It != Accesses->end() && isa<MemoryPhi>(*It))
+      ++It;
+    Accesses->insert(It, MA);
+  }
+  if (isa<MemoryDef>(MA))
+    Walker->clearCache();
+  return MA;
+}
+
+MemoryUseOrDef *MemorySSA::createMemoryAccessBefore(Instruction *I,
+                                                    MemoryAccess *Definition,
+                                                    MemoryUseOrDef *InsertPt) {
+  assert(I->getParent() == InsertPt->getBlock() &&
+         "New and old access must be in the same block");
+  MemoryUseOrDef *MA = createNewAccess(I);
+  assert(MA && "Trying to create an access for an instruction that does not "
+               "touch memory");
+  MA->setDefiningAccess(Definition);
+  getOrCreateAccessList(InsertPt->getBlock())
+      ->insert(AccessListType::iterator(InsertPt), MA);
+  if (isa<MemoryDef>(MA))
+    Walker->clearCache();
+  return MA;
+}
+
+MemoryUseOrDef *MemorySSA::createMemoryAccessAfter(Instruction *I,
+                                                   MemoryAccess *Definition,
+                                                   MemoryAccess *InsertPt) {
+  assert(I->getParent() == InsertPt->getBlock() &&
+         "New and old access must be in the same block");
+  MemoryUseOrDef *MA = createNewAccess(I);
+  assert(MA && "Trying to create an access for an instruction that does not "
+               "touch memory");
+  MA->setDefiningAccess(Definition);
+  getOrCreateAccessList(InsertPt->getBlock())
+      ->insertAfter(AccessListType::iterator(InsertPt), MA);
+  if (isa<MemoryDef>(MA))
+    Walker->clearCache();
+  return MA;
+}
+
+//===----------------------------------------------------------------------===//
+// Verification and printing
+//===----------------------------------------------------------------------===//
+
+void MemorySSA::verifyMemorySSA() const {
+  SmallPtrSet<const MemoryAccess *, 32> Seen;
+  for (BasicBlock &BB : F) {
+    const AccessListType *Accesses = getBlockAccesses(&BB);
+    AccessListType::const_iterator It, E;
+    if (Accesses) {
+      It = Accesses->begin();
+      E = Accesses->end();
+    }
+    // The MemoryPhi, if any, comes first.
+    if (MemoryPhi *Phi = getMemoryAccess(&BB)) {
+      if (!Accesses || &*It != Phi)
+        report_fatal_error("MemoryPhi is not the first access of its block");
+      ++It;
+    }
+    // Then come the accesses of the instructions, in order.
+    for (Instruction &I : BB) {
+      MemoryUseOrDef *MA = getMemoryAccess(&I);
+      if (!MA)
+        continue;
+      if (!Accesses || It == E || &*It != MA)
+        report_fatal_error("Memory accesses are not in program order");
+      ++It;
+    }
+    if (Accesses && It != E)
+      report_fatal_error("Block holds an access without an instruction");
+
+    if (!Accesses)
+      continue;
+    bool Reachable = DT->isReachableFromEntry(&BB);
+    for (const MemoryAccess &MA : *Accesses) {
+      if (MA.getBlock() != &BB)
+        report_fatal_error("Memory access in the wrong block");
+      for (MemoryAccess *U : MA.users()) {
+        bool Uses = false;
+        if (const MemoryUseOrDef *MUD = dyn_cast<MemoryUseOrDef>(U)) {
+          Uses = MUD->getDefiningAccess() == &MA;
+        } else {
+          const MemoryPhi *UserPhi = cast<MemoryPhi>(U);
+          for (unsigned I = 0, E = UserPhi->getNumIncomingValues(); I != E; ++I)
+            Uses |= UserPhi->getIncomingValue(I) == &MA;
+        }
+        if (!Uses)
+          report_fatal_error("Memory access has a stale user");
+      }
+      if (const MemoryUseOrDef *MUD = dyn_cast<MemoryUseOrDef>(&MA)) {
+        MemoryAccess *Def = MUD->getDefiningAccess();
+        if (!Def || !Def->Users.count(const_cast<MemoryAccess *>(&MA)))
+          report_fatal_error("Memory access missing from the users of its "
+                             "defining access");
+        if (Reachable && !dominates(Def, &MA))
+          report_fatal_error("Memory access is not dominated by its defining "
+                             "access");
+        continue;
+      }
+      const MemoryPhi *Phi = cast<MemoryPhi>(&MA);
+      for (unsigned I = 0, E = Phi->getNumIncomingValues(); I != E; ++I) {
+        MemoryAccess *In = Phi->getIncomingValue(I);
+        BasicBlock *Pred = Phi->getIncomingBlock(I);
+        if (!In->Users.count(const_cast<MemoryPhi *>(Phi)))
+          report_fatal_error("MemoryPhi missing from the users of its "
+                             "incoming value");
+        if (!isLiveOnEntryDef(In) && DT->isReachableFromEntry(Pred) &&
+            !DT->dominates(In->getBlock(), Pred))
+          report_fatal_error("MemoryPhi incoming value does not dominate "
+                             "its incoming block");
+      }
+    }
+  }
+}
+
+namespace {
+/// MemorySSAAnnotatedWriter - Prints the memory accesses of a function as
+/// comments on its instructions.
+class MemorySSAAnnotatedWriter : public AssemblyAnnotationWriter {
+  const MemorySSA *MSSA;
+
+public:
+  explicit MemorySSAAnnotatedWriter(const MemorySSA *MSSA) : MSSA(MSSA) {}
+
+  void emitBasicBlockStartAnnot(const BasicBlock *BB,
+                                formatted_raw_ostream &OS) override {
+    if (MemoryPhi *Phi = MSSA->getMemoryAccess(BB))
+      OS << "; " << *Phi << '\n';
+  }
+
+  void emitInstructionAnnot(const Instruction *I,
+                            formatted_raw_ostream &OS) override {
+    if (MemoryUseOrDef *MA = MSSA->getMemoryAccess(I))
+      OS << "; " << *MA << '\n';
+  }
+};
+} // end anonymous namespace
+
+void MemorySSA::print(raw_ostream &OS) const {
+  MemorySSAAnnotatedWriter Writer(this);
+  F.print(OS, &Writer);
+}
+
+void MemorySSA::dump() const { print(dbgs()); }
+
+//===----------------------------------------------------------------------===//
+// Walkers
+//===----------------------------------------------------------------------===//
+
+MemoryAccess *
+DoNothingMemorySSAWalker::getClobberingMemoryAccess(const Instruction *I) {
+  MemoryUseOrDef *MA = MSSA->getMemoryAccess(I);
+  assert(MA && "Instruction does not touch memory");
+  return MA->getDefiningAccess();
+}
+
+MemoryAccess *DoNothingMemorySSAWalker::getClobberingMemoryAccess(
+    MemoryAccess *StartingAccess, const AliasAnalysis::Location &) {
+  return StartingAccess;
+}
+
+/// UpwardsWalkState - The state of one clobber query of the caching walker.
+struct CachingMemorySSAWalker::UpwardsWalkState {
+  AliasAnalysis::Location Loc;
+  /// The MemoryPhis being walked through, with their depth in the walk.
+  DenseMap<const MemoryPhi *, unsigned> OnStack;
+  /// The number of accesses looked at so far.
+  unsigned Steps;
+  /// Whether the walk ran out of steps.
+  bool GaveUp;
+
+  explicit UpwardsWalkState(const AliasAnalysis::Location &Loc)
+      : Loc(Loc), Steps(0), GaveUp(false) {}
+};
+
+CachingMemorySSAWalker::CachingMemorySSAWalker(MemorySSA *MSSA,
+                                               AliasAnalysis *AA)
+    : MemorySSAWalker(MSSA), AA(AA) {}
+
+CachingMemorySSAWalker::~CachingMemorySSAWalker() {}
+
+MemoryAccess *
+CachingMemorySSAWalker::lookupCache(const MemoryAccess *MA,
+                                    const AliasAnalysis::Location &Loc) const {
+  ++NumClobberCacheLookups;
+  MemoryAccess *Result = CachedClobbers.lookup(std::make_pair(MA, Loc));
+  if (Result)
+    ++NumClobberCacheHits;
+  return Result;
+}
+
+void CachingMemorySSAWalker::addCacheEntry(const MemoryAccess *MA,
+                                           const AliasAnalysis::Location &Loc,
+                                           MemoryAccess *Result) {
+  if (!CachedClobbers.insert(std::make_pair(std::make_pair(MA, Loc), Result))
+           .second)
+    return;
+  ++NumClobberCacheInserts;
+  ++CacheRefs[MA];
+  ++CacheRefs[Result];
+}
+
+void CachingMemorySSAWalker::invalidateInfo(MemoryAccess *MA) {
+  // The answers that walked past MA without stopping are still right; only
+  // those starting at MA or finding it must be dropped.
+  auto RefIt = CacheRefs.find(MA);
+  if (RefIt == CacheRefs.end())
+    return;
+  CacheRefs.erase(RefIt);
+  SmallVector<CacheKey, 8> Stale;
+  for (const auto &Entry : CachedClobbers) {
+    const MemoryAccess *Key = Entry.first.first;
+    MemoryAccess *Result = Entry.second;
+    if (Key != MA && Result != MA)
+      continue;
+    Stale.push_back(Entry.first);
+    const MemoryAccess *Other = Key == MA ? Result : Key;
+    if (Other != MA) {
+      auto OtherIt = CacheRefs.find(Other);
+      if (OtherIt != CacheRefs.end() && --OtherIt->second == 0)
+        CacheRefs.erase(OtherIt);
+    }
+  }
+  for (const CacheKey &Key : Stale)
+    CachedClobbers.erase(Key);
+}
+
+void CachingMemorySSAWalker::clearCache() {
+  CachedClobbers.clear();
+  CacheRefs.clear();
+}
+
+/// walkUpwards - Return the closest access at or above Current that clobbers
+/// the location of State.  Returns null if every path from Current leads back
+/// to a MemoryPhi the walk is already going through; CutDepth is then lowered
+/// to the depth of the outermost such MemoryPhi, since the answers found below
+/// it only hold for this walk.
+MemoryAccess *CachingMemorySSAWalker::walkUpwards(MemoryAccess *Current,
+                                                  UpwardsWalkState &State,
+                                                  unsigned &CutDepth) {
+  // Go up the MemoryDefs that do not clobber the location.
+  while (!isa<MemoryPhi>(Current)) {
+    if (MSSA->isLiveOnEntryDef(Current))
+      return Current;
+    if (MemoryAccess *Cached = lookupCache(Current, State.Loc))
+      return Cached;
+    MemoryDef *Def = cast<MemoryDef>(Current);
+    if (++State.Steps > WalkLimit) {
+      State.GaveUp = true;
+      return Def;
+    }
+    if (AA->getModRefInfo(Def->getMemoryInst(), State.Loc) &
+        AliasAnalysis::Mod)
+      return Def;
+    Current = Def->getDefiningAccess();
+  }
+
+  MemoryPhi *Phi = cast<MemoryPhi>(Current);
+  if (MemoryAccess *Cached = lookupCache(Phi, State.Loc))
+    return Cached;
+  auto OnStackIt = State.OnStack.find(Phi);
+  if (OnStackIt != State.OnStack.end()) {
+    // Going around a cycle brings nothing new.
+    CutDepth = std::min(CutDepth, OnStackIt->second);
+    return nullptr;
+  }
+  if (++State.Steps > WalkLimit) {
+    State.GaveUp = true;
+    return Phi;
+  }
+
+  // The clobber is the same on every path, or it is the MemoryPhi itself.
+  unsigned Depth = State.OnStack.size();
+  State.OnStack[Phi] = Depth;
+  MemoryAccess *Result = nullptr;
+  unsigned PhiCutDepth = UINT_MAX;
+  for (unsigned I = 0, E = Phi->getNumIncomingValues(); I != E; ++I) {
+    MemoryAccess *Clobber =
+        walkUpwards(Phi->getIncomingValue(I), State, PhiCutDepth);
+    if (State.GaveUp) {
+      Result = Phi;
+      break;
+    }
+    if (!Clobber)
+      continue;
+    if (!Result) {
+      Result = Clobber;
+    } else if (Clobber != Result) {
+      Result = Phi;
+      break;
+    }
+  }
+  State.OnStack.erase(Phi);
+
+  // Once the walk gives up, every MemoryPhi on the way back answers itself,
+  // which is always right.
+  if (State.GaveUp)
+    return Phi;
+  if (Result == Phi)
+    PhiCutDepth = UINT_MAX;
+  if (PhiCutDepth < Depth) {
+    CutDepth = std::min(CutDepth, PhiCutDepth);
+    return Result;
+  }
+  if (!Result)
+    Result = Phi;
+  addCacheEntry(Phi, State.Loc, Result);
+  return Result;
+}
+
+MemoryAccess *CachingMemorySSAWalker::getClobberingMemoryAccess(
+    MemoryAccess *StartingAccess, const AliasAnalysis::Location &Loc) {
+  if (MSSA->isLiveOnEntryDef(StartingAccess))
+    return StartingAccess;
+  if (MemoryAccess *Cached = lookupCache(StartingAccess, Loc))
+    return Cached;
+
+  UpwardsWalkState State(Loc);
+  unsigned CutDepth = UINT_MAX;
+  MemoryAccess *Result = walkUpwards(StartingAccess, State, CutDepth);
+  assert(Result && CutDepth == UINT_MAX && "Walk did not complete");
+  addCacheEntry(StartingAccess, Loc, Result);
+  DEBUG(dbgs() << "Clobber of " << *Loc.Ptr << " from " << *StartingAccess
+               << " is " << *Result << '\n');
+  return Result;
+}
+
+MemoryAccess *
+CachingMemorySSAWalker::getClobberingMemoryAccess(const Instruction *I) {
+  MemoryUseOrDef *MA = MSSA->getMemoryAccess(I);
+  assert(MA && "Instruction does not touch memory");
+  MemoryAccess *Def = MA->getDefiningAccess();
+
+  // Only simple loads and stores have a location worth walking for.  Calls,
+  // fences and ordered accesses stop at the previous write.
+  AliasAnalysis::Location Loc;
+  if (const LoadInst *LI = dyn_cast<LoadInst>(I)) {
+    if (!LI->isUnordered())
+      return Def;
+    Loc = AA->getLocation(LI);
+    if (AA->pointsToConstantMemory(Loc))
+      return MSSA->getLiveOnEntryDef();
+  } else if (const StoreInst *SI = dyn_cast<StoreInst>(I)) {
+    if (!SI->isUnordered())
+      return Def;
+    Loc = AA->getLocation(SI);
+  } else {
+    return Def;
+  }
+  return getClobberingMemoryAccess(Def, Loc);
+}
+
+//===----------------------------------------------------------------------===//
+// MemorySSAWrapperPass
+//===----------------------------------------------------------------------===//
+
+char MemorySSAWrapperPass::ID = 0;
+INITIALIZE_PASS_BEGIN(MemorySSAWrapperPass, "memoryssa", "Memory SSA", false,
+                      true)
+INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
+INITIALIZE_AG_DEPENDENCY(AliasAnalysis)
+INITIALIZE_PASS_END(MemorySSAWrapperPass, "memoryssa", "Memory SSA", false,
+                    true)
+
+MemorySSAWrapperPass::MemorySSAWrapperPass() : FunctionPass(ID) {
+  initializeMemorySSAWrapperPassPass(*PassRegistry::getPassRegistry());
+}
+
+bool MemorySSAWrapperPass::runOnFunction(Function &F) {
+  AliasAnalysis *AA = &getAnalysis<AliasAnalysis>();
+  DominatorTree *DT = &getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+  MSSA.reset(new MemorySSA(F, AA, DT));
+  return false;
+}
+
+void MemorySSAWrapperPass::releaseMemory() { MSSA.reset(); }
+
+void MemorySSAWrapperPass::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.setPreservesAll();
+  AU.addRequiredTransitive<DominatorTreeWrapperPass>();
+  AU.addRequiredTransitive<AliasAnalysis>();
+}
+
+void MemorySSAWrapperPass::verifyAnalysis() const {
+  if (VerifyMemorySSA && MSSA)
+    MSSA->verifyMemorySSA();
+}
+
+void MemorySSAWrapperPass::print(raw_ostream &OS, const Module *M) const {
+  if (MSSA)
+    MSSA->print(OS);
+}
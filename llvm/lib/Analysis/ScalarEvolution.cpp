@@ -101,6 +101,8 @@ STATISTIC(NumTripCountsNotComputed,
           "Number of loops without predictable loop counts");
 STATISTIC(NumBruteForceTripCountsComputed,
           "Number of loops with trip counts computed by force");
+STATISTIC(NumTripCountsOverBudget,
+          "Number of loops whose trip counts were too expensive to compute");
 
 static cl::opt<unsigned>
 MaxBruteForceIterations("scalar-evolution-max-iterations", cl::ReallyHidden,
@@ -109,6 +111,13 @@ MaxBruteForceIterations("scalar-evolution-max-iterations", cl::ReallyHidden,
                                  "derived loop"),
                         cl::init(100));
 
+static cl::opt<unsigned>
+MaxBECountQueryCost("scalar-evolution-max-backedge-taken-cost", cl::Hidden,
+                    cl::desc("Maximum number of exit conditions and implied "
+                             "conditions SCEV will evaluate to compute the "
+                             "backedge-taken count of one loop"),
+                    cl::init(4096));
+
 // FIXME: Enable this with XDEBUG when the test suite is clean.
 static cl::opt<bool>
 VerifySCEV("verify-scev",
@@ -4584,7 +4593,23 @@ ScalarEvolution::getBackedgeTakenInfo(const Loop *L) {
   // ComputeBackedgeTakenCount may allocate memory for its result. Inserting it
   // into the BackedgeTakenCounts map transfers ownership. Otherwise, the result
   // must be cleared in this scope.
+  //
+  // The counts of other loops computed on behalf of this one are charged to
+  // the same query.
+  if (BECountQueryDepth++ == 0)
+    BECountQueryCost = 0;
   BackedgeTakenInfo Result = ComputeBackedgeTakenCount(L);
+  --BECountQueryDepth;
+
+  // Once the query runs out of budget, the answers it gets are still correct
+  // but they depend on where exactly that happened. Don't cache a count that
+  // is only as good as the order of evaluation.
+  if (BECountQueryCost > MaxBECountQueryCost) {
+    SmallVector<std::pair<BasicBlock *, const SCEV *>, 1> NoExitCounts;
+    Result.clear();
+    Result = BackedgeTakenInfo(NoExitCounts, false, getCouldNotCompute());
+    ++NumTripCountsOverBudget;
+  }
 
   if (Result.getExact(this) != getCouldNotCompute()) {
     assert(isLoopInvariant(Result.getExact(this), L) &&
@@ -4636,6 +4661,8 @@ ScalarEvolution::getBackedgeTakenInfo(const Loop *L) {
     }
   }
 
+  addBECountUsers(L, Result);
+
   // Re-lookup the insert position, since the call to
   // ComputeBackedgeTakenCount above could result in a
   // recusive call to getBackedgeTakenInfo (on a different
@@ -4644,17 +4671,83 @@ ScalarEvolution::getBackedgeTakenInfo(const Loop *L) {
   return BackedgeTakenCounts.find(L)->second = Result;
 }
 
+namespace {
+typedef DenseMap<const SCEV *, SmallPtrSet<const Loop *, 2>> BECountUsersMap;
+
+/// SCEVAddUser - Record a loop as a user of every subexpression of the
+/// expressions visited.
+struct SCEVAddUser {
+  BECountUsersMap &Users;
+  const Loop *L;
+
+  SCEVAddUser(BECountUsersMap &Users, const Loop *L) : Users(Users), L(L) {}
+
+  bool follow(const SCEV *S) {
+    // A subexpression that already names this loop was visited before,
+    // along with its own operands.
+    return Users[S].insert(L).second;
+  }
+  bool isDone() const { return false; }
+};
+
+/// SCEVRemoveUser - Undo SCEVAddUser.
+struct SCEVRemoveUser {
+  BECountUsersMap &Users;
+  const Loop *L;
+
+  SCEVRemoveUser(BECountUsersMap &Users, const Loop *L) : Users(Users), L(L) {}
+
+  bool follow(const SCEV *S) {
+    BECountUsersMap::iterator I = Users.find(S);
+    if (I == Users.end() || !I->second.erase(L))
+      return false;
+    if (I->second.empty())
+      Users.erase(I);
+    return true;
+  }
+  bool isDone() const { return false; }
+};
+}
+
+void ScalarEvolution::addBECountUsers(const Loop *L,
+                                      const BackedgeTakenInfo &BTI) {
+  SmallVector<const SCEV *, 4> Exprs;
+  BTI.getExprs(Exprs, this);
+  SCEVAddUser AddUser(BECountUsers, L);
+  for (const SCEV *S : Exprs)
+    visitAll(S, AddUser);
+}
+
+void ScalarEvolution::eraseBackedgeTakenInfo(const Loop *L) {
+  DenseMap<const Loop*, BackedgeTakenInfo>::iterator BTCPos =
+    BackedgeTakenCounts.find(L);
+  if (BTCPos == BackedgeTakenCounts.end())
+    return;
+
+  SmallVector<const SCEV *, 4> Exprs;
+  BTCPos->second.getExprs(Exprs, this);
+  SCEVRemoveUser RemoveUser(BECountUsers, L);
+  for (const SCEV *S : Exprs)
+    visitAll(S, RemoveUser);
+
+  BTCPos->second.clear();
+  BackedgeTakenCounts.erase(BTCPos);
+}
+
+bool ScalarEvolution::chargeBECountQuery() {
+  if (!BECountQueryDepth)
+    return false;
+  if (BECountQueryCost <= MaxBECountQueryCost)
+    ++BECountQueryCost;
+  return BECountQueryCost > MaxBECountQueryCost;
+}
+
 /// forgetLoop - This method should be called by the client when it has
 /// changed a loop in a way that may effect ScalarEvolution's ability to
 /// compute a trip count, or if the loop is deleted.
 void ScalarEvolution::forgetLoop(const Loop *L) {
   // Drop any stored trip count value.
-  DenseMap<const Loop*, BackedgeTakenInfo>::iterator BTCPos =
-    BackedgeTakenCounts.find(L);
-  if (BTCPos != BackedgeTakenCounts.end()) {
-    BTCPos->second.clear();
-    BackedgeTakenCounts.erase(BTCPos);
-  }
+  eraseBackedgeTakenInfo(L);
 
   // Drop information about expressions based on loop-header PHIs.
   SmallVector<Instruction *, 16> Worklist;
@@ -4765,23 +4858,19 @@ ScalarEvolution::BackedgeTakenInfo::getMax(ScalarEvolution *SE) const {
   return Max ? Max : SE->getCouldNotCompute();
 }
 
-bool ScalarEvolution::BackedgeTakenInfo::hasOperand(const SCEV *S,
-                                                    ScalarEvolution *SE) const {
-  if (Max && Max != SE->getCouldNotCompute() && SE->hasOperand(Max, S))
-    return true;
+void ScalarEvolution::BackedgeTakenInfo::getExprs(
+    SmallVectorImpl<const SCEV *> &Exprs, ScalarEvolution *SE) const {
+  if (Max && Max != SE->getCouldNotCompute())
+    Exprs.push_back(Max);
 
   if (!ExitNotTaken.ExitingBlock)
-    return false;
+    return;
 
   for (const ExitNotTakenInfo *ENT = &ExitNotTaken;
        ENT != nullptr; ENT = ENT->getNextExit()) {
-
-    if (ENT->ExactNotTaken != SE->getCouldNotCompute()
-        && SE->hasOperand(ENT->ExactNotTaken, S)) {
-      return true;
-    }
+    if (ENT->ExactNotTaken != SE->getCouldNotCompute())
+      Exprs.push_back(ENT->ExactNotTaken);
   }
-  return false;
 }
 
 /// Allocate memory for BackedgeTakenInfo and copy the not-taken count of each
@@ -4973,6 +5062,9 @@ ScalarEvolution::ComputeExitLimitFromCond(const Loop *L,
                                           BasicBlock *TBB,
                                           BasicBlock *FBB,
                                           bool ControlsExit) {
+  if (chargeBECountQuery())
+    return getCouldNotCompute();
+
   // Check if the controlling expression for this loop is an And or Or.
   if (BinaryOperator *BO = dyn_cast<BinaryOperator>(ExitCond)) {
     if (BO->getOpcode() == Instruction::And) {
@@ -5558,6 +5650,9 @@ const SCEV *ScalarEvolution::ComputeExitCountExhaustively(const Loop *L,
   unsigned MaxIterations = MaxBruteForceIterations;   // Limit analysis.
   const DataLayout &DL = F->getParent()->getDataLayout();
   for (unsigned IterationNum = 0; IterationNum != MaxIterations;++IterationNum){
+    if (chargeBECountQuery())
+      return getCouldNotCompute();
+
     ConstantInt *CondVal = dyn_cast_or_null<ConstantInt>(
         EvaluateExpression(Cond, L, CurrentIterVals, DL, TLI));
 
@@ -6832,6 +6927,9 @@ bool ScalarEvolution::isImpliedCond(ICmpInst::Predicate Pred,
                                     const SCEV *LHS, const SCEV *RHS,
                                     Value *FoundCondValue,
                                     bool Inverse) {
+  if (chargeBECountQuery())
+    return false;
+
   MarkPendingLoopPredicate Mark(FoundCondValue, PendingLoopPredicates);
   if (Mark.Pending)
     return false;
@@ -8027,7 +8125,8 @@ ScalarEvolution::SCEVCallbackVH::SCEVCallbackVH(Value *V, ScalarEvolution *se)
 //===----------------------------------------------------------------------===//
 
 ScalarEvolution::ScalarEvolution()
-    : FunctionPass(ID), WalkingBEDominatingConds(false), ValuesAtScopes(64),
+    : FunctionPass(ID), WalkingBEDominatingConds(false),
+      BECountQueryDepth(0), BECountQueryCost(0), ValuesAtScopes(64),
       LoopDispositions(64), BlockDispositions(64), FirstUnknown(nullptr) {
   initializeScalarEvolutionPass(*PassRegistry::getPassRegistry());
 }
@@ -8061,7 +8160,10 @@ void ScalarEvolution::releaseMemory() {
   assert(PendingLoopPredicates.empty() && "isImpliedCond garbage");
   assert(!WalkingBEDominatingConds && "isLoopBackedgeGuardedByCond garbage!");
 
+  assert(!BECountQueryDepth && "getBackedgeTakenInfo garbage!");
+
   BackedgeTakenCounts.clear();
+  BECountUsers.clear();
   ConstantEvolutionLoopExitValue.clear();
   ValuesAtScopes.clear();
   LoopDispositions.clear();
@@ -8404,16 +8506,15 @@ void ScalarEvolution::forgetMemoizedResults(const SCEV *S) {
   UnsignedRanges.erase(S);
   SignedRanges.erase(S);
 
-  for (DenseMap<const Loop*, BackedgeTakenInfo>::iterator I =
-         BackedgeTakenCounts.begin(), E = BackedgeTakenCounts.end(); I != E; ) {
-    BackedgeTakenInfo &BEInfo = I->second;
-    if (BEInfo.hasOperand(S, this)) {
-      BEInfo.clear();
-      BackedgeTakenCounts.erase(I++);
-    }
-    else
-      ++I;
-  }
+  // Erasing a count updates BECountUsers, so work on a copy of the users.
+  DenseMap<const SCEV *, SmallPtrSet<const Loop *, 2>>::iterator Users =
+      BECountUsers.find(S);
+  if (Users == BECountUsers.end())
+    return;
+  SmallVector<const Loop *, 4> Loops(Users->second.begin(),
+                                     Users->second.end());
+  for (const Loop *L : Loops)
+    eraseBackedgeTakenInfo(L);
 }
 
 typedef DenseMap<const Loop *, std::string> VerifyMap;
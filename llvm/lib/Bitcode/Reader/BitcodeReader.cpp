@@ -8,10 +8,12 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Triple.h"
+#include "llvm/Bitcode/BitcodeSymbolTable.h"
 #include "llvm/Bitcode/BitstreamReader.h"
 #include "llvm/Bitcode/LLVMBitCodes.h"
 #include "llvm/IR/AutoUpgrade.h"
@@ -20,6 +22,7 @@
 #include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/DiagnosticPrinter.h"
+#include "llvm/IR/FunctionInfo.h"
 #include "llvm/IR/GVMaterializer.h"
 #include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/IntrinsicInst.h"
@@ -219,6 +222,26 @@ class BitcodeReader : public GVMaterializer {
   /// True if any Metadata block has been materialized.
   bool IsMetadataMaterialized;
 
+  /// True if the records of an indexed module-level METADATA_BLOCK should be
+  /// loaded on demand, when a named metadata or a function body references
+  /// them, rather than when the block is parsed.
+  bool LazyLoadMetadataRecords = false;
+
+  /// When the records of the module-level METADATA_BLOCK are loaded on demand,
+  /// a cursor inside the block, with its abbreviations, and the bit position
+  /// of the record of each metadata, indexed by ID - LazyMetadataBaseID.
+  BitstreamCursor LazyMetadataCursor;
+  std::vector<uint64_t> LazyMetadataPositions;
+  unsigned LazyMetadataBaseID = 0;
+
+  /// The metadata being loaded on demand, by ID - LazyMetadataBaseID. A
+  /// reference to one of them is a cycle, and gets a placeholder.
+  BitVector LazyMetadataLoading;
+
+  /// Nesting depth of lazyLoadMetadata(). Cycles are resolved when the
+  /// outermost load completes.
+  unsigned LazyMetadataLoadDepth = 0;
+
   bool StripDebugInfo = false;
 
 public:
@@ -253,6 +276,14 @@ public:
   /// @returns true if an error occurred.
   ErrorOr<std::string> parseTriple();
 
+  /// Cheap mechanism to just read the function summary into \p Index, without
+  /// parsing the module.
+  std::error_code parseFunctionInfoIndex(FunctionInfoIndex &Index);
+
+  /// Cheap mechanism to just read the symbol table, without parsing the
+  /// module. Returns null if there is no symbol table.
+  ErrorOr<std::unique_ptr<BitcodeSymbolTable>> parseSymbolTable();
+
   static uint64_t decodeSignRotatedValue(uint64_t V);
 
   /// Materialize any deferred Metadata block.
@@ -260,6 +291,10 @@ public:
 
   void setStripDebugInfo() override;
 
+  /// Load the records of an indexed module-level METADATA_BLOCK on demand.
+  /// Only worthwhile if not all the function bodies will be materialized.
+  void setLazyLoadMetadataRecords() { LazyLoadMetadataRecords = true; }
+
 private:
   std::vector<StructType *> IdentifiedStructTypes;
   StructType *createIdentifiedStructType(LLVMContext &Context, StringRef Name);
@@ -272,8 +307,9 @@ private:
     return ValueList.getValueFwdRef(ID, Ty);
   }
   Metadata *getFnMetadataByID(unsigned ID) {
-    return MDValueList.getValueFwdRef(ID);
+    return getMetadataFwdRef(ID);
   }
+  Metadata *getMetadataFwdRef(unsigned ID);
   BasicBlock *getBasicBlock(unsigned ID) const {
     if (ID >= FunctionBBs.size()) return nullptr; // Invalid ID
     return FunctionBBs[ID];
@@ -370,8 +406,22 @@ private:
   std::error_code GlobalCleanup();
   std::error_code ResolveGlobalAndAliasInits();
   std::error_code ParseMetadata();
+  std::error_code ParseMetadataRecord(unsigned Code, ArrayRef<uint64_t> Record,
+                                      unsigned &NextMDValueNo);
+  std::error_code ParseMetadataIndex(uint64_t IndexOffset,
+                                     unsigned &NextMDValueNo);
+  std::error_code lazyLoadMetadata(unsigned ID);
   std::error_code ParseMetadataAttachment();
   ErrorOr<std::string> parseModuleTriple();
+  std::error_code parseModuleFunctionSummary(FunctionInfoIndex &Index);
+  std::error_code
+  parseModuleStringTable(FunctionInfoIndex &Index,
+                         DenseMap<uint64_t, StringRef> &ModulePaths);
+  std::error_code
+  parseFunctionSummaryBlock(FunctionInfoIndex &Index,
+                            const DenseMap<uint64_t, StringRef> &ModulePaths);
+  ErrorOr<std::unique_ptr<BitcodeSymbolTable>> parseModuleSymbolTable();
+  std::error_code parseSymbolTableBlock(BitcodeSymbolTable &Symtab);
   std::error_code ParseUseLists();
   std::error_code InitStream();
   std::error_code InitStreamFromBuffer();
@@ -482,6 +532,8 @@ void BitcodeReader::FreeState() {
   std::vector<Function*>().swap(FunctionsWithBodies);
   DeferredFunctionInfo.clear();
   DeferredMetadataInfo.clear();
+  std::vector<uint64_t>().swap(LazyMetadataPositions);
+  LazyMetadataLoading.clear();
   MDKindMap.clear();
 
   assert(BasicBlockFwdRefs.empty() && "Unresolved blockaddress fwd references");
@@ -1553,22 +1605,6 @@ std::error_code BitcodeReader::ParseMetadata() {
 
   SmallVector<uint64_t, 64> Record;
 
-  auto getMD =
-      [&](unsigned ID) -> Metadata *{ return MDValueList.getValueFwdRef(ID); };
-  auto getMDOrNull = [&](unsigned ID) -> Metadata *{
-    if (ID)
-      return getMD(ID - 1);
-    return nullptr;
-  };
-  auto getMDString = [&](unsigned ID) -> MDString *{
-    // This requires that the ID is not really a forward reference.  In
-    // particular, the MDString must already have been resolved.
-    return cast_or_null<MDString>(getMDOrNull(ID));
-  };
-
-#define GET_OR_DISTINCT(CLASS, DISTINCT, ARGS)                                 \
-  (DISTINCT ? CLASS::getDistinct ARGS : CLASS::get ARGS)
-
   // Read all the records.
   while (1) {
     BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
@@ -1588,9 +1624,11 @@ std::error_code BitcodeReader::ParseMetadata() {
     // Read a record.
     Record.clear();
     unsigned Code = Stream.readRecord(Entry.ID, Record);
-    bool IsDistinct = false;
     switch (Code) {
-    default:  // Default behavior: ignore.
+    default:
+      if (std::error_code EC =
+              ParseMetadataRecord(Code, Record, NextMDValueNo))
+        return EC;
       break;
     case bitc::METADATA_NAME: {
       // Read name of the named metadata.
@@ -1606,382 +1644,495 @@ std::error_code BitcodeReader::ParseMetadata() {
       unsigned Size = Record.size();
       NamedMDNode *NMD = TheModule->getOrInsertNamedMetadata(Name);
       for (unsigned i = 0; i != Size; ++i) {
-        MDNode *MD = dyn_cast_or_null<MDNode>(MDValueList.getValueFwdRef(Record[i]));
+        MDNode *MD = dyn_cast_or_null<MDNode>(getMetadataFwdRef(Record[i]));
         if (!MD)
           return Error("Invalid record");
         NMD->addOperand(MD);
       }
       break;
     }
-    case bitc::METADATA_OLD_FN_NODE: {
-      // FIXME: Remove in 4.0.
-      // This is a LocalAsMetadata record, the only type of function-local
-      // metadata.
-      if (Record.size() % 2 == 1)
-        return Error("Invalid record");
-
-      // If this isn't a LocalAsMetadata record, we're dropping it.  This used
-      // to be legal, but there's no upgrade path.
-      auto dropRecord = [&] {
-        MDValueList.AssignValue(MDNode::get(Context, None), NextMDValueNo++);
-      };
-      if (Record.size() != 2) {
-        dropRecord();
-        break;
-      }
-
-      Type *Ty = getTypeByID(Record[0]);
-      if (Ty->isMetadataTy() || Ty->isVoidTy()) {
-        dropRecord();
+    case bitc::METADATA_INDEX_OFFSET: {
+      if (Record.size() != 2)
+        return Error("Invalid record");
+      // Without lazy loading, the records are simply parsed in order.
+      if (!LazyLoadMetadataRecords || !LazyMetadataPositions.empty())
         break;
-      }
-
-      MDValueList.AssignValue(
-          LocalAsMetadata::get(ValueList.getValueFwdRef(Record[1], Ty)),
-          NextMDValueNo++);
+      if (std::error_code EC = ParseMetadataIndex(
+              Record[0] | (Record[1] << 32), NextMDValueNo))
+        return EC;
       break;
     }
-    case bitc::METADATA_OLD_NODE: {
-      // FIXME: Remove in 4.0.
-      if (Record.size() % 2 == 1)
-        return Error("Invalid record");
-
-      unsigned Size = Record.size();
-      SmallVector<Metadata *, 8> Elts;
-      for (unsigned i = 0; i != Size; i += 2) {
-        Type *Ty = getTypeByID(Record[i]);
-        if (!Ty)
-          return Error("Invalid record");
-        if (Ty->isMetadataTy())
-          Elts.push_back(MDValueList.getValueFwdRef(Record[i+1]));
-        else if (!Ty->isVoidTy()) {
-          auto *MD =
-              ValueAsMetadata::get(ValueList.getValueFwdRef(Record[i + 1], Ty));
-          assert(isa<ConstantAsMetadata>(MD) &&
-                 "Expected non-function-local metadata");
-          Elts.push_back(MD);
-        } else
-          Elts.push_back(nullptr);
-      }
-      MDValueList.AssignValue(MDNode::get(Context, Elts), NextMDValueNo++);
+    case bitc::METADATA_INDEX:
+      // Only used through METADATA_INDEX_OFFSET.
       break;
     }
-    case bitc::METADATA_VALUE: {
-      if (Record.size() != 2)
-        return Error("Invalid record");
+  }
+}
 
-      Type *Ty = getTypeByID(Record[0]);
-      if (Ty->isMetadataTy() || Ty->isVoidTy())
-        return Error("Invalid record");
+/// Parse the metadata record \p Record with code \p Code, assigning it the ID
+/// \p NextMDValueNo, which is then incremented.
+std::error_code
+BitcodeReader::ParseMetadataRecord(unsigned Code, ArrayRef<uint64_t> Record,
+                                   unsigned &NextMDValueNo) {
+  auto getMD =
+      [&](unsigned ID) -> Metadata *{ return getMetadataFwdRef(ID); };
+  auto getMDOrNull = [&](unsigned ID) -> Metadata *{
+    if (ID)
+      return getMD(ID - 1);
+    return nullptr;
+  };
+  auto getMDString = [&](unsigned ID) -> MDString *{
+    // This requires that the ID is not really a forward reference.  In
+    // particular, the MDString must already have been resolved.
+    return cast_or_null<MDString>(getMDOrNull(ID));
+  };
 
-      MDValueList.AssignValue(
-          ValueAsMetadata::get(ValueList.getValueFwdRef(Record[1], Ty)),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_DISTINCT_NODE:
-      IsDistinct = true;
-      // fallthrough...
-    case bitc::METADATA_NODE: {
-      SmallVector<Metadata *, 8> Elts;
-      Elts.reserve(Record.size());
-      for (unsigned ID : Record)
-        Elts.push_back(ID ? MDValueList.getValueFwdRef(ID - 1) : nullptr);
-      MDValueList.AssignValue(IsDistinct ? MDNode::getDistinct(Context, Elts)
-                                         : MDNode::get(Context, Elts),
-                              NextMDValueNo++);
+#define GET_OR_DISTINCT(CLASS, DISTINCT, ARGS)                                 \
+  (DISTINCT ? CLASS::getDistinct ARGS : CLASS::get ARGS)
+
+  bool IsDistinct = false;
+  switch (Code) {
+  default:  // Default behavior: ignore.
+    break;
+  case bitc::METADATA_OLD_FN_NODE: {
+    // FIXME: Remove in 4.0.
+    // This is a LocalAsMetadata record, the only type of function-local
+    // metadata.
+    if (Record.size() % 2 == 1)
+      return Error("Invalid record");
+
+    // If this isn't a LocalAsMetadata record, we're dropping it.  This used
+    // to be legal, but there's no upgrade path.
+    auto dropRecord = [&] {
+      MDValueList.AssignValue(MDNode::get(Context, None), NextMDValueNo++);
+    };
+    if (Record.size() != 2) {
+      dropRecord();
       break;
     }
-    case bitc::METADATA_LOCATION: {
-      if (Record.size() != 5)
-        return Error("Invalid record");
 
-      unsigned Line = Record[1];
-      unsigned Column = Record[2];
-      MDNode *Scope = cast<MDNode>(MDValueList.getValueFwdRef(Record[3]));
-      Metadata *InlinedAt =
-          Record[4] ? MDValueList.getValueFwdRef(Record[4] - 1) : nullptr;
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(MDLocation, Record[0],
-                          (Context, Line, Column, Scope, InlinedAt)),
-          NextMDValueNo++);
+    Type *Ty = getTypeByID(Record[0]);
+    if (Ty->isMetadataTy() || Ty->isVoidTy()) {
+      dropRecord();
       break;
     }
-    case bitc::METADATA_GENERIC_DEBUG: {
-      if (Record.size() < 4)
-        return Error("Invalid record");
 
-      unsigned Tag = Record[1];
-      unsigned Version = Record[2];
+    MDValueList.AssignValue(
+        LocalAsMetadata::get(ValueList.getValueFwdRef(Record[1], Ty)),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_OLD_NODE: {
+    // FIXME: Remove in 4.0.
+    if (Record.size() % 2 == 1)
+      return Error("Invalid record");
 
-      if (Tag >= 1u << 16 || Version != 0)
+    unsigned Size = Record.size();
+    SmallVector<Metadata *, 8> Elts;
+    for (unsigned i = 0; i != Size; i += 2) {
+      Type *Ty = getTypeByID(Record[i]);
+      if (!Ty)
         return Error("Invalid record");
-
-      auto *Header = getMDString(Record[3]);
-      SmallVector<Metadata *, 8> DwarfOps;
-      for (unsigned I = 4, E = Record.size(); I != E; ++I)
-        DwarfOps.push_back(Record[I] ? MDValueList.getValueFwdRef(Record[I] - 1)
-                                     : nullptr);
-      MDValueList.AssignValue(GET_OR_DISTINCT(GenericDebugNode, Record[0],
-                                              (Context, Tag, Header, DwarfOps)),
-                              NextMDValueNo++);
-      break;
+      if (Ty->isMetadataTy())
+        Elts.push_back(getMetadataFwdRef(Record[i+1]));
+      else if (!Ty->isVoidTy()) {
+        auto *MD =
+            ValueAsMetadata::get(ValueList.getValueFwdRef(Record[i + 1], Ty));
+        assert(isa<ConstantAsMetadata>(MD) &&
+               "Expected non-function-local metadata");
+        Elts.push_back(MD);
+      } else
+        Elts.push_back(nullptr);
     }
-    case bitc::METADATA_SUBRANGE: {
-      if (Record.size() != 3)
-        return Error("Invalid record");
+    MDValueList.AssignValue(MDNode::get(Context, Elts), NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_VALUE: {
+    if (Record.size() != 2)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(MDSubrange, Record[0],
-                          (Context, Record[1], unrotateSign(Record[2]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_ENUMERATOR: {
-      if (Record.size() != 3)
-        return Error("Invalid record");
+    Type *Ty = getTypeByID(Record[0]);
+    if (Ty->isMetadataTy() || Ty->isVoidTy())
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(GET_OR_DISTINCT(MDEnumerator, Record[0],
-                                              (Context, unrotateSign(Record[1]),
-                                               getMDString(Record[2]))),
-                              NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_BASIC_TYPE: {
-      if (Record.size() != 6)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        ValueAsMetadata::get(ValueList.getValueFwdRef(Record[1], Ty)),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_DISTINCT_NODE:
+    IsDistinct = true;
+    // fallthrough...
+  case bitc::METADATA_NODE: {
+    SmallVector<Metadata *, 8> Elts;
+    Elts.reserve(Record.size());
+    for (unsigned ID : Record)
+      Elts.push_back(ID ? getMetadataFwdRef(ID - 1) : nullptr);
+    MDValueList.AssignValue(IsDistinct ? MDNode::getDistinct(Context, Elts)
+                                       : MDNode::get(Context, Elts),
+                            NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_LOCATION: {
+    if (Record.size() != 5)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(MDBasicType, Record[0],
-                          (Context, Record[1], getMDString(Record[2]),
-                           Record[3], Record[4], Record[5])),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_DERIVED_TYPE: {
-      if (Record.size() != 12)
-        return Error("Invalid record");
+    unsigned Line = Record[1];
+    unsigned Column = Record[2];
+    MDNode *Scope = cast<MDNode>(getMetadataFwdRef(Record[3]));
+    Metadata *InlinedAt =
+        Record[4] ? getMetadataFwdRef(Record[4] - 1) : nullptr;
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(MDLocation, Record[0],
+                        (Context, Line, Column, Scope, InlinedAt)),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_GENERIC_DEBUG: {
+    if (Record.size() < 4)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(MDDerivedType, Record[0],
-                          (Context, Record[1], getMDString(Record[2]),
-                           getMDOrNull(Record[3]), Record[4],
-                           getMDOrNull(Record[5]), getMDOrNull(Record[6]),
-                           Record[7], Record[8], Record[9], Record[10],
-                           getMDOrNull(Record[11]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_COMPOSITE_TYPE: {
-      if (Record.size() != 16)
-        return Error("Invalid record");
+    unsigned Tag = Record[1];
+    unsigned Version = Record[2];
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(MDCompositeType, Record[0],
-                          (Context, Record[1], getMDString(Record[2]),
-                           getMDOrNull(Record[3]), Record[4],
-                           getMDOrNull(Record[5]), getMDOrNull(Record[6]),
-                           Record[7], Record[8], Record[9], Record[10],
-                           getMDOrNull(Record[11]), Record[12],
-                           getMDOrNull(Record[13]), getMDOrNull(Record[14]),
-                           getMDString(Record[15]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_SUBROUTINE_TYPE: {
-      if (Record.size() != 3)
-        return Error("Invalid record");
+    if (Tag >= 1u << 16 || Version != 0)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(MDSubroutineType, Record[0],
-                          (Context, Record[1], getMDOrNull(Record[2]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_FILE: {
-      if (Record.size() != 3)
-        return Error("Invalid record");
+    auto *Header = getMDString(Record[3]);
+    SmallVector<Metadata *, 8> DwarfOps;
+    for (unsigned I = 4, E = Record.size(); I != E; ++I)
+      DwarfOps.push_back(Record[I] ? getMetadataFwdRef(Record[I] - 1)
+                                   : nullptr);
+    MDValueList.AssignValue(GET_OR_DISTINCT(GenericDebugNode, Record[0],
+                                            (Context, Tag, Header, DwarfOps)),
+                            NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_SUBRANGE: {
+    if (Record.size() != 3)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(MDFile, Record[0], (Context, getMDString(Record[1]),
-                                              getMDString(Record[2]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_COMPILE_UNIT: {
-      if (Record.size() != 14)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(MDSubrange, Record[0],
+                        (Context, Record[1], unrotateSign(Record[2]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_ENUMERATOR: {
+    if (Record.size() != 3)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(MDCompileUnit, Record[0],
-                          (Context, Record[1], getMDOrNull(Record[2]),
-                           getMDString(Record[3]), Record[4],
-                           getMDString(Record[5]), Record[6],
-                           getMDString(Record[7]), Record[8],
-                           getMDOrNull(Record[9]), getMDOrNull(Record[10]),
-                           getMDOrNull(Record[11]), getMDOrNull(Record[12]),
-                           getMDOrNull(Record[13]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_SUBPROGRAM: {
-      if (Record.size() != 19)
-        return Error("Invalid record");
+    MDValueList.AssignValue(GET_OR_DISTINCT(MDEnumerator, Record[0],
+                                            (Context, unrotateSign(Record[1]),
+                                             getMDString(Record[2]))),
+                            NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_BASIC_TYPE: {
+    if (Record.size() != 6)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(
-              MDSubprogram, Record[0],
-              (Context, getMDOrNull(Record[1]), getMDString(Record[2]),
-               getMDString(Record[3]), getMDOrNull(Record[4]), Record[5],
-               getMDOrNull(Record[6]), Record[7], Record[8], Record[9],
-               getMDOrNull(Record[10]), Record[11], Record[12], Record[13],
-               Record[14], getMDOrNull(Record[15]), getMDOrNull(Record[16]),
-               getMDOrNull(Record[17]), getMDOrNull(Record[18]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_LEXICAL_BLOCK: {
-      if (Record.size() != 5)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(MDBasicType, Record[0],
+                        (Context, Record[1], getMDString(Record[2]),
+                         Record[3], Record[4], Record[5])),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_DERIVED_TYPE: {
+    if (Record.size() != 12)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(MDLexicalBlock, Record[0],
-                          (Context, getMDOrNull(Record[1]),
-                           getMDOrNull(Record[2]), Record[3], Record[4])),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_LEXICAL_BLOCK_FILE: {
-      if (Record.size() != 4)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(MDDerivedType, Record[0],
+                        (Context, Record[1], getMDString(Record[2]),
+                         getMDOrNull(Record[3]), Record[4],
+                         getMDOrNull(Record[5]), getMDOrNull(Record[6]),
+                         Record[7], Record[8], Record[9], Record[10],
+                         getMDOrNull(Record[11]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_COMPOSITE_TYPE: {
+    if (Record.size() != 16)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(MDLexicalBlockFile, Record[0],
-                          (Context, getMDOrNull(Record[1]),
-                           getMDOrNull(Record[2]), Record[3])),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_NAMESPACE: {
-      if (Record.size() != 5)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(MDCompositeType, Record[0],
+                        (Context, Record[1], getMDString(Record[2]),
+                         getMDOrNull(Record[3]), Record[4],
+                         getMDOrNull(Record[5]), getMDOrNull(Record[6]),
+                         Record[7], Record[8], Record[9], Record[10],
+                         getMDOrNull(Record[11]), Record[12],
+                         getMDOrNull(Record[13]), getMDOrNull(Record[14]),
+                         getMDString(Record[15]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_SUBROUTINE_TYPE: {
+    if (Record.size() != 3)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(MDNamespace, Record[0],
-                          (Context, getMDOrNull(Record[1]),
-                           getMDOrNull(Record[2]), getMDString(Record[3]),
-                           Record[4])),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_TEMPLATE_TYPE: {
-      if (Record.size() != 3)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(MDSubroutineType, Record[0],
+                        (Context, Record[1], getMDOrNull(Record[2]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_FILE: {
+    if (Record.size() != 3)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(GET_OR_DISTINCT(MDTemplateTypeParameter,
-                                              Record[0],
-                                              (Context, getMDString(Record[1]),
-                                               getMDOrNull(Record[2]))),
-                              NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_TEMPLATE_VALUE: {
-      if (Record.size() != 5)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(MDFile, Record[0], (Context, getMDString(Record[1]),
+                                            getMDString(Record[2]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_COMPILE_UNIT: {
+    if (Record.size() != 14)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(MDTemplateValueParameter, Record[0],
-                          (Context, Record[1], getMDString(Record[2]),
-                           getMDOrNull(Record[3]), getMDOrNull(Record[4]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_GLOBAL_VAR: {
-      if (Record.size() != 11)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(MDCompileUnit, Record[0],
+                        (Context, Record[1], getMDOrNull(Record[2]),
+                         getMDString(Record[3]), Record[4],
+                         getMDString(Record[5]), Record[6],
+                         getMDString(Record[7]), Record[8],
+                         getMDOrNull(Record[9]), getMDOrNull(Record[10]),
+                         getMDOrNull(Record[11]), getMDOrNull(Record[12]),
+                         getMDOrNull(Record[13]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_SUBPROGRAM: {
+    if (Record.size() != 19)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(MDGlobalVariable, Record[0],
-                          (Context, getMDOrNull(Record[1]),
-                           getMDString(Record[2]), getMDString(Record[3]),
-                           getMDOrNull(Record[4]), Record[5],
-                           getMDOrNull(Record[6]), Record[7], Record[8],
-                           getMDOrNull(Record[9]), getMDOrNull(Record[10]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_LOCAL_VAR: {
-      if (Record.size() != 10)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(
+            MDSubprogram, Record[0],
+            (Context, getMDOrNull(Record[1]), getMDString(Record[2]),
+             getMDString(Record[3]), getMDOrNull(Record[4]), Record[5],
+             getMDOrNull(Record[6]), Record[7], Record[8], Record[9],
+             getMDOrNull(Record[10]), Record[11], Record[12], Record[13],
+             Record[14], getMDOrNull(Record[15]), getMDOrNull(Record[16]),
+             getMDOrNull(Record[17]), getMDOrNull(Record[18]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_LEXICAL_BLOCK: {
+    if (Record.size() != 5)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(MDLocalVariable, Record[0],
-                          (Context, Record[1], getMDOrNull(Record[2]),
-                           getMDString(Record[3]), getMDOrNull(Record[4]),
-                           Record[5], getMDOrNull(Record[6]), Record[7],
-                           Record[8], getMDOrNull(Record[9]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_EXPRESSION: {
-      if (Record.size() < 1)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(MDLexicalBlock, Record[0],
+                        (Context, getMDOrNull(Record[1]),
+                         getMDOrNull(Record[2]), Record[3], Record[4])),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_LEXICAL_BLOCK_FILE: {
+    if (Record.size() != 4)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(MDExpression, Record[0],
-                          (Context, makeArrayRef(Record).slice(1))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_OBJC_PROPERTY: {
-      if (Record.size() != 8)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(MDLexicalBlockFile, Record[0],
+                        (Context, getMDOrNull(Record[1]),
+                         getMDOrNull(Record[2]), Record[3])),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_NAMESPACE: {
+    if (Record.size() != 5)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(MDObjCProperty, Record[0],
-                          (Context, getMDString(Record[1]),
-                           getMDOrNull(Record[2]), Record[3],
-                           getMDString(Record[4]), getMDString(Record[5]),
-                           Record[6], getMDOrNull(Record[7]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_IMPORTED_ENTITY: {
-      if (Record.size() != 6)
-        return Error("Invalid record");
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(MDNamespace, Record[0],
+                        (Context, getMDOrNull(Record[1]),
+                         getMDOrNull(Record[2]), getMDString(Record[3]),
+                         Record[4])),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_TEMPLATE_TYPE: {
+    if (Record.size() != 3)
+      return Error("Invalid record");
 
-      MDValueList.AssignValue(
-          GET_OR_DISTINCT(MDImportedEntity, Record[0],
-                          (Context, Record[1], getMDOrNull(Record[2]),
-                           getMDOrNull(Record[3]), Record[4],
-                           getMDString(Record[5]))),
-          NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_STRING: {
-      std::string String(Record.begin(), Record.end());
-      llvm::UpgradeMDStringConstant(String);
-      Metadata *MD = MDString::get(Context, String);
-      MDValueList.AssignValue(MD, NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_KIND: {
-      if (Record.size() < 2)
-        return Error("Invalid record");
+    MDValueList.AssignValue(GET_OR_DISTINCT(MDTemplateTypeParameter,
+                                            Record[0],
+                                            (Context, getMDString(Record[1]),
+                                             getMDOrNull(Record[2]))),
+                            NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_TEMPLATE_VALUE: {
+    if (Record.size() != 5)
+      return Error("Invalid record");
 
-      unsigned Kind = Record[0];
-      SmallString<8> Name(Record.begin()+1, Record.end());
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(MDTemplateValueParameter, Record[0],
+                        (Context, Record[1], getMDString(Record[2]),
+                         getMDOrNull(Record[3]), getMDOrNull(Record[4]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_GLOBAL_VAR: {
+    if (Record.size() != 11)
+      return Error("Invalid record");
 
-      unsigned NewKind = TheModule->getMDKindID(Name.str());
-      if (!MDKindMap.insert(std::make_pair(Kind, NewKind)).second)
-        return Error("Conflicting METADATA_KIND records");
-      break;
-    }
-    }
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(MDGlobalVariable, Record[0],
+                        (Context, getMDOrNull(Record[1]),
+                         getMDString(Record[2]), getMDString(Record[3]),
+                         getMDOrNull(Record[4]), Record[5],
+                         getMDOrNull(Record[6]), Record[7], Record[8],
+                         getMDOrNull(Record[9]), getMDOrNull(Record[10]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_LOCAL_VAR: {
+    if (Record.size() != 10)
+      return Error("Invalid record");
+
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(MDLocalVariable, Record[0],
+                        (Context, Record[1], getMDOrNull(Record[2]),
+                         getMDString(Record[3]), getMDOrNull(Record[4]),
+                         Record[5], getMDOrNull(Record[6]), Record[7],
+                         Record[8], getMDOrNull(Record[9]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_EXPRESSION: {
+    if (Record.size() < 1)
+      return Error("Invalid record");
+
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(MDExpression, Record[0],
+                        (Context, Record.slice(1))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_OBJC_PROPERTY: {
+    if (Record.size() != 8)
+      return Error("Invalid record");
+
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(MDObjCProperty, Record[0],
+                        (Context, getMDString(Record[1]),
+                         getMDOrNull(Record[2]), Record[3],
+                         getMDString(Record[4]), getMDString(Record[5]),
+                         Record[6], getMDOrNull(Record[7]))),
+        NextMDValueNo++);
+    break;
   }
+  case bitc::METADATA_IMPORTED_ENTITY: {
+    if (Record.size() != 6)
+      return Error("Invalid record");
+
+    MDValueList.AssignValue(
+        GET_OR_DISTINCT(MDImportedEntity, Record[0],
+                        (Context, Record[1], getMDOrNull(Record[2]),
+                         getMDOrNull(Record[3]), Record[4],
+                         getMDString(Record[5]))),
+        NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_STRING: {
+    std::string String(Record.begin(), Record.end());
+    llvm::UpgradeMDStringConstant(String);
+    Metadata *MD = MDString::get(Context, String);
+    MDValueList.AssignValue(MD, NextMDValueNo++);
+    break;
+  }
+  case bitc::METADATA_KIND: {
+    if (Record.size() < 2)
+      return Error("Invalid record");
+
+    unsigned Kind = Record[0];
+    SmallString<8> Name(Record.begin()+1, Record.end());
+
+    unsigned NewKind = TheModule->getMDKindID(Name.str());
+    if (!MDKindMap.insert(std::make_pair(Kind, NewKind)).second)
+      return Error("Conflicting METADATA_KIND records");
+    break;
+  }
+  }
+  return std::error_code();
 #undef GET_OR_DISTINCT
 }
 
+/// The current METADATA_BLOCK has an index of its records \p IndexOffset bits
+/// from the current position. Read it to load the records on demand, and skip
+/// to the records following the index.
+std::error_code BitcodeReader::ParseMetadataIndex(uint64_t IndexOffset,
+                                                  unsigned &NextMDValueNo) {
+  // All the abbreviations of the block precede the METADATA_INDEX_OFFSET
+  // record, so a copy of the cursor can read any record of the block.
+  uint64_t BeginPos = Stream.GetCurrentBitNo();
+  LazyMetadataCursor = Stream;
+
+  if (!Stream.canSkipToPos((BeginPos + IndexOffset) / 8))
+    return Error("Invalid record");
+  Stream.JumpToBit(BeginPos + IndexOffset);
+  BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+  if (Entry.Kind != BitstreamEntry::Record)
+    return Error("Malformed block");
+  SmallVector<uint64_t, 64> Record;
+  if (Stream.readRecord(Entry.ID, Record) != bitc::METADATA_INDEX)
+    return Error("Invalid record");
+
+  // The positions are delta encoded, starting from BeginPos.
+  LazyMetadataBaseID = NextMDValueNo;
+  LazyMetadataPositions.reserve(Record.size());
+  uint64_t Pos = BeginPos;
+  for (uint64_t Delta : Record) {
+    Pos += Delta;
+    LazyMetadataPositions.push_back(Pos);
+  }
+  LazyMetadataLoading.resize(Record.size());
+  NextMDValueNo += Record.size();
+  MDValueList.resize(NextMDValueNo);
+  return std::error_code();
+}
+
+/// Load the metadata \p ID from the indexed METADATA_BLOCK, loading the
+/// metadata it references first.
+std::error_code BitcodeReader::lazyLoadMetadata(unsigned ID) {
+  uint64_t Pos = LazyMetadataPositions[ID - LazyMetadataBaseID];
+  if (!LazyMetadataCursor.canSkipToPos(Pos / 8))
+    return Error("Invalid record");
+  LazyMetadataCursor.JumpToBit(Pos);
+  BitstreamEntry Entry = LazyMetadataCursor.advanceSkippingSubblocks();
+  if (Entry.Kind != BitstreamEntry::Record)
+    return Error("Malformed block");
+  SmallVector<uint64_t, 64> Record;
+  unsigned Code = LazyMetadataCursor.readRecord(Entry.ID, Record);
+
+  ++LazyMetadataLoadDepth;
+  LazyMetadataLoading.set(ID - LazyMetadataBaseID);
+  unsigned NextMDValueNo = ID;
+  std::error_code EC = ParseMetadataRecord(Code, Record, NextMDValueNo);
+  LazyMetadataLoading.reset(ID - LazyMetadataBaseID);
+  if (--LazyMetadataLoadDepth == 0)
+    MDValueList.tryToResolveCycles();
+  if (!EC && NextMDValueNo != ID + 1)
+    return Error("Invalid record");
+  return EC;
+}
+
+/// Returns the metadata \p ID, loading it if it has not been loaded yet, or a
+/// placeholder if it is a forward reference.
+Metadata *BitcodeReader::getMetadataFwdRef(unsigned ID) {
+  if (ID >= LazyMetadataBaseID &&
+      ID - LazyMetadataBaseID < LazyMetadataPositions.size() &&
+      !MDValueList[ID] && !LazyMetadataLoading.test(ID - LazyMetadataBaseID))
+    if (std::error_code EC = lazyLoadMetadata(ID))
+      report_fatal_error("Failed to load metadata: " + EC.message());
+  return MDValueList.getValueFwdRef(ID);
+}
+
 /// decodeSignRotatedValue - Decode a signed value stored with the sign bit in
 /// the LSB for dense VBR encoding.
 uint64_t BitcodeReader::decodeSignRotatedValue(uint64_t V) {
@@ -3191,6 +3342,345 @@ ErrorOr<std::string> BitcodeReader::parseTriple() {
   }
 }
 
+std::error_code BitcodeReader::parseModuleStringTable(
+    FunctionInfoIndex &Index, DenseMap<uint64_t, StringRef> &ModulePaths) {
+  if (Stream.EnterSubBlock(bitc::MODULE_STRTAB_BLOCK_ID))
+    return Error("Invalid record");
+
+  SmallVector<uint64_t, 64> Record;
+  while (1) {
+    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::SubBlock: // Handled for us already.
+    case BitstreamEntry::Error:
+      return Error("Malformed block");
+    case BitstreamEntry::EndBlock:
+      return std::error_code();
+    case BitstreamEntry::Record:
+      // The interesting case.
+      break;
+    }
+
+    Record.clear();
+    switch (Stream.readRecord(Entry.ID, Record)) {
+    default: break;  // Default behavior, ignore unknown content.
+    case bitc::MST_CODE_ENTRY: { // MST_ENTRY: [modid, namechar x N]
+      std::string Path;
+      if (Record.empty() || ConvertToString(Record, 1, Path))
+        return Error("Invalid record");
+      ModulePaths[Record[0]] = Index.addModulePath(Path, Record[0]);
+      break;
+    }
+    }
+  }
+}
+
+std::error_code BitcodeReader::parseFunctionSummaryBlock(
+    FunctionInfoIndex &Index, const DenseMap<uint64_t, StringRef> &ModulePaths) {
+  if (Stream.EnterSubBlock(bitc::FUNCTION_SUMMARY_BLOCK_ID))
+    return Error("Invalid record");
+
+  SmallVector<uint64_t, 64> Record;
+  // The summary the call and reference records belong to.
+  FunctionSummary *CurrentSummary = nullptr;
+  while (1) {
+    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::SubBlock: // Handled for us already.
+    case BitstreamEntry::Error:
+      return Error("Malformed block");
+    case BitstreamEntry::EndBlock:
+      return std::error_code();
+    case BitstreamEntry::Record:
+      // The interesting case.
+      break;
+    }
+
+    Record.clear();
+    unsigned Code = Stream.readRecord(Entry.ID, Record);
+    switch (Code) {
+    default: break;  // Default behavior, ignore unknown content.
+    case bitc::FS_CODE_PERMODULE_ENTRY:   // [linkage, instcount, namechar x N]
+    case bitc::FS_CODE_COMBINED_ENTRY: {  // [modid, linkage, instcount,
+                                          //  namechar x N]
+      unsigned Idx = 0;
+      uint64_t ModId = 0;
+      if (Code == bitc::FS_CODE_COMBINED_ENTRY) {
+        if (Record.empty())
+          return Error("Invalid record");
+        ModId = Record[Idx++];
+      }
+      std::string Name;
+      if (Record.size() < Idx + 2 || ConvertToString(Record, Idx + 2, Name))
+        return Error("Invalid record");
+      auto Path = ModulePaths.find(ModId);
+      if (Path == ModulePaths.end())
+        return Error("Invalid module id");
+
+      auto Summary = make_unique<FunctionSummary>(
+          getDecodedLinkage(Record[Idx]), Record[Idx + 1]);
+      Summary->setModulePath(Path->second);
+      CurrentSummary = Summary.get();
+      Index.addFunctionSummary(Name, std::move(Summary));
+      break;
+    }
+    case bitc::FS_CODE_CALL:   // CALL: [namechar x N]
+    case bitc::FS_CODE_REF: {  // REF: [namechar x N]
+      std::string Name;
+      if (!CurrentSummary || ConvertToString(Record, 0, Name))
+        return Error("Invalid record");
+      if (Code == bitc::FS_CODE_CALL)
+        CurrentSummary->addCall(Name);
+      else
+        CurrentSummary->addRef(Name);
+      break;
+    }
+    }
+  }
+}
+
+std::error_code
+BitcodeReader::parseModuleFunctionSummary(FunctionInfoIndex &Index) {
+  if (Stream.EnterSubBlock(bitc::MODULE_BLOCK_ID))
+    return Error("Invalid record");
+
+  // The summaries of a module are attributed to the module's own buffer.
+  DenseMap<uint64_t, StringRef> ModulePaths;
+  ModulePaths[0] = Index.addModulePath(Buffer->getBufferIdentifier(), 0);
+
+  // Skip everything but the function summary block, which is written after
+  // the function bodies.
+  while (1) {
+    BitstreamEntry Entry = Stream.advance();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      return Error("Malformed block");
+    case BitstreamEntry::EndBlock:
+      return std::error_code();
+
+    case BitstreamEntry::SubBlock:
+      if (Entry.ID == bitc::FUNCTION_SUMMARY_BLOCK_ID) {
+        if (std::error_code EC = parseFunctionSummaryBlock(Index, ModulePaths))
+          return EC;
+        continue;
+      }
+      if (Stream.SkipBlock())
+        return Error("Malformed block");
+      continue;
+
+    case BitstreamEntry::Record:
+      Stream.skipRecord(Entry.ID);
+      continue;
+    }
+  }
+}
+
+std::error_code
+BitcodeReader::parseSymbolTableBlock(BitcodeSymbolTable &Symtab) {
+  if (Stream.EnterSubBlock(bitc::SYMTAB_BLOCK_ID))
+    return Error("Invalid record");
+
+  SmallVector<uint64_t, 64> Record;
+  while (1) {
+    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::SubBlock: // Handled for us already.
+    case BitstreamEntry::Error:
+      return Error("Malformed block");
+    case BitstreamEntry::EndBlock:
+      return std::error_code();
+    case BitstreamEntry::Record:
+      // The interesting case.
+      break;
+    }
+
+    Record.clear();
+    switch (Stream.readRecord(Entry.ID, Record)) {
+    default: break;  // Default behavior, ignore unknown content.
+    case bitc::SYMTAB_CODE_TRIPLE: { // TRIPLE: [strchr x N]
+      Symtab.TargetTriple.clear();
+      if (ConvertToString(Record, 0, Symtab.TargetTriple))
+        return Error("Invalid record");
+      break;
+    }
+    case bitc::SYMTAB_CODE_DATALAYOUT: { // DATALAYOUT: [strchr x N]
+      Symtab.DataLayoutStr.clear();
+      if (ConvertToString(Record, 0, Symtab.DataLayoutStr))
+        return Error("Invalid record");
+      break;
+    }
+    case bitc::SYMTAB_CODE_COMDAT: { // COMDAT: [selection_kind, namechar x N]
+      std::string Name;
+      if (Record.empty() || ConvertToString(Record, 1, Name))
+        return Error("Invalid record");
+      Symtab.Comdats.push_back(
+          std::make_pair(Name, getDecodedComdatSelectionKind(Record[0])));
+      break;
+    }
+    case bitc::SYMTAB_CODE_SYMBOL: { // SYMBOL: [flags, linkage, visibility,
+                                     //          alignment, comdat, commonsize,
+                                     //          namechar x N]
+      BitcodeSymbolTable::Symbol Sym;
+      if (Record.size() < 6 || ConvertToString(Record, 6, Sym.Name))
+        return Error("Invalid record");
+      Sym.Flags = Record[0];
+      Sym.Linkage = getDecodedLinkage(Record[1]);
+      if (!GlobalValue::isLocalLinkage(Sym.Linkage))
+        Sym.Visibility = GetDecodedVisibility(Record[2]);
+      if (std::error_code EC = parseAlignmentValue(Record[3], Sym.Alignment))
+        return EC;
+      if (Record[4] > Symtab.Comdats.size())
+        return Error("Invalid comdat");
+      Sym.ComdatIndex = int(Record[4]) - 1;
+      Sym.CommonSize = Record[5];
+      Symtab.Symbols.push_back(std::move(Sym));
+      break;
+    }
+    case bitc::SYMTAB_CODE_LINKER_OPTION: { // LINKER_OPTION: [strchr x N]
+      std::string Option;
+      if (ConvertToString(Record, 0, Option))
+        return Error("Invalid record");
+      Symtab.LinkerOptions.push_back(std::move(Option));
+      break;
+    }
+    }
+  }
+}
+
+ErrorOr<std::unique_ptr<BitcodeSymbolTable>>
+BitcodeReader::parseModuleSymbolTable() {
+  if (Stream.EnterSubBlock(bitc::MODULE_BLOCK_ID))
+    return Error("Invalid record");
+
+  // The symbol table is the first block of the module, if any.
+  while (1) {
+    BitstreamEntry Entry = Stream.advance();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      return Error("Malformed block");
+    case BitstreamEntry::EndBlock:
+      return std::unique_ptr<BitcodeSymbolTable>();
+
+    case BitstreamEntry::SubBlock: {
+      if (Entry.ID != bitc::SYMTAB_BLOCK_ID)
+        return std::unique_ptr<BitcodeSymbolTable>();
+      auto Symtab = llvm::make_unique<BitcodeSymbolTable>();
+      if (std::error_code EC = parseSymbolTableBlock(*Symtab))
+        return EC;
+      return std::move(Symtab);
+    }
+
+    case BitstreamEntry::Record:
+      Stream.skipRecord(Entry.ID);
+      continue;
+    }
+  }
+}
+
+ErrorOr<std::unique_ptr<BitcodeSymbolTable>>
+BitcodeReader::parseSymbolTable() {
+  if (std::error_code EC = InitStream())
+    return EC;
+
+  // Sniff for the signature.
+  if (Stream.Read(8) != 'B' ||
+      Stream.Read(8) != 'C' ||
+      Stream.Read(4) != 0x0 ||
+      Stream.Read(4) != 0xC ||
+      Stream.Read(4) != 0xE ||
+      Stream.Read(4) != 0xD)
+    return Error("Invalid bitcode signature");
+
+  while (1) {
+    if (Stream.AtEndOfStream())
+      return std::unique_ptr<BitcodeSymbolTable>();
+
+    BitstreamEntry Entry = Stream.advance();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      return Error("Malformed block");
+    case BitstreamEntry::EndBlock:
+      return std::unique_ptr<BitcodeSymbolTable>();
+
+    case BitstreamEntry::SubBlock:
+      if (Entry.ID == bitc::MODULE_BLOCK_ID)
+        return parseModuleSymbolTable();
+
+      // Ignore other sub-blocks.
+      if (Stream.SkipBlock())
+        return Error("Malformed block");
+      continue;
+
+    case BitstreamEntry::Record:
+      Stream.skipRecord(Entry.ID);
+      continue;
+    }
+  }
+}
+
+std::error_code BitcodeReader::parseFunctionInfoIndex(FunctionInfoIndex &Index) {
+  if (std::error_code EC = InitStream())
+    return EC;
+
+  // Sniff for the signature.
+  if (Stream.Read(8) != 'B' ||
+      Stream.Read(8) != 'C' ||
+      Stream.Read(4) != 0x0 ||
+      Stream.Read(4) != 0xC ||
+      Stream.Read(4) != 0xE ||
+      Stream.Read(4) != 0xD)
+    return Error("Invalid bitcode signature");
+
+  // A module with a function summary, or a combined index: a module path
+  // table followed by the function summary block.
+  DenseMap<uint64_t, StringRef> ModulePaths;
+  while (1) {
+    if (Stream.AtEndOfStream())
+      return std::error_code();
+
+    BitstreamEntry Entry = Stream.advance();
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::Error:
+      return Error("Malformed block");
+    case BitstreamEntry::EndBlock:
+      return std::error_code();
+
+    case BitstreamEntry::SubBlock:
+      switch (Entry.ID) {
+      case bitc::MODULE_BLOCK_ID:
+        if (std::error_code EC = parseModuleFunctionSummary(Index))
+          return EC;
+        break;
+      case bitc::MODULE_STRTAB_BLOCK_ID:
+        if (std::error_code EC = parseModuleStringTable(Index, ModulePaths))
+          return EC;
+        break;
+      case bitc::FUNCTION_SUMMARY_BLOCK_ID:
+        if (std::error_code EC = parseFunctionSummaryBlock(Index, ModulePaths))
+          return EC;
+        break;
+      default:
+        // Ignore other sub-blocks.
+        if (Stream.SkipBlock())
+          return Error("Malformed block");
+        break;
+      }
+      continue;
+
+    case BitstreamEntry::Record:
+      Stream.skipRecord(Entry.ID);
+      continue;
+    }
+  }
+}
+
 /// ParseMetadataAttachment - Parse metadata attachments.
 std::error_code BitcodeReader::ParseMetadataAttachment() {
   if (Stream.EnterSubBlock(bitc::METADATA_ATTACHMENT_ID))
@@ -3227,7 +3717,7 @@ std::error_code BitcodeReader::ParseMetadataAttachment() {
           MDKindMap.find(Kind);
         if (I == MDKindMap.end())
           return Error("Invalid ID");
-        Metadata *Node = MDValueList.getValueFwdRef(Record[i + 1]);
+        Metadata *Node = getMetadataFwdRef(Record[i + 1]);
         if (isa<LocalAsMetadata>(Node))
           // Drop the attachment.  This used to be legal, but there's no
           // upgrade path.
@@ -3377,8 +3867,8 @@ std::error_code BitcodeReader::ParseFunctionBody(Function *F) {
       unsigned ScopeID = Record[2], IAID = Record[3];
 
       MDNode *Scope = nullptr, *IA = nullptr;
-      if (ScopeID) Scope = cast<MDNode>(MDValueList.getValueFwdRef(ScopeID-1));
-      if (IAID)    IA = cast<MDNode>(MDValueList.getValueFwdRef(IAID-1));
+      if (ScopeID) Scope = cast<MDNode>(getMetadataFwdRef(ScopeID - 1));
+      if (IAID)    IA = cast<MDNode>(getMetadataFwdRef(IAID - 1));
       LastLoc = DebugLoc::get(Line, Col, Scope, IA);
       I->setDebugLoc(LastLoc);
       I = nullptr;
@@ -4521,6 +5011,11 @@ getLazyBitcodeModuleImpl(std::unique_ptr<MemoryBuffer> &&Buffer,
     return EC;
   };
 
+  // Only load the module-level metadata that is used when not everything is
+  // going to be materialized.
+  if (!WillMaterializeAll)
+    R->setLazyLoadMetadataRecords();
+
   // Delay parsing Metadata if ShouldLazyLoadMetadata is true.
   if (std::error_code EC = R->ParseBitcodeInto(M, ShouldLazyLoadMetadata))
     return cleanupOnError(EC);
@@ -4576,6 +5071,27 @@ llvm::parseBitcodeFile(MemoryBufferRef Buffer, LLVMContext &Context,
   return M;
 }
 
+ErrorOr<std::unique_ptr<FunctionInfoIndex>>
+llvm::getFunctionInfoIndex(MemoryBufferRef Buffer, LLVMContext &Context,
+                           DiagnosticHandlerFunction DiagnosticHandler) {
+  std::unique_ptr<MemoryBuffer> Buf = MemoryBuffer::getMemBuffer(Buffer, false);
+  auto R = llvm::make_unique<BitcodeReader>(Buf.release(), Context,
+                                            DiagnosticHandler);
+  auto Index = llvm::make_unique<FunctionInfoIndex>();
+  if (std::error_code EC = R->parseFunctionInfoIndex(*Index))
+    return EC;
+  return std::move(Index);
+}
+
+ErrorOr<std::unique_ptr<BitcodeSymbolTable>>
+llvm::getBitcodeSymbolTable(MemoryBufferRef Buffer, LLVMContext &Context,
+                            DiagnosticHandlerFunction DiagnosticHandler) {
+  std::unique_ptr<MemoryBuffer> Buf = MemoryBuffer::getMemBuffer(Buffer, false);
+  auto R = llvm::make_unique<BitcodeReader>(Buf.release(), Context,
+                                            DiagnosticHandler);
+  return R->parseSymbolTable();
+}
+
 std::string
 llvm::getBitcodeTargetTriple(MemoryBufferRef Buffer, LLVMContext &Context,
                              DiagnosticHandlerFunction DiagnosticHandler) {
@@ -13,14 +13,17 @@
 
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "ValueEnumerator.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Bitcode/BitstreamWriter.h"
 #include "llvm/Bitcode/LLVMBitCodes.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/FunctionInfo.h"
 #include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/Mangler.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Operator.h"
 #include "llvm/IR/UseListOrder.h"
@@ -34,6 +37,11 @@
 #include <map>
 using namespace llvm;
 
+static cl::opt<unsigned> MetadataIndexThreshold(
+    "bitcode-mdindex-threshold", cl::Hidden, cl::init(25),
+    cl::desc("Number of module-level metadata above which an index of their "
+             "records is emitted, allowing readers to load them lazily"));
+
 /// These are manifest constants used by the bitcode writer. They do not need to
 /// be kept in sync with the reader, but need to be consistent within this file.
 enum {
@@ -477,8 +485,8 @@ static void WriteTypeTable(const ValueEnumerator &VE, BitstreamWriter &Stream) {
   Stream.ExitBlock();
 }
 
-static unsigned getEncodedLinkage(const GlobalValue &GV) {
-  switch (GV.getLinkage()) {
+static unsigned getEncodedLinkage(GlobalValue::LinkageTypes Linkage) {
+  switch (Linkage) {
   case GlobalValue::ExternalLinkage:
     return 0;
   case GlobalValue::WeakAnyLinkage:
@@ -505,6 +513,10 @@ static unsigned getEncodedLinkage(const GlobalValue &GV) {
   llvm_unreachable("Invalid linkage");
 }
 
+static unsigned getEncodedLinkage(const GlobalValue &GV) {
+  return getEncodedLinkage(GV.getLinkage());
+}
+
 static unsigned getEncodedVisibility(const GlobalValue &GV) {
   switch (GV.getVisibility()) {
   case GlobalValue::DefaultVisibility:   return 0;
@@ -1145,7 +1157,8 @@ static void WriteModuleMetadata(const Module *M,
   if (MDs.empty() && M->named_metadata_empty())
     return;
 
-  Stream.EnterSubblock(bitc::METADATA_BLOCK_ID, 3);
+  // Up to six abbreviations are defined below, which needs 4 bits.
+  Stream.EnterSubblock(bitc::METADATA_BLOCK_ID, 4);
 
   unsigned MDSAbbrev = 0;
   if (VE.hasMDString()) {
@@ -1203,7 +1216,39 @@ static void WriteModuleMetadata(const Module *M,
   }
 
   SmallVector<uint64_t, 64> Record;
+
+  // With enough metadata, emit an index of the records so that lazy readers
+  // can load them on demand. The index is emitted after the records; its
+  // offset is written in a METADATA_INDEX_OFFSET placeholder, backpatched
+  // once the records have been emitted.
+  bool EmitIndex = MDs.size() > MetadataIndexThreshold;
+  unsigned IndexAbbrev = 0;
+  uint64_t IndexOffsetRecordBitPos = 0;
+  SmallVector<uint64_t, 0> IndexPos;
+  if (EmitIndex) {
+    BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+    Abbv->Add(BitCodeAbbrevOp(bitc::METADATA_INDEX_OFFSET));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32));
+    unsigned OffsetAbbrev = Stream.EmitAbbrev(Abbv);
+
+    Abbv = new BitCodeAbbrev();
+    Abbv->Add(BitCodeAbbrevOp(bitc::METADATA_INDEX));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
+    IndexAbbrev = Stream.EmitAbbrev(Abbv);
+
+    Record.append(2, uint64_t(0));
+    Stream.EmitRecord(bitc::METADATA_INDEX_OFFSET, Record, OffsetAbbrev);
+    Record.clear();
+    IndexOffsetRecordBitPos = Stream.GetCurrentBitNo();
+    IndexPos.reserve(MDs.size());
+  }
+
   for (const Metadata *MD : MDs) {
+    if (EmitIndex)
+      IndexPos.push_back(Stream.GetCurrentBitNo());
+
     if (const MDNode *N = dyn_cast<MDNode>(MD)) {
       assert(N->isResolved() && "Expected forward references to be resolved");
 
@@ -1230,6 +1275,21 @@ static void WriteModuleMetadata(const Module *M,
     Record.clear();
   }
 
+  if (EmitIndex) {
+    // Fill in the offset of the index, relative to the end of the
+    // METADATA_INDEX_OFFSET record, and emit the position of each record,
+    // delta encoded from the same point.
+    Stream.BackpatchWord64(IndexOffsetRecordBitPos - 64,
+                           Stream.GetCurrentBitNo() - IndexOffsetRecordBitPos);
+    uint64_t PreviousPos = IndexOffsetRecordBitPos;
+    for (uint64_t &Pos : IndexPos) {
+      uint64_t Delta = Pos - PreviousPos;
+      PreviousPos = Pos;
+      Pos = Delta;
+    }
+    Stream.EmitRecord(bitc::METADATA_INDEX, IndexPos, IndexAbbrev);
+  }
+
   // Write named metadata.
   for (const NamedMDNode &NMD : M->named_metadata()) {
     // Write name.
@@ -2308,8 +2368,165 @@ static void WriteBlockInfo(const ValueEnumerator &VE, BitstreamWriter &Stream) {
   Stream.ExitBlock();
 }
 
+/// Emit a function summary record: the fixed fields in \p Fields followed by
+/// the characters of \p Name.
+static void WriteSummaryRecord(unsigned Code, ArrayRef<uint64_t> Fields,
+                               StringRef Name, unsigned AbbrevToUse,
+                               BitstreamWriter &Stream) {
+  SmallVector<uint64_t, 64> Vals(Fields.begin(), Fields.end());
+  for (char C : Name)
+    Vals.push_back((unsigned char)C);
+  Stream.EmitRecord(Code, Vals, AbbrevToUse);
+}
+
+/// Emit the calls and references of a function summary, which follow its
+/// entry record.
+static void WriteSummaryEdges(const FunctionSummary &Summary,
+                              unsigned NameAbbrev, BitstreamWriter &Stream) {
+  for (const std::string &Callee : Summary.calls())
+    WriteSummaryRecord(bitc::FS_CODE_CALL, None, Callee, NameAbbrev, Stream);
+  for (const std::string &Ref : Summary.refs())
+    WriteSummaryRecord(bitc::FS_CODE_REF, None, Ref, NameAbbrev, Stream);
+}
+
+/// Emit the abbreviation for call and reference records.
+static unsigned EmitSummaryNameAbbrev(BitstreamWriter &Stream) {
+  BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 3)); // FS_CODE_CALL/REF
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 8));
+  return Stream.EmitAbbrev(Abbv);
+}
+
+/// Emit the summary of every function defined in the module, which lets the
+/// function summary index be built without parsing the module.
+static void WritePerModuleFunctionSummary(const Module *M,
+                                          BitstreamWriter &Stream) {
+  Stream.EnterSubblock(bitc::FUNCTION_SUMMARY_BLOCK_ID, 3);
+
+  BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::FS_CODE_PERMODULE_ENTRY));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 5)); // linkage
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // instcount
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 8));
+  unsigned EntryAbbrev = Stream.EmitAbbrev(Abbv);
+  unsigned NameAbbrev = EmitSummaryNameAbbrev(Stream);
+
+  for (const Function &F : *M) {
+    if (F.isDeclaration() || !F.hasName())
+      continue;
+    std::unique_ptr<FunctionSummary> Summary = FunctionSummary::compute(F);
+    uint64_t Fields[] = {getEncodedLinkage(Summary->getLinkage()),
+                         Summary->instCount()};
+    WriteSummaryRecord(bitc::FS_CODE_PERMODULE_ENTRY, Fields, F.getName(),
+                       EntryAbbrev, Stream);
+    WriteSummaryEdges(*Summary, NameAbbrev, Stream);
+  }
+
+  Stream.ExitBlock();
+}
+
+/// Returns the bitc::SymtabSymbolFlags of \p GV. The flags that depend on
+/// the name and section of \p GV follow IRObjectFile::getSymbolFlags().
+static unsigned getSymbolTableFlags(const GlobalValue &GV) {
+  unsigned Flags = 0;
+  if (GV.isDeclarationForLinker())
+    Flags |= bitc::SYMTAB_SYMBOL_UNDEFINED;
+  if (GV.getType()->getElementType()->isFunctionTy())
+    Flags |= bitc::SYMTAB_SYMBOL_FUNCTION;
+  if (GV.hasUnnamedAddr())
+    Flags |= bitc::SYMTAB_SYMBOL_UNNAMED_ADDR;
+  if (isa<GlobalAlias>(GV))
+    Flags |= bitc::SYMTAB_SYMBOL_ALIAS;
+
+  if (GV.getName().startswith("llvm."))
+    Flags |= bitc::SYMTAB_SYMBOL_FORMAT_SPECIFIC;
+  if (const auto *Var = dyn_cast<GlobalVariable>(&GV)) {
+    if (Var->isConstant())
+      Flags |= bitc::SYMTAB_SYMBOL_CONSTANT;
+    if (Var->getSection() == StringRef("llvm.metadata"))
+      Flags |= bitc::SYMTAB_SYMBOL_FORMAT_SPECIFIC;
+  }
+  return Flags;
+}
+
+/// Emit the symbol table of the module: its global values, in the order
+/// functions, variables then aliases, with their names mangled for the
+/// target. The comdats are emitted in the order of their first use.
+static void WriteSymbolTable(const Module *M, BitstreamWriter &Stream) {
+  Stream.EnterSubblock(bitc::SYMTAB_BLOCK_ID, 3);
+
+  BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::SYMTAB_CODE_SYMBOL));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // flags
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 5)); // linkage
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 2)); // visibility
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 3)); // alignment
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 4)); // comdat
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 4)); // commonsize
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 8));
+  unsigned SymbolAbbrev = Stream.EmitAbbrev(Abbv);
+
+  WriteStringRecord(bitc::SYMTAB_CODE_TRIPLE, M->getTargetTriple(), 0, Stream);
+
+  // The names are mangled according to the data layout of the module, which
+  // is recorded so that readers can tell if it matches their target.
+  const DataLayout &DL = M->getDataLayout();
+  WriteStringRecord(bitc::SYMTAB_CODE_DATALAYOUT, DL.getStringRepresentation(),
+                    0, Stream);
+  Mangler Mang(&DL);
+  DenseMap<const Comdat *, unsigned> ComdatIDs;
+  SmallString<64> Name;
+  auto WriteSymbol = [&](const GlobalValue &GV) {
+    unsigned ComdatID = 0;
+    if (const Comdat *C = GV.getComdat()) {
+      auto Insertion = ComdatIDs.insert(std::make_pair(C, ComdatIDs.size()));
+      if (Insertion.second) {
+        uint64_t Fields[] = {getEncodedComdatSelectionKind(*C)};
+        WriteSummaryRecord(bitc::SYMTAB_CODE_COMDAT, Fields, C->getName(), 0,
+                           Stream);
+      }
+      ComdatID = Insertion.first->second + 1;
+    }
+
+    uint64_t CommonSize = 0;
+    if (GV.hasCommonLinkage())
+      CommonSize = DL.getTypeAllocSize(GV.getType()->getElementType());
+
+    Name.clear();
+    Mang.getNameWithPrefix(Name, &GV, false);
+    uint64_t Fields[] = {getSymbolTableFlags(GV),
+                         getEncodedLinkage(GV),
+                         getEncodedVisibility(GV),
+                         Log2_32(GV.getAlignment()) + 1,
+                         ComdatID,
+                         CommonSize};
+    WriteSummaryRecord(bitc::SYMTAB_CODE_SYMBOL, Fields, Name, SymbolAbbrev,
+                       Stream);
+  };
+  for (const Function &F : *M)
+    WriteSymbol(F);
+  for (const GlobalVariable &Var : M->globals())
+    WriteSymbol(Var);
+  for (const GlobalAlias &A : M->aliases())
+    WriteSymbol(A);
+
+  if (Metadata *Val = M->getModuleFlag("Linker Options")) {
+    MDNode *LinkerOptions = cast<MDNode>(Val);
+    for (const MDOperand &MDOptions : LinkerOptions->operands())
+      for (const MDOperand &MDOption : cast<MDNode>(MDOptions)->operands())
+        WriteStringRecord(bitc::SYMTAB_CODE_LINKER_OPTION,
+                          cast<MDString>(MDOption)->getString(), 0, Stream);
+  }
+
+  Stream.ExitBlock();
+}
+
 /// WriteModule - Emit the specified module to the bitstream.
-static void WriteModule(const Module *M, BitstreamWriter &Stream) {
+static void WriteModule(const Module *M, BitstreamWriter &Stream,
+                        bool EmitFunctionSummary, bool EmitSymbolTable) {
   Stream.EnterSubblock(bitc::MODULE_BLOCK_ID, 3);
 
   SmallVector<unsigned, 1> Vals;
@@ -2317,6 +2534,12 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream) {
   Vals.push_back(CurVersion);
   Stream.EmitRecord(bitc::MODULE_CODE_VERSION, Vals);
 
+  // Emit the symbol table first, so that readers looking for it can stop at
+  // the first block of the module. The symbols of module-level inline asm are
+  // only known to the target, so there is no table when there is inline asm.
+  if (EmitSymbolTable && M->getModuleInlineAsm().empty())
+    WriteSymbolTable(M, Stream);
+
   // Analyze the module, enumerating globals, functions, etc.
   ValueEnumerator VE(*M);
 
@@ -2359,6 +2582,11 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream) {
     if (!F->isDeclaration())
       WriteFunction(*F, VE, Stream);
 
+  // Emit the function summaries last, so that reading the module does not
+  // need to skip over them before reaching the function bodies.
+  if (EmitFunctionSummary)
+    WritePerModuleFunctionSummary(M, Stream);
+
   Stream.ExitBlock();
 }
 
@@ -2435,9 +2663,20 @@ static void EmitDarwinBCHeaderAndTrailer(SmallVectorImpl<char> &Buffer,
     Buffer.push_back(0);
 }
 
+/// Emit the bitcode file signature.
+static void WriteBitcodeHeader(BitstreamWriter &Stream) {
+  Stream.Emit((unsigned)'B', 8);
+  Stream.Emit((unsigned)'C', 8);
+  Stream.Emit(0x0, 4);
+  Stream.Emit(0xC, 4);
+  Stream.Emit(0xE, 4);
+  Stream.Emit(0xD, 4);
+}
+
 /// WriteBitcodeToFile - Write the specified module to the specified output
 /// stream.
-void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out) {
+void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out,
+                              bool EmitFunctionSummary, bool EmitSymbolTable) {
   SmallVector<char, 0> Buffer;
   Buffer.reserve(256*1024);
 
@@ -2452,15 +2691,10 @@ void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out) {
     BitstreamWriter Stream(Buffer);
 
     // Emit the file header.
-    Stream.Emit((unsigned)'B', 8);
-    Stream.Emit((unsigned)'C', 8);
-    Stream.Emit(0x0, 4);
-    Stream.Emit(0xC, 4);
-    Stream.Emit(0xE, 4);
-    Stream.Emit(0xD, 4);
+    WriteBitcodeHeader(Stream);
 
     // Emit the module.
-    WriteModule(M, Stream);
+    WriteModule(M, Stream, EmitFunctionSummary, EmitSymbolTable);
   }
 
   if (TT.isOSDarwin())
@@ -2469,3 +2703,58 @@ void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out) {
   // Write the generated bitstream to "Out".
   Out.write((char*)&Buffer.front(), Buffer.size());
 }
+
+/// Write the combined function summary index \p Index to \p Out. The module
+/// path table comes first, so that the summaries can refer to module ids.
+void llvm::WriteFunctionSummaryToFile(const FunctionInfoIndex &Index,
+                                      raw_ostream &Out) {
+  SmallVector<char, 0> Buffer;
+  Buffer.reserve(256 * 1024);
+  {
+    BitstreamWriter Stream(Buffer);
+    WriteBitcodeHeader(Stream);
+
+    // Sort the module paths and the function names so that the output does
+    // not depend on the hashing of the index tables.
+    std::vector<std::pair<uint64_t, StringRef>> ModulePaths;
+    for (auto &Entry : Index.modulePaths())
+      ModulePaths.push_back(std::make_pair(Entry.second, Entry.first()));
+    std::sort(ModulePaths.begin(), ModulePaths.end());
+
+    Stream.EnterSubblock(bitc::MODULE_STRTAB_BLOCK_ID, 3);
+    for (auto &Entry : ModulePaths)
+      WriteSummaryRecord(bitc::MST_CODE_ENTRY, Entry.first, Entry.second, 0,
+                         Stream);
+    Stream.ExitBlock();
+
+    std::vector<StringRef> Names;
+    for (auto &Entry : Index)
+      Names.push_back(Entry.first());
+    std::sort(Names.begin(), Names.end());
+
+    Stream.EnterSubblock(bitc::FUNCTION_SUMMARY_BLOCK_ID, 3);
+    BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+    Abbv->Add(BitCodeAbbrevOp(bitc::FS_CODE_COMBINED_ENTRY));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // modid
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 5)); // linkage
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // instcount
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Array));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 8));
+    unsigned EntryAbbrev = Stream.EmitAbbrev(Abbv);
+    unsigned NameAbbrev = EmitSummaryNameAbbrev(Stream);
+
+    for (StringRef Name : Names) {
+      for (auto &Summary : *Index.findFunctionSummaryList(Name)) {
+        uint64_t Fields[] = {Index.getModuleId(Summary->modulePath()),
+                             getEncodedLinkage(Summary->getLinkage()),
+                             Summary->instCount()};
+        WriteSummaryRecord(bitc::FS_CODE_COMBINED_ENTRY, Fields, Name,
+                           EntryAbbrev, Stream);
+        WriteSummaryEdges(*Summary, NameAbbrev, Stream);
+      }
+    }
+    Stream.ExitBlock();
+  }
+
+  Out.write((char *)&Buffer.front(), Buffer.size());
+}
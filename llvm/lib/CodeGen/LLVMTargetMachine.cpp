@@ -42,6 +42,13 @@ static cl::opt<cl::boolOrDefault>
 EnableFastISelOption("fast-isel", cl::Hidden,
   cl::desc("Enable the \"fast\" instruction selector"));
 
+// Run the machine passes on several functions at once.  Zero keeps the
+// classic pipeline; with any other value, the output does not depend on it.
+static cl::opt<unsigned>
+CodeGenThreads("codegen-threads", cl::init(0),
+  cl::desc("Number of threads running the machine passes of the functions "
+           "of a module (0 runs them in the pass pipeline)"));
+
 void LLVMTargetMachine::initAsmInfo() {
   MRI = TheTarget.createMCRegInfo(getTargetTriple());
   MII = TheTarget.createMCInstrInfo();
@@ -87,11 +94,15 @@ TargetIRAnalysis LLVMTargetMachine::getTargetIRAnalysis() {
 }
 
 /// addPassesToX helper drives creation and initialization of TargetPassConfig.
+/// addPassesToGenerateCode - Add the code generation passes up to, but not
+/// including, the AsmPrinter.  If DeferMachinePasses is set, the passes that
+/// run on machine functions are left for createParallelMachinePassesPass().
 static MCContext *addPassesToGenerateCode(LLVMTargetMachine *TM,
                                           PassManagerBase &PM,
                                           bool DisableVerify,
                                           AnalysisID StartAfter,
-                                          AnalysisID StopAfter) {
+                                          AnalysisID StopAfter,
+                                          bool DeferMachinePasses = false) {
 
   // Add internal analysis passes from the target machine.
   PM.add(createTargetTransformInfoWrapperPass(TM->getTargetIRAnalysis()));
@@ -133,7 +144,8 @@ static MCContext *addPassesToGenerateCode(LLVMTargetMachine *TM,
   if (PassConfig->addInstSelector())
     return nullptr;
 
-  PassConfig->addMachinePasses();
+  if (!DeferMachinePasses)
+    PassConfig->addMachinePasses();
 
   PassConfig->setInitialized();
 
@@ -147,8 +159,9 @@ bool LLVMTargetMachine::addPassesToEmitFile(PassManagerBase &PM,
                                             AnalysisID StartAfter,
                                             AnalysisID StopAfter) {
   // Add common CodeGen passes.
+  bool Parallel = CodeGenThreads != 0 && !StartAfter && !StopAfter;
   MCContext *Context = addPassesToGenerateCode(this, PM, DisableVerify,
-                                               StartAfter, StopAfter);
+                                               StartAfter, StopAfter, Parallel);
   if (!Context)
     return true;
 
@@ -219,7 +232,10 @@ bool LLVMTargetMachine::addPassesToEmitFile(PassManagerBase &PM,
   if (!Printer)
     return true;
 
-  PM.add(Printer);
+  if (Parallel)
+    PM.add(createParallelMachinePassesPass(CodeGenThreads, Printer));
+  else
+    PM.add(Printer);
 
   return false;
 }
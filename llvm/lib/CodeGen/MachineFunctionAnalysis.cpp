@@ -20,7 +20,7 @@ using namespace llvm;
 char MachineFunctionAnalysis::ID = 0;
 
 MachineFunctionAnalysis::MachineFunctionAnalysis(const TargetMachine &tm) :
-  FunctionPass(ID), TM(tm), MF(nullptr) {
+  FunctionPass(ID), TM(tm), MF(nullptr), AdoptedMF(nullptr), OwnsMF(true) {
   initializeMachineModuleInfoPass(*PassRegistry::getPassRegistry());
 }
 
@@ -45,12 +45,34 @@ bool MachineFunctionAnalysis::doInitialization(Module &M) {
 
 bool MachineFunctionAnalysis::runOnFunction(Function &F) {
   assert(!MF && "MachineFunctionAnalysis already initialized!");
+  if (AdoptedMF) {
+    assert(AdoptedMF->getFunction() == &F &&
+           "Adopted MachineFunction is for another function!");
+    MF = AdoptedMF;
+    AdoptedMF = nullptr;
+    OwnsMF = false;
+    return false;
+  }
   MF = new MachineFunction(&F, TM, NextFnNum++,
                            getAnalysis<MachineModuleInfo>());
+  OwnsMF = true;
   return false;
 }
 
 void MachineFunctionAnalysis::releaseMemory() {
-  delete MF;
+  if (OwnsMF)
+    delete MF;
   MF = nullptr;
 }
+
+MachineFunction *MachineFunctionAnalysis::takeMF() {
+  assert(OwnsMF && "MachineFunction is not owned by this pass!");
+  MachineFunction *Result = MF;
+  MF = nullptr;
+  return Result;
+}
+
+void MachineFunctionAnalysis::adoptMF(MachineFunction *NewMF) {
+  assert(!MF && !AdoptedMF && "MachineFunctionAnalysis already initialized!");
+  AdoptedMF = NewMF;
+}
@@ -272,9 +272,9 @@ MachineModuleInfo::~MachineModuleInfo() {
 bool MachineModuleInfo::doInitialization(Module &M) {
 
   ObjFileMMI = nullptr;
-  CurCallSite = 0;
-  CallsEHReturn = 0;
-  CallsUnwindInit = 0;
+  CurFunction.CurCallSite = 0;
+  CurFunction.CallsEHReturn = 0;
+  CurFunction.CallsUnwindInit = 0;
   DbgInfoAvailable = UsesVAFloatArgument = UsesMorestackAddr = false;
   // Always emit some info, by default "no personality" info.
   Personalities.push_back(nullptr);
@@ -303,18 +303,57 @@ bool MachineModuleInfo::doFinalization(Module &M) {
 /// EndFunction - Discard function meta information.
 ///
 void MachineModuleInfo::EndFunction() {
+  FunctionState &FS = getFunctionState();
+
   // Clean up frame info.
-  FrameInstructions.clear();
+  FS.FrameInstructions.clear();
 
   // Clean up exception info.
-  LandingPads.clear();
-  CallSiteMap.clear();
-  TypeInfos.clear();
-  FilterIds.clear();
-  FilterEnds.clear();
-  CallsEHReturn = 0;
-  CallsUnwindInit = 0;
-  VariableDbgInfos.clear();
+  FS.LandingPads.clear();
+  FS.CallSiteMap.clear();
+  FS.TypeInfos.clear();
+  FS.FilterIds.clear();
+  FS.FilterEnds.clear();
+  FS.CallsEHReturn = 0;
+  FS.CallsUnwindInit = 0;
+  FS.VariableDbgInfos.clear();
+}
+
+void MachineModuleInfo::swapFunctionState(FunctionState &State) {
+  FunctionState &FS = getFunctionState();
+  FS.FrameInstructions.swap(State.FrameInstructions);
+  FS.LandingPads.swap(State.LandingPads);
+  FS.CallSiteMap.swap(State.CallSiteMap);
+  std::swap(FS.CurCallSite, State.CurCallSite);
+  FS.TypeInfos.swap(State.TypeInfos);
+  FS.FilterIds.swap(State.FilterIds);
+  FS.FilterEnds.swap(State.FilterEnds);
+  std::swap(FS.CallsEHReturn, State.CallsEHReturn);
+  std::swap(FS.CallsUnwindInit, State.CallsUnwindInit);
+  FS.VariableDbgInfos.swap(State.VariableDbgInfos);
+}
+
+/// The function state that FunctionStateScope installed on this thread, and
+/// the MachineModuleInfo it applies to.
+static LLVM_THREAD_LOCAL MachineModuleInfo *ScopeMMI = nullptr;
+static LLVM_THREAD_LOCAL MachineModuleInfo::FunctionState *ScopeState = nullptr;
+
+MachineModuleInfo::FunctionState &MachineModuleInfo::getFunctionState() {
+  if (ScopeMMI == this)
+    return *ScopeState;
+  return CurFunction;
+}
+
+MachineModuleInfo::FunctionStateScope::FunctionStateScope(
+    MachineModuleInfo &MMI, FunctionState &State)
+    : PrevMMI(ScopeMMI), PrevState(ScopeState) {
+  ScopeMMI = &MMI;
+  ScopeState = &State;
+}
+
+MachineModuleInfo::FunctionStateScope::~FunctionStateScope() {
+  ScopeMMI = PrevMMI;
+  ScopeState = PrevState;
 }
 
 /// AnalyzeModule - Scan the module for global debug information.
@@ -378,6 +417,7 @@ takeDeletedSymbolsForFunction(const Function *F,
 /// specified MachineBasicBlock.
 LandingPadInfo &MachineModuleInfo::getOrCreateLandingPadInfo
     (MachineBasicBlock *LandingPad) {
+  std::vector<LandingPadInfo> &LandingPads = getFunctionState().LandingPads;
   unsigned N = LandingPads.size();
   for (unsigned i = 0; i < N; ++i) {
     LandingPadInfo &LP = LandingPads[i];
@@ -472,6 +512,7 @@ MachineModuleInfo::addClauseForLandingPad(MachineBasicBlock *LandingPad) {
 /// TidyLandingPads - Remap landing pad labels and remove any deleted landing
 /// pads.
 void MachineModuleInfo::TidyLandingPads(DenseMap<MCSymbol*, uintptr_t> *LPMap) {
+  std::vector<LandingPadInfo> &LandingPads = getFunctionState().LandingPads;
   for (unsigned i = 0; i != LandingPads.size(); ) {
     LandingPadInfo &LandingPad = LandingPads[i];
     if (LandingPad.LandingPadLabel &&
@@ -524,6 +565,7 @@ void MachineModuleInfo::setCallSiteLandingPad(MCSymbol *Sym,
 /// getTypeIDFor - Return the type id for the specified typeinfo.  This is
 /// function wide.
 unsigned MachineModuleInfo::getTypeIDFor(const GlobalValue *TI) {
+  std::vector<const GlobalValue *> &TypeInfos = getFunctionState().TypeInfos;
   for (unsigned i = 0, N = TypeInfos.size(); i != N; ++i)
     if (TypeInfos[i] == TI) return i + 1;
 
@@ -534,6 +576,8 @@ unsigned MachineModuleInfo::getTypeIDFor(const GlobalValue *TI) {
 /// getFilterIDFor - Return the filter id for the specified typeinfos.  This is
 /// function wide.
 int MachineModuleInfo::getFilterIDFor(std::vector<unsigned> &TyIds) {
+  std::vector<unsigned> &FilterIds = getFunctionState().FilterIds;
+  std::vector<unsigned> &FilterEnds = getFunctionState().FilterEnds;
   // If the new filter coincides with the tail of an existing filter, then
   // re-use the existing filter.  Folding filters more than this requires
   // re-ordering filters and/or their elements - probably not worth it.
@@ -563,7 +607,7 @@ try_next:;
 
 /// getPersonality - Return the personality function for the current function.
 const Function *MachineModuleInfo::getPersonality() const {
-  for (const LandingPadInfo &LPI : LandingPads)
+  for (const LandingPadInfo &LPI : getFunctionState().LandingPads)
     if (LPI.Personality)
       return LPI.Personality;
   return nullptr;
@@ -577,6 +621,8 @@ EHPersonality MachineModuleInfo::getPersonalityType() {
 /// getPersonalityIndex - Return unique index for current personality
 /// function. NULL/first personality function should always get zero index.
 unsigned MachineModuleInfo::getPersonalityIndex() const {
+  const std::vector<LandingPadInfo> &LandingPads =
+      getFunctionState().LandingPads;
   const Function* Personality = nullptr;
 
   // Scan landing pads. If there is at least one non-NULL personality - use it.
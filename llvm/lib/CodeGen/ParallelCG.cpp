@@ -0,0 +1,98 @@
+//===-- ParallelCG.cpp ----------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines functions that can be used for parallel code generation.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/ParallelCG.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+
+using namespace llvm;
+
+static void codegen(Module *M, llvm::raw_ostream &OS, const Target *TheTarget,
+                    StringRef CPU, StringRef Features,
+                    const TargetOptions &Options, Reloc::Model RM,
+                    CodeModel::Model CM, CodeGenOpt::Level OL,
+                    TargetMachine::CodeGenFileType FileType) {
+  std::unique_ptr<TargetMachine> TM(TheTarget->createTargetMachine(
+      M->getTargetTriple(), CPU, Features, Options, RM, CM, OL));
+
+  legacy::PassManager CodeGenPasses;
+  formatted_raw_ostream FOS(OS);
+  if (TM->addPassesToEmitFile(CodeGenPasses, FOS, FileType))
+    report_fatal_error("Failed to setup codegen");
+  CodeGenPasses.run(*M);
+}
+
+void llvm::splitCodeGen(Module &M, ArrayRef<raw_ostream *> OSs, StringRef CPU,
+                        StringRef Features, const TargetOptions &Options,
+                        Reloc::Model RM, CodeModel::Model CM,
+                        CodeGenOpt::Level OL,
+                        TargetMachine::CodeGenFileType FileType) {
+  StringRef TripleStr = M.getTargetTriple();
+  std::string ErrMsg;
+  const Target *TheTarget = TargetRegistry::lookupTarget(TripleStr, ErrMsg);
+  if (!TheTarget)
+    report_fatal_error(Twine("Target not found: ") + ErrMsg);
+
+  if (OSs.size() == 1) {
+    codegen(&M, *OSs[0], TheTarget, CPU, Features, Options, RM, CM, OL,
+            FileType);
+    return;
+  }
+
+  // Each partition is serialized to bitcode on this thread, then deserialized
+  // into a fresh LLVMContext on its own thread, because an LLVMContext (and
+  // anything allocated in it) must only be touched by one thread at a time.
+  std::vector<SmallString<0>> BCs;
+  SplitModule(M, OSs.size(), [&](std::unique_ptr<Module> MPart) {
+    BCs.emplace_back();
+    raw_svector_ostream BCOS(BCs.back());
+    WriteBitcodeToFile(MPart.get(), BCOS);
+  });
+
+  auto CodegenPartition = [&](unsigned I) {
+    LLVMContext Ctx;
+    ErrorOr<Module *> MOrErr = parseBitcodeFile(
+        MemoryBufferRef(StringRef(BCs[I].data(), BCs[I].size()),
+                        "<split-module>"),
+        Ctx);
+    if (!MOrErr)
+      report_fatal_error("Failed to read bitcode");
+    std::unique_ptr<Module> MPart(MOrErr.get());
+    codegen(MPart.get(), *OSs[I], TheTarget, CPU, Features, Options, RM,
+            CM, OL, FileType);
+  };
+
+  if (!llvm_is_multithreaded()) {
+    for (unsigned I = 0, E = OSs.size(); I != E; ++I)
+      CodegenPartition(I);
+    return;
+  }
+
+  ThreadPool Pool(OSs.size() - 1);
+  for (unsigned I = 1, E = OSs.size(); I != E; ++I)
+    Pool.async(CodegenPartition, I);
+  // The calling thread takes the first partition.
+  CodegenPartition(0);
+  Pool.wait();
+}
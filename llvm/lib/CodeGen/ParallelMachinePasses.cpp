@@ -0,0 +1,296 @@
+//===-- ParallelMachinePasses.cpp - Run machine passes on many threads ----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a pass that takes the place of the machine passes and
+// the AsmPrinter at the end of the code generation pipeline (see
+// -codegen-threads).  It sets each machine function aside after instruction
+// selection, and once it holds a batch of them, runs the machine passes on
+// the batch on several threads.  The functions are then emitted one by one,
+// in their original order, so the output does not depend on the number of
+// threads.
+//
+// Every thread has a private pass manager holding its own instances of the
+// machine passes and alias analyses.  The module-level analyses of the outer
+// pipeline (MachineModuleInfo, TargetPassConfig, ...) are shared through
+// proxy passes.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Analysis/AssumptionCache.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/CodeGen/GCMetadata.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineFunctionAnalysis.h"
+#include "llvm/CodeGen/MachineModuleInfo.h"
+#include "llvm/CodeGen/Passes.h"
+#include "llvm/CodeGen/StackProtector.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Target/TargetMachine.h"
+#include <atomic>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "parallel-machine-passes"
+
+static cl::opt<unsigned> BatchSize(
+    "codegen-batch-size", cl::Hidden, cl::init(64),
+    cl::desc("Number of functions whose machine passes run together with "
+             "-codegen-threads"));
+
+namespace {
+/// AnalysisProxy - Stands for an analysis of the outer pass manager in one of
+/// the private pass managers, so that their passes use the outer instance.
+class AnalysisProxy : public ImmutablePass {
+  Pass *Target;
+
+public:
+  explicit AnalysisProxy(Pass *Target)
+      : ImmutablePass(*const_cast<char *>(
+            static_cast<const char *>(Target->getPassID()))),
+        Target(Target) {}
+
+  const char *getPassName() const override { return Target->getPassName(); }
+
+  void *getAdjustedAnalysisPointer(AnalysisID PI) override {
+    return Target->getAdjustedAnalysisPointer(PI);
+  }
+};
+
+/// PipelineInstance - A private pass manager running on the machine function
+/// handed to its MachineFunctionAnalysis.
+struct PipelineInstance {
+  std::unique_ptr<legacy::FunctionPassManager> FPM;
+  MachineFunctionAnalysis *MFA;
+
+  PipelineInstance() : MFA(nullptr) {}
+  PipelineInstance(PipelineInstance &&Other)
+      : FPM(std::move(Other.FPM)), MFA(Other.MFA) {}
+  PipelineInstance &operator=(PipelineInstance &&Other) {
+    FPM = std::move(Other.FPM);
+    MFA = Other.MFA;
+    return *this;
+  }
+
+  void run(MachineFunction &MF) {
+    MFA->adoptMF(&MF);
+    FPM->run(*const_cast<Function *>(MF.getFunction()));
+  }
+};
+
+/// PendingFunction - A function that went through instruction selection and
+/// waits for its machine passes.
+struct PendingFunction {
+  std::unique_ptr<MachineFunction> MF;
+  std::unique_ptr<MachineModuleInfo::FunctionState> State;
+
+  PendingFunction() {}
+  PendingFunction(PendingFunction &&Other)
+      : MF(std::move(Other.MF)), State(std::move(Other.State)) {}
+  PendingFunction &operator=(PendingFunction &&Other) {
+    MF = std::move(Other.MF);
+    State = std::move(Other.State);
+    return *this;
+  }
+};
+
+class ParallelMachinePasses : public FunctionPass {
+  unsigned NumThreads;
+  FunctionPass *Printer;
+
+  Module *M;
+  MachineModuleInfo *MMI;
+
+  /// The analyses of the outer pass manager shared with the pipelines.
+  SmallVector<Pass *, 8> SharedAnalyses;
+
+  /// One pipeline of machine passes per thread, created with the first
+  /// batch.
+  std::vector<PipelineInstance> Workers;
+
+  /// The pipeline running the printer.
+  PipelineInstance Emitter;
+
+  std::vector<PendingFunction> Batch;
+
+  /// Whether the batch holds functions whose machine passes are not safe to
+  /// run concurrently.
+  bool BatchNeedsOneThread;
+
+  std::unique_ptr<ThreadPool> Pool;
+
+public:
+  static char ID;
+  ParallelMachinePasses(unsigned NumThreads, FunctionPass *Printer)
+      : FunctionPass(ID), NumThreads(NumThreads), Printer(Printer),
+        M(nullptr), MMI(nullptr), BatchNeedsOneThread(false) {}
+
+  ~ParallelMachinePasses() {
+    // The printer is owned by Emitter once doInitialization has run.
+    if (!Emitter.FPM)
+      delete Printer;
+  }
+
+  const char *getPassName() const override {
+    return "Parallel Machine Passes";
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<MachineFunctionAnalysis>();
+    AU.addRequired<MachineModuleInfo>();
+    AU.addRequired<TargetPassConfig>();
+    AU.addRequired<GCModuleInfo>();
+    AU.addRequired<TargetLibraryInfoWrapperPass>();
+    AU.addRequired<AssumptionCacheTracker>();
+    AU.addRequired<StackProtector>();
+    AU.setPreservesAll();
+  }
+
+  bool doInitialization(Module &Mod) override;
+  bool runOnFunction(Function &F) override;
+  bool doFinalization(Module &Mod) override;
+
+private:
+  PipelineInstance createPipeline(bool ForPrinter);
+  void runMachinePasses(unsigned WorkerIdx, std::atomic<unsigned> &Next);
+  void flushBatch();
+};
+} // end anonymous namespace
+
+char ParallelMachinePasses::ID = 0;
+
+FunctionPass *llvm::createParallelMachinePassesPass(unsigned NumThreads,
+                                                    FunctionPass *Printer) {
+  return new ParallelMachinePasses(NumThreads, Printer);
+}
+
+PipelineInstance ParallelMachinePasses::createPipeline(bool ForPrinter) {
+  TargetPassConfig &PassConfig = *getAnalysisIfAvailable<TargetPassConfig>();
+  TargetMachine &TM = PassConfig.getTM<TargetMachine>();
+
+  PipelineInstance P;
+  P.FPM = make_unique<legacy::FunctionPassManager>(M);
+  for (Pass *Shared : SharedAnalyses)
+    P.FPM->add(new AnalysisProxy(Shared));
+  if (ForPrinter) {
+    P.MFA = new MachineFunctionAnalysis(TM);
+    P.FPM->add(P.MFA);
+    P.FPM->add(Printer);
+  } else {
+    // The wrapper pass caches the TargetTransformInfo of the last function it
+    // saw, so each pipeline needs its own.
+    P.FPM->add(createTargetTransformInfoWrapperPass(TM.getTargetIRAnalysis()));
+    P.MFA = new MachineFunctionAnalysis(TM);
+    P.FPM->add(P.MFA);
+    PassConfig.addMachinePassesTo(*P.FPM);
+  }
+  P.FPM->doInitialization();
+  return P;
+}
+
+bool ParallelMachinePasses::doInitialization(Module &Mod) {
+  M = &Mod;
+  MMI = getAnalysisIfAvailable<MachineModuleInfo>();
+  assert(MMI && "MachineModuleInfo not around yet??");
+  if (NumThreads > 1 && llvm_is_multithreaded())
+    MMI->getContext().setThreadSafeSymbols(true);
+
+  SharedAnalyses.push_back(MMI);
+  SharedAnalyses.push_back(getAnalysisIfAvailable<TargetPassConfig>());
+  SharedAnalyses.push_back(getAnalysisIfAvailable<GCModuleInfo>());
+  Emitter = createPipeline(/*ForPrinter=*/true);
+  return false;
+}
+
+bool ParallelMachinePasses::runOnFunction(Function &F) {
+  if (Workers.empty()) {
+    // The outer StackProtector is a function pass, so it can only be reached
+    // from runOnFunction.  Its layout of the stack slots of every function is
+    // kept until the end of the module.
+    SharedAnalyses.push_back(&getAnalysis<TargetLibraryInfoWrapperPass>());
+    SharedAnalyses.push_back(&getAnalysis<AssumptionCacheTracker>());
+    SharedAnalyses.push_back(&getAnalysis<StackProtector>());
+    for (unsigned I = 0; I != NumThreads; ++I)
+      Workers.push_back(createPipeline(/*ForPrinter=*/false));
+  }
+
+  PendingFunction PF;
+  PF.MF.reset(getAnalysis<MachineFunctionAnalysis>().takeMF());
+  PF.State = make_unique<MachineModuleInfo::FunctionState>();
+  MMI->swapFunctionState(*PF.State);
+
+  // Fill the assumption cache now; the worker threads only read it.
+  getAnalysis<AssumptionCacheTracker>().getAssumptionCache(F).assumptions();
+
+  // Garbage collection metadata and Windows EH tables are module-level maps
+  // that the machine passes update.
+  if (F.hasGC() || MMI->hasWinEHFuncInfo(&F))
+    BatchNeedsOneThread = true;
+
+  Batch.push_back(std::move(PF));
+  if (Batch.size() >= BatchSize)
+    flushBatch();
+  return false;
+}
+
+void ParallelMachinePasses::runMachinePasses(unsigned WorkerIdx,
+                                             std::atomic<unsigned> &Next) {
+  for (unsigned I = Next++, E = Batch.size(); I < E; I = Next++) {
+    PendingFunction &PF = Batch[I];
+    MachineModuleInfo::FunctionStateScope Scope(*MMI, *PF.State);
+    Workers[WorkerIdx].run(*PF.MF);
+  }
+}
+
+void ParallelMachinePasses::flushBatch() {
+  if (Batch.empty())
+    return;
+
+  unsigned NumWorkers = std::min<unsigned>(NumThreads, Batch.size());
+  if (BatchNeedsOneThread || !llvm_is_multithreaded())
+    NumWorkers = 1;
+
+  std::atomic<unsigned> Next(0);
+  if (NumWorkers > 1) {
+    if (!Pool)
+      Pool = make_unique<ThreadPool>(NumThreads - 1);
+    for (unsigned I = 1; I != NumWorkers; ++I)
+      Pool->async([this, I, &Next] { runMachinePasses(I, Next); });
+  }
+  // The calling thread takes part too.
+  runMachinePasses(0, Next);
+  if (NumWorkers > 1)
+    Pool->wait();
+
+  // Emit the functions in order.  The printer expects the state of the
+  // function to be the current one, and discards it when done.
+  for (PendingFunction &PF : Batch) {
+    MMI->swapFunctionState(*PF.State);
+    Emitter.run(*PF.MF);
+  }
+
+  Batch.clear();
+  BatchNeedsOneThread = false;
+}
+
+bool ParallelMachinePasses::doFinalization(Module &Mod) {
+  flushBatch();
+  bool Changed = false;
+  for (PipelineInstance &P : Workers)
+    Changed |= P.FPM->doFinalization();
+  Changed |= Emitter.FPM->doFinalization();
+  MMI->getContext().setThreadSafeSymbols(false);
+  return Changed;
+}
@@ -362,7 +362,7 @@ void TargetPassConfig::addVerifyPass(const std::string &Banner) {
 
 /// Add common target configurable passes that perform LLVM IR to IR transforms
 /// following machine independent optimization.
-void TargetPassConfig::addIRPasses() {
+void TargetPassConfig::addAliasAnalysisPasses() {
   // Basic AliasAnalysis support.
   // Add TypeBasedAliasAnalysis before BasicAliasAnalysis so that
   // BasicAliasAnalysis wins if they disagree. This is intended to help
@@ -372,6 +372,10 @@ void TargetPassConfig::addIRPasses() {
   addPass(createTypeBasedAliasAnalysisPass());
   addPass(createScopedNoAliasAAPass());
   addPass(createBasicAliasAnalysisPass());
+}
+
+void TargetPassConfig::addIRPasses() {
+  addAliasAnalysisPasses();
 
   // Before running any passes, run the verifier to determine if the input
   // coming from the front-end and/or optimizer is valid.
@@ -561,6 +565,23 @@ void TargetPassConfig::addMachinePasses() {
   AddingMachinePasses = false;
 }
 
+void TargetPassConfig::addMachinePassesTo(PassManagerBase &PassMgr) {
+  assert(Started && !StopAfter &&
+         "Cannot add the machine passes of a partial pipeline");
+  PassManagerBase *SavedPM = PM;
+  bool SavedInitialized = Initialized;
+  PM = &PassMgr;
+  Initialized = false;
+
+  // The machine passes query alias analysis, which is not shared with the
+  // outer pipeline.
+  addAliasAnalysisPasses();
+  addMachinePasses();
+
+  PM = SavedPM;
+  Initialized = SavedInitialized;
+}
+
 /// Add passes that optimize machine instructions in SSA form.
 void TargetPassConfig::addMachineSSAOptimization() {
   // Pre-ra tail duplication.
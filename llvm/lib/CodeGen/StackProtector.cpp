@@ -58,7 +58,10 @@ FunctionPass *llvm::createStackProtectorPass(const TargetMachine *TM) {
 
 StackProtector::SSPLayoutKind
 StackProtector::getSSPLayout(const AllocaInst *AI) const {
-  return AI ? Layout.lookup(AI) : SSPLK_None;
+  if (!AI)
+    return SSPLK_None;
+  sys::SmartScopedLock<true> Lock(LayoutMutex);
+  return Layout.lookup(AI);
 }
 
 void StackProtector::adjustForColoring(const AllocaInst *From,
@@ -66,6 +69,7 @@ void StackProtector::adjustForColoring(const AllocaInst *From,
   // When coloring replaces one alloca with another, transfer the SSPLayoutKind
   // tag from the remapped to the target alloca. The remapped alloca should
   // have a size smaller than or equal to the replacement alloca.
+  sys::SmartScopedLock<true> Lock(LayoutMutex);
   SSPLayoutMap::iterator I = Layout.find(From);
   if (I != Layout.end()) {
     SSPLayoutKind Kind = I->second;
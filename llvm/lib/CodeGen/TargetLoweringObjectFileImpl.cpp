@@ -32,6 +32,7 @@
 #include "llvm/MC/MCStreamer.h"
 #include "llvm/MC/MCSymbol.h"
 #include "llvm/MC/MCValue.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/ELF.h"
 #include "llvm/Support/ErrorHandling.h"
@@ -42,6 +43,16 @@
 using namespace llvm;
 using namespace dwarf;
 
+static cl::opt<bool> ProfileGuidedSectionPrefix(
+    "profile-guided-section-prefix", cl::Hidden, cl::init(true),
+    cl::desc("Put the functions the profile finds hot or cold into "
+             ".text.hot or .text.unlikely"));
+
+static cl::opt<unsigned> HotFunctionPercent(
+    "hot-function-percent", cl::Hidden, cl::init(1),
+    cl::desc("A function is hot when it is entered at least this percentage "
+             "of the times the most frequently entered function is"));
+
 //===----------------------------------------------------------------------===//
 //                                  ELF
 //===----------------------------------------------------------------------===//
@@ -245,6 +256,27 @@ static StringRef getSectionPrefixForGlobal(SectionKind Kind) {
   return ".data.rel.ro";
 }
 
+/// Return the suffix of the text section of \p GV that groups the functions
+/// the profile finds hot or cold, like GCC does, so that the linker can lay
+/// them out apart from the rest of the text.
+static StringRef getTextSectionSuffix(const GlobalValue *GV) {
+  const Function *F = dyn_cast<Function>(GV);
+  if (!F || !ProfileGuidedSectionPrefix)
+    return "";
+
+  if (Optional<uint64_t> Count = F->getEntryCount()) {
+    if (*Count == 0)
+      return ".unlikely";
+    Optional<uint64_t> MaxCount = F->getParent()->getMaximumFunctionCount();
+    if (MaxCount &&
+        (double)*Count >= (double)*MaxCount * HotFunctionPercent / 100)
+      return ".hot";
+  }
+  if (F->hasFnAttribute(llvm::Attribute::Cold))
+    return ".unlikely";
+  return "";
+}
+
 static const MCSectionELF *
 selectELFSectionForGlobal(MCContext &Ctx, const GlobalValue *GV,
                           SectionKind Kind, Mangler &Mang,
@@ -293,6 +325,8 @@ selectELFSectionForGlobal(MCContext &Ctx, const GlobalValue *GV,
     Name += utostr(EntrySize);
   } else {
     Name = getSectionPrefixForGlobal(Kind);
+    if (Kind.isText())
+      Name += getTextSectionSuffix(GV);
   }
 
   if (EmitUniqueSection && UniqueSectionNames) {
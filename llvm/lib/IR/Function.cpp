@@ -377,6 +377,18 @@ void Function::setGC(const char *Str) {
   (*GCNames)[this] = GCNamePool->intern(Str);
 }
 
+void Function::setEntryCount(uint64_t Count) {
+  addFnAttr("function-entry-count", utostr(Count));
+}
+
+Optional<uint64_t> Function::getEntryCount() const {
+  Attribute A = getFnAttribute("function-entry-count");
+  uint64_t Count;
+  if (!A.isStringAttribute() || A.getValueAsString().getAsInteger(10, Count))
+    return None;
+  return Count;
+}
+
 void Function::clearGC() {
   sys::SmartScopedWriter<true> Writer(*GCLock);
   if (GCNames) {
@@ -0,0 +1,94 @@
+//===-- FunctionInfo.cpp - Function Summary Index -------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the function summary index and the computation of the
+// summary of a function.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/FunctionInfo.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include <algorithm>
+using namespace llvm;
+
+// Walks the operands of constant expressions to find the global values they
+// reference.
+static void findRefs(const User *U, SmallPtrSetImpl<const User *> &Visited,
+                     SmallPtrSetImpl<const GlobalValue *> &RefSet,
+                     FunctionSummary &Summary) {
+  for (const Use &Op : U->operands()) {
+    if (auto *GV = dyn_cast<GlobalValue>(Op)) {
+      if (GV->hasName() && RefSet.insert(GV).second)
+        Summary.addRef(GV->getName());
+      continue;
+    }
+    auto *CE = dyn_cast<ConstantExpr>(Op);
+    if (CE && Visited.insert(CE).second)
+      findRefs(CE, Visited, RefSet, Summary);
+  }
+}
+
+std::unique_ptr<FunctionSummary> FunctionSummary::compute(const Function &F) {
+  assert(!F.isDeclaration() && "Cannot summarize a declaration");
+
+  unsigned InstCount = 0;
+  for (const Instruction &I : inst_range(F))
+    if (!isa<DbgInfoIntrinsic>(I))
+      ++InstCount;
+  auto Summary = make_unique<FunctionSummary>(F.getLinkage(), InstCount);
+
+  SmallPtrSet<const Function *, 8> CallSet;
+  SmallPtrSet<const GlobalValue *, 8> RefSet;
+  SmallPtrSet<const User *, 8> Visited;
+  for (const Instruction &I : inst_range(F)) {
+    if (isa<DbgInfoIntrinsic>(I))
+      continue;
+    ImmutableCallSite CS(&I);
+    if (CS) {
+      const Function *Callee = CS.getCalledFunction();
+      if (Callee && Callee->hasName() && !Callee->isIntrinsic()) {
+        if (CallSet.insert(Callee).second)
+          Summary->addCall(Callee->getName());
+        // The callee operand is accounted for as a call, not as a reference.
+        RefSet.insert(Callee);
+      }
+    }
+    findRefs(&I, Visited, RefSet, *Summary);
+  }
+  return Summary;
+}
+
+void FunctionInfoIndex::mergeFrom(std::unique_ptr<FunctionInfoIndex> Other,
+                                  uint64_t NextModuleId) {
+  // Renumber the modules of Other in the order of their current identifiers,
+  // so that the result does not depend on the hashing of the path table.
+  std::vector<std::pair<uint64_t, StringRef>> OtherPaths;
+  for (auto &Entry : Other->ModulePathStringTable)
+    OtherPaths.push_back(std::make_pair(Entry.second, Entry.first()));
+  std::sort(OtherPaths.begin(), OtherPaths.end());
+
+  StringMap<StringRef> NewPaths;
+  for (auto &Entry : OtherPaths)
+    NewPaths[Entry.second] = addModulePath(Entry.second, NextModuleId++);
+
+  for (auto &Entry : Other->FunctionMap) {
+    FunctionSummaryList &List = FunctionMap[Entry.first()];
+    for (std::unique_ptr<FunctionSummary> &Summary : Entry.second) {
+      Summary->setModulePath(NewPaths.lookup(Summary->modulePath()));
+      List.push_back(std::move(Summary));
+    }
+  }
+}
@@ -0,0 +1,144 @@
+//===-- IRMemoryUsage.cpp - Memory used by the IR -------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the IRMemoryUsage class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/IRMemoryUsage.h"
+#include "LLVMContextImpl.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+using namespace llvm;
+
+IRMemoryUsage::IRMemoryUsage() {
+  for (unsigned I = 0; I != NumEntityKinds; ++I)
+    Counts[I] = Bytes[I] = 0;
+}
+
+/// Return the size of the object of instruction \p I, without its operands.
+static size_t getInstructionSize(const Instruction &I) {
+  switch (I.getOpcode()) {
+#define HANDLE_INST(N, OPC, CLASS)                                             \
+  case Instruction::OPC:                                                       \
+    return sizeof(CLASS);
+#include "llvm/IR/Instruction.def"
+  }
+  llvm_unreachable("Unknown instruction opcode");
+}
+
+void IRMemoryUsage::addName(const Value &V) {
+  if (!V.hasName())
+    return;
+  // The entry holds the name, and the symbol table has a bucket and a hash
+  // for it.
+  add(ValueNames, 1, sizeof(ValueName) + V.getName().size() + 1 +
+                         sizeof(StringMapEntryBase *) + sizeof(unsigned));
+}
+
+void IRMemoryUsage::addInstruction(const Instruction &I) {
+  add(Instructions, 1, getInstructionSize(I));
+
+  // The operands of most instructions are allocated in front of the
+  // instruction. The hung-off operands of PHIs, switches and the like are
+  // followed by a tag pointing back to the user, and PHIs also keep their
+  // incoming blocks there.
+  uint64_t OperandBytes = I.getNumOperands() * sizeof(Use);
+  if (isa<PHINode>(I) || isa<SwitchInst>(I) || isa<IndirectBrInst>(I) ||
+      isa<LandingPadInst>(I))
+    OperandBytes += sizeof(Use::UserRef);
+  if (const PHINode *PN = dyn_cast<PHINode>(&I))
+    OperandBytes += PN->getNumIncomingValues() * sizeof(BasicBlock *);
+  add(Operands, I.getNumOperands(), OperandBytes);
+
+  addName(I);
+
+  if (!I.hasMetadataOtherThanDebugLoc())
+    return;
+  const LLVMContextImpl::MDMapTy &Info =
+      I.getContext().pImpl->MetadataStore.find(&I)->second;
+  add(MetadataAttachments, Info.size(),
+      sizeof(std::pair<const Instruction *, LLVMContextImpl::MDMapTy>) +
+          Info.getMemorySize());
+}
+
+void IRMemoryUsage::addModule(const Module &M) {
+  for (const GlobalVariable &GV : M.globals()) {
+    add(GlobalVariables, 1,
+        sizeof(GlobalVariable) + GV.getNumOperands() * sizeof(Use));
+    addName(GV);
+  }
+
+  for (const GlobalAlias &GA : M.aliases()) {
+    add(GlobalAliases, 1, sizeof(GlobalAlias) + sizeof(Use));
+    addName(GA);
+  }
+
+  for (const Function &F : M) {
+    add(Functions, 1, sizeof(Function));
+    addName(F);
+    // The arguments are only allocated once they are asked for.
+    if (!F.isDeclaration()) {
+      add(Arguments, F.arg_size(), F.arg_size() * sizeof(Argument));
+      for (const Argument &A : F.args())
+        addName(A);
+    }
+
+    for (const BasicBlock &BB : F) {
+      add(BasicBlocks, 1, sizeof(BasicBlock));
+      addName(BB);
+      for (const Instruction &I : BB)
+        addInstruction(I);
+    }
+  }
+}
+
+uint64_t IRMemoryUsage::getTotalBytes() const {
+  uint64_t Total = 0;
+  for (unsigned I = 0; I != NumEntityKinds; ++I)
+    Total += Bytes[I];
+  return Total;
+}
+
+const char *IRMemoryUsage::getEntityKindName(EntityKind Kind) {
+  switch (Kind) {
+  case GlobalVariables:     return "Global variables";
+  case GlobalAliases:       return "Global aliases";
+  case Functions:           return "Functions";
+  case Arguments:           return "Arguments";
+  case BasicBlocks:         return "Basic blocks";
+  case Instructions:        return "Instructions";
+  case Operands:            return "Operands";
+  case ValueNames:          return "Value names";
+  case MetadataAttachments: return "Metadata attachments";
+  case NumEntityKinds:      break;
+  }
+  llvm_unreachable("Unknown entity kind");
+}
+
+void IRMemoryUsage::print(raw_ostream &OS) const {
+  OS << "===" << std::string(73, '-') << "===\n"
+     << "                          ... IR Memory Usage ...\n"
+     << "===" << std::string(73, '-') << "===\n\n";
+
+  OS << "       Count        Bytes  Kind\n";
+  for (unsigned I = 0; I != NumEntityKinds; ++I)
+    OS << format("%12llu %12llu  %s\n", (unsigned long long)Counts[I],
+                 (unsigned long long)Bytes[I],
+                 getEntityKindName(EntityKind(I)));
+  OS << format("%25llu", (unsigned long long)getTotalBytes()) << "  Total\n";
+
+  if (uint64_t NumInsts = Counts[Instructions])
+    OS << format("%25.1f", double(getTotalBytes()) / NumInsts)
+       << "  Bytes per instruction\n";
+  OS << '\n';
+  OS.flush();
+}
@@ -43,6 +43,7 @@ LLVMContextImpl::LLVMContextImpl(LLVMContext &C)
   RespectDiagnosticFilters = false;
   YieldCallback = nullptr;
   YieldOpaqueHandle = nullptr;
+  DiscardValueNames = false;
   NamedStructTypesUniqueID = 0;
 }
 
@@ -200,6 +201,35 @@ namespace llvm {
 static const Metadata *get_hashable_data(const MDOperand &X) { return X.get(); }
 }
 
+MDAttachmentList::~MDAttachmentList() {
+  if (!H)
+    return;
+  for (value_type &P : *this)
+    P.~value_type();
+  ::operator delete(H);
+}
+
+void MDAttachmentList::grow() {
+  // Instructions rarely have more than a couple of attachments, so start
+  // small.
+  unsigned NewCapacity = H ? H->Capacity * 2 : 1;
+  Header *NewH = static_cast<Header *>(
+      ::operator new(sizeof(Header) + NewCapacity * sizeof(value_type)));
+  NewH->Size = 0;
+  NewH->Capacity = NewCapacity;
+  if (H) {
+    // Moving the tracking references updates their registration.
+    value_type *NewData = reinterpret_cast<value_type *>(NewH + 1);
+    for (unsigned I = 0, E = H->Size; I != E; ++I) {
+      new (NewData + I) value_type(std::move(data()[I]));
+      data()[I].~value_type();
+    }
+    NewH->Size = H->Size;
+    ::operator delete(H);
+  }
+  H = NewH;
+}
+
 unsigned MDNodeOpsKey::calculateHash(MDNode *N, unsigned Offset) {
   unsigned Hash = hash_combine_range(N->op_begin() + Offset, N->op_end());
 #ifndef NDEBUG
@@ -855,6 +855,74 @@ template <class NodeTy> struct MDNodeInfo {
 #define HANDLE_MDNODE_LEAF(CLASS) typedef MDNodeInfo<CLASS> CLASS##Info;
 #include "llvm/IR/Metadata.def"
 
+/// \brief The metadata attachments of an instruction, other than !dbg.
+///
+/// The attachments are kept in a single allocation that starts with their
+/// count, so that an entry of LLVMContextImpl::MetadataStore is only two
+/// pointers wide. Moving the list doesn't move the attachments, which keeps
+/// the tracking references valid when the store is rehashed.
+class MDAttachmentList {
+public:
+  typedef std::pair<unsigned, TrackingMDNodeRef> value_type;
+  typedef value_type *iterator;
+  typedef const value_type *const_iterator;
+
+private:
+  struct Header {
+    unsigned Size;
+    unsigned Capacity;
+  };
+  Header *H;
+
+  value_type *data() const { return reinterpret_cast<value_type *>(H + 1); }
+  void grow();
+
+  MDAttachmentList(const MDAttachmentList &) = delete;
+  void operator=(const MDAttachmentList &) = delete;
+
+public:
+  MDAttachmentList() : H(nullptr) {}
+  MDAttachmentList(MDAttachmentList &&X) : H(X.H) { X.H = nullptr; }
+  MDAttachmentList &operator=(MDAttachmentList &&X) {
+    std::swap(H, X.H);
+    return *this;
+  }
+  ~MDAttachmentList();
+
+  bool empty() const { return !H || !H->Size; }
+  unsigned size() const { return H ? H->Size : 0; }
+  unsigned capacity() const { return H ? H->Capacity : 0; }
+
+  iterator begin() { return H ? data() : nullptr; }
+  iterator end() { return H ? data() + H->Size : nullptr; }
+  const_iterator begin() const { return H ? data() : nullptr; }
+  const_iterator end() const { return H ? data() + H->Size : nullptr; }
+
+  value_type &operator[](unsigned I) {
+    assert(I < size() && "Attachment index out of range!");
+    return data()[I];
+  }
+  value_type &back() { return (*this)[size() - 1]; }
+
+  void push_back(unsigned KindID, MDNode *Node) {
+    if (size() == capacity())
+      grow();
+    new (data() + H->Size) value_type(KindID, TrackingMDNodeRef(Node));
+    ++H->Size;
+  }
+
+  void pop_back() {
+    assert(!empty() && "Popping an empty list!");
+    --H->Size;
+    data()[H->Size].~value_type();
+  }
+
+  /// \brief Returns the number of bytes allocated by the list.
+  size_t getMemorySize() const {
+    return H ? sizeof(Header) + H->Capacity * sizeof(value_type) : 0;
+  }
+};
+
 class LLVMContextImpl {
 public:
   /// OwnedModules - The set of modules instantiated in this context, and which
@@ -871,6 +939,10 @@ public:
   LLVMContext::YieldCallbackTy YieldCallback;
   void *YieldOpaqueHandle;
 
+  /// DiscardValueNames - Whether the names of the values other than
+  /// GlobalValues are dropped.
+  bool DiscardValueNames;
+
   typedef DenseMap<APInt, ConstantInt *, DenseMapAPIntKeyInfo> IntMapTy;
   IntMapTy IntConstants;
 
@@ -954,8 +1026,7 @@ public:
   /// CustomMDKindNames - Map to hold the metadata string to ID mapping.
   StringMap<unsigned> CustomMDKindNames;
 
-  typedef std::pair<unsigned, TrackingMDNodeRef> MDPairTy;
-  typedef SmallVector<MDPairTy, 2> MDMapTy;
+  typedef MDAttachmentList MDMapTy;
 
   /// MetadataStore - Collection of per-instruction metadata used in this
   /// context.
@@ -21,8 +21,11 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/TimeValue.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
@@ -494,6 +497,55 @@ public:
 
 static TimingInfo *TheTimeInfo;
 
+namespace {
+
+enum PassTraceFormat { PTF_JSON, PTF_CSV };
+
+/// PassTrace - This class writes the entries of the -pass-trace file. Entries
+/// are written when their region ends, so nested passes come before the pass
+/// that ran them. The heap usage is the one of the whole process, so it is
+/// only meaningful when passes don't run on several threads at once.
+class PassTrace {
+  sys::SmartMutex<true> Lock;
+  std::unique_ptr<raw_fd_ostream> OS;
+  PassTraceFormat Format;
+  double StartWall;
+  unsigned NumEntries;
+  unsigned NumThreads;
+
+public:
+  // Use 'createThePassTrace' to get this.
+  PassTrace();
+  ~PassTrace();
+
+  /// createThePassTrace - This method either initializes the ThePassTrace
+  /// pointer to a non-null value (if -pass-trace is enabled and its file could
+  /// be opened) or it leaves it null.  It may be called multiple times.
+  static void createThePassTrace();
+
+  /// getStartWall - Return the wall time the trace was started at.
+  double getStartWall() const { return StartWall; }
+
+  /// writeEntry - Write the entry of a region that has ended. The times are in
+  /// seconds, the heap sizes are in bytes.
+  void writeEntry(StringRef PassName, StringRef Unit, unsigned Depth,
+                  double Start, double Wall, double User, double System,
+                  int64_t HeapDelta, int64_t HeapPeak);
+
+  void flush();
+};
+
+} // End of anon namespace
+
+static PassTrace *ThePassTrace;
+
+/// The innermost active trace region of the current thread.
+static LLVM_THREAD_LOCAL PassTraceRegion *CurrentTraceRegion = nullptr;
+
+/// The 1-based index of the current thread in the trace, or 0 if it didn't
+/// write any entry yet.
+static LLVM_THREAD_LOCAL unsigned CurrentTraceThread = 0;
+
 //===----------------------------------------------------------------------===//
 // PMTopLevelManager implementation
 
@@ -1313,6 +1365,7 @@ bool BBPassManager::runOnFunction(Function &F) {
         // If the pass crashes, remember this.
         PassManagerPrettyStackEntry X(BP, *I);
         TimeRegion PassTimer(getPassTimer(BP));
+        PassTraceRegion Trace(BP, F.getName());
 
         LocalChanged |= BP->runOnBasicBlock(*I);
       }
@@ -1481,6 +1534,7 @@ void FunctionPassManagerImpl::releaseMemoryOnTheFly() {
 bool FunctionPassManagerImpl::run(Function &F) {
   bool Changed = false;
   TimingInfo::createTheTimeInfo();
+  PassTrace::createThePassTrace();
 
   initializeAllAnalysisInfo();
   for (unsigned Index = 0; Index < getNumContainedManagers(); ++Index) {
@@ -1491,6 +1545,9 @@ bool FunctionPassManagerImpl::run(Function &F) {
   for (unsigned Index = 0; Index < getNumContainedManagers(); ++Index)
     getContainedManager(Index)->cleanup();
 
+  if (ThePassTrace)
+    ThePassTrace->flush();
+
   wasRun = true;
   return Changed;
 }
@@ -1534,6 +1591,7 @@ bool FPPassManager::runOnFunction(Function &F) {
     {
       PassManagerPrettyStackEntry X(FP, F);
       TimeRegion PassTimer(getPassTimer(FP));
+      PassTraceRegion Trace(FP, F.getName());
 
       LocalChanged |= FP->runOnFunction(F);
     }
@@ -1612,6 +1670,7 @@ MPPassManager::runOnModule(Module &M) {
     {
       PassManagerPrettyStackEntry X(MP, M);
       TimeRegion PassTimer(getPassTimer(MP));
+      PassTraceRegion Trace(MP, M.getModuleIdentifier());
 
       LocalChanged |= MP->runOnModule(M);
     }
@@ -1708,6 +1767,7 @@ Pass* MPPassManager::getOnTheFlyPass(Pass *MP, AnalysisID PI, Function &F){
 bool PassManagerImpl::run(Module &M) {
   bool Changed = false;
   TimingInfo::createTheTimeInfo();
+  PassTrace::createThePassTrace();
 
   dumpArguments();
   dumpPasses();
@@ -1729,6 +1789,9 @@ bool PassManagerImpl::run(Module &M) {
     Changed |= (*I)->doFinalization(M);
   }
 
+  if (ThePassTrace)
+    ThePassTrace->flush();
+
   return Changed;
 }
 
@@ -1784,6 +1847,177 @@ Timer *llvm::getPassTimer(Pass *P) {
   return nullptr;
 }
 
+//===----------------------------------------------------------------------===//
+// PassTrace implementation
+
+static cl::opt<std::string>
+PassTraceFile("pass-trace", cl::value_desc("filename"),
+              cl::desc("Record the time and heap usage of each pass on each "
+                       "function and write them to the given file"));
+
+static cl::opt<PassTraceFormat>
+PassTraceFormatOpt("pass-trace-format", cl::desc("Format of -pass-trace"),
+                   cl::init(PTF_JSON),
+                   cl::values(clEnumValN(PTF_JSON, "json",
+                                         "Chrome trace event JSON (default)"),
+                              clEnumValN(PTF_CSV, "csv",
+                                         "Comma separated values"),
+                              clEnumValEnd));
+
+
+PassTrace::PassTrace()
+    : Format(PassTraceFormatOpt),
+      StartWall(TimeRecord::getCurrentTime().getWallTime()), NumEntries(0),
+      NumThreads(0) {
+  std::error_code EC;
+  OS = llvm::make_unique<raw_fd_ostream>(PassTraceFile, EC, sys::fs::F_Text);
+  if (EC) {
+    errs() << "Error opening pass trace file '" << PassTraceFile
+           << "': " << EC.message() << '\n';
+    OS.reset();
+    return;
+  }
+
+  // The closing bracket of the JSON array is written on exit, but the trace
+  // viewers accept files without it, e.g. if the process doesn't shut down.
+  if (Format == PTF_JSON)
+    *OS << "[\n";
+  else
+    *OS << "pass,unit,depth,thread,start_us,wall_us,user_us,system_us,"
+           "heap_delta,heap_peak\n";
+}
+
+PassTrace::~PassTrace() {
+  if (OS && Format == PTF_JSON)
+    *OS << "\n]\n";
+}
+
+void PassTrace::createThePassTrace() {
+  if (PassTraceFile.empty() || ThePassTrace)
+    return;
+
+  // Constructed the first time this is called, iff -pass-trace is enabled.
+  // It is destroyed by llvm_shutdown(), which ends the trace.
+  static ManagedStatic<PassTrace> PT;
+  if (PT->OS)
+    ThePassTrace = &*PT;
+}
+
+static void writeJSONString(raw_ostream &OS, StringRef S) {
+  OS << '"';
+  for (unsigned char C : S) {
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << format("\\u%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+static void writeCSVString(raw_ostream &OS, StringRef S) {
+  if (S.find_first_of(",\"\n\r") == StringRef::npos) {
+    OS << S;
+    return;
+  }
+  OS << '"';
+  for (char C : S) {
+    if (C == '"')
+      OS << '"';
+    OS << C;
+  }
+  OS << '"';
+}
+
+static int64_t toMicroseconds(double Seconds) {
+  return (int64_t)(Seconds * 1000000.0 + 0.5);
+}
+
+void PassTrace::writeEntry(StringRef PassName, StringRef Unit, unsigned Depth,
+                           double Start, double Wall, double User,
+                           double System, int64_t HeapDelta,
+                           int64_t HeapPeak) {
+  sys::SmartScopedLock<true> Guard(Lock);
+  if (!CurrentTraceThread)
+    CurrentTraceThread = ++NumThreads;
+
+  if (Format == PTF_JSON) {
+    if (NumEntries)
+      *OS << ",\n";
+    *OS << "{\"name\":";
+    writeJSONString(*OS, PassName);
+    *OS << ",\"cat\":\"pass\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+        << CurrentTraceThread << ",\"ts\":" << toMicroseconds(Start)
+        << ",\"dur\":" << toMicroseconds(Wall) << ",\"args\":{\"unit\":";
+    writeJSONString(*OS, Unit);
+    *OS << ",\"depth\":" << Depth << ",\"user_us\":" << toMicroseconds(User)
+        << ",\"system_us\":" << toMicroseconds(System)
+        << ",\"heap_delta\":" << HeapDelta << ",\"heap_peak\":" << HeapPeak
+        << "}}";
+  } else {
+    writeCSVString(*OS, PassName);
+    *OS << ',';
+    writeCSVString(*OS, Unit);
+    *OS << ',' << Depth << ',' << CurrentTraceThread << ','
+        << toMicroseconds(Start) << ',' << toMicroseconds(Wall) << ','
+        << toMicroseconds(User) << ',' << toMicroseconds(System) << ','
+        << HeapDelta << ',' << HeapPeak << '\n';
+  }
+  ++NumEntries;
+}
+
+void PassTrace::flush() {
+  sys::SmartScopedLock<true> Guard(Lock);
+  OS->flush();
+}
+
+void PassTraceRegion::updateHeapPeaks(size_t Heap) {
+  for (PassTraceRegion *R = CurrentTraceRegion; R; R = R->Parent)
+    R->PeakHeap = std::max(R->PeakHeap, Heap);
+}
+
+PassTraceRegion::PassTraceRegion(Pass *P, StringRef Unit)
+    : Parent(nullptr), P(P), Depth(0), StartWall(0), StartUser(0),
+      StartSystem(0), StartHeap(0), PeakHeap(0), Active(false) {
+  // Like for -time-passes, only the passes doing the work are recorded, not
+  // the pass managers running them.
+  if (!ThePassTrace || P->getAsPMDataManager())
+    return;
+
+  Active = true;
+  this->Unit = Unit;
+  Parent = CurrentTraceRegion;
+  Depth = Parent ? Parent->Depth + 1 : 0;
+
+  StartHeap = PeakHeap = sys::Process::GetMallocUsage();
+  updateHeapPeaks(StartHeap);
+  CurrentTraceRegion = this;
+
+  TimeRecord Start = TimeRecord::getCurrentTime(true);
+  StartWall = Start.getWallTime();
+  StartUser = Start.getUserTime();
+  StartSystem = Start.getSystemTime();
+}
+
+PassTraceRegion::~PassTraceRegion() {
+  if (!Active)
+    return;
+
+  TimeRecord End = TimeRecord::getCurrentTime(false);
+  size_t EndHeap = sys::Process::GetMallocUsage();
+  updateHeapPeaks(EndHeap);
+  CurrentTraceRegion = Parent;
+
+  ThePassTrace->writeEntry(P->getPassName(), Unit, Depth,
+                           StartWall - ThePassTrace->getStartWall(),
+                           End.getWallTime() - StartWall,
+                           End.getUserTime() - StartUser,
+                           End.getSystemTime() - StartSystem,
+                           (int64_t)EndHeap - (int64_t)StartHeap,
+                           (int64_t)PeakHeap - (int64_t)StartHeap);
+}
+
 //===----------------------------------------------------------------------===//
 // PMStack implementation
 //
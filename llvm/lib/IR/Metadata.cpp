@@ -1060,8 +1060,7 @@ void Instruction::setMetadata(unsigned KindID, MDNode *Node) {
     }
 
     // No replacement, just add it to the list.
-    Info.emplace_back(std::piecewise_construct, std::make_tuple(KindID),
-                      std::make_tuple(Node));
+    Info.push_back(KindID, Node);
     return;
   }
 
@@ -171,6 +171,11 @@ void Value::setName(const Twine &NewName) {
   if (NewName.isTriviallyEmpty() && !hasName())
     return;
 
+  // Don't name new local values if the context discards their names.
+  if (!hasName() && !isa<GlobalValue>(this) &&
+      getContext().shouldDiscardValueNames())
+    return;
+
   SmallString<256> NameData;
   StringRef NameRef = NewName.toStringRef(NameData);
   assert(NameRef.find_first_of(0) == StringRef::npos &&
@@ -18,6 +18,7 @@
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/CodeGen/RuntimeLibcalls.h"
 #include "llvm/Config/config.h"
 #include "llvm/IR/Constants.h"
@@ -36,11 +37,15 @@
 #include "llvm/MC/MCAsmInfo.h"
 #include "llvm/MC/MCContext.h"
 #include "llvm/MC/SubtargetFeature.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormattedStream.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
@@ -53,9 +58,22 @@
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/ObjCARC.h"
+#include <algorithm>
 #include <system_error>
 using namespace llvm;
 
+// The names of local values are only useful to read the IR, so they aren't
+// worth their memory in release builds.
+static cl::opt<bool> LTODiscardValueNames(
+    "lto-discard-value-names",
+    cl::desc("Discard the names of the values other than GlobalValues"),
+#ifdef NDEBUG
+    cl::init(true),
+#else
+    cl::init(false),
+#endif
+    cl::Hidden);
+
 const char* LTOCodeGenerator::getVersionString() {
 #ifdef LLVM_VERSION_INFO
   return PACKAGE_NAME " version " PACKAGE_VERSION ", " LLVM_VERSION_INFO;
@@ -83,6 +101,11 @@ void LTOCodeGenerator::initialize() {
   DiagHandler = nullptr;
   DiagContext = nullptr;
   OwnedModule = nullptr;
+  CachePruningInterval = 1200;
+  CacheEntryExpiration = 7 * 24 * 3600;
+  CacheMaxSize = 0;
+
+  Context.setDiscardValueNames(LTODiscardValueNames);
 
   initializeLTOPasses();
 }
@@ -244,7 +267,8 @@ bool LTOCodeGenerator::compileOptimizedToFile(const char **name,
   // generate object file
   tool_output_file objFile(Filename.c_str(), FD);
 
-  bool genResult = compileOptimized(objFile.os(), errMsg);
+  raw_ostream *OS = &objFile.os();
+  bool genResult = compileOptimized(OS, errMsg);
   objFile.os().close();
   if (objFile.os().has_error()) {
     objFile.os().clear_error();
@@ -263,15 +287,91 @@ bool LTOCodeGenerator::compileOptimizedToFile(const char **name,
   return true;
 }
 
+bool LTOCodeGenerator::compileOptimizedToFiles(unsigned Parallelism,
+                                               const char ***names,
+                                               std::string &errMsg) {
+  std::string CacheKey;
+  if (!CacheDir.empty()) {
+    if (!determineTarget(errMsg))
+      return false;
+    CacheKey = computeCacheKey("codegen:" + utostr(Parallelism));
+
+    std::vector<std::string> Filenames;
+    if (loadFromCache(CacheKey, Parallelism, Filenames)) {
+      NativeObjectPaths = std::move(Filenames);
+      NativeObjectPathNames.clear();
+      for (const std::string &Name : NativeObjectPaths)
+        NativeObjectPathNames.push_back(Name.c_str());
+      *names = NativeObjectPathNames.data();
+      return true;
+    }
+  }
+
+  // make unique temp .o files to put generated object files
+  std::vector<std::string> Filenames;
+  std::vector<std::unique_ptr<tool_output_file>> ObjFiles;
+  std::vector<raw_ostream *> OSs;
+  for (unsigned I = 0; I != Parallelism; ++I) {
+    SmallString<128> Filename;
+    int FD;
+    std::error_code EC =
+        sys::fs::createTemporaryFile("lto-llvm", "o", FD, Filename);
+    if (EC) {
+      errMsg = EC.message();
+      for (const std::string &Name : Filenames)
+        sys::fs::remove(Name);
+      return false;
+    }
+    Filenames.push_back(Filename.str());
+    ObjFiles.emplace_back(new tool_output_file(Filename.c_str(), FD));
+    OSs.push_back(&ObjFiles.back()->os());
+  }
+
+  // generate object files
+  bool genResult = compileOptimized(OSs, errMsg);
+  bool writeError = false;
+  for (std::unique_ptr<tool_output_file> &ObjFile : ObjFiles) {
+    ObjFile->os().close();
+    if (ObjFile->os().has_error()) {
+      ObjFile->os().clear_error();
+      writeError = true;
+    }
+    ObjFile->keep();
+  }
+
+  if (!genResult || writeError) {
+    for (const std::string &Name : Filenames)
+      sys::fs::remove(Name);
+    return false;
+  }
+
+  if (!CacheKey.empty())
+    storeInCache(CacheKey, Filenames);
+
+  NativeObjectPaths = std::move(Filenames);
+  NativeObjectPathNames.clear();
+  for (const std::string &Name : NativeObjectPaths)
+    NativeObjectPathNames.push_back(Name.c_str());
+  *names = NativeObjectPathNames.data();
+  return true;
+}
+
 const void *LTOCodeGenerator::compileOptimized(size_t *length,
                                                std::string &errMsg) {
   const char *name;
   if (!compileOptimizedToFile(&name, errMsg))
     return nullptr;
 
+  return readNativeObjectFile(length, errMsg);
+}
+
+/// Reads the object file at NativeObjectPath into NativeObjectFile and removes
+/// it.
+const void *LTOCodeGenerator::readNativeObjectFile(size_t *length,
+                                                   std::string &errMsg) {
   // read .o file into memory buffer
   ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
-      MemoryBuffer::getFile(name, -1, false);
+      MemoryBuffer::getFile(NativeObjectPath, -1, false);
   if (std::error_code EC = BufferOrErr.getError()) {
     errMsg = EC.message();
     sys::fs::remove(NativeObjectPath);
@@ -295,11 +395,34 @@ bool LTOCodeGenerator::compile_to_file(const char **name,
                                        bool disableGVNLoadPRE,
                                        bool disableVectorization,
                                        std::string &errMsg) {
+  // The key is computed before the module is optimized, so that a hit skips
+  // both the optimization and the code generation.
+  std::string CacheKey;
+  if (!CacheDir.empty()) {
+    if (!determineTarget(errMsg))
+      return false;
+    CacheKey = computeCacheKey("optimize:" + utostr(disableInline) +
+                               utostr(disableGVNLoadPRE) +
+                               utostr(disableVectorization));
+
+    std::vector<std::string> Filenames;
+    if (loadFromCache(CacheKey, 1, Filenames)) {
+      NativeObjectPath = Filenames[0];
+      *name = NativeObjectPath.c_str();
+      return true;
+    }
+  }
+
   if (!optimize(disableInline, disableGVNLoadPRE,
                 disableVectorization, errMsg))
     return false;
 
-  return compileOptimizedToFile(name, errMsg);
+  if (!compileOptimizedToFile(name, errMsg))
+    return false;
+
+  if (!CacheKey.empty())
+    storeInCache(CacheKey, NativeObjectPath);
+  return true;
 }
 
 const void* LTOCodeGenerator::compile(size_t *length,
@@ -307,11 +430,139 @@ const void* LTOCodeGenerator::compile(size_t *length,
                                       bool disableGVNLoadPRE,
                                       bool disableVectorization,
                                       std::string &errMsg) {
-  if (!optimize(disableInline, disableGVNLoadPRE,
-                disableVectorization, errMsg))
+  const char *name;
+  if (!compile_to_file(&name, disableInline, disableGVNLoadPRE,
+                       disableVectorization, errMsg))
     return nullptr;
 
-  return compileOptimized(length, errMsg);
+  return readNativeObjectFile(length, errMsg);
+}
+
+/// Returns the name of the cache entries holding the object files generated
+/// from the merged module in its current state with the current options.
+/// \p Pipeline describes the work that remains to be done on the module.
+std::string LTOCodeGenerator::computeCacheKey(StringRef Pipeline) {
+  MD5 Hasher;
+  auto AddString = [&](StringRef Str) {
+    // Terminate every string so that consecutive strings can't alias.
+    Hasher.update(Str);
+    const uint8_t Terminator = 0;
+    Hasher.update(makeArrayRef(Terminator));
+  };
+  auto AddStringSet = [&](const StringSet &Set) {
+    std::vector<StringRef> Keys;
+    for (auto &Entry : Set)
+      Keys.push_back(Entry.getKey());
+    std::sort(Keys.begin(), Keys.end());
+    AddString(utostr(Keys.size()));
+    for (StringRef Key : Keys)
+      AddString(Key);
+  };
+
+  AddString(getVersionString());
+  AddString(Pipeline);
+
+  // The inputs: the merged module, and the symbols the linker needs.
+  SmallVector<char, 0> Bitcode;
+  {
+    raw_svector_ostream OS(Bitcode);
+    WriteBitcodeToFile(IRLinker.getModule(), OS);
+  }
+  Hasher.update(ArrayRef<uint8_t>(
+      reinterpret_cast<const uint8_t *>(Bitcode.data()), Bitcode.size()));
+  AddStringSet(MustPreserveSymbols);
+  AddStringSet(AsmUndefinedRefs);
+
+  // The options. The target options are derived from the command line, which
+  // is covered by CodegenOptions.
+  AddString(TargetMach->getTargetTriple());
+  AddString(TargetMach->getTargetCPU());
+  AddString(TargetMach->getTargetFeatureString());
+  AddString(utostr(OptLevel));
+  AddString(utostr(CodeModel));
+  AddString(utostr(EmitDwarfDebugInfo));
+  AddString(utostr(CodegenOptions.size()));
+  for (const char *Option : CodegenOptions)
+    AddString(Option);
+
+  MD5::MD5Result Result;
+  Hasher.final(Result);
+  SmallString<32> Hash;
+  MD5::stringifyResult(Result, Hash);
+  return ("llvm-lto-" + Hash).str();
+}
+
+/// Returns the path of the cache entry holding the object file of partition
+/// \p Partition for \p Key.
+static std::string getCacheEntryPath(StringRef CacheDir, StringRef Key,
+                                     unsigned Partition) {
+  SmallString<128> Path(CacheDir);
+  sys::path::append(Path, Key + "." + utostr(Partition) + ".o");
+  return Path.str();
+}
+
+/// Copies the \p NumFiles cache entries of \p Key to new temporary files,
+/// whose names are returned in \p Filenames. Returns false, without creating
+/// any file, if one of the entries is missing.
+bool LTOCodeGenerator::loadFromCache(StringRef Key, unsigned NumFiles,
+                                     std::vector<std::string> &Filenames) {
+  std::vector<std::string> Entries;
+  for (unsigned I = 0; I != NumFiles; ++I) {
+    Entries.push_back(getCacheEntryPath(CacheDir, Key, I));
+    if (!sys::fs::exists(Entries.back()))
+      return false;
+  }
+
+  for (const std::string &Entry : Entries) {
+    SmallString<128> Filename;
+    if (sys::fs::createTemporaryFile("lto-llvm", "o", Filename) ||
+        sys::fs::copy_file(Entry, Filename)) {
+      // The entry may have been pruned concurrently; fall back to compiling.
+      sys::fs::remove(Filename);
+      for (const std::string &Name : Filenames)
+        sys::fs::remove(Name);
+      Filenames.clear();
+      return false;
+    }
+    Filenames.push_back(Filename.str());
+
+    // Mark the entry as used for the pruning.
+    int FD;
+    if (!sys::fs::openFileForRead(Entry, FD)) {
+      sys::fs::setLastModificationAndAccessTime(FD, sys::TimeValue::now());
+      sys::Process::SafelyCloseFileDescriptor(FD);
+    }
+  }
+  return true;
+}
+
+/// Stores \p Filenames as the cache entries of \p Key and prunes the cache.
+/// Failures are ignored: the cache is only an optimization.
+void LTOCodeGenerator::storeInCache(StringRef Key,
+                                    ArrayRef<std::string> Filenames) {
+  if (sys::fs::create_directories(CacheDir))
+    return;
+
+  for (unsigned I = 0, E = Filenames.size(); I != E; ++I) {
+    // Write the entry under a temporary name first, so that concurrent links
+    // never see a partial file.
+    SmallString<128> TempPath;
+    SmallString<128> Model(CacheDir);
+    sys::path::append(Model, "llvm-lto-tmp-%%%%%%%%.o");
+    if (sys::fs::createUniqueFile(Model, TempPath))
+      return;
+    if (sys::fs::copy_file(Filenames[I], TempPath) ||
+        sys::fs::rename(TempPath, getCacheEntryPath(CacheDir, Key, I))) {
+      sys::fs::remove(TempPath);
+      return;
+    }
+  }
+
+  CachePruning(CacheDir)
+      .setPruningInterval(CachePruningInterval)
+      .setEntryExpiration(CacheEntryExpiration)
+      .setMaxSize(CacheMaxSize)
+      .prune();
 }
 
 bool LTOCodeGenerator::determineTarget(std::string &errMsg) {
@@ -566,7 +817,8 @@ bool LTOCodeGenerator::optimize(bool DisableInline,
   return true;
 }
 
-bool LTOCodeGenerator::compileOptimized(raw_ostream &out, std::string &errMsg) {
+bool LTOCodeGenerator::compileOptimized(ArrayRef<raw_ostream *> Out,
+                                        std::string &errMsg) {
   if (!this->determineTarget(errMsg))
     return false;
 
@@ -575,15 +827,29 @@ bool LTOCodeGenerator::compileOptimized(raw_ostream &out, std::string &errMsg) {
   // Mark which symbols can not be internalized
   this->applyScopeRestrictions();
 
+  if (Out.size() > 1) {
+    // The ObjCARCContractPass must be run before the module is split, as the
+    // partitions are code generated with plain codegen pipelines.
+    legacy::PassManager preCodeGenPasses;
+    preCodeGenPasses.add(createObjCARCContractPass());
+    preCodeGenPasses.run(*mergedModule);
+
+    splitCodeGen(*mergedModule, Out, TargetMach->getTargetCPU(),
+                 TargetMach->getTargetFeatureString(), Options,
+                 TargetMach->getRelocationModel(),
+                 TargetMach->getCodeModel(), TargetMach->getOptLevel());
+    return true;
+  }
+
   legacy::PassManager codeGenPasses;
 
-  formatted_raw_ostream Out(out);
+  formatted_raw_ostream OutFile(*Out[0]);
 
   // If the bitcode files contain ARC code and were compiled with optimization,
   // the ObjCARCContractPass must be run, so do it unconditionally here.
   codeGenPasses.add(createObjCARCContractPass());
 
-  if (TargetMach->addPassesToEmitFile(codeGenPasses, Out,
+  if (TargetMach->addPassesToEmitFile(codeGenPasses, OutFile,
                                       TargetMachine::CGFT_ObjectFile)) {
     errMsg = "target file type not supported";
     return false;
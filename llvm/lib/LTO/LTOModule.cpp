@@ -14,9 +14,11 @@
 
 #include "llvm/LTO/LTOModule.h"
 #include "llvm/ADT/Triple.h"
+#include "llvm/Bitcode/BitcodeSymbolTable.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/Analysis.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DiagnosticPrinter.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Metadata.h"
@@ -186,6 +188,15 @@ static Module *parseBitcodeFileImpl(MemoryBufferRef Buffer,
   return *M;
 }
 
+/// Returns true if symbol names are mangled the same way under both data
+/// layouts.
+static bool hasSameMangling(const DataLayout &A, const DataLayout &B) {
+  return A.getGlobalPrefix() == B.getGlobalPrefix() &&
+         StringRef(A.getPrivateGlobalPrefix()) == B.getPrivateGlobalPrefix() &&
+         A.hasMicrosoftFastStdCallMangling() ==
+             B.hasMicrosoftFastStdCallMangling();
+}
+
 LTOModule *LTOModule::makeLTOModule(MemoryBufferRef Buffer,
                                     TargetOptions options, std::string &errMsg,
                                     LLVMContext *Context) {
@@ -196,14 +207,47 @@ LTOModule *LTOModule::makeLTOModule(MemoryBufferRef Buffer,
   }
 
   // If we own a context, we know this is being used only for symbol
-  // extraction, not linking.  Be lazy in that case.
-  std::unique_ptr<Module> M(parseBitcodeFileImpl(
-      Buffer, *Context,
-      /* ShouldBeLazy */ static_cast<bool>(OwnedContext), errMsg));
-  if (!M)
-    return nullptr;
+  // extraction, not linking.  Use the symbol table of the module if it has
+  // one, or else be lazy in that case.
+  std::unique_ptr<BitcodeSymbolTable> Symtab;
+  if (OwnedContext) {
+    ErrorOr<MemoryBufferRef> BCOrErr =
+        IRObjectFile::findBitcodeInMemBuffer(Buffer);
+    if (std::error_code EC = BCOrErr.getError()) {
+      errMsg = EC.message();
+      return nullptr;
+    }
+    ErrorOr<std::unique_ptr<BitcodeSymbolTable>> SymtabOrErr =
+        getBitcodeSymbolTable(*BCOrErr, *Context);
+    if (std::error_code EC = SymtabOrErr.getError()) {
+      errMsg = EC.message();
+      return nullptr;
+    }
+    Symtab = std::move(*SymtabOrErr);
+
+    // The symbols of the old Objective-C ABI, used on 32-bit Darwin, are
+    // synthesized from the initializers of the ObjC data structures, so the
+    // module is needed there.
+    if (Symtab) {
+      Triple T(Symtab->TargetTriple);
+      if (T.isOSDarwin() && !T.isArch64Bit())
+        Symtab.reset();
+    }
+  }
+
+  std::unique_ptr<Module> M;
+  std::string TripleStr;
+  if (Symtab) {
+    TripleStr = Symtab->TargetTriple;
+  } else {
+    M.reset(parseBitcodeFileImpl(
+        Buffer, *Context,
+        /* ShouldBeLazy */ static_cast<bool>(OwnedContext), errMsg));
+    if (!M)
+      return nullptr;
+    TripleStr = M->getTargetTriple();
+  }
 
-  std::string TripleStr = M->getTargetTriple();
   if (TripleStr.empty())
     TripleStr = sys::getDefaultTargetTriple();
   llvm::Triple Triple(TripleStr);
@@ -230,10 +274,26 @@ LTOModule *LTOModule::makeLTOModule(MemoryBufferRef Buffer,
 
   TargetMachine *target = march->createTargetMachine(TripleStr, CPU, FeatureStr,
                                                      options);
-  M->setDataLayout(*target->getDataLayout());
 
-  std::unique_ptr<object::IRObjectFile> IRObj(
-      new object::IRObjectFile(Buffer, std::move(M)));
+  // The names in the symbol table are mangled for the data layout of the
+  // module, which the target's data layout replaces below.
+  if (Symtab &&
+      !hasSameMangling(DataLayout(Symtab->DataLayoutStr),
+                       *target->getDataLayout())) {
+    Symtab.reset();
+    M.reset(parseBitcodeFileImpl(Buffer, *Context, /* ShouldBeLazy */ true,
+                                 errMsg));
+    if (!M) {
+      delete target;
+      return nullptr;
+    }
+  }
+
+  std::unique_ptr<object::IRObjectFile> IRObj;
+  if (M) {
+    M->setDataLayout(*target->getDataLayout());
+    IRObj.reset(new object::IRObjectFile(Buffer, std::move(M)));
+  }
 
   LTOModule *Ret;
   if (OwnedContext)
@@ -241,6 +301,12 @@ LTOModule *LTOModule::makeLTOModule(MemoryBufferRef Buffer,
   else
     Ret = new LTOModule(std::move(IRObj), target);
 
+  if (Symtab) {
+    Ret->SymtabTargetTriple = Symtab->TargetTriple;
+    Ret->parseSymbolTable(*Symtab);
+    return Ret;
+  }
+
   if (Ret->parseSymbols(errMsg)) {
     delete Ret;
     return nullptr;
@@ -430,44 +496,62 @@ void LTOModule::addDefinedFunctionSymbol(const char *Name, const Function *F) {
   addDefinedSymbol(Name, F, true);
 }
 
-void LTOModule::addDefinedSymbol(const char *Name, const GlobalValue *def,
-                                 bool isFunction) {
+/// Returns the attributes of a definition with the given properties.
+/// \p CanBeHidden is only used for global symbols with default visibility.
+static uint32_t getDefinitionAttributes(unsigned Alignment, bool IsFunction,
+                                        bool IsConstant,
+                                        GlobalValue::LinkageTypes Linkage,
+                                        GlobalValue::VisibilityTypes Visibility,
+                                        bool CanBeHidden) {
   // set alignment part log2() can have rounding errors
-  uint32_t align = def->getAlignment();
-  uint32_t attr = align ? countTrailingZeros(align) : 0;
+  uint32_t attr = Alignment ? countTrailingZeros(Alignment) : 0;
 
   // set permissions part
-  if (isFunction) {
+  if (IsFunction)
     attr |= LTO_SYMBOL_PERMISSIONS_CODE;
-  } else {
-    const GlobalVariable *gv = dyn_cast<GlobalVariable>(def);
-    if (gv && gv->isConstant())
-      attr |= LTO_SYMBOL_PERMISSIONS_RODATA;
-    else
-      attr |= LTO_SYMBOL_PERMISSIONS_DATA;
-  }
+  else if (IsConstant)
+    attr |= LTO_SYMBOL_PERMISSIONS_RODATA;
+  else
+    attr |= LTO_SYMBOL_PERMISSIONS_DATA;
 
   // set definition part
-  if (def->hasWeakLinkage() || def->hasLinkOnceLinkage())
+  if (GlobalValue::isWeakLinkage(Linkage) ||
+      GlobalValue::isLinkOnceLinkage(Linkage))
     attr |= LTO_SYMBOL_DEFINITION_WEAK;
-  else if (def->hasCommonLinkage())
+  else if (GlobalValue::isCommonLinkage(Linkage))
     attr |= LTO_SYMBOL_DEFINITION_TENTATIVE;
   else
     attr |= LTO_SYMBOL_DEFINITION_REGULAR;
 
   // set scope part
-  if (def->hasLocalLinkage())
+  if (GlobalValue::isLocalLinkage(Linkage))
     // Ignore visibility if linkage is local.
     attr |= LTO_SYMBOL_SCOPE_INTERNAL;
-  else if (def->hasHiddenVisibility())
+  else if (Visibility == GlobalValue::HiddenVisibility)
     attr |= LTO_SYMBOL_SCOPE_HIDDEN;
-  else if (def->hasProtectedVisibility())
+  else if (Visibility == GlobalValue::ProtectedVisibility)
     attr |= LTO_SYMBOL_SCOPE_PROTECTED;
-  else if (canBeOmittedFromSymbolTable(def))
+  else if (CanBeHidden)
     attr |= LTO_SYMBOL_SCOPE_DEFAULT_CAN_BE_HIDDEN;
   else
     attr |= LTO_SYMBOL_SCOPE_DEFAULT;
 
+  return attr;
+}
+
+void LTOModule::addDefinedSymbol(const char *Name, const GlobalValue *def,
+                                 bool isFunction) {
+  const GlobalVariable *gv = dyn_cast<GlobalVariable>(def);
+  bool CanBeHidden = !def->hasLocalLinkage() && def->hasDefaultVisibility() &&
+                     canBeOmittedFromSymbolTable(def);
+  uint32_t attr = getDefinitionAttributes(
+      def->getAlignment(), isFunction, gv && gv->isConstant(),
+      def->getLinkage(), def->getVisibility(), CanBeHidden);
+  addDefinedSymbol(Name, attr, def, isFunction);
+}
+
+void LTOModule::addDefinedSymbol(const char *Name, uint32_t attr,
+                                 const GlobalValue *def, bool isFunction) {
   auto Iter = _defines.insert(Name).first;
 
   // fill information structure
@@ -554,7 +638,15 @@ void LTOModule::addPotentialUndefinedSymbol(const object::BasicSymbolRef &Sym,
     Sym.printName(OS);
   }
 
-  auto IterBool = _undefines.insert(std::make_pair(name, NameAndAttributes()));
+  const GlobalValue *decl = IRFile->getSymbolGV(Sym.getRawDataRefImpl());
+  addPotentialUndefinedSymbol(name, decl->hasExternalWeakLinkage(), isFunc,
+                              decl);
+}
+
+void LTOModule::addPotentialUndefinedSymbol(StringRef Name,
+                                            bool isExternalWeak, bool isFunc,
+                                            const GlobalValue *decl) {
+  auto IterBool = _undefines.insert(std::make_pair(Name, NameAndAttributes()));
 
   // we already have the symbol
   if (!IterBool.second)
@@ -564,9 +656,7 @@ void LTOModule::addPotentialUndefinedSymbol(const object::BasicSymbolRef &Sym,
 
   info.name = IterBool.first->first().data();
 
-  const GlobalValue *decl = IRFile->getSymbolGV(Sym.getRawDataRefImpl());
-
-  if (decl->hasExternalWeakLinkage())
+  if (isExternalWeak)
     info.attributes = LTO_SYMBOL_DEFINITION_WEAKUNDEF;
   else
     info.attributes = LTO_SYMBOL_DEFINITION_UNDEFINED;
@@ -623,6 +713,42 @@ bool LTOModule::parseSymbols(std::string &errMsg) {
     addDefinedDataSymbol(Sym);
   }
 
+  addUndefinedSymbols();
+  return false;
+}
+
+void LTOModule::parseSymbolTable(const BitcodeSymbolTable &Symtab) {
+  for (const BitcodeSymbolTable::Symbol &Sym : Symtab.Symbols) {
+    // Skip the symbols IRObjectFile flags as format specific.
+    if (Sym.isFormatSpecific() || GlobalValue::isPrivateLinkage(Sym.Linkage))
+      continue;
+
+    // Aliases are data symbols, even when they alias a function.
+    bool IsFunction = Sym.isFunction() && !Sym.isAlias();
+    if (Sym.isUndefined()) {
+      addPotentialUndefinedSymbol(
+          Sym.Name, GlobalValue::isExternalWeakLinkage(Sym.Linkage),
+          IsFunction, nullptr);
+      continue;
+    }
+
+    // Telling whether the symbol can be hidden may need its uses, which are
+    // not recorded in the table; only the simple case of unnamed_addr
+    // linkonce_odr symbols is handled (see canBeOmittedFromSymbolTable()).
+    bool CanBeHidden = GlobalValue::isLinkOnceODRLinkage(Sym.Linkage) &&
+                       Sym.hasUnnamedAddr();
+    uint32_t attr = getDefinitionAttributes(Sym.Alignment, IsFunction,
+                                            Sym.isConstant(), Sym.Linkage,
+                                            Sym.Visibility, CanBeHidden);
+    addDefinedSymbol(Sym.Name.c_str(), attr, nullptr, IsFunction);
+  }
+  addUndefinedSymbols();
+
+  for (const std::string &Opt : Symtab.LinkerOptions)
+    addLinkerOpt(Opt);
+}
+
+void LTOModule::addUndefinedSymbols() {
   // make symbols for all undefines
   for (StringMap<NameAndAttributes>::iterator u =_undefines.begin(),
          e = _undefines.end(); u != e; ++u) {
@@ -632,8 +758,6 @@ bool LTOModule::parseSymbols(std::string &errMsg) {
     NameAndAttributes info = u->getValue();
     _symbols.push_back(info);
   }
-
-  return false;
 }
 
 /// parseMetadata - Parse metadata from the module
@@ -645,20 +769,23 @@ void LTOModule::parseMetadata() {
       MDNode *MDOptions = cast<MDNode>(LinkerOptions->getOperand(i));
       for (unsigned ii = 0, ie = MDOptions->getNumOperands(); ii != ie; ++ii) {
         MDString *MDOption = cast<MDString>(MDOptions->getOperand(ii));
-        // FIXME: Make StringSet::insert match Self-Associative Container
-        // requirements, returning <iter,bool> rather than bool, and use that
-        // here.
-        StringRef Op =
-            _linkeropt_strings.insert(MDOption->getString()).first->first();
-        StringRef DepLibName =
-            _target->getObjFileLowering()->getDepLibFromLinkerOpt(Op);
-        if (!DepLibName.empty())
-          _deplibs.push_back(DepLibName.data());
-        else if (!Op.empty())
-          _linkeropts.push_back(Op.data());
+        addLinkerOpt(MDOption->getString());
       }
     }
   }
 
   // Add other interesting metadata here.
 }
+
+void LTOModule::addLinkerOpt(StringRef Opt) {
+  // FIXME: Make StringSet::insert match Self-Associative Container
+  // requirements, returning <iter,bool> rather than bool, and use that
+  // here.
+  StringRef Op = _linkeropt_strings.insert(Opt).first->first();
+  StringRef DepLibName =
+      _target->getObjFileLowering()->getDepLibFromLinkerOpt(Op);
+  if (!DepLibName.empty())
+    _deplibs.push_back(DepLibName.data());
+  else if (!Op.empty())
+    _linkeropts.push_back(Op.data());
+}
@@ -37,7 +37,8 @@ MCContext::MCContext(const MCAsmInfo *mai, const MCRegisterInfo *mri,
       Symbols(Allocator), UsedNames(Allocator),
       CurrentDwarfLoc(0, 0, 0, DWARF2_FLAG_IS_STMT, 0, 0), DwarfLocSeen(false),
       GenDwarfForAssembly(false), GenDwarfFileNumber(0), DwarfVersion(4),
-      AllowTemporaryLabels(true), DwarfCompileUnitID(0),
+      AllowTemporaryLabels(true), ThreadSafeSymbols(false),
+      DwarfCompileUnitID(0),
       AutoReset(DoAutoReset) {
 
   std::error_code EC = llvm::sys::fs::current_path(CompilationDir);
@@ -98,7 +99,27 @@ void MCContext::reset() {
 // Symbol Manipulation
 //===----------------------------------------------------------------------===//
 
+namespace {
+/// Holds the symbol mutex of a context for the duration of a scope, if the
+/// context needs to be thread safe.
+class SymbolLock {
+  sys::SmartMutex<true> *Mutex;
+
+public:
+  SymbolLock(sys::SmartMutex<true> &M, bool Enabled)
+      : Mutex(Enabled ? &M : nullptr) {
+    if (Mutex)
+      Mutex->lock();
+  }
+  ~SymbolLock() {
+    if (Mutex)
+      Mutex->unlock();
+  }
+};
+}
+
 MCSymbol *MCContext::GetOrCreateSymbol(const Twine &Name) {
+  SymbolLock Lock(SymbolMutex, ThreadSafeSymbols);
   SmallString<128> NameSV;
   StringRef NameRef = Name.toStringRef(NameSV);
 
@@ -112,6 +133,7 @@ MCSymbol *MCContext::GetOrCreateSymbol(const Twine &Name) {
 }
 
 MCSymbol *MCContext::getOrCreateSectionSymbol(const MCSectionELF &Section) {
+  SymbolLock Lock(SymbolMutex, ThreadSafeSymbols);
   MCSymbol *&Sym = SectionSymbols[&Section];
   if (Sym)
     return Sym;
@@ -145,6 +167,7 @@ MCSymbol *MCContext::getOrCreateParentFrameOffsetSymbol(StringRef FuncName) {
 }
 
 MCSymbol *MCContext::CreateSymbol(StringRef Name, bool AlwaysAddSuffix) {
+  SymbolLock Lock(SymbolMutex, ThreadSafeSymbols);
   // Determine whether this is an assembler temporary or normal label, if used.
   bool IsTemporary = false;
   if (AllowTemporaryLabels)
@@ -189,6 +212,7 @@ MCSymbol *MCContext::CreateTempSymbol() {
 }
 
 unsigned MCContext::NextInstance(unsigned LocalLabelVal) {
+  SymbolLock Lock(SymbolMutex, ThreadSafeSymbols);
   MCLabel *&Label = Instances[LocalLabelVal];
   if (!Label)
     Label = new (*this) MCLabel(0);
@@ -196,6 +220,7 @@ unsigned MCContext::NextInstance(unsigned LocalLabelVal) {
 }
 
 unsigned MCContext::GetInstance(unsigned LocalLabelVal) {
+  SymbolLock Lock(SymbolMutex, ThreadSafeSymbols);
   MCLabel *&Label = Instances[LocalLabelVal];
   if (!Label)
     Label = new (*this) MCLabel(0);
@@ -204,6 +229,7 @@ unsigned MCContext::GetInstance(unsigned LocalLabelVal) {
 
 MCSymbol *MCContext::getOrCreateDirectionalLocalSymbol(unsigned LocalLabelVal,
                                                        unsigned Instance) {
+  SymbolLock Lock(SymbolMutex, ThreadSafeSymbols);
   MCSymbol *&Sym = LocalSymbols[std::make_pair(LocalLabelVal, Instance)];
   if (!Sym)
     Sym = CreateTempSymbol();
@@ -224,6 +250,7 @@ MCSymbol *MCContext::GetDirectionalLocalSymbol(unsigned LocalLabelVal,
 }
 
 MCSymbol *MCContext::LookupSymbol(const Twine &Name) const {
+  SymbolLock Lock(SymbolMutex, ThreadSafeSymbols);
   SmallString<128> NameSV;
   StringRef NameRef = Name.toStringRef(NameSV);
   return Symbols.lookup(NameRef);
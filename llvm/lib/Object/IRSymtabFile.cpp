@@ -0,0 +1,89 @@
+//===- IRSymtabFile.cpp - IR symbol table file implementation ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Part of the IRSymtabFile class implementation.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Object/IRSymtabFile.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/Object/IRObjectFile.h"
+#include "llvm/Support/raw_ostream.h"
+using namespace llvm;
+using namespace object;
+
+IRSymtabFile::IRSymtabFile(MemoryBufferRef Object,
+                           std::unique_ptr<BitcodeSymbolTable> Symtab)
+    : SymbolicFile(Binary::ID_IRSymtab, Object), Symtab(std::move(Symtab)) {}
+
+IRSymtabFile::~IRSymtabFile() {}
+
+void IRSymtabFile::moveSymbolNext(DataRefImpl &Symb) const {
+  assert(Symb.p < Symtab->Symbols.size());
+  ++Symb.p;
+}
+
+std::error_code IRSymtabFile::printSymbolName(raw_ostream &OS,
+                                              DataRefImpl Symb) const {
+  OS << getSymbol(Symb).Name;
+  return object_error::success;
+}
+
+// This matches IRObjectFile::getSymbolFlags().
+uint32_t IRSymtabFile::getSymbolFlags(DataRefImpl Symb) const {
+  const BitcodeSymbolTable::Symbol &Sym = getSymbol(Symb);
+
+  uint32_t Res = BasicSymbolRef::SF_None;
+  if (Sym.isUndefined())
+    Res |= BasicSymbolRef::SF_Undefined;
+  if (GlobalValue::isPrivateLinkage(Sym.Linkage))
+    Res |= BasicSymbolRef::SF_FormatSpecific;
+  if (!GlobalValue::isLocalLinkage(Sym.Linkage))
+    Res |= BasicSymbolRef::SF_Global;
+  if (GlobalValue::isCommonLinkage(Sym.Linkage))
+    Res |= BasicSymbolRef::SF_Common;
+  if (GlobalValue::isLinkOnceLinkage(Sym.Linkage) ||
+      GlobalValue::isWeakLinkage(Sym.Linkage))
+    Res |= BasicSymbolRef::SF_Weak;
+  if (Sym.isFormatSpecific())
+    Res |= BasicSymbolRef::SF_FormatSpecific;
+
+  return Res;
+}
+
+basic_symbol_iterator IRSymtabFile::symbol_begin_impl() const {
+  DataRefImpl Ret;
+  Ret.p = 0;
+  return basic_symbol_iterator(BasicSymbolRef(Ret, this));
+}
+
+basic_symbol_iterator IRSymtabFile::symbol_end_impl() const {
+  DataRefImpl Ret;
+  Ret.p = Symtab->Symbols.size();
+  return basic_symbol_iterator(BasicSymbolRef(Ret, this));
+}
+
+ErrorOr<std::unique_ptr<IRSymtabFile>>
+llvm::object::IRSymtabFile::create(MemoryBufferRef Object,
+                                   LLVMContext &Context) {
+  ErrorOr<MemoryBufferRef> BCOrErr =
+      IRObjectFile::findBitcodeInMemBuffer(Object);
+  if (!BCOrErr)
+    return BCOrErr.getError();
+
+  ErrorOr<std::unique_ptr<BitcodeSymbolTable>> SymtabOrErr =
+      getBitcodeSymbolTable(*BCOrErr, Context);
+  if (std::error_code EC = SymtabOrErr.getError())
+    return EC;
+  if (!*SymtabOrErr)
+    return std::unique_ptr<IRSymtabFile>();
+
+  return llvm::make_unique<IRSymtabFile>(Object, std::move(*SymtabOrErr));
+}
@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Object/IRObjectFile.h"
+#include "llvm/Object/IRSymtabFile.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Object/SymbolicFile.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -24,6 +25,19 @@ SymbolicFile::SymbolicFile(unsigned int Type, MemoryBufferRef Source)
 
 SymbolicFile::~SymbolicFile() {}
 
+// Reads the symbols of the bitcode in Object from its symbol table if it has
+// one, which is much cheaper than reading the module.
+static ErrorOr<std::unique_ptr<SymbolicFile>>
+createIRSymbolicFile(MemoryBufferRef Object, LLVMContext &Context) {
+  ErrorOr<std::unique_ptr<IRSymtabFile>> SymtabOrErr =
+      IRSymtabFile::create(Object, Context);
+  if (std::error_code EC = SymtabOrErr.getError())
+    return EC;
+  if (*SymtabOrErr)
+    return std::unique_ptr<SymbolicFile>(std::move(*SymtabOrErr));
+  return IRObjectFile::create(Object, Context);
+}
+
 ErrorOr<std::unique_ptr<SymbolicFile>> SymbolicFile::createSymbolicFile(
     MemoryBufferRef Object, sys::fs::file_magic Type, LLVMContext *Context) {
   StringRef Data = Object.getBuffer();
@@ -33,7 +47,7 @@ ErrorOr<std::unique_ptr<SymbolicFile>> SymbolicFile::createSymbolicFile(
   switch (Type) {
   case sys::fs::file_magic::bitcode:
     if (Context)
-      return IRObjectFile::create(Object, *Context);
+      return createIRSymbolicFile(Object, *Context);
   // Fallthrough
   case sys::fs::file_magic::unknown:
   case sys::fs::file_magic::archive:
@@ -70,7 +84,7 @@ ErrorOr<std::unique_ptr<SymbolicFile>> SymbolicFile::createSymbolicFile(
     if (!BCData)
       return std::move(Obj);
 
-    return IRObjectFile::create(
+    return createIRSymbolicFile(
         MemoryBufferRef(BCData->getBuffer(), Object.getBufferIdentifier()),
         *Context);
   }
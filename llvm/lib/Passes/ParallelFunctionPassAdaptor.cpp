@@ -0,0 +1,293 @@
+//===- ParallelFunctionPassAdaptor.cpp - Run function passes on threads ---===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+///
+/// This file implements the ParallelModuleToFunctionPassAdaptor.
+///
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Passes/ParallelFunctionPassAdaptor.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include <thread>
+
+using namespace llvm;
+
+namespace {
+/// The properties of a global value that SplitModule and the linker may
+/// change, as they were before the split, and the name of the value after
+/// it.
+struct SavedGlobal {
+  GlobalValue *GV;
+  std::string Name;
+  GlobalValue::LinkageTypes Linkage;
+  GlobalValue::VisibilityTypes Visibility;
+  bool UnnamedAddr;
+  bool HadName;
+  Comdat *C;
+};
+}
+
+/// Build the pipeline with \p BuildPipeline and run it on every function of
+/// \p M, on the calling thread.
+static void
+runPipeline(Module &M,
+            const ParallelModuleToFunctionPassAdaptor::PipelineCallbackT &
+                BuildPipeline) {
+  FunctionPassManager FPM;
+  FunctionAnalysisManager FAM;
+  ModuleAnalysisManager MAM;
+  if (!BuildPipeline(FPM, FAM, MAM))
+    report_fatal_error("Failed to build a parallel function pass pipeline");
+  MAM.registerPass(FunctionAnalysisManagerModuleProxy(FAM));
+  FAM.registerPass(ModuleAnalysisManagerFunctionProxy(MAM));
+
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    PreservedAnalyses PA = FPM.run(F, &FAM);
+    FAM.invalidate(F, std::move(PA));
+  }
+}
+
+/// Return true if \p M can be split, optimized in pieces and put back
+/// together without losing anything.
+static bool canSplit(const Module &M) {
+  // Each partition would get its own copy of the distinct debug info nodes,
+  // and the function bodies would no longer refer to the nodes that the
+  // compile units list.
+  if (M.getNamedMetadata("llvm.dbg.cu"))
+    return false;
+
+  for (const Function &F : M) {
+    // Replacing the body of a function replaces its block addresses with
+    // constants.
+    for (const BasicBlock &BB : F)
+      if (BB.hasAddressTaken())
+        return false;
+  }
+
+  // Only the module's own copy of an appending global survives, so no
+  // function body may refer to one.
+  for (const GlobalVariable &GV : M.globals())
+    if (GV.hasAppendingLinkage() && !GV.use_empty())
+      return false;
+
+  return true;
+}
+
+/// Strip everything but the function definitions from the optimized
+/// partition \p MPart, turning the rest into declarations, so that linking
+/// it back into the module only brings in the new function bodies.
+static void prepareForMerge(Module &MPart) {
+  MPart.setModuleInlineAsm("");
+  while (!MPart.named_metadata_empty())
+    MPart.eraseNamedMetadata(MPart.named_metadata_begin());
+
+  for (Module::global_iterator I = MPart.global_begin(),
+                               E = MPart.global_end();
+       I != E;) {
+    GlobalVariable &GV = *I++;
+    // A partition that doesn't own an appending global, like
+    // llvm.global_ctors, only has a declaration of it.
+    if (GV.hasAppendingLinkage() ||
+        (GV.isDeclaration() && GV.getName().startswith("llvm.") &&
+         GV.use_empty())) {
+      GV.eraseFromParent();
+      continue;
+    }
+    // The declaration keeps the alignment, which a function pass may have
+    // raised.
+    if (!GV.isDeclaration()) {
+      GV.setInitializer(nullptr);
+      GV.setLinkage(GlobalValue::ExternalLinkage);
+      GV.setComdat(nullptr);
+    }
+  }
+
+  for (Module::alias_iterator I = MPart.alias_begin(), E = MPart.alias_end();
+       I != E;) {
+    GlobalAlias &GA = *I++;
+    PointerType *PTy = GA.getType();
+    GlobalValue *Decl;
+    if (FunctionType *FTy = dyn_cast<FunctionType>(PTy->getElementType()))
+      Decl = Function::Create(FTy, GlobalValue::ExternalLinkage, "", &MPart);
+    else
+      Decl = new GlobalVariable(MPart, PTy->getElementType(), false,
+                                GlobalValue::ExternalLinkage, nullptr, "",
+                                nullptr, GA.getThreadLocalMode(),
+                                PTy->getAddressSpace());
+    Decl->setVisibility(GA.getVisibility());
+    Decl->setUnnamedAddr(GA.hasUnnamedAddr());
+    Decl->takeName(&GA);
+    GA.replaceAllUsesWith(ConstantExpr::getBitCast(Decl, PTy));
+    GA.eraseFromParent();
+  }
+
+  // Comdats and linkage are restored from the module after the link.
+  for (Function &F : MPart) {
+    if (F.isDeclaration())
+      continue;
+    F.setLinkage(GlobalValue::ExternalLinkage);
+    F.setComdat(nullptr);
+  }
+}
+
+PreservedAnalyses ParallelModuleToFunctionPassAdaptor::run(Module &M,
+                                                           ModuleAnalysisManager *) {
+  unsigned NumDefined = 0;
+  for (Function &F : M)
+    if (!F.isDeclaration())
+      ++NumDefined;
+
+  unsigned N = NumThreads ? NumThreads : std::thread::hardware_concurrency();
+  N = std::min(N, NumDefined);
+  if (N <= 1 || !llvm_is_multithreaded() || !canSplit(M)) {
+    runPipeline(M, BuildPipeline);
+    return PreservedAnalyses::none();
+  }
+
+  // The subtargets of a TargetMachine are created on demand. Create them all
+  // now, so that the threads only ever look them up.
+  if (TM)
+    for (Function &F : M)
+      if (!F.isDeclaration())
+        TM->getSubtargetImpl(F);
+
+  // SplitModule externalizes and names local symbols so that the partitions
+  // can refer to each other's. Remember what they were.
+  std::vector<SavedGlobal> Saved;
+  auto Save = [&](GlobalValue &GV) {
+    SavedGlobal S;
+    S.GV = &GV;
+    S.Linkage = GV.getLinkage();
+    S.Visibility = GV.getVisibility();
+    S.UnnamedAddr = GV.hasUnnamedAddr();
+    S.HadName = GV.hasName();
+    S.C = nullptr;
+    if (GlobalObject *GO = dyn_cast<GlobalObject>(&GV))
+      S.C = GO->getComdat();
+    Saved.push_back(S);
+  };
+  for (Function &F : M)
+    Save(F);
+  for (GlobalVariable &GV : M.globals())
+    Save(GV);
+  for (GlobalAlias &GA : M.aliases())
+    Save(GA);
+
+  // Each partition is serialized to bitcode on this thread, then deserialized
+  // into a fresh LLVMContext on its own thread.
+  std::vector<SmallString<0>> BCs;
+  SplitModule(M, N, [&](std::unique_ptr<Module> MPart) {
+    BCs.emplace_back();
+    raw_svector_ostream BCOS(BCs.back());
+    WriteBitcodeToFile(MPart.get(), BCOS);
+  });
+  for (SavedGlobal &S : Saved)
+    S.Name = S.GV->getName();
+
+  auto OptimizePartition = [&](unsigned I) {
+    LLVMContext Ctx;
+    ErrorOr<Module *> MOrErr = parseBitcodeFile(
+        MemoryBufferRef(StringRef(BCs[I].data(), BCs[I].size()),
+                        "<parallel-function>"),
+        Ctx);
+    if (!MOrErr)
+      report_fatal_error("Failed to read bitcode");
+    std::unique_ptr<Module> MPart(MOrErr.get());
+    runPipeline(*MPart, BuildPipeline);
+    prepareForMerge(*MPart);
+
+    BCs[I].clear();
+    raw_svector_ostream BCOS(BCs[I]);
+    WriteBitcodeToFile(MPart.get(), BCOS);
+  };
+
+  {
+    ThreadPool Pool(N - 1);
+    for (unsigned I = 1; I != N; ++I)
+      Pool.async(OptimizePartition, I);
+    // The calling thread takes the first partition.
+    OptimizePartition(0);
+    Pool.wait();
+  }
+
+  // Link the optimized bodies in place of the old ones, in partition order.
+  // The linker replaces each function declaration with a new function.
+  for (Function &F : M)
+    if (!F.isDeclaration())
+      F.deleteBody();
+  Linker L(&M);
+  for (unsigned I = 0; I != N; ++I) {
+    ErrorOr<Module *> MOrErr = parseBitcodeFile(
+        MemoryBufferRef(StringRef(BCs[I].data(), BCs[I].size()),
+                        "<parallel-function>"),
+        M.getContext());
+    if (!MOrErr)
+      report_fatal_error("Failed to read bitcode");
+    std::unique_ptr<Module> MPart(MOrErr.get());
+    for (GlobalVariable &GV : MPart->globals())
+      if (GlobalVariable *Old = M.getGlobalVariable(GV.getName(), true))
+        if (GV.getAlignment() > Old->getAlignment())
+          Old->setAlignment(GV.getAlignment());
+    if (L.linkInModule(MPart.get()))
+      report_fatal_error("Failed to link a partition back into its module");
+  }
+
+  // Find the values again before giving any of them its name back.
+  for (SavedGlobal &S : Saved) {
+    S.GV = M.getNamedValue(S.Name);
+    assert(S.GV && "Lost a global value while merging the partitions!");
+  }
+  for (SavedGlobal &S : Saved) {
+    GlobalValue *GV = S.GV;
+    GV->setVisibility(GlobalValue::DefaultVisibility);
+    GV->setLinkage(S.Linkage);
+    GV->setVisibility(S.Visibility);
+    GV->setUnnamedAddr(S.UnnamedAddr);
+    if (GlobalObject *GO = dyn_cast<GlobalObject>(GV))
+      GO->setComdat(S.C);
+    if (!S.HadName)
+      GV->setName("");
+  }
+
+  // The linked functions were appended to the module. Put the functions back
+  // in their original order, followed by the declarations that the pipeline
+  // added.
+  SmallVector<Function *, 16> Order;
+  SmallPtrSet<Function *, 16> Original;
+  for (SavedGlobal &S : Saved)
+    if (Function *F = dyn_cast<Function>(S.GV)) {
+      Order.push_back(F);
+      Original.insert(F);
+    }
+  for (Function &F : M)
+    if (!Original.count(&F))
+      Order.push_back(&F);
+  Module::FunctionListType &FL = M.getFunctionList();
+  for (Function *F : Order)
+    FL.splice(FL.end(), FL, F);
+
+  return PreservedAnalyses::none();
+}
@@ -26,6 +26,8 @@
 #include "llvm/IR/IRPrintingPasses.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Passes/ParallelFunctionPassAdaptor.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/InstCombine/InstCombine.h"
@@ -35,6 +37,12 @@
 
 using namespace llvm;
 
+static cl::opt<unsigned> ParallelFunctionThreads(
+    "parallel-function-threads", cl::Hidden,
+    cl::desc("Number of threads that parallel-function(...) pipelines run on "
+             "(0 = the number of hardware threads)"),
+    cl::init(0));
+
 namespace {
 
 /// \brief No-op module pass which does nothing.
@@ -346,6 +354,35 @@ bool PassBuilder::parseModulePassPipeline(ModulePassManager &MPM,
 
       // Add the nested pass manager with the appropriate adaptor.
       MPM.addPass(createModuleToFunctionPassAdaptor(std::move(NestedFPM)));
+    } else if (PipelineText.startswith("parallel-function(")) {
+      FunctionPassManager NestedFPM(DebugLogging);
+
+      // Parse the inner pipeline once to check it. Each thread of the adaptor
+      // parses its own copy again, in its own context.
+      PipelineText = PipelineText.substr(strlen("parallel-function("));
+      StringRef NestedText = PipelineText;
+      if (!parseFunctionPassPipeline(NestedFPM, PipelineText, VerifyEachPass,
+                                     DebugLogging) ||
+          PipelineText.empty())
+        return false;
+      assert(PipelineText[0] == ')');
+      std::string Nested =
+          NestedText.substr(0, NestedText.size() - PipelineText.size());
+      PipelineText = PipelineText.substr(1);
+
+      TargetMachine *TM = this->TM;
+      MPM.addPass(ParallelModuleToFunctionPassAdaptor(
+          [=](FunctionPassManager &FPM, FunctionAnalysisManager &FAM,
+              ModuleAnalysisManager &MAM) {
+            PassBuilder PB(TM);
+            PB.registerModuleAnalyses(MAM);
+            PB.registerFunctionAnalyses(FAM);
+            StringRef Text = Nested;
+            return PB.parseFunctionPassPipeline(FPM, Text, VerifyEachPass,
+                                                DebugLogging) &&
+                   Text.empty();
+          },
+          ParallelFunctionThreads, TM));
     } else {
       // Otherwise try to parse a pass name.
       size_t End = PipelineText.find_first_of(",)");
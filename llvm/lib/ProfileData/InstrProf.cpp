@@ -13,8 +13,17 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ProfileData/InstrProf.h"
+#include "InstrProfIndexed.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Path.h"
+#include <algorithm>
 
 using namespace llvm;
 
@@ -50,6 +59,8 @@ class InstrProfErrorCategoryType : public std::error_category {
       return "Function count mismatch";
     case instrprof_error::counter_overflow:
       return "Counter overflow";
+    case instrprof_error::value_site_count_mismatch:
+      return "Function value site count change detected (hash mismatch?)";
     }
     llvm_unreachable("A value of instrprof_error has no message.");
   }
@@ -61,3 +72,125 @@ static ManagedStatic<InstrProfErrorCategoryType> ErrorCategory;
 const std::error_category &llvm::instrprof_category() {
   return *ErrorCategory;
 }
+
+void InstrProfValueSiteRecord::sortByCount() {
+  std::stable_sort(
+      ValueData.begin(), ValueData.end(),
+      [](const InstrProfValueData &L, const InstrProfValueData &R) {
+        if (L.Count != R.Count)
+          return L.Count > R.Count;
+        return L.Value < R.Value;
+      });
+}
+
+instrprof_error
+InstrProfValueSiteRecord::merge(const InstrProfValueSiteRecord &Input) {
+  for (const InstrProfValueData &In : Input.ValueData) {
+    auto Found = std::find_if(ValueData.begin(), ValueData.end(),
+                              [&](const InstrProfValueData &VD) {
+      return VD.Value == In.Value;
+    });
+    if (Found == ValueData.end()) {
+      ValueData.push_back(In);
+      continue;
+    }
+    if (Found->Count + In.Count < Found->Count)
+      return instrprof_error::counter_overflow;
+    Found->Count += In.Count;
+  }
+  sortByCount();
+  return instrprof_error::success;
+}
+
+uint64_t InstrProfValueSiteRecord::getTotalCount() const {
+  uint64_t Total = 0;
+  for (const InstrProfValueData &VD : ValueData)
+    Total += VD.Count;
+  return Total;
+}
+
+uint64_t llvm::getInstrProfNameHash(StringRef Name) {
+  return IndexedInstrProf::ComputeHash(IndexedInstrProf::HashType, Name);
+}
+
+std::string llvm::getPGOFuncName(const Function &F) {
+  StringRef Name = F.getName();
+  // Drop the marker asking the backend not to mangle the name, as the
+  // frontend does.
+  if (!Name.empty() && Name[0] == '\1')
+    Name = Name.substr(1);
+  if (!F.hasLocalLinkage())
+    return Name;
+  // The driver names the main file of the module without its directory.
+  StringRef FileName =
+      sys::path::filename(F.getParent()->getModuleIdentifier());
+  if (FileName.empty())
+    FileName = "<unknown>";
+  return (FileName + ":" + Name).str();
+}
+
+void llvm::annotateValueSite(Instruction &Inst,
+                             const InstrProfValueSiteRecord &Site,
+                             InstrProfValueKind Kind, uint32_t MaxMDCount) {
+  InstrProfValueSiteRecord Sorted = Site;
+  Sorted.sortByCount();
+  annotateValueSite(Inst, Sorted.ValueData, Sorted.getTotalCount(), Kind,
+                    MaxMDCount);
+}
+
+void llvm::annotateValueSite(Instruction &Inst,
+                             ArrayRef<InstrProfValueData> VDs,
+                             uint64_t TotalCount, InstrProfValueKind Kind,
+                             uint32_t MaxMDCount) {
+  if (VDs.empty())
+    return;
+
+  LLVMContext &Ctx = Inst.getContext();
+  MDBuilder MDHelper(Ctx);
+  Type *Int32Ty = Type::getInt32Ty(Ctx);
+  Type *Int64Ty = Type::getInt64Ty(Ctx);
+
+  SmallVector<Metadata *, 9> Vals;
+  Vals.push_back(MDHelper.createString("VP"));
+  Vals.push_back(MDHelper.createConstant(ConstantInt::get(Int32Ty, Kind)));
+  Vals.push_back(
+      MDHelper.createConstant(ConstantInt::get(Int64Ty, TotalCount)));
+  for (const InstrProfValueData &VD :
+       VDs.slice(0, std::min<size_t>(VDs.size(), MaxMDCount))) {
+    Vals.push_back(
+        MDHelper.createConstant(ConstantInt::get(Int64Ty, VD.Value)));
+    Vals.push_back(
+        MDHelper.createConstant(ConstantInt::get(Int64Ty, VD.Count)));
+  }
+  Inst.setMetadata(LLVMContext::MD_prof, MDNode::get(Ctx, Vals));
+}
+
+bool llvm::getValueProfDataFromInst(
+    const Instruction &Inst, InstrProfValueKind Kind,
+    SmallVectorImpl<InstrProfValueData> &ValueData, uint64_t &TotalCount) {
+  MDNode *MD = Inst.getMetadata(LLVMContext::MD_prof);
+  if (!MD || MD->getNumOperands() < 5 || MD->getNumOperands() % 2 == 0)
+    return false;
+
+  MDString *Tag = dyn_cast<MDString>(MD->getOperand(0));
+  if (!Tag || Tag->getString() != "VP")
+    return false;
+
+  ConstantInt *KindInt = mdconst::dyn_extract<ConstantInt>(MD->getOperand(1));
+  ConstantInt *TotalInt = mdconst::dyn_extract<ConstantInt>(MD->getOperand(2));
+  if (!KindInt || !TotalInt || KindInt->getZExtValue() != Kind)
+    return false;
+
+  ValueData.clear();
+  TotalCount = TotalInt->getZExtValue();
+  for (unsigned I = 3, E = MD->getNumOperands(); I != E; I += 2) {
+    ConstantInt *Value = mdconst::dyn_extract<ConstantInt>(MD->getOperand(I));
+    ConstantInt *Count =
+        mdconst::dyn_extract<ConstantInt>(MD->getOperand(I + 1));
+    if (!Value || !Count)
+      return false;
+    InstrProfValueData VD = {Value->getZExtValue(), Count->getZExtValue()};
+    ValueData.push_back(VD);
+  }
+  return true;
+}
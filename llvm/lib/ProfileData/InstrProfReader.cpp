@@ -139,6 +139,60 @@ std::error_code TextInstrProfReader::readNextRecord(InstrProfRecord &Record) {
   // Give the record a reference to our internal counter storage.
   Record.Counts = Counts;
 
+  return readValueProfileData(Record);
+}
+
+std::error_code
+TextInstrProfReader::readValueProfileData(InstrProfRecord &Record) {
+  Record.clearValueSites();
+
+  // The value profile data is optional; the next line is the name of the
+  // next function if there is none.
+  uint64_t NumValueKinds;
+  if (Line.is_at_end() || Line->getAsInteger(10, NumValueKinds))
+    return success();
+  ++Line;
+  if (NumValueKinds > IPVK_Last + 1)
+    return error(instrprof_error::malformed);
+
+#define READ_NUM(Num)                                                          \
+  do {                                                                         \
+    if (Line.is_at_end())                                                      \
+      return error(instrprof_error::truncated);                                \
+    if ((Line++)->getAsInteger(10, Num))                                       \
+      return error(instrprof_error::malformed);                                \
+  } while (0)
+
+  for (uint64_t K = 0; K < NumValueKinds; ++K) {
+    uint64_t Kind, NumSites;
+    READ_NUM(Kind);
+    if (Kind > IPVK_Last)
+      return error(instrprof_error::malformed);
+    READ_NUM(NumSites);
+
+    std::vector<InstrProfValueSiteRecord> &Sites = Record.ValueSites[Kind];
+    Sites.resize(NumSites);
+    for (InstrProfValueSiteRecord &Site : Sites) {
+      uint64_t NumValues;
+      READ_NUM(NumValues);
+      for (uint64_t V = 0; V < NumValues; ++V) {
+        if (Line.is_at_end())
+          return error(instrprof_error::truncated);
+        std::pair<StringRef, StringRef> ValueAndCount = (Line++)->rsplit(':');
+        InstrProfValueData VD;
+        if (ValueAndCount.second.getAsInteger(10, VD.Count))
+          return error(instrprof_error::malformed);
+        if (Kind == IPVK_IndirectCallTarget)
+          VD.Value = getInstrProfNameHash(ValueAndCount.first);
+        else if (ValueAndCount.first.getAsInteger(10, VD.Value))
+          return error(instrprof_error::malformed);
+        Site.ValueData.push_back(VD);
+      }
+      Site.sortByCount();
+    }
+  }
+#undef READ_NUM
+
   return success();
 }
 
@@ -220,14 +274,16 @@ RawInstrProfReader<IntPtrT>::readNextHeader(const char *CurrentPos) {
   return readHeader(*Header);
 }
 
+/// The newest version of the raw format; version 1 has no value profiles.
 static uint64_t getRawVersion() {
-  return 1;
+  return 2;
 }
 
 template <class IntPtrT>
 std::error_code
 RawInstrProfReader<IntPtrT>::readHeader(const RawHeader &Header) {
-  if (swap(Header.Version) != getRawVersion())
+  Version = swap(Header.Version);
+  if (Version < 1 || Version > getRawVersion())
     return error(instrprof_error::unsupported_version);
 
   CountersDelta = swap(Header.CountersDelta);
@@ -235,22 +291,96 @@ RawInstrProfReader<IntPtrT>::readHeader(const RawHeader &Header) {
   auto DataSize = swap(Header.DataSize);
   auto CountersSize = swap(Header.CountersSize);
   auto NamesSize = swap(Header.NamesSize);
+  uint64_t ValueDataSize = 0;
+  size_t HeaderSize = sizeof(RawHeader);
+  DataRecordSize = sizeof(ProfileData);
+  if (Version >= 2) {
+    auto *Start = reinterpret_cast<const char *>(&Header);
+    if (Start + sizeof(RawHeaderV2) > DataBuffer->getBufferEnd())
+      return error(instrprof_error::bad_header);
+    ValueDataSize =
+        swap(reinterpret_cast<const RawHeaderV2 &>(Header).ValueDataSize);
+    HeaderSize = sizeof(RawHeaderV2);
+    DataRecordSize = sizeof(ProfileDataV2);
+  }
 
-  ptrdiff_t DataOffset = sizeof(RawHeader);
-  ptrdiff_t CountersOffset = DataOffset + sizeof(ProfileData) * DataSize;
+  ptrdiff_t DataOffset = HeaderSize;
+  ptrdiff_t CountersOffset = DataOffset + DataRecordSize * DataSize;
   ptrdiff_t NamesOffset = CountersOffset + sizeof(uint64_t) * CountersSize;
   size_t ProfileSize = NamesOffset + sizeof(char) * NamesSize;
+  // The value data follows the padding the runtime writes after the names.
+  ptrdiff_t ValueDataOffset = 0;
+  if (Version >= 2) {
+    ValueDataOffset =
+        ProfileSize + sizeof(uint64_t) - NamesSize % sizeof(uint64_t);
+    ProfileSize = ValueDataOffset + ValueDataSize;
+  }
 
   auto *Start = reinterpret_cast<const char *>(&Header);
   if (Start + ProfileSize > DataBuffer->getBufferEnd())
     return error(instrprof_error::bad_header);
 
-  Data = reinterpret_cast<const ProfileData *>(Start + DataOffset);
-  DataEnd = Data + DataSize;
+  Data = Start + DataOffset;
+  DataEnd = Data + DataRecordSize * DataSize;
   CountersStart = reinterpret_cast<const uint64_t *>(Start + CountersOffset);
   NamesStart = Start + NamesOffset;
+  ValueDataCur = ValueDataEnd = nullptr;
+  if (Version >= 2) {
+    ValueDataCur = reinterpret_cast<const uint64_t *>(Start + ValueDataOffset);
+    ValueDataEnd = ValueDataCur + ValueDataSize / sizeof(uint64_t);
+  }
   ProfileEnd = Start + ProfileSize;
 
+  // Indirect call targets are recorded by address; map them to the hash of
+  // the name of the function.
+  FunctionNameHashes.clear();
+  if (Version >= 2) {
+    for (const char *D = Data; D != DataEnd; D += DataRecordSize) {
+      auto *DV2 = reinterpret_cast<const ProfileDataV2 *>(D);
+      StringRef Name(getName(DV2->Common.NamePtr),
+                     swap(DV2->Common.NameSize));
+      if (Name.data() < NamesStart || Name.data() + Name.size() > ProfileEnd)
+        return error(instrprof_error::malformed);
+      if (uint64_t Addr = swap(DV2->FunctionPointer))
+        FunctionNameHashes[Addr] = getInstrProfNameHash(Name);
+    }
+  }
+
+  return success();
+}
+
+template <class IntPtrT>
+std::error_code RawInstrProfReader<IntPtrT>::readValueProfileData(
+    const ProfileDataV2 &DV2, InstrProfRecord &Record) {
+  // The value data holds, for each function with value sites and in the
+  // order of the data records, the number of values of each site followed
+  // by the value and count pairs.
+  for (uint32_t Kind = IPVK_First; Kind <= IPVK_Last; ++Kind) {
+    std::vector<InstrProfValueSiteRecord> &Sites = Record.ValueSites[Kind];
+    Sites.resize(swap(DV2.NumValueSites[Kind]));
+    for (InstrProfValueSiteRecord &Site : Sites) {
+      if (ValueDataCur == ValueDataEnd)
+        return error(instrprof_error::malformed);
+      uint64_t NumValues = swap(*ValueDataCur++);
+      if (uint64_t(ValueDataEnd - ValueDataCur) < 2 * NumValues)
+        return error(instrprof_error::malformed);
+      for (uint64_t V = 0; V < NumValues; ++V) {
+        InstrProfValueData VD;
+        VD.Value = swap(*ValueDataCur++);
+        VD.Count = swap(*ValueDataCur++);
+        if (Kind == IPVK_IndirectCallTarget) {
+          // Calls to functions that were not instrumented cannot be named,
+          // and are dropped.
+          auto Found = FunctionNameHashes.find(VD.Value);
+          if (Found == FunctionNameHashes.end())
+            continue;
+          VD.Value = Found->second;
+        }
+        Site.ValueData.push_back(VD);
+      }
+      Site.sortByCount();
+    }
+  }
   return success();
 }
 
@@ -262,11 +392,12 @@ RawInstrProfReader<IntPtrT>::readNextRecord(InstrProfRecord &Record) {
       return EC;
 
   // Get the raw data.
-  StringRef RawName(getName(Data->NamePtr), swap(Data->NameSize));
-  uint32_t NumCounters = swap(Data->NumCounters);
+  auto *D = reinterpret_cast<const ProfileData *>(Data);
+  StringRef RawName(getName(D->NamePtr), swap(D->NameSize));
+  uint32_t NumCounters = swap(D->NumCounters);
   if (NumCounters == 0)
     return error(instrprof_error::malformed);
-  auto RawCounts = makeArrayRef(getCounter(Data->CounterPtr), NumCounters);
+  auto RawCounts = makeArrayRef(getCounter(D->CounterPtr), NumCounters);
 
   // Check bounds.
   auto *NamesStartAsCounter = reinterpret_cast<const uint64_t *>(NamesStart);
@@ -277,7 +408,7 @@ RawInstrProfReader<IntPtrT>::readNextRecord(InstrProfRecord &Record) {
     return error(instrprof_error::malformed);
 
   // Store the data in Record, byte-swapping as necessary.
-  Record.Hash = swap(Data->FuncHash);
+  Record.Hash = swap(D->FuncHash);
   Record.Name = RawName;
   if (ShouldSwapBytes) {
     Counts.clear();
@@ -288,8 +419,14 @@ RawInstrProfReader<IntPtrT>::readNextRecord(InstrProfRecord &Record) {
   } else
     Record.Counts = RawCounts;
 
+  Record.clearValueSites();
+  if (Version >= 2)
+    if (std::error_code EC = readValueProfileData(
+            *reinterpret_cast<const ProfileDataV2 *>(Data), Record))
+      return EC;
+
   // Iterate.
-  ++Data;
+  Data += DataRecordSize;
   return success();
 }
 
@@ -350,28 +487,89 @@ std::error_code IndexedInstrProfReader::readHeader() {
   return success();
 }
 
+std::error_code
+IndexedInstrProfReader::readRecordAt(ArrayRef<uint64_t> Data, size_t &Offset,
+                                     InstrProfRecord &Record) {
+  // Valid data starts with a hash and either a count or the number of counts.
+  if (Offset + 1 > Data.size())
+    return error(instrprof_error::malformed);
+  // First we have a function hash.
+  Record.Hash = Data[Offset++];
+  // In version 1 we knew the number of counters implicitly, but in newer
+  // versions we store the number of counters next.
+  uint64_t NumCounts =
+      FormatVersion == 1 ? Data.size() - Offset : Data[Offset++];
+  if (Offset + NumCounts > Data.size())
+    return error(instrprof_error::malformed);
+  // And then the counts themselves.
+  Record.Counts = Data.slice(Offset, NumCounts);
+  Offset += NumCounts;
+
+  // Since version 3 the counts are followed by the size of the value profile
+  // data and the data: the number of value kinds, and for each kind, the
+  // number of sites and for each site the number of values followed by the
+  // value and count pairs.
+  Record.clearValueSites();
+  if (FormatVersion < 3)
+    return success();
+  if (Offset + 1 > Data.size())
+    return error(instrprof_error::malformed);
+  uint64_t ValueDataSize = Data[Offset++];
+  if (Offset + ValueDataSize > Data.size())
+    return error(instrprof_error::malformed);
+  ArrayRef<uint64_t> ValueData = Data.slice(Offset, ValueDataSize);
+  Offset += ValueDataSize;
+  if (ValueData.empty())
+    return success();
+
+  size_t I = 0;
+  uint64_t NumKinds = ValueData[I++];
+  if (NumKinds > IPVK_Last + 1)
+    return error(instrprof_error::malformed);
+  for (uint64_t Kind = 0; Kind < NumKinds; ++Kind) {
+    if (I == ValueData.size())
+      return error(instrprof_error::malformed);
+    std::vector<InstrProfValueSiteRecord> &Sites = Record.ValueSites[Kind];
+    Sites.resize(ValueData[I++]);
+    for (InstrProfValueSiteRecord &Site : Sites) {
+      if (I == ValueData.size())
+        return error(instrprof_error::malformed);
+      uint64_t NumValues = ValueData[I++];
+      if (I + 2 * NumValues > ValueData.size())
+        return error(instrprof_error::malformed);
+      Site.ValueData.reserve(NumValues);
+      for (uint64_t V = 0; V < NumValues; ++V, I += 2) {
+        InstrProfValueData VD = {ValueData[I], ValueData[I + 1]};
+        Site.ValueData.push_back(VD);
+      }
+    }
+  }
+  return success();
+}
+
 std::error_code IndexedInstrProfReader::getFunctionCounts(
     StringRef FuncName, uint64_t FuncHash, std::vector<uint64_t> &Counts) {
+  InstrProfRecord Record;
+  if (std::error_code EC = getFunctionRecord(FuncName, FuncHash, Record))
+    return EC;
+  Counts = Record.Counts;
+  return success();
+}
+
+std::error_code IndexedInstrProfReader::getFunctionRecord(
+    StringRef FuncName, uint64_t FuncHash, InstrProfRecord &Record) {
   auto Iter = Index->find(FuncName);
   if (Iter == Index->end())
     return error(instrprof_error::unknown_function);
 
   // Found it. Look for counters with the right hash.
   ArrayRef<uint64_t> Data = (*Iter).Data;
-  uint64_t NumCounts;
-  for (uint64_t I = 0, E = Data.size(); I != E; I += NumCounts) {
-    // The function hash comes first.
-    uint64_t FoundHash = Data[I++];
-    // In v1, we have at least one count. Later, we have the number of counts.
-    if (I == E)
-      return error(instrprof_error::malformed);
-    NumCounts = FormatVersion == 1 ? E - I : Data[I++];
-    // If we have more counts than data, this is bogus.
-    if (I + NumCounts > E)
-      return error(instrprof_error::malformed);
-    // Check for a match and fill the vector if there is one.
-    if (FoundHash == FuncHash) {
-      Counts = Data.slice(I, NumCounts);
+  for (size_t Offset = 0, E = Data.size(); Offset != E;) {
+    if (std::error_code EC = readRecordAt(Data, Offset, Record))
+      return EC;
+    // Check for a match.
+    if (Record.Hash == FuncHash) {
+      Record.Name = (*Iter).Name;
       return success();
     }
   }
@@ -388,22 +586,10 @@ IndexedInstrProfReader::readNextRecord(InstrProfRecord &Record) {
   Record.Name = (*RecordIterator).Name;
 
   ArrayRef<uint64_t> Data = (*RecordIterator).Data;
-  // Valid data starts with a hash and either a count or the number of counts.
-  if (CurrentOffset + 1 > Data.size())
-    return error(instrprof_error::malformed);
-  // First we have a function hash.
-  Record.Hash = Data[CurrentOffset++];
-  // In version 1 we knew the number of counters implicitly, but in newer
-  // versions we store the number of counters next.
-  uint64_t NumCounts =
-      FormatVersion == 1 ? Data.size() - CurrentOffset : Data[CurrentOffset++];
-  if (CurrentOffset + NumCounts > Data.size())
-    return error(instrprof_error::malformed);
-  // And finally the counts themselves.
-  Record.Counts = Data.slice(CurrentOffset, NumCounts);
+  if (std::error_code EC = readRecordAt(Data, CurrentOffset, Record))
+    return EC;
 
   // If we've exhausted this function's data, increment the record.
-  CurrentOffset += NumCounts;
   if (CurrentOffset == Data.size()) {
     ++RecordIterator;
     CurrentOffset = 0;
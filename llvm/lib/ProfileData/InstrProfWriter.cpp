@@ -45,8 +45,9 @@ public:
     LE.write<offset_type>(N);
 
     offset_type M = 0;
-    for (const auto &Counts : *V)
-      M += (2 + Counts.second.size()) * sizeof(uint64_t);
+    for (const auto &Record : *V)
+      M += (3 + Record.second.Counts.size() + getValueDataSize(Record.second)) *
+           sizeof(uint64_t);
     LE.write<offset_type>(M);
 
     return std::make_pair(N, M);
@@ -61,11 +62,56 @@ public:
     using namespace llvm::support;
     endian::Writer<little> LE(Out);
 
-    for (const auto &Counts : *V) {
-      LE.write<uint64_t>(Counts.first);
-      LE.write<uint64_t>(Counts.second.size());
-      for (uint64_t I : Counts.second)
+    for (const auto &Record : *V) {
+      LE.write<uint64_t>(Record.first);
+      LE.write<uint64_t>(Record.second.Counts.size());
+      for (uint64_t I : Record.second.Counts)
         LE.write<uint64_t>(I);
+      emitValueData(LE, Record.second);
+    }
+  }
+
+  /// Return the number of words of the value profile data of Record.
+  static uint64_t
+  getValueDataSize(const InstrProfWriter::FunctionRecord &Record) {
+    uint64_t NumKinds = getNumValueKinds(Record);
+    if (!NumKinds)
+      return 0;
+    uint64_t Size = 1;
+    for (uint64_t Kind = 0; Kind < NumKinds; ++Kind) {
+      Size += 1;
+      for (const InstrProfValueSiteRecord &Site : Record.ValueSites[Kind])
+        Size += 1 + 2 * Site.ValueData.size();
+    }
+    return Size;
+  }
+
+private:
+  /// Return one past the last kind of value Record has sites for.
+  static uint64_t
+  getNumValueKinds(const InstrProfWriter::FunctionRecord &Record) {
+    for (uint64_t Kind = IPVK_Last + 1; Kind != 0; --Kind)
+      if (!Record.ValueSites[Kind - 1].empty())
+        return Kind;
+    return 0;
+  }
+
+  static void emitValueData(support::endian::Writer<support::little> &LE,
+                            const InstrProfWriter::FunctionRecord &Record) {
+    LE.write<uint64_t>(getValueDataSize(Record));
+    uint64_t NumKinds = getNumValueKinds(Record);
+    if (!NumKinds)
+      return;
+    LE.write<uint64_t>(NumKinds);
+    for (uint64_t Kind = 0; Kind < NumKinds; ++Kind) {
+      LE.write<uint64_t>(Record.ValueSites[Kind].size());
+      for (const InstrProfValueSiteRecord &Site : Record.ValueSites[Kind]) {
+        LE.write<uint64_t>(Site.ValueData.size());
+        for (const InstrProfValueData &VD : Site.ValueData) {
+          LE.write<uint64_t>(VD.Value);
+          LE.write<uint64_t>(VD.Count);
+        }
+      }
     }
   }
 };
@@ -75,12 +121,20 @@ std::error_code
 InstrProfWriter::addFunctionCounts(StringRef FunctionName,
                                    uint64_t FunctionHash,
                                    ArrayRef<uint64_t> Counters) {
-  auto &CounterData = FunctionData[FunctionName];
+  return addRecord(InstrProfRecord(FunctionName, FunctionHash, Counters));
+}
 
-  auto Where = CounterData.find(FunctionHash);
+std::error_code InstrProfWriter::addRecord(const InstrProfRecord &Record) {
+  auto &CounterData = FunctionData[Record.Name];
+  ArrayRef<uint64_t> Counters = Record.Counts;
+
+  auto Where = CounterData.find(Record.Hash);
   if (Where == CounterData.end()) {
     // We've never seen a function with this name and hash, add it.
-    CounterData[FunctionHash] = Counters;
+    FunctionRecord &New = CounterData[Record.Hash];
+    New.Counts = Counters;
+    for (uint32_t Kind = IPVK_First; Kind <= IPVK_Last; ++Kind)
+      New.ValueSites[Kind] = Record.ValueSites[Kind];
     // We keep track of the max function count as we go for simplicity.
     if (Counters[0] > MaxFunctionCount)
       MaxFunctionCount = Counters[0];
@@ -88,17 +142,28 @@ InstrProfWriter::addFunctionCounts(StringRef FunctionName,
   }
 
   // We're updating a function we've seen before.
-  auto &FoundCounters = Where->second;
+  auto &FoundCounters = Where->second.Counts;
   // If the number of counters doesn't match we either have bad data or a hash
   // collision.
   if (FoundCounters.size() != Counters.size())
     return instrprof_error::count_mismatch;
+  for (uint32_t Kind = IPVK_First; Kind <= IPVK_Last; ++Kind)
+    if (Where->second.ValueSites[Kind].size() != Record.ValueSites[Kind].size())
+      return instrprof_error::value_site_count_mismatch;
 
   for (size_t I = 0, E = Counters.size(); I < E; ++I) {
     if (FoundCounters[I] + Counters[I] < FoundCounters[I])
       return instrprof_error::counter_overflow;
     FoundCounters[I] += Counters[I];
   }
+  for (uint32_t Kind = IPVK_First; Kind <= IPVK_Last; ++Kind) {
+    auto &FoundSites = Where->second.ValueSites[Kind];
+    for (size_t I = 0, E = FoundSites.size(); I < E; ++I) {
+      instrprof_error Result = FoundSites[I].merge(Record.ValueSites[Kind][I]);
+      if (Result != instrprof_error::success)
+        return Result;
+    }
+  }
   // We keep track of the max function count as we go for simplicity.
   if (FoundCounters[0] > MaxFunctionCount)
     MaxFunctionCount = FoundCounters[0];
@@ -0,0 +1,134 @@
+//===-CachePruning.cpp - LLVM Cache Directory Pruning ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the pruning of a directory based on least recently used.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/CachePruning.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#define DEBUG_TYPE "cache-pruning"
+
+using namespace llvm;
+
+/// Write a new timestamp file with the given path. This is used for the pruning
+/// interval option.
+static void writeTimestampFile(StringRef TimestampFile) {
+  std::error_code EC;
+  raw_fd_ostream Out(TimestampFile.str(), EC, sys::fs::F_None);
+}
+
+/// Prune the cache of files that haven't been accessed in a long time.
+bool CachePruning::prune() {
+  if (Path.empty())
+    return false;
+
+  bool isPathDir;
+  if (sys::fs::is_directory(Path, isPathDir))
+    return false;
+
+  if (!isPathDir)
+    return false;
+
+  if (Expiration == 0 && MaxSize == 0) {
+    DEBUG(dbgs() << "No pruning settings set, exit early\n");
+    // Nothing will be pruned, early exit
+    return false;
+  }
+
+  // Try to stat() the timestamp file.
+  SmallString<128> TimestampFile(Path);
+  sys::path::append(TimestampFile, "llvm.prune.timestamp");
+  sys::fs::file_status FileStatus;
+  sys::TimeValue CurrentTime = sys::TimeValue::now();
+  if (!sys::fs::status(TimestampFile, FileStatus) &&
+      sys::fs::exists(FileStatus)) {
+    sys::TimeValue TimeStampModTime = FileStatus.getLastModificationTime();
+    auto TimeInterval = CurrentTime.seconds() - TimeStampModTime.seconds();
+    DEBUG(dbgs() << "Timestamp file age: " << TimeInterval << "s\n");
+    if (Interval > 0 && TimeInterval < Interval) {
+      DEBUG(dbgs() << "Skip pruning, the interval has not expired\n");
+      return false;
+    }
+  }
+  // Write a new timestamp file so that other clients know we'll take care of
+  // the pruning.
+  writeTimestampFile(TimestampFile);
+
+  // The files kept after the expiration-based pruning, as (last use time,
+  // path, size), for the size-based pruning.
+  struct CacheEntry {
+    uint64_t LastUse;
+    std::string Path;
+    uint64_t Size;
+    bool operator<(const CacheEntry &Other) const {
+      return std::tie(LastUse, Path) < std::tie(Other.LastUse, Other.Path);
+    }
+  };
+  std::vector<CacheEntry> Entries;
+  uint64_t TotalSize = 0;
+
+  // Walk the entire directory cache, looking for unused files.
+  std::error_code EC;
+  SmallString<128> CachePathNative;
+  sys::path::native(Path, CachePathNative);
+  // Walk all of the files within this directory.
+  for (sys::fs::directory_iterator File(CachePathNative, EC), FileEnd;
+       File != FileEnd && !EC; File.increment(EC)) {
+    // Only the files written by the cache are considered.
+    if (!sys::path::filename(File->path()).startswith("llvm-"))
+      continue;
+
+    if (sys::fs::status(File->path(), FileStatus))
+      continue;
+    if (!sys::fs::is_regular_file(FileStatus))
+      continue;
+
+    // If the file hasn't been used recently enough, delete it. The cache
+    // updates the modification time of an entry each time it is used.
+    sys::TimeValue FileModTime = FileStatus.getLastModificationTime();
+    auto TimeDiff = CurrentTime.seconds() - FileModTime.seconds();
+    if (Expiration && TimeDiff > Expiration) {
+      DEBUG(dbgs() << "Remove " << File->path() << " (" << TimeDiff
+                   << "s old)\n");
+      sys::fs::remove(File->path());
+      continue;
+    }
+
+    // Leave it here for now, but add it to the list of size-based pruning.
+    TotalSize += FileStatus.getSize();
+    Entries.push_back({FileModTime.seconds(), File->path(),
+                       FileStatus.getSize()});
+  }
+
+  // Prune for size now if needed, least recently used files first.
+  if (MaxSize && TotalSize > MaxSize) {
+    DEBUG(dbgs() << "Occupancy: " << TotalSize << "/" << MaxSize << "\n");
+    std::sort(Entries.begin(), Entries.end());
+    for (const CacheEntry &Entry : Entries) {
+      if (TotalSize <= MaxSize)
+        break;
+      DEBUG(dbgs() << "Remove " << Entry.Path << " (" << Entry.Size
+                   << " bytes)\n");
+      sys::fs::remove(Entry.Path);
+      TotalSize -= Entry.Size;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,219 @@
+//==-- llvm/Support/ThreadPool.cpp - A ThreadPool implementation -*- C++ -*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a crude C++11 based thread pool with work stealing.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ThreadPool.h"
+
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+#if LLVM_ENABLE_THREADS
+
+// The pool and queue index of the worker running on the current thread, if
+// any. A thread is a worker of at most one pool.
+static LLVM_THREAD_LOCAL ThreadPool *CurrentPool = nullptr;
+static LLVM_THREAD_LOCAL unsigned CurrentQueue = 0;
+
+// Default to std::thread::hardware_concurrency
+ThreadPool::ThreadPool() : ThreadPool(std::thread::hardware_concurrency()) {}
+
+ThreadPool::ThreadPool(unsigned ThreadCount)
+    : ThreadCount(ThreadCount ? ThreadCount : 1), QueuedTasks(0),
+      ActiveTasks(0), NextQueue(0), EnableFlag(true) {
+  // Create the queues first so that every thread sees all of them when it
+  // starts stealing.
+  Queues.reserve(this->ThreadCount);
+  for (unsigned ThreadID = 0; ThreadID < this->ThreadCount; ++ThreadID)
+    Queues.emplace_back(new TaskQueue());
+
+  // Create ThreadCount threads that will loop forever, wait on SleepCondition
+  // for tasks to be queued or the Pool to be destroyed.
+  Threads.reserve(this->ThreadCount);
+  for (unsigned ThreadID = 0; ThreadID < this->ThreadCount; ++ThreadID)
+    Threads.emplace_back([this, ThreadID] { work(ThreadID); });
+}
+
+unsigned ThreadPool::getLocalQueueIndex() {
+  if (CurrentPool == this)
+    return CurrentQueue;
+  return NextQueue++ % ThreadCount;
+}
+
+bool ThreadPool::popTask(unsigned Index, PackagedTaskTy &Task) {
+  // Our own queue first, newest task first.
+  {
+    TaskQueue &Q = *Queues[Index];
+    std::unique_lock<std::mutex> LockGuard(Q.Lock);
+    if (!Q.Tasks.empty()) {
+      Task = std::move(Q.Tasks.back());
+      Q.Tasks.pop_back();
+      --QueuedTasks;
+      return true;
+    }
+  }
+
+  // Then steal the oldest task of one of the other queues.
+  for (unsigned I = 1; I < ThreadCount; ++I) {
+    TaskQueue &Q = *Queues[(Index + I) % ThreadCount];
+    std::unique_lock<std::mutex> LockGuard(Q.Lock);
+    if (!Q.Tasks.empty()) {
+      Task = std::move(Q.Tasks.front());
+      Q.Tasks.pop_front();
+      --QueuedTasks;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::runTask(PackagedTaskTy &Task) {
+  Task();
+
+  // Wake up the threads waiting for a task or a group to complete. The lock
+  // is taken so that a thread that just found the predicate false can't miss
+  // the notification.
+  --ActiveTasks;
+  {
+    std::unique_lock<std::mutex> LockGuard(SleepLock);
+  }
+  SleepCondition.notify_all();
+}
+
+void ThreadPool::work(unsigned Index) {
+  CurrentPool = this;
+  CurrentQueue = Index;
+  while (true) {
+    PackagedTaskTy Task;
+    if (popTask(Index, Task)) {
+      runTask(Task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> LockGuard(SleepLock);
+    // Wait for tasks to be pushed in the queue
+    SleepCondition.wait(LockGuard,
+                        [&] { return !EnableFlag || QueuedTasks != 0; });
+    // Exit condition
+    if (!EnableFlag && QueuedTasks == 0)
+      return;
+  }
+}
+
+void ThreadPool::waitUntil(const std::function<bool()> &Done) {
+  unsigned Index = getLocalQueueIndex();
+  while (!Done()) {
+    PackagedTaskTy Task;
+    if (popTask(Index, Task)) {
+      runTask(Task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> LockGuard(SleepLock);
+    SleepCondition.wait(LockGuard,
+                        [&] { return Done() || QueuedTasks != 0; });
+  }
+}
+
+void ThreadPool::wait() {
+  assert(CurrentPool != this && "wait() called from one of the pool threads");
+  std::unique_lock<std::mutex> LockGuard(SleepLock);
+  SleepCondition.wait(LockGuard, [&] { return ActiveTasks == 0; });
+}
+
+std::shared_future<void> ThreadPool::asyncImpl(std::function<void()> Task) {
+  PackagedTaskTy PackagedTask(std::move(Task));
+  std::shared_future<void> Future = PackagedTask.get_future().share();
+  ++ActiveTasks;
+  {
+    TaskQueue &Q = *Queues[getLocalQueueIndex()];
+    std::unique_lock<std::mutex> LockGuard(Q.Lock);
+    Q.Tasks.push_back(std::move(PackagedTask));
+  }
+  {
+    // Increment under the lock so that a thread about to sleep either sees
+    // the task or gets the notification.
+    std::unique_lock<std::mutex> LockGuard(SleepLock);
+    assert(EnableFlag && "Queuing a task during the pool destruction");
+    ++QueuedTasks;
+  }
+  SleepCondition.notify_one();
+  return Future;
+}
+
+// The destructor joins all threads, waiting for completion.
+ThreadPool::~ThreadPool() {
+  {
+    std::unique_lock<std::mutex> LockGuard(SleepLock);
+    EnableFlag = false;
+  }
+  SleepCondition.notify_all();
+  for (auto &Worker : Threads)
+    Worker.join();
+}
+
+#else // LLVM_ENABLE_THREADS Disabled
+
+ThreadPool::ThreadPool() : ThreadPool(0) {}
+
+// No threads are launched, issue a warning if ThreadCount is not 0
+ThreadPool::ThreadPool(unsigned ThreadCount)
+    : ThreadCount(1), QueuedTasks(0), ActiveTasks(0), NextQueue(0),
+      EnableFlag(true) {
+  if (ThreadCount > 1) {
+    errs() << "Warning: request a ThreadPool with " << ThreadCount
+           << " threads, but LLVM_ENABLE_THREADS has been turned off\n";
+  }
+}
+
+void ThreadPool::wait() {}
+
+void ThreadPool::waitUntil(const std::function<bool()> &Done) {
+  assert(Done() && "Tasks are run synchronously without thread support");
+}
+
+std::shared_future<void> ThreadPool::asyncImpl(std::function<void()> Task) {
+  // Without threads the task is run right away, which keeps the futures and
+  // TaskGroup::sync() from ever blocking.
+  PackagedTaskTy PackagedTask(std::move(Task));
+  std::shared_future<void> Future = PackagedTask.get_future().share();
+  PackagedTask();
+  return Future;
+}
+
+ThreadPool::~ThreadPool() {}
+
+#endif
+
+static ManagedStatic<ThreadPool> DefaultThreadPool;
+
+ThreadPool &llvm::getDefaultThreadPool() { return *DefaultThreadPool; }
+
+TaskGroup::TaskGroup() : TaskGroup(getDefaultThreadPool()) {}
+
+TaskGroup::TaskGroup(ThreadPool &Pool) : Pool(Pool), Pending(0) {}
+
+TaskGroup::~TaskGroup() { sync(); }
+
+void TaskGroup::spawn(std::function<void()> F) {
+  ++Pending;
+  Pool.async([this, F] {
+    F();
+    --Pending;
+  });
+}
+
+void TaskGroup::sync() {
+  Pool.waitUntil([this] { return Pending == 0; });
+}
@@ -0,0 +1,336 @@
+//===- FunctionImport.cpp - ThinLTO Summary-based Function Import ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements Function import based on summaries.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/IPO/FunctionImport.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DiagnosticPrinter.h"
+#include "llvm/IR/FunctionInfo.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/IPO.h"
+#include <map>
+using namespace llvm;
+
+#define DEBUG_TYPE "function-import"
+
+STATISTIC(NumImported, "Number of functions imported");
+
+/// Limit on instruction count of imported functions.
+static cl::opt<unsigned> ImportInstrLimit(
+    "import-instr-limit", cl::init(100), cl::Hidden, cl::value_desc("N"),
+    cl::desc("Only import functions with less than N instructions"));
+
+/// Returns the summary of the definition of \p Name to import into the module
+/// \p DestPath, or null if no definition can be imported.
+static const FunctionSummary *selectCallee(const FunctionInfoIndex &Index,
+                                           StringRef Name, StringRef DestPath) {
+  const FunctionSummaryList *List = Index.findFunctionSummaryList(Name);
+  if (!List)
+    return nullptr;
+
+  for (const std::unique_ptr<FunctionSummary> &Summary : *List) {
+    if (Summary->modulePath() == DestPath)
+      continue;
+    // Only a definition that is known to be the one the linker will pick, or
+    // that is equivalent to it, can be duplicated as available_externally.
+    switch (Summary->getLinkage()) {
+    case GlobalValue::ExternalLinkage:
+    case GlobalValue::AvailableExternallyLinkage:
+    case GlobalValue::LinkOnceODRLinkage:
+    case GlobalValue::WeakODRLinkage:
+      break;
+    default:
+      continue;
+    }
+    if (Summary->instCount() > ImportInstrLimit)
+      continue;
+    return Summary.get();
+  }
+  return nullptr;
+}
+
+/// Returns true if the body of \p F references a global value that can't be
+/// referenced from another module: a local or an alias (which may alias a
+/// local, and is dropped from the source module before linking).
+static bool referencesLocalValue(const Function &F) {
+  SmallPtrSet<const Constant *, 8> Visited;
+  SmallVector<const User *, 8> Worklist;
+  for (const Instruction &I : inst_range(F))
+    Worklist.push_back(&I);
+
+  while (!Worklist.empty()) {
+    const User *U = Worklist.pop_back_val();
+    for (const Use &Op : U->operands()) {
+      if (auto *GV = dyn_cast<GlobalValue>(Op)) {
+        if (GV->hasLocalLinkage() || isa<GlobalAlias>(GV))
+          return true;
+        continue;
+      }
+      auto *C = dyn_cast<Constant>(Op);
+      if (C && Visited.insert(C).second)
+        Worklist.push_back(C);
+    }
+  }
+  return false;
+}
+
+/// Strips the fully materialized \p SrcModule down to the functions in
+/// \p ToImport, whose callees must already have been turned into declarations,
+/// so that linking it in only adds the imports: the other definitions become
+/// declarations, and what the imported functions don't reference is dropped.
+static void stripToImports(Module &SrcModule,
+                           const SmallPtrSetImpl<Function *> &ToImport) {
+  SrcModule.setModuleInlineAsm("");
+
+  for (GlobalVariable &GV : SrcModule.globals()) {
+    if (!GV.isDeclaration()) {
+      GV.setInitializer(nullptr);
+      // Dropping the initializer of an appending or local variable does not
+      // leave a valid declaration; those are erased below as they can't be
+      // used by an imported function.
+      if (!GV.hasAppendingLinkage() && !GV.hasLocalLinkage())
+        GV.setLinkage(GlobalValue::ExternalLinkage);
+    }
+    GV.setComdat(nullptr);
+  }
+
+  while (!SrcModule.alias_empty()) {
+    GlobalAlias &GA = *SrcModule.alias_begin();
+    GA.replaceAllUsesWith(UndefValue::get(GA.getType()));
+    GA.eraseFromParent();
+  }
+
+  for (Module::iterator I = SrcModule.begin(), E = SrcModule.end(); I != E;) {
+    Function &F = *I++;
+    if (!ToImport.count(&F) && F.use_empty())
+      F.eraseFromParent();
+  }
+  for (Module::global_iterator I = SrcModule.global_begin(),
+                               E = SrcModule.global_end();
+       I != E;) {
+    GlobalVariable &GV = *I++;
+    if (GV.use_empty())
+      GV.eraseFromParent();
+  }
+
+  // The imports are linked with their own linkage, as the linker does not link
+  // available_externally definitions over declarations, and are turned into
+  // available_externally definitions afterwards.
+  for (Function *F : ToImport)
+    F->setComdat(nullptr);
+}
+
+// Automatically import functions in Module \p DestModule based on the summaries
+// index.
+bool FunctionImporter::importFunctions(Module &DestModule) {
+  DEBUG(dbgs() << "Starting import for Module "
+               << DestModule.getModuleIdentifier() << "\n");
+  StringRef DestPath = DestModule.getModuleIdentifier();
+
+  // The names of the functions referenced from the destination module, or
+  // called by the functions imported so far, that might need to be imported.
+  SmallVector<std::string, 64> Worklist;
+  StringSet<> Visited;
+  auto Visit = [&](StringRef Name) {
+    if (Visited.insert(Name).second)
+      Worklist.push_back(Name);
+  };
+  for (Function &F : DestModule)
+    if (F.isDeclaration() && !F.isIntrinsic() && !F.use_empty())
+      Visit(F.getName());
+
+  bool Changed = false;
+  while (!Worklist.empty()) {
+    // Group this round of imports by source module, so that each module is
+    // loaded once per round.
+    std::map<StringRef, SmallVector<std::string, 8>> ModuleToFunctions;
+    for (const std::string &Name : Worklist) {
+      // Only functions that are still declared (not defined) in the
+      // destination module need importing.
+      Function *F = DestModule.getFunction(Name);
+      if (!F || !F->isDeclaration())
+        continue;
+      if (const FunctionSummary *Summary = selectCallee(Index, Name, DestPath))
+        ModuleToFunctions[Summary->modulePath()].push_back(Name);
+      else
+        DEBUG(dbgs() << "Ignoring " << Name << ": no importable definition\n");
+    }
+    Worklist.clear();
+
+    for (auto &Entry : ModuleToFunctions) {
+      StringRef SrcPath = Entry.first;
+      std::unique_ptr<Module> SrcModule = ModuleLoader(SrcPath);
+      if (!SrcModule)
+        continue;
+
+      // Materialize only the bodies of the functions to import.
+      SmallPtrSet<Function *, 8> ToImport;
+      for (const std::string &Name : Entry.second) {
+        Function *F = SrcModule->getFunction(Name);
+        if (!F || F->isDeclaration())
+          continue;
+        if (std::error_code EC = F->materialize()) {
+          DEBUG(dbgs() << "Error materializing " << Name << ": "
+                       << EC.message() << "\n");
+          continue;
+        }
+        if (F->hasPrefixData() || F->hasPrologueData() ||
+            referencesLocalValue(*F)) {
+          DEBUG(dbgs() << "Ignoring " << Name << ": references local values\n");
+          continue;
+        }
+        ToImport.insert(F);
+      }
+      if (ToImport.empty())
+        continue;
+
+      // Drop the other bodies before they are ever read, then finish loading
+      // the module (metadata, upgrades) so that it can be modified freely.
+      for (Function &F : *SrcModule)
+        if (!ToImport.count(&F) && !F.isDeclaration())
+          F.deleteBody();
+      if (std::error_code EC = SrcModule->materializeAllPermanently()) {
+        DEBUG(dbgs() << "Error loading " << SrcPath << ": " << EC.message()
+                     << "\n");
+        continue;
+      }
+      stripToImports(*SrcModule, ToImport);
+
+      // The callees of the imported functions may be worth importing too.
+      SmallVector<StringRef, 8> Imported;
+      for (const std::string &Name : Entry.second) {
+        Function *F = SrcModule->getFunction(Name);
+        if (!F || !ToImport.count(F))
+          continue;
+        DEBUG(dbgs() << "Importing " << Name << " from " << SrcPath << "\n");
+        Imported.push_back(Name);
+        if (const FunctionSummary *Summary =
+                selectCallee(Index, Name, DestPath))
+          for (const std::string &Callee : Summary->calls())
+            Visit(Callee);
+      }
+
+      if (Linker::LinkModules(&DestModule, SrcModule.get()))
+        report_fatal_error("Function Import: link error");
+      for (StringRef Name : Imported)
+        DestModule.getFunction(Name)->setLinkage(
+            GlobalValue::AvailableExternallyLinkage);
+      NumImported += Imported.size();
+      Changed = true;
+    }
+  }
+
+  DEBUG(dbgs() << "Imported " << NumImported << " functions for Module "
+               << DestModule.getModuleIdentifier() << "\n");
+  return Changed;
+}
+
+/// Summary file to use for function importing when using -function-import from
+/// the command line.
+static cl::opt<std::string>
+    SummaryFile("summary-file",
+                cl::desc("The summary file to use for function importing."));
+
+static void diagnosticHandler(const DiagnosticInfo &DI) {
+  raw_ostream &OS = errs();
+  DiagnosticPrinterRawOStream DP(OS);
+  DI.print(DP);
+  OS << '\n';
+}
+
+/// Load a module lazily, for the FunctionImporter.
+static std::unique_ptr<Module> loadFile(StringRef FileName,
+                                        LLVMContext &Context) {
+  SMDiagnostic Err;
+  DEBUG(dbgs() << "Loading '" << FileName << "'\n");
+  std::unique_ptr<Module> Result = getLazyIRFileModule(FileName, Err, Context);
+  if (!Result)
+    Err.print("function-import", errs());
+  return Result;
+}
+
+namespace {
+/// Pass that performs cross-module function import provided a summary file.
+class FunctionImportPass : public ModulePass {
+  /// Optional function summary index to use for importing, otherwise
+  /// the summary-file option must be specified.
+  const FunctionInfoIndex *Index;
+
+public:
+  /// Pass identification, replacement for typeid
+  static char ID;
+
+  /// Specify pass name for debug output
+  const char *getPassName() const override {
+    return "Function Importing";
+  }
+
+  explicit FunctionImportPass(const FunctionInfoIndex *Index = nullptr)
+      : ModulePass(ID), Index(Index) {
+    initializeFunctionImportPassPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override {
+    std::unique_ptr<FunctionInfoIndex> OwnedIndex;
+    if (!Index) {
+      if (SummaryFile.empty())
+        report_fatal_error("error: -function-import requires -summary-file or "
+                           "a function summary index\n");
+      ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
+          MemoryBuffer::getFile(SummaryFile);
+      if (std::error_code EC = BufferOrErr.getError())
+        report_fatal_error("error loading summary file '" + SummaryFile +
+                           "': " + EC.message());
+      ErrorOr<std::unique_ptr<FunctionInfoIndex>> IndexOrErr =
+          getFunctionInfoIndex((*BufferOrErr)->getMemBufferRef(),
+                               M.getContext(), diagnosticHandler);
+      if (std::error_code EC = IndexOrErr.getError())
+        report_fatal_error("error loading summary file '" + SummaryFile +
+                           "': " + EC.message());
+      OwnedIndex = std::move(*IndexOrErr);
+      Index = OwnedIndex.get();
+    }
+
+    // Perform the import now.
+    auto ModuleLoader = [&M](StringRef Path) {
+      return loadFile(Path, M.getContext());
+    };
+    FunctionImporter Importer(*Index, ModuleLoader);
+    bool Changed = Importer.importFunctions(M);
+    if (OwnedIndex)
+      Index = nullptr;
+    return Changed;
+  }
+};
+} // anonymous namespace
+
+char FunctionImportPass::ID = 0;
+INITIALIZE_PASS(FunctionImportPass, "function-import",
+                "Summary Based Function Import", false, false)
+
+ModulePass *llvm::createFunctionImportPass(const FunctionInfoIndex *Index) {
+  return new FunctionImportPass(Index);
+}
@@ -0,0 +1,309 @@
+//===- HotColdSplitting.cpp - Outline the cold regions of functions -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass outlines the cold regions of functions into separate functions, so
+// that rarely executed code such as error handling no longer shares i-cache
+// lines and pages with the hot code around it.  Block placement can only move
+// such code to the end of its function.
+//
+// A block is cold when the profile (the branch weights attached by the
+// frontend's instrumentation based PGO or by -sample-profile) says it runs at
+// most once every -hotcoldsplit-cold-ratio calls of its function.  Functions
+// without profile data are left alone.  A region is grown from each cold block
+// whose immediate dominator is hot through the cold blocks it dominates, and
+// the blocks that can be entered from outside of the region other than through
+// its header are dropped.  The region is outlined with the CodeExtractor when
+// the code it removes from the function outweighs the cost of calling it.
+//
+// The outlined functions are marked cold, minsize and noinline.  On ELF they
+// are placed in .text.unlikely, next to the other code the linker keeps away
+// from the hot text.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/IPO.h"
+#include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/BranchProbability.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/CodeExtractor.h"
+using namespace llvm;
+
+#define DEBUG_TYPE "hotcoldsplit"
+
+STATISTIC(NumSplitFunctions, "Number of functions with cold regions outlined");
+STATISTIC(NumColdRegions, "Number of cold regions outlined");
+STATISTIC(NumColdInsts, "Number of instructions moved out of hot functions");
+STATISTIC(ColdCodeSize, "Estimated size of the code moved out of hot "
+                        "functions");
+
+static cl::opt<unsigned>
+    ColdRatio("hotcoldsplit-cold-ratio", cl::init(1000), cl::Hidden,
+              cl::desc("A block is cold when it runs at most once per this "
+                       "many calls of its function"));
+
+static cl::opt<unsigned>
+    MinBenefit("hotcoldsplit-threshold", cl::init(2), cl::Hidden,
+               cl::desc("The minimum estimated size a region must save "
+                        "beyond the cost of calling it to be outlined"));
+
+namespace {
+class HotColdSplitting : public ModulePass {
+public:
+  static char ID; // Pass identification, replacement for typeid
+  HotColdSplitting() : ModulePass(ID), UseUnlikelySection(false) {
+    initializeHotColdSplittingPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<BlockFrequencyInfo>();
+    AU.addRequired<TargetTransformInfoWrapperPass>();
+  }
+
+private:
+  bool splitFunction(Function &F);
+  bool outlineRegion(Function &F, ArrayRef<BasicBlock *> Region,
+                     DominatorTree &DT, const TargetTransformInfo &TTI);
+
+  /// Whether the outlined functions go to .text.unlikely.
+  bool UseUnlikelySection;
+};
+} // end anonymous namespace
+
+char HotColdSplitting::ID = 0;
+INITIALIZE_PASS_BEGIN(HotColdSplitting, "hotcoldsplit",
+                      "Hot Cold Splitting", false, false)
+INITIALIZE_PASS_DEPENDENCY(BlockFrequencyInfo)
+INITIALIZE_PASS_DEPENDENCY(TargetTransformInfoWrapperPass)
+INITIALIZE_PASS_END(HotColdSplitting, "hotcoldsplit",
+                    "Hot Cold Splitting", false, false)
+
+ModulePass *llvm::createHotColdSplittingPass() {
+  return new HotColdSplitting();
+}
+
+/// Return true if a terminator of \p F carries branch weights.
+static bool hasProfileData(const Function &F) {
+  for (const BasicBlock &BB : F)
+    if (BB.getTerminator()->getMetadata(LLVMContext::MD_prof))
+      return true;
+  return false;
+}
+
+/// Return true if \p BB may be part of an outlined region.  A return would
+/// return from the outlined function instead, and the landing pad of an invoke
+/// has to stay in the function of the invoke.
+static bool mayBeOutlined(const BasicBlock &BB) {
+  const TerminatorInst *TI = BB.getTerminator();
+  return !BB.isLandingPad() && !isa<ReturnInst>(TI) && !isa<ResumeInst>(TI);
+}
+
+/// Return the single-entry region headed by the cold block \p Header: the cold
+/// blocks it dominates through other cold blocks, without the blocks that can
+/// be entered from outside of the region.  The header comes first.
+static SmallVector<BasicBlock *, 8>
+growRegion(BasicBlock *Header, DominatorTree &DT,
+           const SmallPtrSetImpl<BasicBlock *> &ColdBlocks) {
+  SmallVector<BasicBlock *, 8> Region;
+  SmallVector<DomTreeNode *, 8> Worklist(1, DT.getNode(Header));
+  while (!Worklist.empty()) {
+    DomTreeNode *Node = Worklist.pop_back_val();
+    Region.push_back(Node->getBlock());
+    for (DomTreeNode *Child : *Node)
+      if (ColdBlocks.count(Child->getBlock()))
+        Worklist.push_back(Child);
+  }
+
+  // Dropping a block may expose its successors to the outside; iterate until
+  // only the header has predecessors outside of the region.
+  SmallPtrSet<BasicBlock *, 8> InRegion(Region.begin(), Region.end());
+  bool Changed = true;
+  while (Changed) {
+    Changed = false;
+    for (BasicBlock *BB : Region) {
+      if (BB == Header || !InRegion.count(BB))
+        continue;
+      for (BasicBlock *Pred : predecessors(BB))
+        if (!InRegion.count(Pred)) {
+          InRegion.erase(BB);
+          Changed = true;
+          break;
+        }
+    }
+  }
+  Region.erase(std::remove_if(Region.begin(), Region.end(),
+                              [&](BasicBlock *BB) {
+                                return !InRegion.count(BB);
+                              }),
+               Region.end());
+  return Region;
+}
+
+bool HotColdSplitting::outlineRegion(Function &F,
+                                     ArrayRef<BasicBlock *> Region,
+                                     DominatorTree &DT,
+                                     const TargetTransformInfo &TTI) {
+  BasicBlock *Header = Region.front();
+  CodeExtractor CE(Region, &DT);
+  if (!CE.isEligible()) {
+    DEBUG(dbgs() << "HotColdSplit: cannot extract region at "
+                 << Header->getName() << "\n");
+    return false;
+  }
+
+  // The size the region takes out of the function, and the code needed in its
+  // place: the call with its arguments, a reload of each value the region
+  // defines for the rest of the function, and the dispatch on the exit taken.
+  unsigned Size = 0, NumInsts = 0;
+  SmallPtrSet<BasicBlock *, 8> InRegion(Region.begin(), Region.end());
+  SmallPtrSet<BasicBlock *, 4> Exits;
+  for (BasicBlock *BB : Region) {
+    for (Instruction &I : *BB) {
+      Size += TTI.getUserCost(&I);
+      ++NumInsts;
+    }
+    for (BasicBlock *Succ : successors(BB))
+      if (!InRegion.count(Succ))
+        Exits.insert(Succ);
+  }
+
+  // The extractor cannot merge the values that several blocks of the region
+  // pass to a PHI node outside of it.
+  for (BasicBlock *Exit : Exits) {
+    if (!isa<PHINode>(Exit->begin()))
+      continue;
+    SmallPtrSet<BasicBlock *, 4> RegionPreds;
+    for (BasicBlock *Pred : predecessors(Exit))
+      if (InRegion.count(Pred))
+        RegionPreds.insert(Pred);
+    if (RegionPreds.size() > 1) {
+      DEBUG(dbgs() << "HotColdSplit: region at " << Header->getName()
+                   << " merges values into " << Exit->getName() << "\n");
+      return false;
+    }
+  }
+
+  SetVector<Value *> Inputs, Outputs;
+  CE.findInputsOutputs(Inputs, Outputs);
+  unsigned Penalty = 1 + Inputs.size() + 2 * Outputs.size() +
+                     (Exits.size() > 1 ? Exits.size() : 0);
+  if (Size < Penalty + MinBenefit) {
+    DEBUG(dbgs() << "HotColdSplit: region at " << Header->getName()
+                 << " of size " << Size << " does not pay for its call ("
+                 << Penalty << ")\n");
+    return false;
+  }
+
+  DebugLoc DL = Header->getFirstNonPHI()->getDebugLoc();
+  Function *Outlined = CE.extractCodeRegion();
+  if (!Outlined)
+    return false;
+
+  Outlined->addFnAttr(Attribute::Cold);
+  Outlined->addFnAttr(Attribute::MinSize);
+  Outlined->addFnAttr(Attribute::NoInline);
+  if (F.hasSection())
+    Outlined->setSection(F.getSection());
+  else if (UseUnlikelySection)
+    Outlined->setSection(".text.unlikely");
+
+  // A region without exits never returns; the extractor assumed it was the
+  // tail of the function and returns after the call.
+  if (Exits.empty()) {
+    CallInst *Call = cast<CallInst>(Outlined->user_back());
+    Outlined->setDoesNotReturn();
+    Call->setDoesNotReturn();
+    TerminatorInst *Ret = Call->getParent()->getTerminator();
+    new UnreachableInst(F.getContext(), Ret);
+    Ret->eraseFromParent();
+  }
+
+  DEBUG(dbgs() << "HotColdSplit: outlined " << NumInsts
+               << " instructions of " << F.getName() << " into "
+               << Outlined->getName() << "\n");
+  emitOptimizationRemark(F.getContext(), DEBUG_TYPE, F, DL,
+                         "outlined cold region (" + Twine(NumInsts) +
+                             " instructions) into " + Outlined->getName());
+  ++NumColdRegions;
+  NumColdInsts += NumInsts;
+  ColdCodeSize += Size;
+  return true;
+}
+
+bool HotColdSplitting::splitFunction(Function &F) {
+  BlockFrequencyInfo &BFI = getAnalysis<BlockFrequencyInfo>(F);
+  const TargetTransformInfo &TTI =
+      getAnalysis<TargetTransformInfoWrapperPass>().getTTI(F);
+
+  // Find the cold blocks before changing anything; outlining does not keep the
+  // frequencies up to date.
+  BlockFrequency ColdFreq =
+      BlockFrequency(BFI.getEntryFreq()) * BranchProbability(1, ColdRatio);
+  SmallPtrSet<BasicBlock *, 16> ColdBlocks;
+  for (BasicBlock &BB : F)
+    if (&BB != &F.getEntryBlock() && mayBeOutlined(BB) &&
+        BFI.getBlockFreq(&BB) <= ColdFreq)
+      ColdBlocks.insert(&BB);
+  if (ColdBlocks.empty())
+    return false;
+
+  // Each region starts at a cold block dominated by a hot one.  Regions do not
+  // overlap, so they stay valid while the others are outlined.
+  DominatorTree DT;
+  DT.recalculate(F);
+  SmallVector<SmallVector<BasicBlock *, 8>, 4> Regions;
+  for (DomTreeNode *Node : depth_first(DT.getRootNode())) {
+    BasicBlock *BB = Node->getBlock();
+    if (ColdBlocks.count(BB) && !ColdBlocks.count(Node->getIDom()->getBlock()))
+      Regions.push_back(growRegion(BB, DT, ColdBlocks));
+  }
+
+  bool Changed = false;
+  for (auto &Region : Regions)
+    if (outlineRegion(F, Region, DT, TTI)) {
+      DT.recalculate(F);
+      Changed = true;
+    }
+  if (Changed)
+    ++NumSplitFunctions;
+  return Changed;
+}
+
+bool HotColdSplitting::runOnModule(Module &M) {
+  UseUnlikelySection = Triple(M.getTargetTriple()).isOSBinFormatELF();
+
+  // Outlining adds functions to the module; collect the candidates first.  The
+  // outlined functions are cold and never split again.
+  SmallVector<Function *, 16> Worklist;
+  for (Function &F : M)
+    if (!F.isDeclaration() && !F.hasFnAttribute(Attribute::Cold) &&
+        !F.hasFnAttribute(Attribute::OptimizeNone) && hasProfileData(F))
+      Worklist.push_back(&F);
+
+  bool Changed = false;
+  for (Function *F : Worklist)
+    Changed |= splitFunction(*F);
+  return Changed;
+}
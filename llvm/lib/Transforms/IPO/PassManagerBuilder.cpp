@@ -25,6 +25,7 @@
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/Instrumentation.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Vectorize.h"
 
@@ -85,6 +86,22 @@ static cl::opt<bool> EnableLoopInterchange(
     "enable-loopinterchange", cl::init(false), cl::Hidden,
     cl::desc("Enable the new, experimental LoopInterchange Pass"));
 
+static cl::opt<bool> EnablePriorityInliner(
+    "enable-priority-inliner", cl::init(false), cl::Hidden,
+    cl::desc("Replace the SCC inliner with the module-wide priority inliner"));
+
+static cl::opt<bool> EnableHotColdSplit(
+    "hot-cold-split", cl::init(false), cl::Hidden,
+    cl::desc("Outline the cold regions of functions with profile data"));
+
+static cl::opt<bool> EnableFunctionSpecialization(
+    "enable-function-specialization", cl::init(false), cl::Hidden,
+    cl::desc("Specialize functions for the constant arguments of hot calls"));
+
+static cl::opt<bool> EnableLoopDistribute(
+    "enable-loop-distribute", cl::init(false), cl::Hidden,
+    cl::desc("Enable the new, experimental LoopDistribution Pass"));
+
 PassManagerBuilder::PassManagerBuilder() {
     OptLevel = 2;
     SizeLevel = 0;
@@ -199,6 +216,11 @@ void PassManagerBuilder::populateModulePassManager(
   if (!DisableUnitAtATime) {
     addExtensionsToPM(EP_ModuleOptimizerEarly, MPM);
 
+    // Make the hot indirect calls direct before anything looks at the calls.
+    MPM.add(createPGOIndirectCallPromotionPass());
+
+    if (EnableFunctionSpecialization)
+      MPM.add(createFunctionSpecializationPass());
     MPM.add(createIPSCCPPass());              // IP SCCP
     MPM.add(createGlobalOptimizerPass());     // Optimize out global vars
 
@@ -213,7 +235,13 @@ void PassManagerBuilder::populateModulePassManager(
   if (!DisableUnitAtATime)
     MPM.add(createPruneEHPass());             // Remove dead EH info
   if (Inliner) {
-    MPM.add(Inliner);
+    if (EnablePriorityInliner) {
+      // The priority inliner sees the whole module at once, so the function
+      // passes below run after it rather than interleaved with the inlining.
+      delete Inliner;
+      MPM.add(createPriorityInlinerPass(OptLevel, SizeLevel));
+    } else
+      MPM.add(Inliner);
     Inliner = nullptr;
   }
   if (!DisableUnitAtATime)
@@ -319,6 +347,11 @@ void PassManagerBuilder::populateModulePassManager(
   // on the rotated form.
   MPM.add(createLoopRotatePass());
 
+  // Distribute loops to allow partial vectorization.  I.e. isolate dependences
+  // into separate loop that would otherwise inhibit vectorization.
+  if (EnableLoopDistribute)
+    MPM.add(createLoopDistributePass());
+
   MPM.add(createLoopVectorizePass(DisableUnrollLoops, LoopVectorize));
   // FIXME: Because of #pragma vectorize enable, the passes below are always
   // inserted in the pipeline, even when the vectorizer doesn't run (ex. when
@@ -387,6 +420,11 @@ void PassManagerBuilder::populateModulePassManager(
   // about pointer alignments.
   MPM.add(createAlignmentFromAssumptionsPass());
 
+  // Move the cold regions out of the functions last, once the hot code is in
+  // its final shape.
+  if (EnableHotColdSplit)
+    MPM.add(createHotColdSplittingPass());
+
   if (!DisableUnitAtATime) {
     // FIXME: We shouldn't bother with this anymore.
     MPM.add(createStripDeadPrototypesPass()); // Get rid of dead prototypes
@@ -0,0 +1,346 @@
+//===- PriorityInliner.cpp - Inline the best call sites of the module -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass is an inliner that ranks the call sites of the whole module.  The
+// SCC inliner decides each call site against the threshold in the order it
+// visits them, so the order, not the benefit of the sites, decides what is
+// inlined, and nothing bounds how much the module grows.
+//
+// Here every call site the cost analysis accepts gets a priority: how far
+// below the threshold its cost is, weighted by how often the site runs.  The
+// frequency of a site is its block frequency relative to the entry of its
+// caller, scaled by the profile entry count of the caller when there is one.
+// The sites are inlined from a module-wide priority queue, best first, while
+// the code they add stays within -priority-inline-growth percent of the size
+// of the module.  The sites are first visited bottom-up over the call graph,
+// which breaks the ties in favor of the callees.
+//
+// Each function has a summary: its size and a version that changes whenever
+// something is inlined into it.  The cost of a site is computed once and kept
+// in the queue with the version of the callee it was computed against; only
+// the sites of callees that changed since are analyzed again, when they reach
+// the top of the queue.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/IPO.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/AssumptionCache.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/InlineCost.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/ValueHandle.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <limits>
+#include <queue>
+using namespace llvm;
+
+#define DEBUG_TYPE "priority-inline"
+
+STATISTIC(NumInlined, "Number of call sites inlined");
+STATISTIC(NumDeleted, "Number of functions deleted because all callers found");
+STATISTIC(NumCostsComputed, "Number of call site costs computed");
+STATISTIC(NumOverBudget, "Number of call sites not inlined for lack of budget");
+
+static cl::opt<unsigned> Growth(
+    "priority-inline-growth", cl::init(20), cl::Hidden,
+    cl::desc("Maximum growth of the module by inlining, in percent of its "
+             "size"));
+
+// The threshold adjustments of the SCC inliner for the attributes of the
+// caller and the callee.
+static const int OptSizeThreshold = 75;
+static const int HintThreshold = 325;
+
+namespace {
+/// A call site waiting in the queue, with the cost it was ranked by.
+struct InlineCandidate {
+  WeakVH Call;
+  double Priority;
+  /// How often the site runs, to rank it again.
+  double Frequency;
+  /// The version of the callee the cost was computed against.
+  unsigned CalleeVersion;
+  /// The order the site was found in, to break ties.
+  unsigned Order;
+  /// The call site is to an always_inline function.
+  bool IsAlways;
+};
+
+struct CandidateCompare {
+  bool operator()(const InlineCandidate &L, const InlineCandidate &R) const {
+    if (L.Priority != R.Priority)
+      return L.Priority < R.Priority;
+    return L.Order > R.Order;
+  }
+};
+
+/// What the inliner knows of a function without looking at it again.
+struct FunctionSummary {
+  FunctionSummary() : Size(0), Version(0) {}
+  /// The number of instructions of the function.
+  unsigned Size;
+  /// Changes when a call site is inlined into the function.
+  unsigned Version;
+};
+
+class PriorityInliner : public ModulePass {
+public:
+  static char ID; // Pass identification, replacement for typeid
+  PriorityInliner(int Threshold = 225)
+      : ModulePass(ID), Threshold(Threshold), NextOrder(0), CG(nullptr),
+        ACT(nullptr) {
+    initializePriorityInlinerPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<AliasAnalysis>();
+    AU.addRequired<AssumptionCacheTracker>();
+    AU.addRequired<BlockFrequencyInfo>();
+    AU.addRequired<CallGraphWrapperPass>();
+    AU.addRequired<TargetTransformInfoWrapperPass>();
+  }
+
+private:
+  int getThreshold(CallSite CS) const;
+  double getCallerCount(Function &F) const;
+  void addCallSites(Function &F, ArrayRef<Instruction *> Calls);
+  bool rankCallSite(CallSite CS, InlineCandidate &C);
+  unsigned getGrowth(Function &Callee) const;
+  void deleteIfDead(Function &F);
+
+  int Threshold;
+  unsigned NextOrder;
+  CallGraph *CG;
+  AssumptionCacheTracker *ACT;
+  std::priority_queue<InlineCandidate, std::vector<InlineCandidate>,
+                      CandidateCompare> Queue;
+  DenseMap<const Function *, FunctionSummary> Summaries;
+};
+} // end anonymous namespace
+
+char PriorityInliner::ID = 0;
+INITIALIZE_PASS_BEGIN(PriorityInliner, "priority-inline",
+                      "Priority-based Function Inlining", false, false)
+INITIALIZE_AG_DEPENDENCY(AliasAnalysis)
+INITIALIZE_PASS_DEPENDENCY(AssumptionCacheTracker)
+INITIALIZE_PASS_DEPENDENCY(BlockFrequencyInfo)
+INITIALIZE_PASS_DEPENDENCY(CallGraphWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(TargetTransformInfoWrapperPass)
+INITIALIZE_PASS_END(PriorityInliner, "priority-inline",
+                    "Priority-based Function Inlining", false, false)
+
+ModulePass *llvm::createPriorityInlinerPass() { return new PriorityInliner(); }
+
+ModulePass *llvm::createPriorityInlinerPass(unsigned OptLevel,
+                                            unsigned SizeOptLevel) {
+  return new PriorityInliner(
+      computeThresholdFromOptLevels(OptLevel, SizeOptLevel));
+}
+
+int PriorityInliner::getThreshold(CallSite CS) const {
+  int Thres = Threshold;
+  Function *Caller = CS.getCaller();
+  Function *Callee = CS.getCalledFunction();
+  if (Caller->hasFnAttribute(Attribute::OptimizeForSize))
+    Thres = std::min(Thres, OptSizeThreshold);
+  if (Callee->hasFnAttribute(Attribute::InlineHint) &&
+      !Caller->hasFnAttribute(Attribute::MinSize))
+    Thres = std::max(Thres, HintThreshold);
+  return Thres;
+}
+
+/// Return how many times \p F is entered: its profile entry count, or 1 when
+/// there is no profile, which ranks its sites by block frequency alone.
+double PriorityInliner::getCallerCount(Function &F) const {
+  if (Optional<uint64_t> Count = F.getEntryCount())
+    return *Count;
+  return 1.0;
+}
+
+/// Compute the cost of inlining \p CS, and rank it in \p C by the cost and
+/// the frequency already in \p C.  Return false if the cost analysis rejects
+/// the site.
+bool PriorityInliner::rankCallSite(CallSite CS, InlineCandidate &C) {
+  Function *Callee = CS.getCalledFunction();
+  ++NumCostsComputed;
+  InlineCost IC = getInlineCost(
+      CS, Callee, getThreshold(CS),
+      getAnalysis<TargetTransformInfoWrapperPass>().getTTI(*Callee), ACT);
+  if (!IC)
+    return false;
+
+  C.Call = CS.getInstruction();
+  C.CalleeVersion = Summaries[Callee].Version;
+  C.IsAlways = IC.isAlways();
+  // Sites that are cheaper than the threshold by the same amount are worth
+  // more the more often they run.  Sites that never run keep the benefit of
+  // the cost analysis alone, behind every site that runs.
+  if (C.IsAlways)
+    C.Priority = std::numeric_limits<double>::max();
+  else
+    C.Priority = (IC.getCostDelta() + 1) * (C.Frequency + 1.0);
+  return true;
+}
+
+/// Queue the direct calls \p Calls of \p F.
+void PriorityInliner::addCallSites(Function &F, ArrayRef<Instruction *> Calls) {
+  BlockFrequencyInfo &BFI = getAnalysis<BlockFrequencyInfo>(F);
+  double EntryFreq = BFI.getEntryFreq();
+  double Count = getCallerCount(F);
+  for (Instruction *I : Calls) {
+    CallSite CS(I);
+    Function *Callee = CS.getCalledFunction();
+    if (!Callee || Callee->isDeclaration() || Callee == &F)
+      continue;
+    InlineCandidate C;
+    C.Frequency =
+        Count * BFI.getBlockFreq(I->getParent()).getFrequency() / EntryFreq;
+    C.Order = NextOrder++;
+    if (rankCallSite(CS, C))
+      Queue.push(C);
+  }
+}
+
+/// Return how much inlining a call to \p Callee grows the module.  The last
+/// call to a local function costs nothing: the function goes away.
+unsigned PriorityInliner::getGrowth(Function &Callee) const {
+  if (Callee.hasLocalLinkage() && Callee.hasOneUse())
+    return 0;
+  return Summaries.lookup(&Callee).Size;
+}
+
+void PriorityInliner::deleteIfDead(Function &F) {
+  if (!F.hasLocalLinkage() || !F.use_empty())
+    return;
+  CallGraphNode *CGN = (*CG)[&F];
+  if (CGN->getNumReferences())
+    return;
+  CGN->removeAllCalledFunctions();
+  Summaries.erase(&F);
+  delete CG->removeFunctionFromModule(CGN);
+  ++NumDeleted;
+}
+
+bool PriorityInliner::runOnModule(Module &M) {
+  CG = &getAnalysis<CallGraphWrapperPass>().getCallGraph();
+  ACT = &getAnalysis<AssumptionCacheTracker>();
+  AliasAnalysis *AA = &getAnalysis<AliasAnalysis>();
+
+  // Summarize the functions and queue their call sites, callees first.
+  uint64_t ModuleSize = 0;
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    unsigned Size = 0;
+    for (BasicBlock &BB : F)
+      Size += BB.size();
+    Summaries[&F].Size = Size;
+    ModuleSize += Size;
+  }
+  for (scc_iterator<CallGraph *> I = scc_begin(CG); !I.isAtEnd(); ++I)
+    for (CallGraphNode *CGN : *I) {
+      Function *F = CGN->getFunction();
+      if (!F || F->isDeclaration() ||
+          F->hasFnAttribute(Attribute::OptimizeNone))
+        continue;
+      SmallVector<Instruction *, 16> Calls;
+      for (BasicBlock &BB : *F)
+        for (Instruction &I : BB)
+          if (CallSite(&I))
+            Calls.push_back(&I);
+      addCallSites(*F, Calls);
+    }
+
+  uint64_t Budget = ModuleSize * Growth / 100, Used = 0;
+  DEBUG(dbgs() << "PriorityInline: module size " << ModuleSize << ", budget "
+               << Budget << "\n");
+
+  bool Changed = false;
+  InlineFunctionInfo IFI(CG, AA, ACT);
+  while (!Queue.empty()) {
+    InlineCandidate C = Queue.top();
+    Queue.pop();
+    Instruction *I = cast_or_null<Instruction>(C.Call);
+    if (!I)
+      continue;
+    CallSite CS(I);
+    Function *Caller = CS.getCaller();
+    Function *Callee = CS.getCalledFunction();
+    if (!Callee || Callee->isDeclaration())
+      continue;
+
+    // The callee changed since the site was ranked; rank it again.
+    if (C.CalleeVersion != Summaries[Callee].Version) {
+      if (rankCallSite(CS, C))
+        Queue.push(C);
+      continue;
+    }
+
+    // Always-inline sites are not up for discussion and don't use the
+    // budget.
+    unsigned SiteGrowth = C.IsAlways ? 0 : getGrowth(*Callee);
+    if (Used + SiteGrowth > Budget) {
+      DEBUG(dbgs() << "PriorityInline: no budget left to inline "
+                   << Callee->getName() << " into " << Caller->getName()
+                   << "\n");
+      ++NumOverBudget;
+      continue;
+    }
+
+    DebugLoc DLoc = I->getDebugLoc();
+    IFI.reset();
+    if (!InlineFunction(CS, IFI))
+      continue;
+    emitOptimizationRemark(Caller->getContext(), DEBUG_TYPE, *Caller, DLoc,
+                           Twine(Callee->getName()) + " inlined into " +
+                               Caller->getName());
+    ++NumInlined;
+    Changed = true;
+    Used += SiteGrowth;
+
+    FunctionSummary &CallerSummary = Summaries[Caller];
+    CallerSummary.Size += Summaries[Callee].Size;
+    ++CallerSummary.Version;
+
+    // Queue the calls that came with the callee, with the frequencies of the
+    // caller as it is now.
+    SmallVector<Instruction *, 8> NewCalls;
+    for (WeakVH &V : IFI.InlinedCalls)
+      if (Instruction *NewCall = cast_or_null<Instruction>(V))
+        NewCalls.push_back(NewCall);
+    if (!NewCalls.empty())
+      addCallSites(*Caller, NewCalls);
+
+    // The last call of a local function is worth more than the others; let
+    // the cost analysis see it again.
+    if (Callee->hasLocalLinkage() && Callee->hasOneUse())
+      ++Summaries[Callee].Version;
+    deleteIfDead(*Callee);
+  }
+
+  DEBUG(dbgs() << "PriorityInline: inlined " << NumInlined << " call sites, "
+               << "growth " << Used << "\n");
+  return Changed;
+}
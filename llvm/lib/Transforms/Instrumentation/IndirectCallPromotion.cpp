@@ -0,0 +1,288 @@
+//===-- IndirectCallPromotion.cpp - Promote hot indirect call targets -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass promotes the hottest targets of indirect calls to direct calls,
+// using the value profiles the frontend attaches to them from instrumentation
+// based profiles (see annotateValueSite).  A promoted call becomes
+//
+//   if (callee == @target)
+//     call @target(...)
+//   else
+//     call callee(...)
+//
+// so that the inliner and the other interprocedural passes see the direct
+// call.  The value profile of the remaining indirect call is updated to what
+// was not promoted.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/Instrumentation.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InlineAsm.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/ProfileData/InstrProf.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "pgo-icall-prom"
+
+STATISTIC(NumOfPGOICallPromotion, "Number of indirect call promotions.");
+STATISTIC(NumOfPGOICallsites, "Number of indirect call candidate sites.");
+STATISTIC(NumOfPGOICallMismatch,
+          "Number of hot targets not promoted because of a type mismatch.");
+
+static cl::opt<bool> DisableICP("disable-icp", cl::init(false), cl::Hidden,
+                                cl::desc("Disable indirect call promotion"));
+
+static cl::opt<unsigned>
+    ICPCountThreshold("icp-count-threshold", cl::init(1000), cl::Hidden,
+                      cl::desc("The minimum count of a target of an indirect "
+                               "call for it to be promoted"));
+
+static cl::opt<unsigned>
+    ICPPercentThreshold("icp-percent-threshold", cl::init(30), cl::Hidden,
+                        cl::desc("The minimum percentage of the calls left at "
+                                 "a site a target needs to be promoted"));
+
+static cl::opt<unsigned>
+    ICPMaxProm("icp-max-prom", cl::init(2), cl::Hidden,
+               cl::desc("The maximum number of targets promoted at a site"));
+
+namespace {
+class PGOIndirectCallPromotion : public ModulePass {
+public:
+  static char ID;
+
+  PGOIndirectCallPromotion() : ModulePass(ID) {
+    initializePGOIndirectCallPromotionPass(*PassRegistry::getPassRegistry());
+  }
+
+  const char *getPassName() const override {
+    return "PGOIndirectCallPromotion";
+  }
+
+  bool runOnModule(Module &M) override;
+
+private:
+  /// The functions of the module, by the hash of their profile name.
+  DenseMap<uint64_t, Function *> FunctionsByNameHash;
+
+  bool processFunction(Function &F);
+  void promote(Instruction *Inst, Function *Target, uint64_t Count,
+               uint64_t TotalCount);
+};
+} // end anonymous namespace
+
+char PGOIndirectCallPromotion::ID = 0;
+INITIALIZE_PASS(PGOIndirectCallPromotion, "pgo-icall-prom",
+                "Use PGO instrumentation profile to promote indirect calls to "
+                "direct calls.",
+                false, false)
+
+ModulePass *llvm::createPGOIndirectCallPromotionPass() {
+  return new PGOIndirectCallPromotion();
+}
+
+bool PGOIndirectCallPromotion::runOnModule(Module &M) {
+  if (DisableICP)
+    return false;
+
+  FunctionsByNameHash.clear();
+  for (Function &F : M)
+    if (!F.isIntrinsic())
+      FunctionsByNameHash[getInstrProfNameHash(getPGOFuncName(F))] = &F;
+
+  bool Changed = false;
+  for (Function &F : M)
+    if (!F.isDeclaration())
+      Changed |= processFunction(F);
+  return Changed;
+}
+
+/// Scale the counts of a branch to fit the 32-bit branch weights.
+static MDNode *createBranchWeights(LLVMContext &Ctx, uint64_t TrueCount,
+                                   uint64_t FalseCount) {
+  uint64_t Scale = 1;
+  uint64_t MaxCount = std::max(TrueCount, FalseCount);
+  if (MaxCount > UINT32_MAX)
+    Scale = MaxCount / UINT32_MAX + 1;
+  return MDBuilder(Ctx).createBranchWeights(uint32_t(TrueCount / Scale),
+                                            uint32_t(FalseCount / Scale));
+}
+
+/// Return a copy of the indirect call Inst calling Target, not inserted yet.
+static Instruction *cloneAsDirectCall(Instruction *Inst, Function *Target) {
+  Instruction *NewInst = Inst->clone();
+  NewInst->setMetadata(LLVMContext::MD_prof, nullptr);
+  CallSite(NewInst).setCalledFunction(Target);
+  if (!Inst->getName().empty())
+    NewInst->setName(Inst->getName() + ".direct");
+  return NewInst;
+}
+
+/// Promote the call of Target at the call instruction Inst.
+static void promoteCall(CallInst *Inst, Function *Target, MDNode *Weights) {
+  IRBuilder<> Builder(Inst);
+  Value *Callee = CallSite(Inst).getCalledValue();
+  Value *Cond = Builder.CreateICmpEQ(
+      Callee, Builder.CreateBitCast(Target, Callee->getType()));
+
+  TerminatorInst *ThenTerm, *ElseTerm;
+  SplitBlockAndInsertIfThenElse(Cond, Inst, &ThenTerm, &ElseTerm, Weights);
+  BasicBlock *TailBB = Inst->getParent();
+
+  Instruction *DirectCall = cloneAsDirectCall(Inst, Target);
+  DirectCall->insertBefore(ThenTerm);
+  Inst->moveBefore(ElseTerm);
+
+  if (Inst->getType()->isVoidTy() || Inst->use_empty())
+    return;
+  PHINode *Result = PHINode::Create(Inst->getType(), 2, "", &TailBB->front());
+  Inst->replaceAllUsesWith(Result);
+  Result->addIncoming(DirectCall, ThenTerm->getParent());
+  Result->addIncoming(Inst, ElseTerm->getParent());
+}
+
+/// Promote the call of Target at the invoke Inst.  Both invokes unwind to the
+/// original landing pad, and return to a new block merging their results.
+static void promoteInvoke(InvokeInst *Inst, Function *Target,
+                          MDNode *Weights) {
+  BasicBlock *OrigBB = Inst->getParent();
+  BasicBlock *NormalDest = Inst->getNormalDest();
+  BasicBlock *UnwindDest = Inst->getUnwindDest();
+  LLVMContext &Ctx = Inst->getContext();
+  Function *F = OrigBB->getParent();
+
+  BasicBlock *DirectBB =
+      BasicBlock::Create(Ctx, "icp.direct", F, NormalDest);
+  BasicBlock *IndirectBB =
+      BasicBlock::Create(Ctx, "icp.indirect", F, NormalDest);
+  BasicBlock *MergeBB = BasicBlock::Create(Ctx, "icp.merge", F, NormalDest);
+
+  IRBuilder<> Builder(Inst);
+  Value *Callee = CallSite(Inst).getCalledValue();
+  Value *Cond = Builder.CreateICmpEQ(
+      Callee, Builder.CreateBitCast(Target, Callee->getType()));
+  Builder.CreateCondBr(Cond, DirectBB, IndirectBB, Weights);
+
+  // Move the invoke and create its direct copy.
+  Inst->removeFromParent();
+  IndirectBB->getInstList().push_back(Inst);
+  Instruction *DirectInvoke = cloneAsDirectCall(Inst, Target);
+  DirectBB->getInstList().push_back(DirectInvoke);
+  cast<InvokeInst>(DirectInvoke)->setNormalDest(MergeBB);
+  Inst->setNormalDest(MergeBB);
+  BranchInst::Create(NormalDest, MergeBB);
+
+  // The normal destination is now reached from MergeBB, and the unwind
+  // destination from both invokes.
+  for (Instruction &I : *NormalDest) {
+    PHINode *Phi = dyn_cast<PHINode>(&I);
+    if (!Phi)
+      break;
+    int Idx = Phi->getBasicBlockIndex(OrigBB);
+    Phi->setIncomingBlock(Idx, MergeBB);
+  }
+  for (Instruction &I : *UnwindDest) {
+    PHINode *Phi = dyn_cast<PHINode>(&I);
+    if (!Phi)
+      break;
+    int Idx = Phi->getBasicBlockIndex(OrigBB);
+    Value *V = Phi->getIncomingValue(Idx);
+    Phi->setIncomingBlock(Idx, IndirectBB);
+    Phi->addIncoming(V, DirectBB);
+  }
+
+  if (Inst->getType()->isVoidTy() || Inst->use_empty())
+    return;
+  PHINode *Result = PHINode::Create(Inst->getType(), 2, "", &MergeBB->front());
+  Inst->replaceAllUsesWith(Result);
+  Result->addIncoming(DirectInvoke, DirectBB);
+  Result->addIncoming(Inst, IndirectBB);
+}
+
+void PGOIndirectCallPromotion::promote(Instruction *Inst, Function *Target,
+                                       uint64_t Count, uint64_t TotalCount) {
+  DEBUG(dbgs() << "ICP: promoting " << Target->getName() << " (count "
+               << Count << " of " << TotalCount << ") at " << *Inst << "\n");
+  MDNode *Weights =
+      createBranchWeights(Inst->getContext(), Count, TotalCount - Count);
+  if (CallInst *CI = dyn_cast<CallInst>(Inst))
+    promoteCall(CI, Target, Weights);
+  else
+    promoteInvoke(cast<InvokeInst>(Inst), Target, Weights);
+  ++NumOfPGOICallPromotion;
+}
+
+bool PGOIndirectCallPromotion::processFunction(Function &F) {
+  // Collect the sites first, as promotion splits blocks.
+  SmallVector<Instruction *, 8> Sites;
+  for (BasicBlock &BB : F)
+    for (Instruction &I : BB) {
+      CallSite CS(&I);
+      if (!CS || CS.getCalledFunction() || isa<InlineAsm>(CS.getCalledValue()))
+        continue;
+      if (I.getMetadata(LLVMContext::MD_prof))
+        Sites.push_back(&I);
+    }
+
+  bool Changed = false;
+  for (Instruction *Inst : Sites) {
+    SmallVector<InstrProfValueData, 4> ValueData;
+    uint64_t TotalCount;
+    if (!getValueProfDataFromInst(*Inst, IPVK_IndirectCallTarget, ValueData,
+                                  TotalCount))
+      continue;
+    ++NumOfPGOICallsites;
+
+    FunctionType *CalleeTy = cast<FunctionType>(
+        CallSite(Inst).getCalledValue()->getType()->getPointerElementType());
+    InstrProfValueSiteRecord Remaining;
+    unsigned NumPromoted = 0;
+    for (const InstrProfValueData &VD : ValueData) {
+      // The percentage is of what the promotions so far leave at the site.
+      bool Hot = NumPromoted < ICPMaxProm && VD.Count >= ICPCountThreshold &&
+                 VD.Count * 100 >= ICPPercentThreshold * TotalCount;
+      Function *Target = Hot ? FunctionsByNameHash.lookup(VD.Value) : nullptr;
+      if (Target && Target->getFunctionType() != CalleeTy) {
+        DEBUG(dbgs() << "ICP: not promoting " << Target->getName()
+                     << ", its type does not match the call\n");
+        ++NumOfPGOICallMismatch;
+        Target = nullptr;
+      }
+      if (!Target) {
+        Remaining.ValueData.push_back(VD);
+        continue;
+      }
+      promote(Inst, Target, VD.Count, TotalCount);
+      TotalCount -= VD.Count;
+      ++NumPromoted;
+    }
+    if (!NumPromoted)
+      continue;
+
+    // Keep the profile of what is left of the indirect call.
+    Inst->setMetadata(LLVMContext::MD_prof, nullptr);
+    if (TotalCount)
+      annotateValueSite(*Inst, Remaining.ValueData, TotalCount,
+                        IPVK_IndirectCallTarget, Remaining.ValueData.size());
+    Changed = true;
+  }
+  return Changed;
+}
@@ -7,9 +7,10 @@
 //
 //===----------------------------------------------------------------------===//
 //
-// This pass lowers instrprof_increment intrinsics emitted by a frontend for
-// profiling. It also builds the data structures and initialization code needed
-// for updating execution counts and emitting the profile at runtime.
+// This pass lowers instrprof_increment and instrprof_value_profile intrinsics
+// emitted by a frontend for profiling. It also builds the data structures and
+// initialization code needed for updating execution counts and value profiles
+// and emitting the profile at runtime.
 //
 //===----------------------------------------------------------------------===//
 
@@ -19,6 +20,7 @@
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Module.h"
+#include "llvm/ProfileData/InstrProf.h"
 #include "llvm/Transforms/Utils/ModuleUtils.h"
 
 using namespace llvm;
@@ -47,9 +49,19 @@ public:
   }
 
 private:
+  /// The profiling variables of a function, keyed by its name variable.
+  struct PerFunctionProfileData {
+    uint32_t NumValueSites[IPVK_Last + 1];
+    GlobalVariable *RegionCounters;
+    GlobalVariable *DataVar;
+    PerFunctionProfileData() : RegionCounters(nullptr), DataVar(nullptr) {
+      std::fill(std::begin(NumValueSites), std::end(NumValueSites), 0);
+    }
+  };
+
   InstrProfOptions Options;
   Module *M;
-  DenseMap<GlobalVariable *, GlobalVariable *> RegionCounters;
+  DenseMap<GlobalVariable *, PerFunctionProfileData> ProfileDataMap;
   std::vector<Value *> UsedVars;
 
   bool isMachO() const {
@@ -76,6 +88,12 @@ private:
     return isMachO() ? "__DATA,__llvm_covmap" : "__llvm_covmap";
   }
 
+  /// Count the value profiling sites of each kind of the function of Ind.
+  void computeNumValueSites(InstrProfValueProfileInst *Ind);
+
+  /// Replace instrprof_value_profile with a call to the runtime.
+  void lowerValueProfileInst(InstrProfValueProfileInst *Ind);
+
   /// Replace instrprof_increment with an increment of the appropriate value.
   void lowerIncrement(InstrProfIncrementInst *Inc);
 
@@ -116,9 +134,17 @@ bool InstrProfiling::runOnModule(Module &M) {
   bool MadeChange = false;
 
   this->M = &M;
-  RegionCounters.clear();
+  ProfileDataMap.clear();
   UsedVars.clear();
 
+  // The data variables, created with the counters, record the number of
+  // value sites, so count them first.
+  for (Function &F : M)
+    for (BasicBlock &BB : F)
+      for (Instruction &I : BB)
+        if (auto *Ind = dyn_cast<InstrProfValueProfileInst>(&I))
+          computeNumValueSites(Ind);
+
   for (Function &F : M)
     for (BasicBlock &BB : F)
       for (auto I = BB.begin(), E = BB.end(); I != E;)
@@ -126,6 +152,13 @@ bool InstrProfiling::runOnModule(Module &M) {
           lowerIncrement(Inc);
           MadeChange = true;
         }
+  for (Function &F : M)
+    for (BasicBlock &BB : F)
+      for (auto I = BB.begin(), E = BB.end(); I != E;)
+        if (auto *Ind = dyn_cast<InstrProfValueProfileInst>(I++)) {
+          lowerValueProfileInst(Ind);
+          MadeChange = true;
+        }
   if (GlobalVariable *Coverage = M.getNamedGlobal("__llvm_coverage_mapping")) {
     lowerCoverageData(Coverage);
     MadeChange = true;
@@ -140,6 +173,49 @@ bool InstrProfiling::runOnModule(Module &M) {
   return true;
 }
 
+void InstrProfiling::computeNumValueSites(InstrProfValueProfileInst *Ind) {
+  uint64_t ValueKind = Ind->getValueKind()->getZExtValue();
+  uint64_t Index = Ind->getIndex()->getZExtValue();
+  assert(ValueKind <= IPVK_Last && "unknown kind of value profiling site");
+  uint32_t &NumSites = ProfileDataMap[Ind->getName()].NumValueSites[ValueKind];
+  NumSites = std::max<uint32_t>(NumSites, Index + 1);
+}
+
+static Constant *getOrInsertValueProfilingCall(Module &M) {
+  LLVMContext &Ctx = M.getContext();
+  Type *ParamTypes[] = {Type::getInt64Ty(Ctx), Type::getInt8PtrTy(Ctx),
+                        Type::getInt32Ty(Ctx)};
+  auto *ValueProfilingCallTy =
+      FunctionType::get(Type::getVoidTy(Ctx), ParamTypes, false);
+  return M.getOrInsertFunction("__llvm_profile_instrument_target",
+                               ValueProfilingCallTy);
+}
+
+void InstrProfiling::lowerValueProfileInst(InstrProfValueProfileInst *Ind) {
+  auto It = ProfileDataMap.find(Ind->getName());
+  // Without counters, the function has no data variable to record the values
+  // in.
+  if (It == ProfileDataMap.end() || !It->second.DataVar) {
+    Ind->eraseFromParent();
+    return;
+  }
+
+  // The runtime numbers the sites of all kinds together.
+  uint64_t ValueKind = Ind->getValueKind()->getZExtValue();
+  uint64_t Index = Ind->getIndex()->getZExtValue();
+  for (uint32_t Kind = IPVK_First; Kind < ValueKind; ++Kind)
+    Index += It->second.NumValueSites[Kind];
+
+  IRBuilder<> Builder(Ind->getParent(), *Ind);
+  Value *Args[] = {Ind->getTargetValue(),
+                   Builder.CreateBitCast(It->second.DataVar,
+                                         Builder.getInt8PtrTy()),
+                   Builder.getInt32(Index)};
+  Ind->replaceAllUsesWith(
+      Builder.CreateCall(getOrInsertValueProfilingCall(*M), Args));
+  Ind->eraseFromParent();
+}
+
 void InstrProfiling::lowerIncrement(InstrProfIncrementInst *Inc) {
   GlobalVariable *Counters = getOrCreateRegionCounters(Inc);
 
@@ -171,8 +247,8 @@ void InstrProfiling::lowerCoverageData(GlobalVariable *CoverageData) {
     GlobalVariable *Name = cast<GlobalVariable>(V);
 
     // If we have region counters for this name, we've already handled it.
-    auto It = RegionCounters.find(Name);
-    if (It != RegionCounters.end())
+    auto It = ProfileDataMap.find(Name);
+    if (It != ProfileDataMap.end() && It->second.RegionCounters)
       continue;
 
     // Move the name variable to the right section.
@@ -181,19 +257,23 @@ void InstrProfiling::lowerCoverageData(GlobalVariable *CoverageData) {
   }
 }
 
+/// Get the name of the function of an increment in the profile.
+static StringRef getPGOName(InstrProfIncrementInst *Inc) {
+  auto *Arr = cast<ConstantDataArray>(Inc->getName()->getInitializer());
+  return Arr->isCString() ? Arr->getAsCString() : Arr->getAsString();
+}
+
 /// Get the name of a profiling variable for a particular function.
 static std::string getVarName(InstrProfIncrementInst *Inc, StringRef VarName) {
-  auto *Arr = cast<ConstantDataArray>(Inc->getName()->getInitializer());
-  StringRef Name = Arr->isCString() ? Arr->getAsCString() : Arr->getAsString();
-  return ("__llvm_profile_" + VarName + "_" + Name).str();
+  return ("__llvm_profile_" + VarName + "_" + getPGOName(Inc)).str();
 }
 
 GlobalVariable *
 InstrProfiling::getOrCreateRegionCounters(InstrProfIncrementInst *Inc) {
   GlobalVariable *Name = Inc->getName();
-  auto It = RegionCounters.find(Name);
-  if (It != RegionCounters.end())
-    return It->second;
+  PerFunctionProfileData &PD = ProfileDataMap[Name];
+  if (PD.RegionCounters)
+    return PD.RegionCounters;
 
   // Move the name variable to the right section.
   Name->setSection(getNameSection());
@@ -211,29 +291,63 @@ InstrProfiling::getOrCreateRegionCounters(InstrProfIncrementInst *Inc) {
   Counters->setSection(getCountersSection());
   Counters->setAlignment(8);
 
-  RegionCounters[Inc->getName()] = Counters;
+  PD.RegionCounters = Counters;
 
   // Create data variable.
   auto *NameArrayTy = Name->getType()->getPointerElementType();
+  auto *Int16Ty = Type::getInt16Ty(Ctx);
   auto *Int32Ty = Type::getInt32Ty(Ctx);
   auto *Int64Ty = Type::getInt64Ty(Ctx);
   auto *Int8PtrTy = Type::getInt8PtrTy(Ctx);
   auto *Int64PtrTy = Type::getInt64PtrTy(Ctx);
+  auto *NumValueSitesTy = ArrayType::get(Int16Ty, IPVK_Last + 1);
+
+  // The runtime keeps the values seen at each value site in a list whose
+  // head is in an array of the function.
+  uint32_t TotalValueSites = 0;
+  Constant *NumValueSites[IPVK_Last + 1];
+  for (uint32_t Kind = IPVK_First; Kind <= IPVK_Last; ++Kind) {
+    TotalValueSites += PD.NumValueSites[Kind];
+    NumValueSites[Kind] = ConstantInt::get(Int16Ty, PD.NumValueSites[Kind]);
+  }
+  Constant *ValuesPtr = ConstantPointerNull::get(Int8PtrTy);
+  if (TotalValueSites) {
+    auto *ValuesTy = ArrayType::get(Int8PtrTy, TotalValueSites);
+    auto *Values = new GlobalVariable(*M, ValuesTy, false, Name->getLinkage(),
+                                      Constant::getNullValue(ValuesTy),
+                                      getVarName(Inc, "values"));
+    Values->setVisibility(Name->getVisibility());
+    Values->setAlignment(8);
+    ValuesPtr = ConstantExpr::getBitCast(Values, Int8PtrTy);
+  }
+
+  // Indirect call targets are recorded by address, so the runtime needs the
+  // address of each function to name them.  Only record it in the data of the
+  // function itself, not of a function inlined into it.
+  Function *Fn = Inc->getParent()->getParent();
+  Constant *FunctionAddr = ConstantPointerNull::get(Int8PtrTy);
+  if (getPGOFuncName(*Fn) == getPGOName(Inc))
+    FunctionAddr = ConstantExpr::getBitCast(Fn, Int8PtrTy);
 
-  Type *DataTypes[] = {Int32Ty, Int32Ty, Int64Ty, Int8PtrTy, Int64PtrTy};
+  Type *DataTypes[] = {Int32Ty,   Int32Ty,   Int64Ty,        Int8PtrTy,
+                       Int64PtrTy, Int8PtrTy, Int8PtrTy, NumValueSitesTy};
   auto *DataTy = StructType::get(Ctx, makeArrayRef(DataTypes));
   Constant *DataVals[] = {
       ConstantInt::get(Int32Ty, NameArrayTy->getArrayNumElements()),
       ConstantInt::get(Int32Ty, NumCounters),
       ConstantInt::get(Int64Ty, Inc->getHash()->getZExtValue()),
       ConstantExpr::getBitCast(Name, Int8PtrTy),
-      ConstantExpr::getBitCast(Counters, Int64PtrTy)};
+      ConstantExpr::getBitCast(Counters, Int64PtrTy),
+      FunctionAddr,
+      ValuesPtr,
+      ConstantArray::get(NumValueSitesTy, NumValueSites)};
   auto *Data = new GlobalVariable(*M, DataTy, true, Name->getLinkage(),
                                   ConstantStruct::get(DataTy, DataVals),
                                   getVarName(Inc, "data"));
   Data->setVisibility(Name->getVisibility());
   Data->setSection(getDataSection());
   Data->setAlignment(8);
+  PD.DataVar = Data;
 
   // Mark the data variable as used so that it isn't stripped out.
   UsedVars.push_back(Data);
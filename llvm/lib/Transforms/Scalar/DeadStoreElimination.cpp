@@ -23,6 +23,7 @@
 #include "llvm/Analysis/CaptureTracking.h"
 #include "llvm/Analysis/MemoryBuiltins.h"
 #include "llvm/Analysis/MemoryDependenceAnalysis.h"
+#include "llvm/Analysis/MemorySSA.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/Constants.h"
@@ -33,6 +34,7 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/Local.h"
@@ -43,15 +45,28 @@ using namespace llvm;
 STATISTIC(NumFastStores, "Number of stores deleted");
 STATISTIC(NumFastOther , "Number of other instrs removed");
 
+static cl::opt<bool>
+UseMemorySSA("dse-use-memoryssa", cl::init(false), cl::Hidden,
+             cl::desc("Find the stores killed by a later store with memory "
+                      "SSA rather than memory dependence analysis"));
+
+static cl::opt<unsigned>
+MemorySSAScanLimit("dse-memoryssa-scanlimit", cl::init(150), cl::Hidden,
+                   cl::desc("The number of memory writes above a store that "
+                            "-dse-use-memoryssa looks at (default = 150)"));
+
 namespace {
   struct DSE : public FunctionPass {
     AliasAnalysis *AA;
     MemoryDependenceAnalysis *MD;
+    MemorySSA *MSSA;
     DominatorTree *DT;
     const TargetLibraryInfo *TLI;
 
     static char ID; // Pass identification, replacement for typeid
-    DSE() : FunctionPass(ID), AA(nullptr), MD(nullptr), DT(nullptr) {
+    DSE()
+        : FunctionPass(ID), AA(nullptr), MD(nullptr), MSSA(nullptr),
+          DT(nullptr) {
       initializeDSEPass(*PassRegistry::getPassRegistry());
     }
 
@@ -61,6 +76,8 @@ namespace {
 
       AA = &getAnalysis<AliasAnalysis>();
       MD = &getAnalysis<MemoryDependenceAnalysis>();
+      MSSA = UseMemorySSA ? &getAnalysis<MemorySSAWrapperPass>().getMSSA()
+                          : nullptr;
       DT = &getAnalysis<DominatorTreeWrapperPass>().getDomTree();
       TLI = AA->getTargetLibraryInfo();
 
@@ -71,11 +88,22 @@ namespace {
         if (DT->isReachableFromEntry(I))
           Changed |= runOnBasicBlock(*I);
 
-      AA = nullptr; MD = nullptr; DT = nullptr;
+      AA = nullptr; MD = nullptr; MSSA = nullptr; DT = nullptr;
       return Changed;
     }
 
     bool runOnBasicBlock(BasicBlock &BB);
+    LoadInst *getStoredBackLoad(StoreInst *SI, MemDepResult InstDep);
+    bool killEarlierWrite(Instruction *Inst, const AliasAnalysis::Location &Loc,
+                          Instruction *DepWrite,
+                          const AliasAnalysis::Location &DepLoc,
+                          bool &MadeChange);
+    bool isMonotonicAccessOfOtherLocation(Instruction *Inst,
+                                          Instruction *DepWrite,
+                                          const AliasAnalysis::Location &Loc);
+    bool killEarlierWritesWithMemorySSA(Instruction *Inst,
+                                        const AliasAnalysis::Location &Loc,
+                                        bool &MadeChange);
     bool HandleFree(CallInst *F);
     bool handleEndBlock(BasicBlock &BB);
     void RemoveAccessedObjects(const AliasAnalysis::Location &LoadedLoc,
@@ -90,6 +118,10 @@ namespace {
       AU.addPreserved<AliasAnalysis>();
       AU.addPreserved<DominatorTreeWrapperPass>();
       AU.addPreserved<MemoryDependenceAnalysis>();
+      if (UseMemorySSA) {
+        AU.addRequired<MemorySSAWrapperPass>();
+        AU.addPreserved<MemorySSAWrapperPass>();
+      }
     }
   };
 }
@@ -98,6 +130,7 @@ char DSE::ID = 0;
 INITIALIZE_PASS_BEGIN(DSE, "dse", "Dead Store Elimination", false, false)
 INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
 INITIALIZE_PASS_DEPENDENCY(MemoryDependenceAnalysis)
+INITIALIZE_PASS_DEPENDENCY(MemorySSAWrapperPass)
 INITIALIZE_AG_DEPENDENCY(AliasAnalysis)
 INITIALIZE_PASS_END(DSE, "dse", "Dead Store Elimination", false, false)
 
@@ -112,9 +145,11 @@ FunctionPass *llvm::createDeadStoreEliminationPass() { return new DSE(); }
 /// dead, delete them and the computation tree that feeds them.
 ///
 /// If ValueSet is non-null, remove any deleted instructions from it as well.
+/// If MSSA is non-null, the deleted instructions are removed from it too.
 ///
 static void DeleteDeadInstruction(Instruction *I,
                                MemoryDependenceAnalysis &MD,
+                               MemorySSA *MSSA,
                                const TargetLibraryInfo *TLI,
                                SmallSetVector<Value*, 16> *ValueSet = nullptr) {
   SmallVector<Instruction*, 32> NowDeadInsts;
@@ -131,6 +166,9 @@ static void DeleteDeadInstruction(Instruction *I,
     // MemDep, which needs to know the operands and needs it to be in the
     // function.
     MD.removeInstruction(DeadInst);
+    if (MSSA)
+      if (MemoryUseOrDef *MA = MSSA->getMemoryAccess(DeadInst))
+        MSSA->removeMemoryAccess(MA);
 
     for (unsigned op = 0, e = DeadInst->getNumOperands(); op != e; ++op) {
       Value *Op = DeadInst->getOperand(op);
@@ -491,19 +529,21 @@ bool DSE::runOnBasicBlock(BasicBlock &BB) {
     if (!hasMemoryWrite(Inst, TLI))
       continue;
 
-    MemDepResult InstDep = MD->getDependency(Inst);
+    MemDepResult InstDep;
+    if (!MSSA) {
+      InstDep = MD->getDependency(Inst);
 
-    // Ignore any store where we can't find a local dependence.
-    // FIXME: cross-block DSE would be fun. :)
-    if (!InstDep.isDef() && !InstDep.isClobber())
-      continue;
+      // Ignore any store where we can't find a local dependence.
+      // FIXME: cross-block DSE would be fun. :)
+      if (!InstDep.isDef() && !InstDep.isClobber())
+        continue;
+    }
 
     // If we're storing the same value back to a pointer that we just
     // loaded from, then the store can be removed.
     if (StoreInst *SI = dyn_cast<StoreInst>(Inst)) {
-      if (LoadInst *DepLoad = dyn_cast<LoadInst>(InstDep.getInst())) {
-        if (SI->getPointerOperand() == DepLoad->getPointerOperand() &&
-            SI->getOperand(0) == DepLoad && isRemovable(SI)) {
+      if (LoadInst *DepLoad = getStoredBackLoad(SI, InstDep)) {
+        if (isRemovable(SI)) {
           DEBUG(dbgs() << "DSE: Remove Store Of Load from same pointer:\n  "
                        << "LOAD: " << *DepLoad << "\n  STORE: " << *SI << '\n');
 
@@ -511,7 +551,7 @@ bool DSE::runOnBasicBlock(BasicBlock &BB) {
           // in case we need it.
           WeakVH NextInst(BBI);
 
-          DeleteDeadInstruction(SI, *MD, TLI);
+          DeleteDeadInstruction(SI, *MD, MSSA, TLI);
 
           if (!NextInst)  // Next instruction deleted.
             BBI = BB.begin();
@@ -531,6 +571,17 @@ bool DSE::runOnBasicBlock(BasicBlock &BB) {
     if (!Loc.Ptr)
       continue;
 
+    if (MSSA) {
+      if (killEarlierWritesWithMemorySSA(Inst, Loc, MadeChange)) {
+        // DeleteDeadInstruction can delete the current instruction in loop
+        // cases, reset BBI.
+        BBI = Inst;
+        if (BBI != BB.begin())
+          --BBI;
+      }
+      continue;
+    }
+
     while (InstDep.isDef() || InstDep.isClobber()) {
       // Get the memory clobbered by the instruction we depend on.  MemDep will
       // skip any instructions that 'Loc' clearly doesn't interact with.  If we
@@ -545,57 +596,13 @@ bool DSE::runOnBasicBlock(BasicBlock &BB) {
       if (!DepLoc.Ptr)
         break;
 
-      // If we find a write that is a) removable (i.e., non-volatile), b) is
-      // completely obliterated by the store to 'Loc', and c) which we know that
-      // 'Inst' doesn't load from, then we can remove it.
-      if (isRemovable(DepWrite) &&
-          !isPossibleSelfRead(Inst, Loc, DepWrite, *AA)) {
-        int64_t InstWriteOffset, DepWriteOffset;
-        const DataLayout &DL = BB.getModule()->getDataLayout();
-        OverwriteResult OR =
-            isOverwrite(Loc, DepLoc, DL, AA->getTargetLibraryInfo(),
-                        DepWriteOffset, InstWriteOffset);
-        if (OR == OverwriteComplete) {
-          DEBUG(dbgs() << "DSE: Remove Dead Store:\n  DEAD: "
-                << *DepWrite << "\n  KILLER: " << *Inst << '\n');
-
-          // Delete the store and now-dead instructions that feed it.
-          DeleteDeadInstruction(DepWrite, *MD, TLI);
-          ++NumFastStores;
-          MadeChange = true;
-
-          // DeleteDeadInstruction can delete the current instruction in loop
-          // cases, reset BBI.
-          BBI = Inst;
-          if (BBI != BB.begin())
-            --BBI;
-          break;
-        } else if (OR == OverwriteEnd && isShortenable(DepWrite)) {
-          // TODO: base this on the target vector size so that if the earlier
-          // store was too small to get vector writes anyway then its likely
-          // a good idea to shorten it
-          // Power of 2 vector writes are probably always a bad idea to optimize
-          // as any store/memset/memcpy is likely using vector instructions so
-          // shortening it to not vector size is likely to be slower
-          MemIntrinsic* DepIntrinsic = cast<MemIntrinsic>(DepWrite);
-          unsigned DepWriteAlign = DepIntrinsic->getAlignment();
-          if (llvm::isPowerOf2_64(InstWriteOffset) ||
-              ((DepWriteAlign != 0) && InstWriteOffset % DepWriteAlign == 0)) {
-
-            DEBUG(dbgs() << "DSE: Remove Dead Store:\n  OW END: "
-                  << *DepWrite << "\n  KILLER (offset "
-                  << InstWriteOffset << ", "
-                  << DepLoc.Size << ")"
-                  << *Inst << '\n');
-
-            Value* DepWriteLength = DepIntrinsic->getLength();
-            Value* TrimmedLength = ConstantInt::get(DepWriteLength->getType(),
-                                                    InstWriteOffset -
-                                                    DepWriteOffset);
-            DepIntrinsic->setLength(TrimmedLength);
-            MadeChange = true;
-          }
-        }
+      if (killEarlierWrite(Inst, Loc, DepWrite, DepLoc, MadeChange)) {
+        // DeleteDeadInstruction can delete the current instruction in loop
+        // cases, reset BBI.
+        BBI = Inst;
+        if (BBI != BB.begin())
+          --BBI;
+        break;
       }
 
       // If this is a may-aliased store that is clobbering the store value, we
@@ -624,6 +631,167 @@ bool DSE::runOnBasicBlock(BasicBlock &BB) {
   return MadeChange;
 }
 
+/// getStoredBackLoad - If SI stores back the value of a load from the same
+/// pointer, with no write to the pointer in between, return that load.
+/// InstDep is the memory dependence of SI when memory SSA is not used.
+LoadInst *DSE::getStoredBackLoad(StoreInst *SI, MemDepResult InstDep) {
+  if (!MSSA) {
+    LoadInst *DepLoad = dyn_cast<LoadInst>(InstDep.getInst());
+    if (DepLoad && SI->getPointerOperand() == DepLoad->getPointerOperand() &&
+        SI->getOperand(0) == DepLoad)
+      return DepLoad;
+    return nullptr;
+  }
+
+  LoadInst *DepLoad = dyn_cast<LoadInst>(SI->getValueOperand());
+  if (!DepLoad || DepLoad->getPointerOperand() != SI->getPointerOperand() ||
+      (DepLoad->isAtomic() && DepLoad->getOrdering() != Unordered))
+    return nullptr;
+
+  // Nothing writes the pointer in between if the clobber seen from the store
+  // is the one seen from the load, or the load itself when it is volatile.
+  AliasAnalysis::Location Loc = AA->getLocation(SI);
+  MemorySSAWalker *Walker = MSSA->getWalker();
+  MemoryUseOrDef *LoadAccess = MSSA->getMemoryAccess(DepLoad);
+  MemoryAccess *StoreClobber = Walker->getClobberingMemoryAccess(
+      MSSA->getMemoryAccess(SI)->getDefiningAccess(), Loc);
+  if (StoreClobber == LoadAccess)
+    return DepLoad;
+  MemoryAccess *LoadClobber = Walker->getClobberingMemoryAccess(
+      LoadAccess->getDefiningAccess(), Loc);
+  return StoreClobber == LoadClobber ? DepLoad : nullptr;
+}
+
+/// killEarlierWrite - Inst writes Loc and DepWrite, an earlier write of
+/// DepLoc, may be overwritten by it.  Delete DepWrite if it is completely
+/// overwritten, or shorten it if its end is.  Returns true if DepWrite was
+/// deleted.
+bool DSE::killEarlierWrite(Instruction *Inst,
+                           const AliasAnalysis::Location &Loc,
+                           Instruction *DepWrite,
+                           const AliasAnalysis::Location &DepLoc,
+                           bool &MadeChange) {
+  // If we find a write that is a) removable (i.e., non-volatile), b) is
+  // completely obliterated by the store to 'Loc', and c) which we know that
+  // 'Inst' doesn't load from, then we can remove it.
+  if (!isRemovable(DepWrite) || isPossibleSelfRead(Inst, Loc, DepWrite, *AA))
+    return false;
+
+  int64_t InstWriteOffset, DepWriteOffset;
+  const DataLayout &DL = Inst->getModule()->getDataLayout();
+  OverwriteResult OR =
+      isOverwrite(Loc, DepLoc, DL, AA->getTargetLibraryInfo(),
+                  DepWriteOffset, InstWriteOffset);
+  if (OR == OverwriteComplete) {
+    DEBUG(dbgs() << "DSE: Remove Dead Store:\n  DEAD: "
+          << *DepWrite << "\n  KILLER: " << *Inst << '\n');
+
+    // Delete the store and now-dead instructions that feed it.
+    DeleteDeadInstruction(DepWrite, *MD, MSSA, TLI);
+    ++NumFastStores;
+    MadeChange = true;
+    return true;
+  }
+
+  if (OR == OverwriteEnd && isShortenable(DepWrite)) {
+    // TODO: base this on the target vector size so that if the earlier
+    // store was too small to get vector writes anyway then its likely
+    // a good idea to shorten it
+    // Power of 2 vector writes are probably always a bad idea to optimize
+    // as any store/memset/memcpy is likely using vector instructions so
+    // shortening it to not vector size is likely to be slower
+    MemIntrinsic* DepIntrinsic = cast<MemIntrinsic>(DepWrite);
+    unsigned DepWriteAlign = DepIntrinsic->getAlignment();
+    if (llvm::isPowerOf2_64(InstWriteOffset) ||
+        ((DepWriteAlign != 0) && InstWriteOffset % DepWriteAlign == 0)) {
+
+      DEBUG(dbgs() << "DSE: Remove Dead Store:\n  OW END: "
+            << *DepWrite << "\n  KILLER (offset "
+            << InstWriteOffset << ", "
+            << DepLoc.Size << ")"
+            << *Inst << '\n');
+
+      Value* DepWriteLength = DepIntrinsic->getLength();
+      Value* TrimmedLength = ConstantInt::get(DepWriteLength->getType(),
+                                              InstWriteOffset -
+                                              DepWriteOffset);
+      DepIntrinsic->setLength(TrimmedLength);
+      MadeChange = true;
+    }
+  }
+  return false;
+}
+
+/// isMonotonicAccessOfOtherLocation - Memory SSA makes every atomic access a
+/// write.  Like the memory dependence walk, let an unordered store look past
+/// a monotonic load or store that does not alias it.
+bool DSE::isMonotonicAccessOfOtherLocation(Instruction *Inst,
+                                           Instruction *DepWrite,
+                                           const AliasAnalysis::Location &Loc) {
+  StoreInst *SI = dyn_cast<StoreInst>(Inst);
+  if (!SI || !SI->isUnordered())
+    return false;
+
+  AliasAnalysis::Location DepLoc;
+  if (LoadInst *LI = dyn_cast<LoadInst>(DepWrite)) {
+    if (LI->isVolatile() || LI->getOrdering() != Monotonic)
+      return false;
+    DepLoc = AA->getLocation(LI);
+  } else if (StoreInst *DepSI = dyn_cast<StoreInst>(DepWrite)) {
+    if (DepSI->isVolatile() || DepSI->getOrdering() != Monotonic)
+      return false;
+    DepLoc = AA->getLocation(DepSI);
+  } else {
+    return false;
+  }
+  return AA->isNoAlias(DepLoc, Loc);
+}
+
+/// killEarlierWritesWithMemorySSA - The memory SSA version of the memory
+/// dependence walk of runOnBasicBlock: go up the writes of the block above
+/// Inst, which writes Loc, killing those it overwrites, until one of them or a
+/// read in between may read Loc.  Only the memory instructions are looked at.
+/// Returns true if a write was deleted.
+bool DSE::killEarlierWritesWithMemorySSA(Instruction *Inst,
+                                         const AliasAnalysis::Location &Loc,
+                                         bool &MadeChange) {
+  BasicBlock *BB = Inst->getParent();
+  MemoryAccess *Current = MSSA->getMemoryAccess(Inst)->getDefiningAccess();
+  for (unsigned Scanned = 0; Scanned != MemorySSAScanLimit; ++Scanned) {
+    MemoryDef *Def = dyn_cast<MemoryDef>(Current);
+    if (!Def || MSSA->isLiveOnEntryDef(Def) || Def->getBlock() != BB)
+      return false;
+
+    // The reads using Def sit between it and the previously visited write.
+    for (MemoryAccess *User : Def->users())
+      if (MemoryUse *MU = dyn_cast<MemoryUse>(User))
+        if (AA->getModRefInfo(MU->getMemoryInst(), Loc) & AliasAnalysis::Ref)
+          return false;
+
+    Instruction *DepWrite = Def->getMemoryInst();
+    if (isMonotonicAccessOfOtherLocation(Inst, DepWrite, Loc)) {
+      Current = Def->getDefiningAccess();
+      continue;
+    }
+
+    AliasAnalysis::ModRefResult MR = AA->getModRefInfo(DepWrite, Loc);
+    if (MR & AliasAnalysis::Mod) {
+      AliasAnalysis::Location DepLoc = getLocForWrite(DepWrite, *AA);
+      if (!DepLoc.Ptr)
+        return false;
+      if (killEarlierWrite(Inst, Loc, DepWrite, DepLoc, MadeChange))
+        return true;
+    }
+
+    // A may-aliased store can be looked past, as in the memory dependence
+    // walk, but not something that might read 'Loc'.
+    if (MR & AliasAnalysis::Ref)
+      return false;
+    Current = Def->getDefiningAccess();
+  }
+  return false;
+}
+
 /// Find all blocks that will unconditionally lead to the block BB and append
 /// them to F.
 static void FindUnconditionalPreds(SmallVectorImpl<BasicBlock *> &Blocks,
@@ -671,7 +839,7 @@ bool DSE::HandleFree(CallInst *F) {
       Instruction *Next = std::next(BasicBlock::iterator(Dependency));
 
       // DCE instructions only used to calculate that store
-      DeleteDeadInstruction(Dependency, *MD, TLI);
+      DeleteDeadInstruction(Dependency, *MD, MSSA, TLI);
       ++NumFastStores;
       MadeChange = true;
 
@@ -757,7 +925,7 @@ bool DSE::handleEndBlock(BasicBlock &BB) {
               dbgs() << '\n');
 
         // DCE instructions only used to calculate that store.
-        DeleteDeadInstruction(Dead, *MD, TLI, &DeadStackObjects);
+        DeleteDeadInstruction(Dead, *MD, MSSA, TLI, &DeadStackObjects);
         ++NumFastStores;
         MadeChange = true;
         continue;
@@ -767,7 +935,7 @@ bool DSE::handleEndBlock(BasicBlock &BB) {
     // Remove any dead non-memory-mutating instructions.
     if (isInstructionTriviallyDead(BBI, TLI)) {
       Instruction *Inst = BBI++;
-      DeleteDeadInstruction(Inst, *MD, TLI, &DeadStackObjects);
+      DeleteDeadInstruction(Inst, *MD, MSSA, TLI, &DeadStackObjects);
       ++NumFastOther;
       MadeChange = true;
       continue;
@@ -24,6 +24,7 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
 #include "llvm/Analysis/ConstantFolding.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/IR/CallSite.h"
@@ -33,12 +34,15 @@
 #include "llvm/IR/InstVisitor.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/Local.h"
 #include <algorithm>
+#include <map>
 using namespace llvm;
 
 #define DEBUG_TYPE "sccp"
@@ -1554,17 +1558,12 @@ static void DeleteInstructionInBlock(BasicBlock *BB) {
   }
 }
 
-// runOnFunction() - Run the Sparse Conditional Constant Propagation algorithm,
-// and return true if the function was modified.
+// runSCCP() - Run the Sparse Conditional Constant Propagation algorithm on F,
+// with its arguments overdefined, and return true if F was modified.
 //
-bool SCCP::runOnFunction(Function &F) {
-  if (skipOptnoneFunction(F))
-    return false;
-
+static bool runSCCP(Function &F, const DataLayout &DL,
+                    const TargetLibraryInfo *TLI) {
   DEBUG(dbgs() << "SCCP on function '" << F.getName() << "'\n");
-  const DataLayout &DL = F.getParent()->getDataLayout();
-  const TargetLibraryInfo *TLI =
-      &getAnalysis<TargetLibraryInfoWrapperPass>().getTLI();
   SCCPSolver Solver(DL, TLI);
 
   // Mark the first block of the function as being executable.
@@ -1630,6 +1629,19 @@ bool SCCP::runOnFunction(Function &F) {
   return MadeChanges;
 }
 
+// runOnFunction() - Run the Sparse Conditional Constant Propagation algorithm,
+// and return true if the function was modified.
+//
+bool SCCP::runOnFunction(Function &F) {
+  if (skipOptnoneFunction(F))
+    return false;
+
+  const DataLayout &DL = F.getParent()->getDataLayout();
+  const TargetLibraryInfo *TLI =
+      &getAnalysis<TargetLibraryInfoWrapperPass>().getTLI();
+  return runSCCP(F, DL, TLI);
+}
+
 namespace {
   //===--------------------------------------------------------------------===//
   //
@@ -1944,3 +1956,291 @@ bool IPSCCP::runOnModule(Module &M) {
 
   return MadeChanges;
 }
+
+//===----------------------------------------------------------------------===//
+//
+// Function specialization.
+//
+// IPSCCP only propagates an argument into a function when every call site
+// passes the same constant.  The FunctionSpecialization pass instead clones a
+// function for the constants that some hot call sites pass it, propagates
+// them through the clone with SCCP, and calls the clone from those sites.
+//
+
+static cl::opt<unsigned> SpecGrowth(
+    "func-spec-growth", cl::init(10), cl::Hidden,
+    cl::desc("Let function specialization grow the module by at most this "
+             "percentage of its instructions"));
+
+static cl::opt<unsigned> SpecMaxSize(
+    "func-spec-max-size", cl::init(1000), cl::Hidden,
+    cl::desc("Don't specialize functions with more instructions than this"));
+
+static cl::opt<unsigned> SpecMaxClones(
+    "func-spec-max-clones", cl::init(3), cl::Hidden,
+    cl::desc("The maximum number of specializations of a function"));
+
+static cl::opt<unsigned> SpecMinBenefit(
+    "func-spec-min-benefit", cl::init(10), cl::Hidden,
+    cl::desc("The percentage of its instructions that constant propagation "
+             "must remove from a specialization to keep it"));
+
+static cl::opt<uint64_t> SpecMinCount(
+    "func-spec-min-count", cl::init(100), cl::Hidden,
+    cl::desc("Ignore the call sites that the profile says run fewer times "
+             "than this"));
+
+STATISTIC(NumSpecialized, "Number of functions specialized");
+STATISTIC(NumSpecializedCalls, "Number of calls to specialized functions");
+
+namespace {
+  /// SpecCandidate - The call sites that pass the same constants to the same
+  /// function, and the specialization of the function for them.
+  struct SpecCandidate {
+    Function *Callee;
+    // The constant passed for each argument, or null if the argument is not
+    // a constant at every call site.
+    SmallVector<Constant *, 4> Args;
+    SmallVector<Instruction *, 4> Calls;
+    // How often the calls run: their profile count, or their frequency
+    // relative to the entry of their callers when there is no profile.
+    double Count;
+    bool HasProfile;
+
+    Function *Clone;
+    unsigned Size;
+    double Priority;
+
+    SpecCandidate(Function *Callee)
+        : Callee(Callee), Count(0), HasProfile(false), Clone(nullptr),
+          Size(0), Priority(0) {}
+  };
+
+  //===--------------------------------------------------------------------===//
+  //
+  /// FunctionSpecialization Class - This class clones functions for the
+  /// constant arguments of their hot call sites, and runs SCCP on the clones.
+  ///
+  struct FunctionSpecialization : public ModulePass {
+    void getAnalysisUsage(AnalysisUsage &AU) const override {
+      AU.addRequired<BlockFrequencyInfo>();
+      AU.addRequired<TargetLibraryInfoWrapperPass>();
+    }
+    static char ID;
+    FunctionSpecialization() : ModulePass(ID) {
+      initializeFunctionSpecializationPass(*PassRegistry::getPassRegistry());
+    }
+    bool runOnModule(Module &M) override;
+
+  private:
+    const DataLayout *DL;
+    const TargetLibraryInfo *TLI;
+    std::vector<SpecCandidate> Candidates;
+    std::map<std::pair<Function *, std::vector<Constant *>>, unsigned> Index;
+
+    void collectCandidates(Function &F);
+    void specialize(SpecCandidate &C);
+  };
+} // end anonymous namespace
+
+char FunctionSpecialization::ID = 0;
+INITIALIZE_PASS_BEGIN(FunctionSpecialization, "function-specialization",
+                "Specialize functions for constant arguments", false, false)
+INITIALIZE_PASS_DEPENDENCY(BlockFrequencyInfo)
+INITIALIZE_PASS_DEPENDENCY(TargetLibraryInfoWrapperPass)
+INITIALIZE_PASS_END(FunctionSpecialization, "function-specialization",
+                "Specialize functions for constant arguments", false, false)
+
+// createFunctionSpecializationPass - This is the public interface to this file.
+ModulePass *llvm::createFunctionSpecializationPass() {
+  return new FunctionSpecialization();
+}
+
+static unsigned getInstructionCount(const Function &F) {
+  unsigned Count = 0;
+  for (const BasicBlock &BB : F)
+    Count += BB.size();
+  return Count;
+}
+
+/// isSpecializable - Return true if the calls to F may call a copy of F
+/// instead.
+static bool isSpecializable(const Function &F) {
+  return !F.isDeclaration() && !F.mayBeOverridden() && !F.isVarArg() &&
+         !F.hasFnAttribute(Attribute::OptimizeNone) &&
+         getInstructionCount(F) <= SpecMaxSize;
+}
+
+/// getSpecializationConstant - Return the constant that CS passes for A, if
+/// propagating it into the callee is worthwhile.
+static Constant *getSpecializationConstant(CallSite CS, Argument &A) {
+  if (A.use_empty() || A.hasByValOrInAllocaAttr())
+    return nullptr;
+  Constant *C = dyn_cast<Constant>(CS.getArgument(A.getArgNo()));
+  if (!C || isa<UndefValue>(C))
+    return nullptr;
+  return C;
+}
+
+/// collectCandidates - Record the direct calls in F that pass constants to a
+/// function that can be specialized.
+void FunctionSpecialization::collectCandidates(Function &F) {
+  BlockFrequencyInfo *BFI = nullptr;
+  Optional<uint64_t> EntryCount = F.getEntryCount();
+
+  for (BasicBlock &BB : F) {
+    for (Instruction &I : BB) {
+      CallSite CS(&I);
+      if (!CS)
+        continue;
+      Function *Callee = CS.getCalledFunction();
+      if (!Callee || !isSpecializable(*Callee))
+        continue;
+
+      std::vector<Constant *> Args;
+      bool AnyConstant = false;
+      for (Argument &A : Callee->args()) {
+        Args.push_back(getSpecializationConstant(CS, A));
+        AnyConstant |= Args.back() != nullptr;
+      }
+      if (!AnyConstant)
+        continue;
+
+      // Scale the frequency of the call by the entry count of the caller, if
+      // the profile has one.
+      if (!BFI)
+        BFI = &getAnalysis<BlockFrequencyInfo>(F);
+      double Count = (double)BFI->getBlockFreq(&BB).getFrequency() /
+                     BFI->getEntryFreq();
+      if (EntryCount) {
+        Count *= *EntryCount;
+        if (Count < SpecMinCount)
+          continue;
+      }
+
+      auto Key = std::make_pair(Callee, Args);
+      auto It = Index.find(Key);
+      if (It == Index.end()) {
+        It = Index.insert(std::make_pair(Key, Candidates.size())).first;
+        Candidates.push_back(SpecCandidate(Callee));
+        Candidates.back().Args.append(Args.begin(), Args.end());
+      }
+      SpecCandidate &C = Candidates[It->second];
+      C.Calls.push_back(&I);
+      C.Count += Count;
+      C.HasProfile |= EntryCount.hasValue();
+    }
+  }
+}
+
+/// specialize - Clone the callee of C with its constant arguments propagated
+/// through it, and rank the clone by the instructions this removed.
+void FunctionSpecialization::specialize(SpecCandidate &C) {
+  Function *Callee = C.Callee;
+  ValueToValueMapTy VMap;
+  Function *Clone = CloneFunction(Callee, VMap, /*ModuleLevelChanges=*/false);
+  Clone->setLinkage(GlobalValue::InternalLinkage);
+  Clone->setVisibility(GlobalValue::DefaultVisibility);
+  Clone->setDLLStorageClass(GlobalValue::DefaultStorageClass);
+  Clone->setComdat(nullptr);
+  Callee->getParent()->getFunctionList().insertAfter(Callee, Clone);
+  Clone->setName(Callee->getName() + ".specialized");
+
+  for (Argument &A : Clone->args())
+    if (Constant *K = C.Args[A.getArgNo()])
+      A.replaceAllUsesWith(K);
+
+  runSCCP(*Clone, *DL, TLI);
+  for (BasicBlock &BB : *Clone)
+    ConstantFoldTerminator(&BB, /*DeleteDeadConditions=*/true, TLI);
+  removeUnreachableBlocks(*Clone);
+
+  // Recursive calls that pass the same constants can stay in the clone.
+  for (BasicBlock &BB : *Clone)
+    for (Instruction &I : BB) {
+      CallSite CS(&I);
+      if (!CS || CS.getCalledFunction() != Callee)
+        continue;
+      bool Same = true;
+      for (unsigned i = 0, e = C.Args.size(); i != e && Same; ++i)
+        Same = !C.Args[i] || CS.getArgument(i) == C.Args[i];
+      if (Same)
+        CS.setCalledFunction(Clone);
+    }
+
+  unsigned CalleeSize = getInstructionCount(*Callee);
+  C.Clone = Clone;
+  C.Size = getInstructionCount(*Clone);
+  unsigned Benefit = CalleeSize > C.Size ? CalleeSize - C.Size : 0;
+  C.Priority =
+      Benefit * 100 < (uint64_t)SpecMinBenefit * CalleeSize || !Benefit
+          ? 0
+          : Benefit * C.Count;
+}
+
+bool FunctionSpecialization::runOnModule(Module &M) {
+  DL = &M.getDataLayout();
+  TLI = &getAnalysis<TargetLibraryInfoWrapperPass>().getTLI();
+  Candidates.clear();
+  Index.clear();
+
+  uint64_t ModuleSize = 0;
+  for (Function &F : M)
+    if (!F.isDeclaration())
+      ModuleSize += getInstructionCount(F);
+
+  for (Function &F : M)
+    if (!F.isDeclaration() && !F.hasFnAttribute(Attribute::OptimizeNone))
+      collectCandidates(F);
+  if (Candidates.empty())
+    return false;
+
+  for (SpecCandidate &C : Candidates)
+    specialize(C);
+
+  // Keep the most profitable clones that fit in the budget, and delete the
+  // others.
+  std::vector<SpecCandidate *> Order;
+  for (SpecCandidate &C : Candidates)
+    Order.push_back(&C);
+  std::stable_sort(Order.begin(), Order.end(),
+                   [](const SpecCandidate *L, const SpecCandidate *R) {
+    return L->Priority > R->Priority;
+  });
+
+  uint64_t Budget = ModuleSize * SpecGrowth / 100;
+  uint64_t Used = 0;
+  DenseMap<Function *, unsigned> NumClones;
+  bool Changed = false;
+  for (SpecCandidate *C : Order) {
+    unsigned &N = NumClones[C->Callee];
+    if (C->Priority <= 0 || Used + C->Size > Budget || N >= SpecMaxClones) {
+      C->Clone->eraseFromParent();
+      C->Clone = nullptr;
+      continue;
+    }
+    Used += C->Size;
+    ++N;
+    DEBUG(dbgs() << "SPECIALIZE: " << C->Callee->getName() << " as "
+                 << C->Clone->getName() << " for " << C->Calls.size()
+                 << " calls\n");
+    for (Instruction *I : C->Calls)
+      CallSite(I).setCalledFunction(C->Clone);
+    NumSpecializedCalls += C->Calls.size();
+    ++NumSpecialized;
+    Changed = true;
+
+    // Move the count of the calls from the callee to the clone.
+    if (C->HasProfile) {
+      uint64_t Count = C->Count;
+      C->Clone->setEntryCount(Count);
+      if (Optional<uint64_t> CalleeCount = C->Callee->getEntryCount())
+        C->Callee->setEntryCount(*CalleeCount > Count ? *CalleeCount - Count
+                                                      : 0);
+    }
+  }
+
+  Candidates.clear();
+  Index.clear();
+  return Changed;
+}
@@ -45,6 +45,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cctype>
 
 using namespace llvm;
@@ -748,6 +749,16 @@ bool SampleProfileLoader::doInitialization(Module &M) {
   }
   Reader = std::move(ReaderOrErr.get());
   ProfileIsValid = (Reader->read() == sampleprof_error::success);
+
+  // Record the hottest function of the profile, so that the entry counts of
+  // the functions can be compared to it.  Every sampled function is entered
+  // at least once, see runOnFunction.
+  if (ProfileIsValid && !M.getMaximumFunctionCount()) {
+    uint64_t MaxCount = 1;
+    for (const auto &I : Reader->getProfiles())
+      MaxCount = std::max<uint64_t>(MaxCount, I.second.getHeadSamples());
+    M.setMaximumFunctionCount(MaxCount);
+  }
   return true;
 }
 
@@ -768,7 +779,11 @@ bool SampleProfileLoader::runOnFunction(Function &F) {
   LI = &getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
   Ctx = &F.getParent()->getContext();
   Samples = Reader->getSamplesFor(F);
-  if (!Samples->empty())
-    return emitAnnotations(F);
-  return false;
+  if (Samples->empty())
+    return false;
+  // Sampling can miss the entry of a function whose body it saw running; do
+  // not make such a function look like it never runs.
+  F.setEntryCount(std::max(Samples->getHeadSamples(), 1u));
+  emitAnnotations(F);
+  return true;
 }
@@ -0,0 +1,192 @@
+//===- SplitModule.cpp - Split a module into partitions -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the function llvm::SplitModule, which splits a module
+// into multiple linkable partitions. It can be used to implement parallel code
+// generation for link-time optimization.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalObject.h"
+#include "llvm/IR/GlobalValue.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+
+using namespace llvm;
+
+typedef EquivalenceClasses<const GlobalValue *> ClusterMapType;
+typedef DenseMap<const GlobalValue *, unsigned> PartitionMapType;
+
+static void externalize(GlobalValue *GV) {
+  if (GV->hasLocalLinkage()) {
+    GV->setLinkage(GlobalValue::ExternalLinkage);
+    GV->setVisibility(GlobalValue::HiddenVisibility);
+  }
+
+  // Unnamed entities must be named consistently between modules. setName will
+  // give a distinct name to each such entity.
+  if (!GV->hasName())
+    GV->setName("__llvmsplit_unnamed");
+}
+
+/// Returns the string used to choose the partition of GV. Members of a comdat
+/// are keyed on the comdat name so that the group is never split.
+static StringRef getPartitionKey(const GlobalValue *GV) {
+  if (const Comdat *C = GV->getComdat())
+    return C->getName();
+  return GV->getName();
+}
+
+/// Returns the partition (0-based) of N that Key hashes to.
+static unsigned getPartition(StringRef Key, unsigned N) {
+  // Partition by MD5 hash. We only need a few bits for evenness as the number
+  // of partitions will generally be in the 1-2 figure range; the low 16 bits
+  // are enough.
+  MD5 H;
+  MD5::MD5Result R;
+  H.update(Key);
+  H.final(R);
+  return (R[0] | (R[1] << 8)) % N;
+}
+
+/// Puts every global value that uses C (looking through constant expressions)
+/// in the same cluster as GV.
+static void addUsersToCluster(ClusterMapType &Clusters, const GlobalValue *GV,
+                              const Constant *C) {
+  SmallVector<const User *, 8> Worklist(C->user_begin(), C->user_end());
+  SmallPtrSet<const User *, 8> Visited;
+  while (!Worklist.empty()) {
+    const User *U = Worklist.pop_back_val();
+    if (!Visited.insert(U).second)
+      continue;
+    if (auto *I = dyn_cast<Instruction>(U))
+      Clusters.unionSets(GV, I->getParent()->getParent());
+    else if (auto *UGV = dyn_cast<GlobalValue>(U))
+      Clusters.unionSets(GV, UGV);
+    else
+      Worklist.append(U->user_begin(), U->user_end());
+  }
+}
+
+/// Finds the global values that must be placed in the same partition as some
+/// other global value, and records the partition of each of them in
+/// PartitionMap. Global values that are not constrained are left out of the
+/// map and are partitioned by their own key.
+static void findClusterPartitions(const Module &M, unsigned N,
+                                  PartitionMapType &PartitionMap) {
+  ClusterMapType Clusters;
+  DenseMap<const Comdat *, const GlobalValue *> ComdatMembers;
+
+  auto RecordGV = [&](const GlobalValue &GV) {
+    if (GV.isDeclaration())
+      return;
+
+    // Comdat groups must not be partitioned.
+    if (const Comdat *C = GV.getComdat()) {
+      const GlobalValue *&Member = ComdatMembers[C];
+      if (Member)
+        Clusters.unionSets(Member, &GV);
+      else
+        Member = &GV;
+    }
+
+    // Aliases must stay with the object they alias.
+    if (auto *GA = dyn_cast<GlobalAlias>(&GV))
+      if (const GlobalObject *Base = GA->getBaseObject())
+        Clusters.unionSets(&GV, Base);
+
+    // A blockaddress can only be materialized in the module that defines the
+    // function containing the block.
+    if (auto *F = dyn_cast<Function>(&GV))
+      for (const BasicBlock &BB : *F)
+        if (BB.hasAddressTaken())
+          if (const BlockAddress *BA = BlockAddress::lookup(&BB))
+            addUsersToCluster(Clusters, F, BA);
+  };
+
+  for (const Function &F : M)
+    RecordGV(F);
+  for (const GlobalVariable &GV : M.globals())
+    RecordGV(GV);
+  for (const GlobalAlias &GA : M.aliases())
+    RecordGV(GA);
+
+  // Key each cluster on the smallest key of its members so that the choice
+  // does not depend on the order in which the clusters were formed.
+  for (ClusterMapType::iterator I = Clusters.begin(), E = Clusters.end();
+       I != E; ++I) {
+    if (!I->isLeader())
+      continue;
+    StringRef Key = getPartitionKey(I->getData());
+    for (ClusterMapType::member_iterator MI = Clusters.member_begin(I),
+                                         ME = Clusters.member_end();
+         MI != ME; ++MI)
+      Key = std::min(Key, getPartitionKey(*MI));
+    unsigned Partition = getPartition(Key, N);
+    for (ClusterMapType::member_iterator MI = Clusters.member_begin(I),
+                                         ME = Clusters.member_end();
+         MI != ME; ++MI)
+      PartitionMap[*MI] = Partition;
+  }
+}
+
+// Returns whether GV should be in partition (0-based) I of N.
+static bool isInPartition(const GlobalValue *GV, unsigned I, unsigned N,
+                          const PartitionMapType &PartitionMap) {
+  // Declarations are the same in every partition.
+  if (GV->isDeclaration())
+    return true;
+
+  // The used lists only attach attributes to their members, so every
+  // partition gets a copy in order to mark the members it defines.
+  if (GV->hasAppendingLinkage() &&
+      (GV->getName() == "llvm.used" || GV->getName() == "llvm.compiler.used"))
+    return true;
+
+  PartitionMapType::const_iterator It = PartitionMap.find(GV);
+  if (It != PartitionMap.end())
+    return It->second == I;
+  return getPartition(getPartitionKey(GV), N) == I;
+}
+
+void llvm::SplitModule(
+    Module &M, unsigned N,
+    std::function<void(std::unique_ptr<Module> MPart)> ModuleCallback) {
+  for (Function &F : M)
+    externalize(&F);
+  for (GlobalVariable &GV : M.globals())
+    externalize(&GV);
+  for (GlobalAlias &GA : M.aliases())
+    externalize(&GA);
+
+  PartitionMapType PartitionMap;
+  findClusterPartitions(M, N, PartitionMap);
+
+  // FIXME: We should be able to reuse M as the last partition instead of
+  // cloning it.
+  for (unsigned I = 0; I != N; ++I) {
+    ValueToValueMapTy VMap;
+    std::unique_ptr<Module> MPart(
+        CloneModule(&M, VMap, [&](const GlobalValue *GV) {
+          return isInPartition(GV, I, N, PartitionMap);
+        }));
+    if (I != 0)
+      MPart->setModuleInlineAsm("");
+    ModuleCallback(std::move(MPart));
+  }
+}
@@ -0,0 +1,60 @@
+; RUN: opt -basicaa -memoryssa -analyze -verify-memoryssa < %s | FileCheck %s
+;
+; Every memory instruction gets an access linked to the last write above it,
+; whether or not they alias.
+
+declare void @clobber(i32*)
+declare i32 @pure(i32*) readonly
+declare i32 @const(i32) readnone
+
+define i32 @straight(i32* %p, i32* %q) {
+; CHECK-LABEL: Printing analysis 'Memory SSA' for function 'straight':
+; CHECK: 1 = MemoryDef(liveOnEntry)
+; CHECK-NEXT: store i32 1, i32* %p
+  store i32 1, i32* %p
+; CHECK: MemoryUse(1)
+; CHECK-NEXT: %a = load i32, i32* %q
+  %a = load i32, i32* %q
+; CHECK: 2 = MemoryDef(1)
+; CHECK-NEXT: store i32 2, i32* %q
+  store i32 2, i32* %q
+; CHECK: MemoryUse(2)
+; CHECK-NEXT: %b = load i32, i32* %p
+  %b = load i32, i32* %p
+  %c = add i32 %a, %b
+  ret i32 %c
+}
+
+define i32 @calls(i32* %p) {
+; CHECK-LABEL: Printing analysis 'Memory SSA' for function 'calls':
+; CHECK: 1 = MemoryDef(liveOnEntry)
+; CHECK-NEXT: call void @clobber(i32* %p)
+  call void @clobber(i32* %p)
+; CHECK: MemoryUse(1)
+; CHECK-NEXT: %a = call i32 @pure(i32* %p)
+  %a = call i32 @pure(i32* %p)
+; CHECK-NOT: Memory
+; CHECK: %b = call i32 @const(i32 %a)
+  %b = call i32 @const(i32 %a)
+  ret i32 %b
+}
+
+; Ordered loads and fences keep their place among the writes.
+define i32 @ordered(i32* %p) {
+; CHECK-LABEL: Printing analysis 'Memory SSA' for function 'ordered':
+; CHECK: 1 = MemoryDef(liveOnEntry)
+; CHECK-NEXT: %a = load volatile i32, i32* %p
+  %a = load volatile i32, i32* %p
+; CHECK: 2 = MemoryDef(1)
+; CHECK-NEXT: fence seq_cst
+  fence seq_cst
+; CHECK: 3 = MemoryDef(2)
+; CHECK-NEXT: %b = load atomic i32, i32* %p acquire
+  %b = load atomic i32, i32* %p acquire, align 4
+; CHECK: MemoryUse(3)
+; CHECK-NEXT: %c = load i32, i32* %p
+  %c = load i32, i32* %p
+  %d = add i32 %a, %b
+  %e = add i32 %d, %c
+  ret i32 %e
+}
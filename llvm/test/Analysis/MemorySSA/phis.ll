@@ -0,0 +1,83 @@
+; RUN: opt -basicaa -memoryssa -analyze -verify-memoryssa < %s | FileCheck %s
+;
+; MemoryPhis are placed where the writes of different paths meet.
+
+define i32 @diamond(i1 %c, i32* %p, i32* %q) {
+; CHECK-LABEL: Printing analysis 'Memory SSA' for function 'diamond':
+entry:
+  br i1 %c, label %left, label %right
+
+left:
+; CHECK: 1 = MemoryDef(liveOnEntry)
+; CHECK-NEXT: store i32 1, i32* %p
+  store i32 1, i32* %p
+  br label %merge
+
+right:
+; CHECK: MemoryUse(liveOnEntry)
+; CHECK-NEXT: %a = load i32, i32* %q
+  %a = load i32, i32* %q
+  br label %merge
+
+merge:
+; CHECK: merge:
+; CHECK-NEXT: ; 2 = MemoryPhi({left,1},{right,liveOnEntry})
+; CHECK: MemoryUse(2)
+; CHECK-NEXT: %b = load i32, i32* %p
+  %b = load i32, i32* %p
+  ret i32 %b
+}
+
+; A block with no write of its own on either side needs no MemoryPhi.
+define i32 @nophi(i1 %c, i32* %p) {
+; CHECK-LABEL: Printing analysis 'Memory SSA' for function 'nophi':
+entry:
+; CHECK: 1 = MemoryDef(liveOnEntry)
+  store i32 0, i32* %p
+  br i1 %c, label %left, label %merge
+
+left:
+  %a = add i32 1, 2
+  br label %merge
+
+merge:
+; CHECK: merge:
+; CHECK-NOT: MemoryPhi
+; CHECK: MemoryUse(1)
+; CHECK-NEXT: %b = load i32, i32* %p
+  %b = load i32, i32* %p
+  ret i32 %b
+}
+
+define void @loop(i32* %p, i32 %n) {
+; CHECK-LABEL: Printing analysis 'Memory SSA' for function 'loop':
+entry:
+; CHECK: 1 = MemoryDef(liveOnEntry)
+  store i32 0, i32* %p
+  br label %header
+
+header:
+; CHECK: header:
+; CHECK-NEXT: ; 3 = MemoryPhi({entry,1},{body,2})
+  %i = phi i32 [ 0, %entry ], [ %i.next, %body ]
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %body, label %exit
+
+body:
+; CHECK: MemoryUse(3)
+; CHECK-NEXT: %v = load i32, i32* %p
+  %v = load i32, i32* %p
+  %v.next = add i32 %v, %i
+; CHECK: 2 = MemoryDef(3)
+; CHECK-NEXT: store i32 %v.next, i32* %p
+  store i32 %v.next, i32* %p
+  %i.next = add i32 %i, 1
+  br label %header
+
+exit:
+; CHECK: exit:
+; CHECK: MemoryUse(3)
+; CHECK-NEXT: %r = load i32, i32* %p
+  %r = load i32, i32* %p
+  ret void
+}
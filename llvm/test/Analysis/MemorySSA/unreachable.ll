@@ -0,0 +1,33 @@
+; RUN: opt -basicaa -memoryssa -analyze -verify-memoryssa < %s | FileCheck %s
+;
+; The accesses of unreachable blocks, and the MemoryPhi edges coming from
+; them, see liveOnEntry.
+
+define i32 @f(i1 %c, i32* %p) {
+; CHECK-LABEL: Printing analysis 'Memory SSA' for function 'f':
+entry:
+  br i1 %c, label %write, label %merge
+
+write:
+; CHECK: 1 = MemoryDef(liveOnEntry)
+; CHECK-NEXT: store i32 1, i32* %p
+  store i32 1, i32* %p
+  br label %merge
+
+dead:
+; CHECK: dead:
+; CHECK: 2 = MemoryDef(liveOnEntry)
+; CHECK-NEXT: store i32 2, i32* %p
+  store i32 2, i32* %p
+; CHECK: MemoryUse(liveOnEntry)
+; CHECK-NEXT: %x = load i32, i32* %p
+  %x = load i32, i32* %p
+  br label %merge
+
+merge:
+; CHECK: merge:
+; CHECK-NEXT: ; 3 = MemoryPhi({entry,liveOnEntry},{write,1},{dead,liveOnEntry})
+; CHECK: MemoryUse(3)
+  %r = load i32, i32* %p
+  ret i32 %r
+}
@@ -0,0 +1,44 @@
+; RUN: opt < %s -analyze -scalar-evolution | FileCheck %s
+; RUN: opt < %s -analyze -scalar-evolution \
+; RUN:   -scalar-evolution-max-backedge-taken-cost=0 \
+; RUN:   | FileCheck %s --check-prefix=BUDGET
+
+; The trip counts of a loop nest are only computed within the budget; once
+; it runs out, the loop's count is unpredictable.
+
+; CHECK-LABEL: Determining loop execution counts for: @nest
+; CHECK: Loop %inner: backedge-taken count is (-1 + %m)
+; CHECK: Loop %outer: backedge-taken count is (-1 + %n)
+
+; BUDGET-LABEL: Determining loop execution counts for: @nest
+; BUDGET: Loop %inner: Unpredictable backedge-taken count.
+; BUDGET: Loop %inner: Unpredictable max backedge-taken count.
+; BUDGET: Loop %outer: Unpredictable backedge-taken count.
+; BUDGET: Loop %outer: Unpredictable max backedge-taken count.
+
+define void @nest(i32* %p, i32 %n, i32 %m) {
+entry:
+  %guard.outer = icmp sgt i32 %n, 0
+  br i1 %guard.outer, label %outer, label %exit
+
+outer:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %outer.latch ]
+  %guard.inner = icmp sgt i32 %m, 0
+  br i1 %guard.inner, label %inner, label %outer.latch
+
+inner:
+  %j = phi i32 [ 0, %outer ], [ %j.next, %inner ]
+  %sum = add i32 %i, %j
+  store volatile i32 %sum, i32* %p
+  %j.next = add nsw i32 %j, 1
+  %inner.cond = icmp slt i32 %j.next, %m
+  br i1 %inner.cond, label %inner, label %outer.latch
+
+outer.latch:
+  %i.next = add nsw i32 %i, 1
+  %outer.cond = icmp slt i32 %i.next, %n
+  br i1 %outer.cond, label %outer, label %exit
+
+exit:
+  ret void
+}
@@ -0,0 +1,45 @@
+; RUN: llvm-as -bitcode-mdindex-threshold=0 < %s -o %t.bc
+; RUN: llvm-bcanalyzer -dump %t.bc | FileCheck --check-prefix=INDEX %s
+; RUN: llvm-as < %s | llvm-bcanalyzer -dump | \
+; RUN:   FileCheck --check-prefix=NOINDEX %s
+
+; The index of the metadata records is only written for large enough blocks.
+; INDEX: <METADATA_BLOCK
+; INDEX: <METADATA_INDEX_OFFSET
+; INDEX: <METADATA_INDEX
+; INDEX: </METADATA_BLOCK>
+; NOINDEX-NOT: METADATA_INDEX
+
+; llvm-link loads the module lazily, and with it the metadata records, which
+; must round-trip, cycles included.
+; RUN: llvm-link -S %t.bc | FileCheck %s
+; RUN: llvm-dis < %t.bc | FileCheck %s
+
+; CHECK: call void @g(), !foo [[NODE:![0-9]+]]
+; CHECK: ret void, !bar [[DISTINCT:![0-9]+]]
+; CHECK: ret void, !baz [[USER:![0-9]+]]
+; CHECK: !named = !{[[INT:![0-9]+]], [[LEAF:![0-9]+]]}
+; CHECK-DAG: [[INT]] = !{i32 1}
+; CHECK-DAG: [[LEAF]] = !{!"leaf"}
+; CHECK-DAG: [[NODE]] = !{[[CYCLE:![0-9]+]], !"node"}
+; CHECK-DAG: [[CYCLE]] = !{[[NODE]]}
+; CHECK-DAG: [[DISTINCT]] = distinct !{[[DISTINCT]], [[INT]]}
+; CHECK-DAG: [[USER]] = !{[[LEAF]], [[CYCLE]]}
+
+define void @f() {
+  call void @g(), !foo !0
+  ret void, !bar !2
+}
+
+define void @g() {
+  ret void, !baz !4
+}
+
+!named = !{!3, !5}
+
+!0 = !{!1, !"node"}
+!1 = !{!0}
+!2 = distinct !{!2, !3}
+!3 = !{i32 1}
+!4 = !{!5, !1}
+!5 = !{!"leaf"}
@@ -0,0 +1,12 @@
+; RUN: llvm-as -symbol-table < %s | llvm-bcanalyzer -dump | FileCheck %s
+
+; No symbol table is written for modules with module asm, as their symbols
+; can only be found by parsing the asm.
+; CHECK-NOT: SYMTAB_BLOCK
+
+module asm ".globl foo"
+module asm "foo:"
+
+define void @f() {
+  ret void
+}
@@ -0,0 +1,46 @@
+; RUN: llvm-as -symbol-table < %s | llvm-bcanalyzer -dump | FileCheck %s
+; RUN: llvm-as -symbol-table < %s | llvm-dis | FileCheck -check-prefix=DIS %s
+; RUN: llvm-as < %s | llvm-bcanalyzer -dump | FileCheck -check-prefix=NOSYMTAB %s
+
+; The symbol table is the first block of the module.
+; CHECK: <MODULE_BLOCK
+; CHECK-NEXT: <VERSION
+; CHECK-NEXT: <SYMTAB_BLOCK
+; CHECK-NEXT: <TRIPLE
+; CHECK-NEXT: <DATALAYOUT
+; CHECK-NEXT: <SYMBOL {{.*}} op0=2 op1=0 op2=0 op3=0 op4=0 op5=0 op6=95 op7=102/>
+; CHECK-NEXT: <SYMBOL {{.*}} op0=3 op1=0 op2=0 op3=0 op4=0 op5=0 op6=95 op7=103/>
+; CHECK-NEXT: <SYMBOL {{.*}} op0=0 op1=0 op2=0 op3=3 op4=0 op5=0 op6=95 op7=118/>
+; CHECK-NEXT: <SYMBOL {{.*}} op0=0 op1=8 op2=0 op3=4 op4=0 op5=8 op6=95 op7=99/>
+; CHECK-NEXT: <SYMBOL {{.*}} op0=0 op1=9 op2=0 op3=0 op4=0 op5=0 op6=76 op7=95 op8=112/>
+; CHECK-NEXT: <COMDAT op0=1 op1=107/>
+; CHECK-NEXT: <SYMBOL {{.*}} op0=12 op1=19 op2=2 op3=0 op4=1 op5=0 op6=95 op7=107/>
+; CHECK-NEXT: <SYMBOL {{.*}} op0=16 op1=16 op2=1 op3=3 op4=0 op5=0 op6=95 op7=97/>
+; CHECK-NEXT: <LINKER_OPTION op0=45 op1=108 op2=122/>
+; CHECK-NEXT: </SYMTAB_BLOCK>
+
+; The module itself is unchanged.
+; DIS: @k = linkonce_odr protected unnamed_addr constant i32 1, comdat
+
+; NOSYMTAB-NOT: SYMTAB_BLOCK
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.10.0"
+
+$k = comdat any
+
+@v = global i32 0, align 4
+@c = common global i64 0, align 8
+@p = private global i32 0
+@k = linkonce_odr protected unnamed_addr constant i32 1, comdat
+@a = weak hidden alias i32* @v
+
+define void @f() {
+  call void @g()
+  ret void
+}
+
+declare void @g()
+
+!llvm.module.flags = !{!0}
+!0 = !{i32 6, !"Linker Options", !{!{!"-lz"}}}
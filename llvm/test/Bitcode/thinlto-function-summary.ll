@@ -0,0 +1,34 @@
+; RUN: llvm-as -function-summary < %s | llvm-bcanalyzer -dump | FileCheck %s -check-prefix=BC
+; RUN: llvm-as < %s | llvm-bcanalyzer -dump | FileCheck %s -check-prefix=NOSUMMARY
+; Check that the summary does not get in the way of reading the module.
+; RUN: llvm-as -function-summary < %s | llvm-dis | FileCheck %s
+
+; The summary block comes after the function blocks, and has an entry for each
+; function definition, followed by its calls and references.
+; BC: <FUNCTION_BLOCK
+; BC: </FUNCTION_BLOCK>
+; BC: <FUNCTION_SUMMARY_BLOCK
+; "foo": linkage external (0), 2 instructions, calls "bar", references "g".
+; BC-NEXT: <PERMODULE_ENTRY {{.*}} op0=0 op1=2 op2=102 op3=111 op4=111/>
+; BC-NEXT: <CALL {{.*}} op0=98 op1=97 op2=114/>
+; BC-NEXT: <REF {{.*}} op0=103/>
+; "bar": linkage internal (3), 1 instruction.
+; BC-NEXT: <PERMODULE_ENTRY {{.*}} op0=3 op1=1 op2=98 op3=97 op4=114/>
+; BC-NEXT: </FUNCTION_SUMMARY_BLOCK>
+
+; NOSUMMARY-NOT: FUNCTION_SUMMARY_BLOCK
+
+@g = global i32 0
+
+; CHECK: define i32 @foo()
+define i32 @foo() {
+  %v = call i32 @bar(i32* @g)
+  ret i32 %v
+}
+
+; CHECK: define internal i32 @bar(i32* %p)
+define internal i32 @bar(i32* %p) {
+  ret i32 0
+}
+
+declare void @decl()
@@ -0,0 +1,99 @@
+; RUN: llc < %s -mtriple=x86_64-linux -codegen-threads=1 > %t.1.s
+; RUN: llc < %s -mtriple=x86_64-linux -codegen-threads=4 > %t.4.s
+; RUN: diff %t.1.s %t.4.s
+; RUN: llc < %s -mtriple=x86_64-linux -codegen-threads=1 -codegen-batch-size=3 > %t.1b.s
+; RUN: llc < %s -mtriple=x86_64-linux -codegen-threads=4 -codegen-batch-size=3 > %t.4b.s
+; RUN: diff %t.1b.s %t.4b.s
+; RUN: FileCheck %s < %t.4.s
+; RUN: llc < %s -mtriple=x86_64-linux -codegen-threads=1 -filetype=obj -o %t.1.o
+; RUN: llc < %s -mtriple=x86_64-linux -codegen-threads=3 -filetype=obj -o %t.3.o
+; RUN: cmp %t.1.o %t.3.o
+
+; The functions are emitted in order whatever the number of threads.
+; CHECK-LABEL: first:
+; CHECK: .cfi_startproc
+; CHECK-LABEL: switch:
+; CHECK: jmpq *.LJTI1_0
+; CHECK-LABEL: protected:
+; CHECK: movq %fs:40
+; CHECK-LABEL: invoker:
+; CHECK: .Ltmp{{[0-9]+}}:
+; CHECK-LABEL: loop:
+; CHECK-LABEL: last:
+
+define i32 @first(i32 %a, i32 %b) {
+  %c = mul i32 %a, %b
+  %d = add i32 %c, %a
+  ret i32 %d
+}
+
+define i32 @switch(i32 %x) {
+entry:
+  switch i32 %x, label %def [
+    i32 0, label %a
+    i32 1, label %b
+    i32 2, label %c
+    i32 3, label %d
+    i32 4, label %e
+  ]
+a:
+  ret i32 10
+b:
+  ret i32 7
+c:
+  ret i32 3
+d:
+  ret i32 42
+e:
+  ret i32 1
+def:
+  ret i32 0
+}
+
+declare void @use(i8*)
+
+define void @protected() sspreq {
+  %buf = alloca [64 x i8]
+  %p = getelementptr [64 x i8], [64 x i8]* %buf, i32 0, i32 0
+  call void @use(i8* %p)
+  ret void
+}
+
+declare i32 @__gxx_personality_v0(...)
+declare void @may_throw()
+declare void @cleanup()
+
+define void @invoker() {
+entry:
+  invoke void @may_throw()
+          to label %cont unwind label %lpad
+cont:
+  ret void
+lpad:
+  %lp = landingpad { i8*, i32 } personality i8* bitcast (i32 (...)* @__gxx_personality_v0 to i8*)
+          cleanup
+  call void @cleanup()
+  resume { i8*, i32 } %lp
+}
+
+define double @loop(double* %p, i32 %n) {
+entry:
+  br label %body
+body:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %body ]
+  %s = phi double [ 0.0, %entry ], [ %s.next, %body ]
+  %q = getelementptr double, double* %p, i32 %i
+  %v = load double, double* %q
+  %s.next = fadd double %s, %v
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %body
+exit:
+  ret double %s.next
+}
+
+define <4 x i32> @last(<4 x i32> %a, <4 x i32> %b) {
+  %c = add <4 x i32> %a, %b
+  %d = xor <4 x i32> %c, <i32 -1, i32 -1, i32 -1, i32 -1>
+  ret <4 x i32> %d
+}
@@ -0,0 +1,55 @@
+; RUN: llc -mtriple=x86_64-pc-linux-gnu < %s | FileCheck %s
+; RUN: llc -mtriple=x86_64-pc-linux-gnu -function-sections < %s | FileCheck %s --check-prefix=SECTIONS
+; RUN: llc -mtriple=x86_64-pc-linux-gnu -profile-guided-section-prefix=false < %s | FileCheck %s --check-prefix=OFF
+
+; Functions entered at least 1% as often as the hottest function of the profile
+; go to .text.hot.  Functions that never ran or are marked cold go to
+; .text.unlikely.  The rest stay in .text.
+
+; CHECK:      .section .text.hot,"ax",@progbits
+; CHECK-NEXT: .globl hot
+; CHECK:      .text
+; CHECK-NEXT: .globl warm
+; CHECK:      .section .text.unlikely,"ax",@progbits
+; CHECK-NEXT: .globl never_run
+; CHECK-NOT:  .text
+; CHECK:      .globl cold
+; CHECK:      .text
+; CHECK-NEXT: .globl no_profile
+
+; SECTIONS: .section .text.hot.hot,"ax",@progbits
+; SECTIONS: .section .text.warm,"ax",@progbits
+; SECTIONS: .section .text.unlikely.never_run,"ax",@progbits
+; SECTIONS: .section .text.unlikely.cold,"ax",@progbits
+; SECTIONS: .section .text.no_profile,"ax",@progbits
+
+; OFF-NOT: .text.hot
+; OFF-NOT: .text.unlikely
+
+define void @hot() #0 {
+  ret void
+}
+
+define void @warm() #1 {
+  ret void
+}
+
+define void @never_run() #2 {
+  ret void
+}
+
+define void @cold() #3 {
+  ret void
+}
+
+define void @no_profile() {
+  ret void
+}
+
+attributes #0 = { "function-entry-count"="1000" }
+attributes #1 = { "function-entry-count"="9" }
+attributes #2 = { "function-entry-count"="0" }
+attributes #3 = { cold }
+
+!llvm.module.flags = !{!0}
+!0 = !{i32 2, !"MaxFunctionCount", i64 1000}
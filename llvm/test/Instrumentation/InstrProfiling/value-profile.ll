@@ -0,0 +1,48 @@
+; RUN: opt < %s -instrprof -S | FileCheck %s
+
+target triple = "x86_64-unknown-linux-gnu"
+
+@__llvm_profile_name_foo = hidden constant [3 x i8] c"foo"
+@__llvm_profile_name_bar = hidden constant [3 x i8] c"bar"
+
+; The value sites of all kinds are numbered together by the runtime, and the
+; data records the address of the function and its sites.
+; CHECK: @__llvm_profile_values_foo = hidden global [3 x i8*] zeroinitializer, align 8
+; CHECK: @__llvm_profile_data_foo = hidden constant { i32, i32, i64, i8*, i64*, i8*, i8*, [2 x i16] } { i32 3, i32 1, i64 0, i8* getelementptr inbounds ([3 x i8], [3 x i8]* @__llvm_profile_name_foo, i32 0, i32 0), i64* getelementptr inbounds ([1 x i64], [1 x i64]* @__llvm_profile_counters_foo, i32 0, i32 0), i8* bitcast (void (void ()*, i64)* @foo to i8*), i8* bitcast ([3 x i8*]* @__llvm_profile_values_foo to i8*), [2 x i16] [i16 2, i16 1] }, section "__llvm_prf_data", align 8
+; Without value sites, there is no array of values.
+; CHECK: @__llvm_profile_data_bar = hidden constant { i32, i32, i64, i8*, i64*, i8*, i8*, [2 x i16] } { i32 3, i32 1, i64 0, i8* getelementptr inbounds ([3 x i8], [3 x i8]* @__llvm_profile_name_bar, i32 0, i32 0), i64* getelementptr inbounds ([1 x i64], [1 x i64]* @__llvm_profile_counters_bar, i32 0, i32 0), i8* bitcast (void ()* @bar to i8*), i8* null, [2 x i16] zeroinitializer }, section "__llvm_prf_data", align 8
+
+define void @foo(void ()* %f, i64 %size) {
+  call void @llvm.instrprof.increment(i8* getelementptr inbounds ([3 x i8], [3 x i8]* @__llvm_profile_name_foo, i32 0, i32 0), i64 0, i32 1, i32 0)
+  %addr = ptrtoint void ()* %f to i64
+; CHECK: call void @__llvm_profile_instrument_target(i64 %addr, i8* bitcast ({{.*}}* @__llvm_profile_data_foo to i8*), i32 1)
+  call void @llvm.instrprof.value.profile(i8* getelementptr inbounds ([3 x i8], [3 x i8]* @__llvm_profile_name_foo, i32 0, i32 0), i64 0, i64 %addr, i32 0, i32 1)
+  call void %f()
+; CHECK: call void @__llvm_profile_instrument_target(i64 %addr, i8* bitcast ({{.*}}* @__llvm_profile_data_foo to i8*), i32 0)
+  call void @llvm.instrprof.value.profile(i8* getelementptr inbounds ([3 x i8], [3 x i8]* @__llvm_profile_name_foo, i32 0, i32 0), i64 0, i64 %addr, i32 0, i32 0)
+  call void %f()
+; The memop size site comes after the two indirect call sites.
+; CHECK: call void @__llvm_profile_instrument_target(i64 %size, i8* bitcast ({{.*}}* @__llvm_profile_data_foo to i8*), i32 2)
+  call void @llvm.instrprof.value.profile(i8* getelementptr inbounds ([3 x i8], [3 x i8]* @__llvm_profile_name_foo, i32 0, i32 0), i64 0, i64 %size, i32 1, i32 0)
+  ret void
+}
+
+define void @bar() {
+  call void @llvm.instrprof.increment(i8* getelementptr inbounds ([3 x i8], [3 x i8]* @__llvm_profile_name_bar, i32 0, i32 0), i64 0, i32 1, i32 0)
+  ret void
+}
+
+; Value sites of functions without counters are dropped.
+; CHECK-LABEL: define void @baz(
+; CHECK-NOT: call
+; CHECK: ret void
+@__llvm_profile_name_baz = hidden constant [3 x i8] c"baz"
+define void @baz(i64 %v) {
+  call void @llvm.instrprof.value.profile(i8* getelementptr inbounds ([3 x i8], [3 x i8]* @__llvm_profile_name_baz, i32 0, i32 0), i64 0, i64 %v, i32 0, i32 0)
+  ret void
+}
+
+declare void @llvm.instrprof.increment(i8*, i64, i32, i32)
+declare void @llvm.instrprof.value.profile(i8*, i64, i64, i32, i32)
+
+; CHECK: declare void @__llvm_profile_instrument_target(i64, i8*, i32)
@@ -0,0 +1,47 @@
+; RUN: llvm-as -o %t.bc %s
+; RUN: rm -rf %t.cache
+
+; The cache directory is created if needed. The first link populates the cache
+; with one entry, the second one reuses it.
+; RUN: llvm-lto -cache-dir %t.cache -exported-symbol=foo -o %t.o %t.bc
+; RUN: ls %t.cache | count 2
+; RUN: llvm-lto -cache-dir %t.cache -exported-symbol=foo -o %t2.o %t.bc
+; RUN: ls %t.cache | count 2
+; RUN: cmp %t.o %t2.o
+
+; A hit doesn't compile the module again.
+; RUN: for f in %t.cache/*.o; do echo cached > $f; done
+; RUN: llvm-lto -cache-dir %t.cache -exported-symbol=foo -o %t3.o %t.bc
+; RUN: FileCheck --check-prefix=HIT %s < %t3.o
+; HIT: cached
+
+; The options are part of the key.
+; RUN: llvm-lto -cache-dir %t.cache -exported-symbol=foo -O1 -o %t4.o %t.bc
+; RUN: ls %t.cache | count 3
+; RUN: llvm-lto -cache-dir %t.cache -exported-symbol=foo -exported-symbol=bar \
+; RUN:   -o %t5.o %t.bc
+; RUN: ls %t.cache | count 4
+; RUN: llvm-lto -cache-dir %t.cache -exported-symbol=foo -j2 %t.bc
+; RUN: ls %t.cache | count 6
+
+; Entries unused for longer than the expiration are pruned.
+; RUN: touch -t 200001010000 %t.cache/*.o
+; RUN: llvm-lto -cache-dir %t.cache -cache-pruning-interval=0 \
+; RUN:   -exported-symbol=foo -O3 -o %t6.o %t.bc
+; RUN: ls %t.cache | count 2
+
+; Entries are pruned, least recently used first, down to the maximum size.
+; RUN: llvm-lto -cache-dir %t.cache -cache-pruning-interval=0 \
+; RUN:   -cache-max-size=1 -exported-symbol=foo -o %t7.o %t.bc
+; RUN: ls %t.cache | count 1
+
+target triple = "x86_64-unknown-linux-gnu"
+
+define void @foo() {
+  call void @bar()
+  ret void
+}
+
+define void @bar() {
+  ret void
+}
@@ -0,0 +1,36 @@
+; RUN: llvm-as -symbol-table -o %t.bc %s
+; RUN: llvm-lto -list-symbols-only %t.bc | FileCheck %s
+
+; The names in the symbol table of a module without a data layout are not
+; mangled for the target, so the module is read instead.
+; RUN: sed -e '/datalayout/d' %s | llvm-as -symbol-table -o %t2.bc
+; RUN: llvm-lto -list-symbols-only %t2.bc | FileCheck %s
+
+; Symbols are listed from the symbol table. Private symbols and llvm.used are
+; not listed.
+; CHECK: .bc:
+; CHECK-NEXT: _foo
+; CHECK-NEXT: _bar
+; CHECK-NEXT: _glob
+; CHECK-NEXT: _alias
+; CHECK-NEXT: _ext
+; CHECK-NOT: {{.}}
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.10.0"
+
+@glob = global i32 0
+@priv = private global i32 1
+@llvm.used = appending global [1 x i8*] [i8* bitcast (void ()* @foo to i8*)], section "llvm.metadata"
+@alias = alias i32* @glob
+
+define void @foo() {
+  call void @ext()
+  ret void
+}
+
+define linkonce_odr void @bar() {
+  ret void
+}
+
+declare void @ext()
@@ -0,0 +1,18 @@
+%struct.S = type { i32, i8* }
+
+@s1 = global %struct.S zeroinitializer
+@llvm.global_ctors = appending global [1 x { i32, void ()*, i8* }] [{ i32, void ()*, i8* } { i32 65535, void ()* @ctor1, i8* null }]
+
+define internal void @ctor1() {
+  ret void
+}
+
+define linkonce i32 @pick() {
+  ret i32 1
+}
+
+define weak i32 @strong() {
+  ret i32 1
+}
+
+@c = common global i32 0
@@ -0,0 +1,15 @@
+%struct.S = type { i32, i8* }
+
+@s2 = global %struct.S zeroinitializer
+@llvm.global_ctors = appending global [1 x { i32, void ()*, i8* }] [{ i32, void ()*, i8* } { i32 65535, void ()* @ctor2, i8* null }]
+
+define internal void @ctor2() {
+  ret void
+}
+
+define i32 @use2(%struct.S* %s) {
+  %v = call i32 @pick()
+  ret i32 %v
+}
+
+declare i32 @pick()
@@ -0,0 +1,18 @@
+%struct.S = type { i32, i8* }
+
+@s3 = global %struct.S zeroinitializer
+@llvm.global_ctors = appending global [1 x { i32, void ()*, i8* }] [{ i32, void ()*, i8* } { i32 65535, void ()* @ctor3, i8* null }]
+
+define internal void @ctor3() {
+  ret void
+}
+
+define linkonce i32 @pick() {
+  ret i32 3
+}
+
+define i32 @strong() {
+  ret i32 3
+}
+
+@c = common global i64 0
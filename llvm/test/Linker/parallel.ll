@@ -0,0 +1,45 @@
+; Linking the inputs on several threads gives the same result as a serial link.
+; RUN: llvm-link -S %s %p/Inputs/parallel-1.ll %p/Inputs/parallel-2.ll \
+; RUN:   %p/Inputs/parallel-3.ll -o - | FileCheck %s
+; RUN: llvm-link -S -j 2 %s %p/Inputs/parallel-1.ll %p/Inputs/parallel-2.ll \
+; RUN:   %p/Inputs/parallel-3.ll -o - | FileCheck %s
+; RUN: llvm-link -S -j 3 %s %p/Inputs/parallel-1.ll %p/Inputs/parallel-2.ll \
+; RUN:   %p/Inputs/parallel-3.ll -o - | FileCheck %s
+; RUN: llvm-link -S -j 8 %s %p/Inputs/parallel-1.ll %p/Inputs/parallel-2.ll \
+; RUN:   %p/Inputs/parallel-3.ll -o - | FileCheck %s
+
+; The isomorphic struct types of all the inputs are merged.
+; CHECK: %struct.S = type { i32, i8* }
+; CHECK-NOT: %struct.S.
+
+; The constructors are kept in input order.
+; CHECK: @llvm.global_ctors = appending global [4 x { i32, void ()*, i8* }] [{ i32, void ()*, i8* } { i32 65535, void ()* @ctor0, i8* null }, { i32, void ()*, i8* } { i32 65535, void ()* @ctor1, i8* null }, { i32, void ()*, i8* } { i32 65535, void ()* @ctor2, i8* null }, { i32, void ()*, i8* } { i32 65535, void ()* @ctor3, i8* null }]
+
+; The first definition of a linkonce function is kept, a strong definition
+; replaces a weak one and the largest common is kept.
+; CHECK: @c = common global i64 0
+
+; CHECK: define i32 @main()
+; CHECK: define linkonce i32 @pick()
+; CHECK-NEXT: ret i32 1
+; CHECK: define i32 @strong()
+; CHECK-NEXT: ret i32 3
+
+%struct.S = type { i32, i8* }
+
+@s0 = global %struct.S zeroinitializer
+@llvm.global_ctors = appending global [1 x { i32, void ()*, i8* }] [{ i32, void ()*, i8* } { i32 65535, void ()* @ctor0, i8* null }]
+
+define internal void @ctor0() {
+  ret void
+}
+
+define i32 @main() {
+  %a = call i32 @pick()
+  %b = call i32 @strong()
+  %c = add i32 %a, %b
+  ret i32 %c
+}
+
+declare i32 @pick()
+declare i32 @strong()
@@ -0,0 +1,67 @@
+; RUN: llvm-as -symbol-table %s -o %t.bc
+; RUN: llvm-nm %t.bc | FileCheck %s
+; RUN: llvm-as %s -o %t2.bc
+; RUN: llvm-nm %t2.bc | FileCheck %s
+; RUN: rm -f %t.a
+; RUN: llvm-ar rcs %t.a %t.bc
+; RUN: llvm-nm -M %t.a | FileCheck --check-prefix=ARMAP %s
+
+; The symbols read from the symbol table are the same as the ones read from
+; the module.
+; CHECK:      D a1
+; CHECK-NEXT: T a2
+; CHECK-NEXT: D c1
+; CHECK-NEXT: T f1
+; CHECK-NEXT: W f2
+; CHECK-NEXT: U f3
+; CHECK-NEXT: D g1
+; CHECK-NEXT: D g2
+; CHECK-NEXT: C g3
+; CHECK-NEXT: d g4
+; CHECK-NEXT: W g6
+; CHECK-NEXT: W g7
+; CHECK-NEXT: U g8
+; CHECK-NEXT: U g9
+; CHECK-NOT: g5
+
+; ARMAP:      Archive map
+; ARMAP-NEXT: f1 in
+; ARMAP-NEXT: f2 in
+; ARMAP-NEXT: g1 in
+; ARMAP-NEXT: g2 in
+; ARMAP-NEXT: g3 in
+; ARMAP-NEXT: g6 in
+; ARMAP-NEXT: g7 in
+; ARMAP-NEXT: c1 in
+; ARMAP-NEXT: a1 in
+; ARMAP-NEXT: a2 in
+; ARMAP-NOT: {{ in }}
+
+target triple = "x86_64-unknown-linux-gnu"
+
+$c1 = comdat any
+
+@g1 = global i32 1, align 8
+@g2 = constant i32 2
+@g3 = common global i32 0, align 4
+@g4 = internal global i32 4
+@g5 = private global i32 5
+@g6 = linkonce_odr unnamed_addr constant i32 6
+@g7 = weak hidden global i32 7
+@g8 = external global i32
+@g9 = extern_weak global i32
+@llvm.used = appending global [1 x i8*] [i8* bitcast (i32* @g4 to i8*)], section "llvm.metadata"
+@c1 = global i32 0, comdat
+
+@a1 = alias i32* @g1
+@a2 = alias void ()* @f1
+
+define void @f1() {
+  ret void
+}
+
+define linkonce_odr protected void @f2() {
+  ret void
+}
+
+declare void @f3()
@@ -0,0 +1,45 @@
+; RUN: opt -ir-memory-usage -disable-output < %s 2>&1 | FileCheck %s
+; RUN: opt -ir-memory-usage -discard-value-names -disable-output < %s 2>&1 \
+; RUN:   | FileCheck --check-prefix=DISCARD %s
+; RUN: opt -discard-value-names -S < %s | FileCheck --check-prefix=IR %s
+
+; CHECK: ... IR Memory Usage ...
+; CHECK: Count Bytes Kind
+; CHECK-NEXT: 1 {{[0-9]+}} Global variables
+; CHECK-NEXT: 0 0 Global aliases
+; CHECK-NEXT: 2 {{[0-9]+}} Functions
+; CHECK-NEXT: 2 {{[0-9]+}} Arguments
+; CHECK-NEXT: 2 {{[0-9]+}} Basic blocks
+; CHECK-NEXT: 5 {{[0-9]+}} Instructions
+; CHECK-NEXT: 7 {{[0-9]+}} Operands
+; CHECK-NEXT: 10 {{[0-9]+}} Value names
+; CHECK-NEXT: 1 {{[0-9]+}} Metadata attachments
+; CHECK-NEXT: {{[0-9]+}} Total
+; CHECK-NEXT: {{[0-9.]+}} Bytes per instruction
+
+; Only the names of the global values are left.
+; DISCARD: 3 {{[0-9]+}} Value names
+
+; IR: define i32 @f(i32, i32) {
+; IR-NEXT: %3 = load i32, i32* @g, !tbaa
+; IR-NEXT: %4 = add i32 %0, %1
+; IR-NEXT: br label %5
+; IR: ; <label>:5
+; IR-NEXT: %6 = add i32 %4, %3
+
+@g = global i32 0
+
+define i32 @f(i32 %a, i32 %b) {
+entry:
+  %v = load i32, i32* @g, !tbaa !0
+  %sum = add i32 %a, %b
+  br label %exit
+
+exit:
+  %r = add i32 %sum, %v
+  ret i32 %r
+}
+
+declare void @h()
+
+!0 = !{!"int"}
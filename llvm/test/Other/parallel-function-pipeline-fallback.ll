@@ -0,0 +1,25 @@
+; A block address doesn't survive the split into partitions, so the parallel
+; adaptor runs the pipeline on the module itself.
+;
+; RUN: opt -S -passes='parallel-function(instcombine)' \
+; RUN:     -parallel-function-threads=4 %s | FileCheck %s
+
+; CHECK: @targets = global [2 x i8*] [i8* blockaddress(@f, %a), i8* blockaddress(@f, %b)]
+@targets = global [2 x i8*] [i8* blockaddress(@f, %a), i8* blockaddress(@f, %b)]
+
+; CHECK-LABEL: define i32 @f(i8* %dest)
+; CHECK: indirectbr i8* %dest, [label %a, label %b]
+define i32 @f(i8* %dest) {
+  indirectbr i8* %dest, [label %a, label %b]
+a:
+  ret i32 0
+b:
+  ret i32 1
+}
+
+; CHECK-LABEL: define i32 @g(i32 %x)
+; CHECK-NEXT: %y = shl i32 %x, 1
+define i32 @g(i32 %x) {
+  %y = mul i32 %x, 2
+  ret i32 %y
+}
@@ -0,0 +1,96 @@
+; The parallel adaptor must produce the same functions as the serial one, with
+; the linkage, visibility, names and order of every global left alone. An alias
+; that lives in another partition can only be seen as a declaration.
+;
+; RUN: opt -S -passes='function(instcombine,simplify-cfg)' %s \
+; RUN:     | FileCheck %s
+; RUN: opt -S -passes='parallel-function(instcombine,simplify-cfg)' \
+; RUN:     -parallel-function-threads=1 %s | FileCheck %s
+; RUN: opt -S -passes='parallel-function(instcombine,simplify-cfg)' \
+; RUN:     -parallel-function-threads=4 %s | FileCheck %s
+; RUN: opt -S -passes='parallel-function(instcombine,simplify-cfg)' \
+; RUN:     -parallel-function-threads=64 %s | FileCheck %s
+; RUN: not opt -disable-output -passes='parallel-function(instcombine,bogus)' \
+; RUN:     %s 2>&1 | FileCheck %s --check-prefix=CHECK-BAD
+; CHECK-BAD: unable to parse pass pipeline description
+
+$c = comdat any
+
+; CHECK: @llvm.global_ctors = appending global
+; CHECK-SAME: @ctor
+; CHECK: @g = internal global i32 0
+; CHECK: @h = hidden global i32 1, comdat($c)
+; CHECK: @0 = private unnamed_addr constant [3 x i8] c"hi\00"
+; CHECK: @a = alias i32 (i32)* @internal_fn
+@llvm.global_ctors = appending global [1 x { i32, void ()*, i8* }] [{ i32, void ()*, i8* } { i32 65535, void ()* @ctor, i8* null }]
+@g = internal global i32 0
+@h = hidden global i32 1, comdat($c)
+@0 = private unnamed_addr constant [3 x i8] c"hi\00"
+@a = alias i32 (i32)* @internal_fn
+
+declare i32 @puts(i8*)
+
+; CHECK-LABEL: define internal void @ctor()
+; CHECK-NEXT: store i32 42, i32* @g
+; CHECK-NEXT: ret void
+define internal void @ctor() {
+  %x = add i32 40, 2
+  store i32 %x, i32* @g
+  ret void
+}
+
+; CHECK-LABEL: define internal i32 @internal_fn(i32 %x)
+; CHECK-NEXT: %y = shl i32 %x, 1
+; CHECK-NEXT: ret i32 %y
+define internal i32 @internal_fn(i32 %x) {
+  %y = mul i32 %x, 2
+  ret i32 %y
+}
+
+; CHECK-LABEL: define hidden i32 @comdat_fn(i1 %c) comdat($c)
+; CHECK-NEXT: entry:
+; CHECK-NEXT: %[[R:.*]] = select i1 %c, i32 1, i32 2
+; CHECK-NEXT: ret i32 %[[R]]
+define hidden i32 @comdat_fn(i1 %c) comdat($c) {
+entry:
+  br i1 %c, label %t, label %f
+t:
+  br label %m
+f:
+  br label %m
+m:
+  %r = phi i32 [ 1, %t ], [ 2, %f ]
+  ret i32 %r
+}
+
+; CHECK-LABEL: define private i32 @1()
+; CHECK-NEXT: %x = load i32, i32* @h
+; CHECK-NEXT: ret i32 %x
+define private i32 @1() {
+  %x = load i32, i32* @h
+  %y = add i32 %x, 0
+  ret i32 %y
+}
+
+; CHECK-LABEL: define linkonce_odr i32 @odr_fn(i32 %x)
+; CHECK-NEXT: %y = call i32 @internal_fn(i32 %x)
+; CHECK-NEXT: ret i32 %y
+define linkonce_odr i32 @odr_fn(i32 %x) {
+  %y = call i32 @internal_fn(i32 %x)
+  %z = or i32 %y, 0
+  ret i32 %z
+}
+
+; CHECK-LABEL: define i32 @main()
+; CHECK-NEXT: %p = call i32 @puts(i8* getelementptr inbounds ([3 x i8], [3 x i8]* @0, i64 0, i64 0))
+; CHECK-NEXT: %q = call i32 @1()
+; CHECK-NEXT: %r = call i32 @{{a|internal_fn}}(i32 %q)
+; CHECK-NEXT: %s = call i32 @odr_fn(i32 %r)
+; CHECK-NEXT: ret i32 %s
+define i32 @main() {
+  %p = call i32 @puts(i8* getelementptr ([3 x i8], [3 x i8]* @0, i64 0, i64 0))
+  %q = call i32 @1()
+  %r = call i32 @a(i32 %q)
+  %s = call i32 @odr_fn(i32 %r)
+  ret i32 %s
+}
@@ -0,0 +1,46 @@
+; RUN: opt -pass-trace=%t.csv -pass-trace-format=csv -inline -instcombine \
+; RUN:   -licm -disable-output %s
+; RUN: FileCheck --check-prefix=CSV %s < %t.csv
+; RUN: opt -pass-trace=%t.json -inline -instcombine -licm -disable-output %s
+; RUN: FileCheck --check-prefix=JSON %s < %t.json
+
+; Each pass run on each function (or SCC, or module) gets its own entry, which
+; is written when the pass finishes.
+
+; CSV: pass,unit,depth,thread,start_us,wall_us,user_us,system_us,heap_delta,heap_peak
+; CSV-NEXT: CallGraph Construction,{{.*}}pass-trace.ll,0,1,{{[0-9]+}},{{[0-9]+}},{{[0-9]+}},{{[0-9]+}},{{-?[0-9]+}},{{[0-9]+}}
+; CSV: Function Integration/Inlining,g,0,1,
+; CSV: Combine redundant instructions,g,0,1,
+; CSV: Function Integration/Inlining,"a,""b",0,1,
+; CSV: Combine redundant instructions,"a,""b",0,1,
+; CSV: Loop Invariant Code Motion,"a,""b",0,1,
+
+; JSON: [
+; JSON-NEXT: {"name":"CallGraph Construction","cat":"pass","ph":"X","pid":1,"tid":1,"ts":{{[0-9]+}},"dur":{{[0-9]+}},"args":{"unit":"{{.*}}pass-trace.ll","depth":0,"user_us":{{[0-9]+}},"system_us":{{[0-9]+}},"heap_delta":{{-?[0-9]+}},"heap_peak":{{[0-9]+}}}},
+; JSON: {"name":"Function Integration/Inlining",{{.*}}"args":{"unit":"g",
+; JSON: {"name":"Loop Invariant Code Motion",{{.*}}"args":{"unit":"a,\"b",
+; JSON: "heap_peak":{{[0-9]+}}}}{{$}}
+; JSON-NEXT: {{^]$}}
+
+define internal i32 @g(i32 %x) {
+  %a = add i32 %x, 0
+  ret i32 %a
+}
+
+define i32 @"a,\22b"(i32 %n, i32 %y) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %inv = mul i32 %y, %y
+  %c = call i32 @g(i32 %inv)
+  %s.next = add i32 %s, %c
+  %i.next = add i32 %i, 1
+  %cmp = icmp slt i32 %i.next, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret i32 %s.next
+}
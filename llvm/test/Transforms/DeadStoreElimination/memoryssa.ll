@@ -0,0 +1,104 @@
+; RUN: opt < %s -basicaa -dse -dse-use-memoryssa -verify-memoryssa -S | FileCheck %s
+;
+; Dead store elimination on top of memory SSA.
+
+declare void @use(i32*)
+declare i32 @pure(i32*) readonly
+
+; Stores to other locations in between are skipped over.
+define void @skip(i32* noalias %p, i32* noalias %q) {
+; CHECK-LABEL: @skip(
+; CHECK-NEXT: store i32 2, i32* %q
+; CHECK-NEXT: store i32 3, i32* %p
+; CHECK-NEXT: ret void
+  store i32 1, i32* %p
+  store i32 2, i32* %q
+  store i32 3, i32* %p
+  ret void
+}
+
+; A read of the location in between keeps the earlier store alive.
+define i32 @read(i32* %p) {
+; CHECK-LABEL: @read(
+; CHECK-NEXT: store i32 1, i32* %p
+; CHECK-NEXT: %a = call i32 @pure(i32* %p)
+; CHECK-NEXT: store i32 2, i32* %p
+  store i32 1, i32* %p
+  %a = call i32 @pure(i32* %p)
+  store i32 2, i32* %p
+  ret i32 %a
+}
+
+; ...but a read of another location does not.
+define i32 @read_other(i32* noalias %p, i32* noalias %q) {
+; CHECK-LABEL: @read_other(
+; CHECK-NEXT: %a = load i32, i32* %q
+; CHECK-NEXT: store i32 2, i32* %p
+  store i32 1, i32* %p
+  %a = load i32, i32* %q
+  store i32 2, i32* %p
+  ret i32 %a
+}
+
+; Chains of dead stores go one after the other, with memory SSA kept up to
+; date by the deletions.
+define void @chain(i32* %p) {
+; CHECK-LABEL: @chain(
+; CHECK-NEXT: store i32 4, i32* %p
+; CHECK-NEXT: ret void
+  store i32 1, i32* %p
+  store i32 2, i32* %p
+  store i32 3, i32* %p
+  store i32 4, i32* %p
+  ret void
+}
+
+; Storing back a loaded value is dead, even across blocks, when nothing
+; writes the location in between.
+define void @store_back(i1 %c, i32* noalias %p, i32* noalias %q) {
+; CHECK-LABEL: @store_back(
+; CHECK: next:
+; CHECK-NEXT: store i32 0, i32* %q
+; CHECK-NEXT: ret void
+entry:
+  %v = load i32, i32* %p
+  br i1 %c, label %side, label %next
+
+side:
+  store i32 1, i32* %q
+  br label %next
+
+next:
+  store i32 %v, i32* %p
+  store i32 0, i32* %q
+  ret void
+}
+
+define void @store_back_clobbered(i1 %c, i32* %p, i32* %q) {
+; CHECK-LABEL: @store_back_clobbered(
+; CHECK: next:
+; CHECK-NEXT: store i32 %v, i32* %p
+entry:
+  %v = load i32, i32* %p
+  br i1 %c, label %side, label %next
+
+side:
+  store i32 1, i32* %q
+  br label %next
+
+next:
+  store i32 %v, i32* %p
+  ret void
+}
+
+; An escaping call in between reads everything.
+define void @call(i32* %p) {
+; CHECK-LABEL: @call(
+; CHECK-NEXT: store i32 1, i32* %p
+; CHECK-NEXT: call void @use(i32* %p)
+; CHECK-NEXT: store i32 2, i32* %p
+  store i32 1, i32* %p
+  call void @use(i32* %p)
+  store i32 2, i32* %p
+  ret void
+}
@@ -0,0 +1,41 @@
+@global = global i32 0
+@staticvar = internal global i32 1
+
+define i32 @callee() {
+entry:
+  %v = call i32 @callee2()
+  ret i32 %v
+}
+
+define i32 @callee2() {
+entry:
+  %v = load i32, i32* @global
+  ret i32 %v
+}
+
+define linkonce_odr i32 @linkonceodrfunc() {
+entry:
+  ret i32 1
+}
+
+define weak i32 @weakfunc() {
+entry:
+  ret i32 2
+}
+
+define i32 @referencestatic() {
+entry:
+  %v = load i32, i32* @staticvar
+  ret i32 %v
+}
+
+define i32 @bigfunc(i32 %a) {
+entry:
+  %b = add i32 %a, 1
+  %c = mul i32 %b, %a
+  %d = sub i32 %c, %b
+  %e = xor i32 %d, %c
+  %f = and i32 %e, %d
+  %g = or i32 %f, %e
+  ret i32 %g
+}
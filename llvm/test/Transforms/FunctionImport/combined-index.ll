@@ -0,0 +1,22 @@
+; RUN: llvm-as -function-summary %s -o %t.bc
+; RUN: llvm-as -function-summary %p/Inputs/funcimport.ll -o %t2.bc
+; RUN: llvm-lto -thinlto -o %t3 %t.bc %t2.bc
+; RUN: llvm-bcanalyzer -dump %t3.thinlto.bc | FileCheck %s
+
+; The combined index lists every module, then the summaries of all of their
+; functions, each followed by its calls and references.
+; CHECK: <MODULE_STRTAB_BLOCK
+; CHECK-NEXT: <ENTRY {{.*}}op0=0 op1=
+; CHECK-NEXT: <ENTRY {{.*}}op0=1 op1=
+; CHECK-NEXT: </MODULE_STRTAB_BLOCK>
+; CHECK: <FUNCTION_SUMMARY_BLOCK
+; CHECK: <COMBINED_ENTRY
+; CHECK: </FUNCTION_SUMMARY_BLOCK>
+
+define i32 @main() {
+entry:
+  %a = call i32 @callee()
+  ret i32 %a
+}
+
+declare i32 @callee()
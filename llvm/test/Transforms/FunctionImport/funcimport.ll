@@ -0,0 +1,43 @@
+; Do setup work for all below tests: generate bitcode and combined index
+; RUN: llvm-as -function-summary %s -o %t.bc
+; RUN: llvm-as -function-summary %p/Inputs/funcimport.ll -o %t2.bc
+; RUN: llvm-lto -thinlto -o %t3 %t.bc %t2.bc
+
+; Test import with a small instruction limit, which excludes @bigfunc.
+; RUN: opt -function-import -summary-file %t3.thinlto.bc -import-instr-limit=5 %t.bc -S | FileCheck %s --check-prefix=INSTLIM5
+; INSTLIM5-NOT: define available_externally i32 @bigfunc(
+
+; RUN: opt -function-import -summary-file %t3.thinlto.bc %t.bc -S | FileCheck %s
+
+define i32 @main() {
+entry:
+  %a = call i32 @callee()
+  %b = call i32 @linkonceodrfunc()
+  %c = call i32 @weakfunc()
+  %d = call i32 @referencestatic()
+  %e = call i32 @bigfunc(i32 %a)
+  ret i32 %e
+}
+
+; Functions are imported as available_externally, together with the functions
+; they call.
+; CHECK-DAG: define available_externally i32 @callee()
+; CHECK-DAG: define available_externally i32 @callee2()
+; CHECK-DAG: define available_externally i32 @linkonceodrfunc()
+; CHECK-DAG: define available_externally i32 @bigfunc(i32 %a)
+
+; The variables they reference are declared, not defined.
+; CHECK-DAG: @global = external global i32
+
+; A weak function may be replaced at link time, so it is not imported.
+; CHECK-DAG: declare i32 @weakfunc()
+
+; A function referencing a local of its module can't be imported.
+; CHECK-DAG: declare i32 @referencestatic()
+; CHECK-NOT: @staticvar
+
+declare i32 @callee()
+declare i32 @linkonceodrfunc()
+declare i32 @weakfunc()
+declare i32 @referencestatic()
+declare i32 @bigfunc(i32)
@@ -0,0 +1,74 @@
+; RUN: opt -function-specialization -func-spec-growth=100 -S < %s | FileCheck %s
+
+; @compute is called with a constant flag from one call site and with an
+; unknown one from the other.  The first call gets a copy of @compute for
+; the constant, with the branch on the flag folded away.
+
+@sink = global i32 0
+
+define i32 @compute(i32 %x, i1 %flag) {
+entry:
+  br i1 %flag, label %fast, label %slow
+
+fast:
+  %f = add i32 %x, 1
+  br label %exit
+
+slow:
+  %s0 = mul i32 %x, %x
+  %s1 = mul i32 %s0, %x
+  %s2 = sdiv i32 %s1, 7
+  %s3 = srem i32 %s2, 13
+  %s4 = xor i32 %s3, %x
+  store volatile i32 %s4, i32* @sink
+  br label %exit
+
+exit:
+  %r = phi i32 [ %f, %fast ], [ %s4, %slow ]
+  ret i32 %r
+}
+
+; CHECK-LABEL: define i32 @hot(i32 %x)
+; CHECK: call i32 @compute.specialized(i32 %x, i1 true)
+define i32 @hot(i32 %x) {
+  %r = call i32 @compute(i32 %x, i1 true)
+  ret i32 %r
+}
+
+; CHECK-LABEL: define i32 @unknown(i32 %x, i1 %flag)
+; CHECK: call i32 @compute(i32 %x, i1 %flag)
+define i32 @unknown(i32 %x, i1 %flag) {
+  %r = call i32 @compute(i32 %x, i1 %flag)
+  ret i32 %r
+}
+
+; A weak function may be replaced at link time, so it is not copied.
+; CHECK-LABEL: define i32 @weak_caller(i32 %x)
+; CHECK: call i32 @weak_compute(i32 %x, i1 true)
+define i32 @weak_caller(i32 %x) {
+  %r = call i32 @weak_compute(i32 %x, i1 true)
+  ret i32 %r
+}
+
+define weak i32 @weak_compute(i32 %x, i1 %flag) {
+entry:
+  br i1 %flag, label %fast, label %slow
+
+fast:
+  %f = add i32 %x, 1
+  ret i32 %f
+
+slow:
+  %s0 = mul i32 %x, %x
+  %s1 = mul i32 %s0, %x
+  %s2 = sdiv i32 %s1, 7
+  store volatile i32 %s2, i32* @sink
+  ret i32 %s2
+}
+
+; CHECK-LABEL: define internal i32 @compute.specialized(i32 %x, i1 %flag)
+; CHECK-NEXT: entry:
+; CHECK-NEXT: %f = add i32 %x, 1
+; CHECK-NEXT: ret i32 %f
+; CHECK-NEXT: }
+; CHECK-NOT: define {{.*}}@weak_compute.specialized
@@ -0,0 +1,64 @@
+; RUN: opt -function-specialization -func-spec-growth=100 -S < %s | FileCheck %s
+; RUN: opt -function-specialization -func-spec-growth=0 -S < %s \
+; RUN:     | FileCheck %s --check-prefix=NOBUDGET
+; RUN: opt -function-specialization -func-spec-growth=100 \
+; RUN:     -func-spec-max-clones=1 -S < %s \
+; RUN:     | FileCheck %s --check-prefix=ONECLONE
+
+; Two constants are worth a clone each, unless the budget or the limit on
+; clones per function says otherwise.  The hotter call site, in the loop,
+; gets the only clone.
+
+define i32 @op(i32 %x, i32 %kind) {
+entry:
+  %is.add = icmp eq i32 %kind, 0
+  br i1 %is.add, label %add, label %notadd
+
+add:
+  %a = add i32 %x, 7
+  ret i32 %a
+
+notadd:
+  %is.mul = icmp eq i32 %kind, 1
+  br i1 %is.mul, label %mul, label %div
+
+mul:
+  %m = mul i32 %x, 7
+  ret i32 %m
+
+div:
+  %d = sdiv i32 %x, %kind
+  ret i32 %d
+}
+
+define i32 @caller(i32 %x, i32 %n) {
+entry:
+  %first = call i32 @op(i32 %x, i32 0)
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %acc = phi i32 [ %first, %entry ], [ %v, %loop ]
+  %v = call i32 @op(i32 %acc, i32 1)
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 %v
+}
+
+; CHECK: call i32 @op.specialized{{[0-9]*}}(i32 %x, i32 0)
+; CHECK: call i32 @op.specialized{{[0-9]*}}(i32 %acc, i32 1)
+; CHECK: define internal i32 @op.specialized
+; CHECK: define internal i32 @op.specialized
+
+; NOBUDGET-NOT: specialized
+
+; ONECLONE: call i32 @op(i32 %x, i32 0)
+; ONECLONE: call i32 @op.specialized{{[0-9]*}}(i32 %acc, i32 1)
+; ONECLONE: define internal i32 @op.specialized
+; ONECLONE-NEXT: entry:
+; ONECLONE-NEXT: %m = mul i32 %x, 7
+; ONECLONE-NEXT: ret i32 %m
+; ONECLONE-NOT: define internal i32 @op.specialized
@@ -0,0 +1,48 @@
+; RUN: opt -function-specialization -func-spec-growth=100 -S < %s | FileCheck %s
+; RUN: opt -function-specialization -func-spec-growth=100 \
+; RUN:     -func-spec-min-count=10 -S < %s \
+; RUN:     | FileCheck %s --check-prefix=LOWCOUNT
+
+; Only the call sites that the profile says are hot get a specialization, and
+; the clone takes their count from the original function.
+
+define i32 @step(i32 %x, i32 %mode) "function-entry-count"="10005" {
+entry:
+  switch i32 %mode, label %other [
+    i32 0, label %zero
+    i32 1, label %one
+  ]
+
+zero:
+  ret i32 %x
+
+one:
+  %a = shl i32 %x, 1
+  ret i32 %a
+
+other:
+  %b0 = mul i32 %x, %mode
+  %b1 = add i32 %b0, %mode
+  %b2 = sdiv i32 %b1, 3
+  %b3 = xor i32 %b2, %x
+  ret i32 %b3
+}
+
+; CHECK-LABEL: define i32 @hot_caller(i32 %x)
+; CHECK: call i32 @step.specialized(i32 %x, i32 1)
+define i32 @hot_caller(i32 %x) "function-entry-count"="10000" {
+  %r = call i32 @step(i32 %x, i32 1)
+  ret i32 %r
+}
+
+; CHECK-LABEL: define i32 @cold_caller(i32 %x)
+; CHECK: call i32 @step(i32 %x, i32 0)
+; LOWCOUNT-LABEL: define i32 @cold_caller(i32 %x)
+; LOWCOUNT: call i32 @step.specialized1(i32 %x, i32 0)
+define i32 @cold_caller(i32 %x) "function-entry-count"="5" {
+  %r = call i32 @step(i32 %x, i32 0)
+  ret i32 %r
+}
+
+; CHECK: attributes #{{[0-9]+}} = { "function-entry-count"="5" }
+; CHECK: attributes #{{[0-9]+}} = { "function-entry-count"="10000" }
@@ -0,0 +1,31 @@
+; RUN: opt -S -hotcoldsplit < %s | FileCheck %s
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.10.0"
+
+; Only ELF has a .text.unlikely section; elsewhere the outlined function keeps
+; the default section.
+
+; CHECK: define internal void @f_if.then(i32 %x) #{{[0-9]+}} {
+
+declare void @report(i32)
+declare void @abort() noreturn
+
+define i32 @f(i32 %x) {
+entry:
+  %cmp = icmp slt i32 %x, 0
+  br i1 %cmp, label %if.then, label %if.end, !prof !0
+
+if.then:
+  call void @report(i32 %x)
+  call void @report(i32 0)
+  call void @report(i32 1)
+  call void @report(i32 2)
+  call void @abort()
+  unreachable
+
+if.end:
+  ret i32 %x
+}
+
+!0 = !{!"branch_weights", i32 1, i32 10000}
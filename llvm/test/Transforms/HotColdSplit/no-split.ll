@@ -0,0 +1,97 @@
+; RUN: opt -S -hotcoldsplit < %s | FileCheck %s
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+declare void @report(i32)
+declare void @abort() noreturn
+
+; Nothing is split without profile data.
+
+; CHECK-LABEL: define i32 @no_profile(
+; CHECK: call void @report(i32 %x)
+define i32 @no_profile(i32 %x) {
+entry:
+  %cmp = icmp slt i32 %x, 0
+  br i1 %cmp, label %if.then, label %if.end
+
+if.then:
+  call void @report(i32 %x)
+  call void @report(i32 0)
+  call void @report(i32 1)
+  call void @report(i32 2)
+  call void @abort()
+  unreachable
+
+if.end:
+  ret i32 %x
+}
+
+; A path taken often enough is not cold.
+
+; CHECK-LABEL: define i32 @warm(
+; CHECK: call void @report(i32 %x)
+define i32 @warm(i32 %x) {
+entry:
+  %cmp = icmp slt i32 %x, 0
+  br i1 %cmp, label %if.then, label %if.end, !prof !1
+
+if.then:
+  call void @report(i32 %x)
+  call void @report(i32 0)
+  call void @report(i32 1)
+  call void @report(i32 2)
+  br label %if.end
+
+if.end:
+  ret i32 %x
+}
+
+; The two blocks of the cold region pass different values to the PHI node
+; after it, which the extracted function cannot return.
+
+; CHECK-LABEL: define i32 @phi_merge(
+; CHECK: call void @report(i32 %x)
+define i32 @phi_merge(i32 %x, i32* %p) {
+entry:
+  %cmp = icmp slt i32 %x, 0
+  br i1 %cmp, label %if.then, label %if.end, !prof !0
+
+if.then:
+  call void @report(i32 %x)
+  call void @report(i32 0)
+  call void @report(i32 1)
+  %cmp1 = icmp eq i32 %x, -1
+  br i1 %cmp1, label %retry, label %if.end, !prof !2
+
+retry:
+  store i32 0, i32* %p
+  br label %if.end
+
+if.end:
+  %r = phi i32 [ 0, %if.then ], [ 1, %retry ], [ %x, %entry ]
+  ret i32 %r
+}
+
+; A region smaller than the call replacing it stays.
+
+; CHECK-LABEL: define i32 @small(
+; CHECK: call void @abort()
+define i32 @small(i32 %x) {
+entry:
+  %cmp = icmp slt i32 %x, 0
+  br i1 %cmp, label %if.then, label %if.end, !prof !0
+
+if.then:
+  call void @abort()
+  unreachable
+
+if.end:
+  ret i32 %x
+}
+
+; CHECK-NOT: define internal
+
+!0 = !{!"branch_weights", i32 1, i32 10000}
+!1 = !{!"branch_weights", i32 1, i32 10}
+!2 = !{!"branch_weights", i32 1, i32 1}
@@ -0,0 +1,81 @@
+; RUN: opt -S -hotcoldsplit < %s | FileCheck %s
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; The error path runs once in ten thousand calls and is outlined into a cold
+; function in .text.unlikely.  It ends in unreachable, so the call does not
+; return.
+
+; CHECK-LABEL: define i32 @f(
+; CHECK: codeRepl:
+; CHECK-NEXT: call void @f_if.then(i32 %x) #{{[0-9]+}}
+; CHECK-NEXT: unreachable
+; CHECK-NOT: call void @report
+; CHECK: ret i32
+
+; CHECK-LABEL: define i32 @multiple_exits(
+; CHECK: [[TARGET:%[A-Za-z.0-9]+]] = call i1 @multiple_exits_if.then(i32 %x)
+; CHECK-NEXT: br i1 [[TARGET]]
+
+; CHECK: define internal void @f_if.then(i32 %x) [[COLD:#[0-9]+]] section ".text.unlikely"
+; CHECK: call void @report(i32 %x)
+; CHECK: call void @abort()
+; CHECK-NEXT: unreachable
+
+; CHECK-LABEL: define internal i1 @multiple_exits_if.then(
+; CHECK-SAME: section ".text.unlikely"
+
+; CHECK: attributes [[COLD]] = { cold minsize noinline noreturn }
+
+declare void @report(i32)
+declare void @abort() noreturn
+
+define i32 @f(i32 %x) {
+entry:
+  %cmp = icmp slt i32 %x, 0
+  br i1 %cmp, label %if.then, label %if.end, !prof !0
+
+if.then:
+  call void @report(i32 %x)
+  call void @report(i32 0)
+  call void @report(i32 1)
+  call void @report(i32 2)
+  call void @abort()
+  unreachable
+
+if.end:
+  %add = add nsw i32 %x, 1
+  ret i32 %add
+}
+
+; The cold region leaves to a different block on each of its paths; the call
+; returns which one.
+
+define i32 @multiple_exits(i32 %x, i32* %p) {
+entry:
+  %cmp = icmp slt i32 %x, 0
+  br i1 %cmp, label %if.then, label %check, !prof !0
+
+check:
+  %cmp2 = icmp eq i32 %x, 5
+  br i1 %cmp2, label %other, label %if.end
+
+if.then:
+  call void @report(i32 %x)
+  call void @report(i32 0)
+  call void @report(i32 1)
+  %cmp1 = icmp eq i32 %x, -1
+  br i1 %cmp1, label %other, label %if.end, !prof !1
+
+other:
+  store i32 0, i32* %p
+  br label %if.end
+
+if.end:
+  %r = phi i32 [ 0, %if.then ], [ 1, %other ], [ %x, %check ]
+  ret i32 %r
+}
+
+!0 = !{!"branch_weights", i32 1, i32 10000}
+!1 = !{!"branch_weights", i32 1, i32 1}
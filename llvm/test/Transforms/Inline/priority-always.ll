@@ -0,0 +1,44 @@
+; RUN: opt < %s -priority-inline -priority-inline-growth=0 -S | FileCheck %s
+
+; Without any budget, the always_inline function is still inlined, and so is
+; the last call of a local function, which goes away after it.
+
+; CHECK-NOT: @only_once
+define internal i32 @only_once(i32 %x) {
+  %a1 = mul i32 %x, %x
+  %a2 = add i32 %a1, 7
+  %a3 = mul i32 %a2, %x
+  %a4 = xor i32 %a3, 12345
+  %a5 = add i32 %a4, %a1
+  ret i32 %a5
+}
+
+define i32 @always(i32 %x) alwaysinline {
+  %b1 = mul i32 %x, %x
+  %b2 = add i32 %b1, 9
+  %b3 = mul i32 %b2, %x
+  %b4 = xor i32 %b3, 54321
+  %b5 = add i32 %b4, %b1
+  ret i32 %b5
+}
+
+define i32 @other(i32 %x) {
+  %c1 = mul i32 %x, %x
+  %c2 = add i32 %c1, 3
+  ret i32 %c2
+}
+
+; CHECK-LABEL: define i32 @h(
+; CHECK-NOT: call i32 @only_once
+; CHECK-NOT: call i32 @always
+; CHECK: call i32 @other(i32 %x)
+; CHECK-NOT: call
+; CHECK: ret i32
+define i32 @h(i32 %x) {
+  %r1 = call i32 @only_once(i32 %x)
+  %r2 = call i32 @always(i32 %x)
+  %r3 = call i32 @other(i32 %x)
+  %s1 = add i32 %r1, %r2
+  %s2 = add i32 %s1, %r3
+  ret i32 %s2
+}
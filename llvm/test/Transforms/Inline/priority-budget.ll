@@ -0,0 +1,50 @@
+; RUN: opt < %s -priority-inline -priority-inline-growth=30 -S | FileCheck %s
+; RUN: opt < %s -priority-inline -priority-inline-growth=100 -S | FileCheck %s --check-prefix=ALL
+
+; The module has 22 instructions, and each callee adds 6 of them where it is
+; inlined.  With a budget of 30% only one call site can be inlined: the one in
+; the loop, which runs more often, although it comes after the other one.
+
+define i32 @callee_a(i32 %x) {
+  %a1 = mul i32 %x, %x
+  %a2 = add i32 %a1, 7
+  %a3 = mul i32 %a2, %x
+  %a4 = xor i32 %a3, 12345
+  %a5 = add i32 %a4, %a1
+  ret i32 %a5
+}
+
+define i32 @callee_b(i32 %x) {
+  %b1 = mul i32 %x, %x
+  %b2 = add i32 %b1, 9
+  %b3 = mul i32 %b2, %x
+  %b4 = xor i32 %b3, 54321
+  %b5 = add i32 %b4, %b1
+  ret i32 %b5
+}
+
+; CHECK-LABEL: define i32 @f(
+; CHECK: call i32 @callee_b(i32 %n)
+; CHECK-NOT: call
+; CHECK: ret i32
+
+; ALL-LABEL: define i32 @f(
+; ALL-NOT: call
+; ALL: ret i32
+define i32 @f(i32 %n) {
+entry:
+  %b = call i32 @callee_b(i32 %n)
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %s = phi i32 [ %b, %entry ], [ %s.next, %loop ]
+  %c = call i32 @callee_a(i32 %i)
+  %s.next = add i32 %s, %c
+  %i.next = add i32 %i, 1
+  %cmp = icmp slt i32 %i.next, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret i32 %s.next
+}
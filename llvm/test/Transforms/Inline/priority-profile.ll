@@ -0,0 +1,41 @@
+; RUN: opt < %s -priority-inline -priority-inline-growth=40 -S | FileCheck %s
+
+; The budget allows one of the two call sites to be inlined.  The profile says
+; @hot_caller runs a thousand times more often than @cold_caller, so its call
+; site goes first.
+
+define i32 @g1(i32 %x) {
+  %a1 = mul i32 %x, %x
+  %a2 = add i32 %a1, 7
+  %a3 = mul i32 %a2, %x
+  %a4 = xor i32 %a3, 12345
+  %a5 = add i32 %a4, %a1
+  ret i32 %a5
+}
+
+define i32 @g2(i32 %x) {
+  %b1 = mul i32 %x, %x
+  %b2 = add i32 %b1, 9
+  %b3 = mul i32 %b2, %x
+  %b4 = xor i32 %b3, 54321
+  %b5 = add i32 %b4, %b1
+  ret i32 %b5
+}
+
+; CHECK-LABEL: define i32 @cold_caller(
+; CHECK: call i32 @g2(i32 %x)
+define i32 @cold_caller(i32 %x) #0 {
+  %r = call i32 @g2(i32 %x)
+  ret i32 %r
+}
+
+; CHECK-LABEL: define i32 @hot_caller(
+; CHECK-NOT: call
+; CHECK: ret i32
+define i32 @hot_caller(i32 %x) #1 {
+  %r = call i32 @g1(i32 %x)
+  ret i32 %r
+}
+
+attributes #0 = { "function-entry-count"="1" }
+attributes #1 = { "function-entry-count"="1000" }
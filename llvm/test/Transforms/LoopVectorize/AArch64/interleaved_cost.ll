@@ -0,0 +1,40 @@
+; RUN: opt -S -loop-vectorize -force-vector-width=4 -debug-only=loop-vectorize -disable-output < %s 2>&1 | FileCheck %s
+; REQUIRES: asserts
+
+target datalayout = "e-m:e-i64:64-i128:128-n32:64-S128"
+target triple = "aarch64--linux-gnueabi"
+
+%struct.ST2 = type { i32, i32 }
+
+; An interleaved load or store group of factor 2 is a single ld2 or st2 on
+; AArch64.  The whole cost is charged to the insert position of the group.
+
+; CHECK-LABEL: Checking a loop in "test_load2_store2"
+; CHECK: LV: Found an estimated cost of 3 for VF 4 For instruction:   %tmp = load i32, i32* %x, align 4
+; CHECK: LV: Found an estimated cost of 0 for VF 4 For instruction:   %tmp1 = load i32, i32* %y, align 4
+; CHECK: LV: Found an estimated cost of 0 for VF 4 For instruction:   store i32 %add, i32* %x2, align 4
+; CHECK: LV: Found an estimated cost of 3 for VF 4 For instruction:   store i32 %sub, i32* %y2, align 4
+
+define void @test_load2_store2(%struct.ST2* noalias nocapture readonly %A, %struct.ST2* noalias nocapture %B) {
+entry:
+  br label %for.body
+
+for.body:                                         ; preds = %for.body, %entry
+  %indvars.iv = phi i64 [ 0, %entry ], [ %indvars.iv.next, %for.body ]
+  %x = getelementptr inbounds %struct.ST2, %struct.ST2* %A, i64 %indvars.iv, i32 0
+  %tmp = load i32, i32* %x, align 4
+  %y = getelementptr inbounds %struct.ST2, %struct.ST2* %A, i64 %indvars.iv, i32 1
+  %tmp1 = load i32, i32* %y, align 4
+  %add = add nsw i32 %tmp, %tmp1
+  %sub = sub nsw i32 %tmp, %tmp1
+  %x2 = getelementptr inbounds %struct.ST2, %struct.ST2* %B, i64 %indvars.iv, i32 0
+  store i32 %add, i32* %x2, align 4
+  %y2 = getelementptr inbounds %struct.ST2, %struct.ST2* %B, i64 %indvars.iv, i32 1
+  store i32 %sub, i32* %y2, align 4
+  %indvars.iv.next = add nuw nsw i64 %indvars.iv, 1
+  %exitcond = icmp eq i64 %indvars.iv.next, 1024
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:                                          ; preds = %for.body
+  ret void
+}
@@ -0,0 +1,114 @@
+; RUN: opt < %s -pgo-icall-prom -icp-count-threshold=100 -S | FileCheck %s
+; RUN: opt < %s -pgo-icall-prom -disable-icp -S | FileCheck %s --check-prefix=DISABLED
+
+; The value profiles name the targets by the MD5 hash of their profile name;
+; local functions are prefixed with the name of the file.
+
+define i32 @func1() {
+  ret i32 1
+}
+
+define i32 @func2() {
+  ret i32 2
+}
+
+define i32 @func3() {
+  ret i32 3
+}
+
+define i32 @mismatch(i32 %x) {
+  ret i32 %x
+}
+
+define internal i32 @local() {
+  ret i32 4
+}
+
+; The two hottest targets are promoted, the second one being hot enough
+; compared to what the first one leaves.
+; CHECK-LABEL: define i32 @call(
+; CHECK: %[[CMP1:[0-9]+]] = icmp eq i32 ()* %fp, @func1
+; CHECK: br i1 %[[CMP1]], label %{{.*}}, label %{{.*}}, !prof ![[BW1:[0-9]+]]
+; CHECK: %r.direct = call i32 @func1()
+; CHECK: %[[CMP2:[0-9]+]] = icmp eq i32 ()* %fp, @func2
+; CHECK: br i1 %[[CMP2]], label %{{.*}}, label %{{.*}}, !prof ![[BW2:[0-9]+]]
+; CHECK: %r.direct{{[0-9]*}} = call i32 @func2()
+; CHECK: %r = call i32 %fp(), !prof ![[VP:[0-9]+]]
+; CHECK: phi i32
+; CHECK: phi i32
+; CHECK: ret i32
+; DISABLED-LABEL: define i32 @call(
+; DISABLED-NOT: icmp
+; DISABLED: ret i32
+define i32 @call(i32 ()* %fp) {
+entry:
+  %r = call i32 %fp(), !prof !0
+  ret i32 %r
+}
+
+declare i32 @__gxx_personality_v0(...)
+
+; Both invokes unwind to the landing pad, and the results are merged before
+; the normal destination.
+; CHECK-LABEL: define i32 @invoke(
+; CHECK: icmp eq i32 ()* %fp, @local
+; CHECK: icp.direct:
+; CHECK-NEXT: %r.direct = invoke i32 @local()
+; CHECK-NEXT: to label %icp.merge unwind label %lpad
+; CHECK: icp.indirect:
+; CHECK-NEXT: %r = invoke i32 %fp()
+; CHECK-NEXT: to label %icp.merge unwind label %lpad{{$}}
+; CHECK: icp.merge:
+; CHECK-NEXT: %[[R:[0-9]+]] = phi i32 [ %r.direct, %icp.direct ], [ %r, %icp.indirect ]
+; CHECK-NEXT: br label %cont
+; CHECK: cont:
+; CHECK-NEXT: %v = phi i32 [ 0, %entry ], [ %[[R]], %icp.merge ]
+; CHECK: lpad:
+; CHECK-NEXT: %p = phi i32 [ 1, %icp.indirect ], [ 1, %icp.direct ]
+define i32 @invoke(i32 ()* %fp, i1 %c) {
+entry:
+  br i1 %c, label %call, label %cont
+
+call:
+  %r = invoke i32 %fp()
+          to label %cont unwind label %lpad, !prof !1
+
+cont:
+  %v = phi i32 [ 0, %entry ], [ %r, %call ]
+  ret i32 %v
+
+lpad:
+  %p = phi i32 [ 1, %call ]
+  %lp = landingpad { i8*, i32 } personality i8* bitcast (i32 (...)* @__gxx_personality_v0 to i8*)
+          cleanup
+  ret i32 %p
+}
+
+; The hottest target does not have the type of the call, and the next one is
+; not hot enough: nothing changes.
+; CHECK-LABEL: define i32 @type_mismatch(
+; CHECK-NOT: icmp
+; CHECK: %r = call i32 %fp(), !prof ![[VPMISMATCH:[0-9]+]]
+define i32 @type_mismatch(i32 ()* %fp) {
+  %r = call i32 %fp(), !prof !2
+  ret i32 %r
+}
+
+; Too few calls for any promotion.
+; CHECK-LABEL: define i32 @cold(
+; CHECK-NOT: icmp
+; CHECK: ret i32
+define i32 @cold(i32 ()* %fp) {
+  %r = call i32 %fp(), !prof !3
+  ret i32 %r
+}
+
+; CHECK: ![[BW1]] = !{!"branch_weights", i32 1000, i32 600}
+; CHECK: ![[BW2]] = !{!"branch_weights", i32 450, i32 150}
+; CHECK: ![[VP]] = !{!"VP", i32 0, i64 150, i64 -6929281286627296573, i64 150}
+; CHECK: ![[VPMISMATCH]] = !{!"VP", i32 0, i64 2100, i64 4921190683841862685, i64 2000, i64 -2545542355363006406, i64 100}
+
+!0 = !{!"VP", i32 0, i64 1600, i64 -2545542355363006406, i64 1000, i64 -4377547752858689819, i64 450, i64 -6929281286627296573, i64 150}
+!1 = !{!"VP", i32 0, i64 2000, i64 7764288052559491867, i64 2000}
+!2 = !{!"VP", i32 0, i64 2100, i64 4921190683841862685, i64 2000, i64 -2545542355363006406, i64 100}
+!3 = !{!"VP", i32 0, i64 50, i64 -2545542355363006406, i64 50}
@@ -1,4 +1,13 @@
 ; RUN: opt < %s -sample-profile -sample-profile-file=%S/Inputs/calls.prof | opt -analyze -branch-prob | FileCheck %s
+; RUN: opt < %s -sample-profile -sample-profile-file=%S/Inputs/calls.prof -S | FileCheck %s --check-prefix=COUNT
+
+; The head samples become the entry counts of the functions.  No sample hit
+; the entry of main, which still ran.
+; COUNT: define i32 @_Z3sumii(i32 %x, i32 %y) #[[SUM:[0-9]+]] {
+; COUNT: define i32 @main() #[[MAIN:[0-9]+]] {
+; COUNT: attributes #[[SUM]] = { "function-entry-count"="5279" }
+; COUNT: attributes #[[MAIN]] = { "function-entry-count"="1" }
+; COUNT: !{i32 2, !"MaxFunctionCount", i64 5279}
 
 ; Original C++ test case
 ;
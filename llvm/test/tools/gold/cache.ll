@@ -0,0 +1,32 @@
+; RUN: llvm-as -o %t.bc %s
+; RUN: rm -rf %t.cache
+; RUN: %gold -plugin %llvmshlibdir/LLVMgold.so -m elf_x86_64 -shared \
+; RUN:    -plugin-opt=cache-dir=%t.cache -plugin-opt=jobs=2 \
+; RUN:    -plugin-opt=obj-path=%t.o -o %t %t.bc
+; RUN: ls %t.cache | count 3
+
+; A second link reuses the cached partitions.
+; RUN: %gold -plugin %llvmshlibdir/LLVMgold.so -m elf_x86_64 -shared \
+; RUN:    -plugin-opt=cache-dir=%t.cache -plugin-opt=jobs=2 \
+; RUN:    -plugin-opt=obj-path=%t2.o -o %t2 %t.bc
+; RUN: ls %t.cache | count 3
+; RUN: cmp %t.o %t2.o
+; RUN: cmp %t.o.1 %t2.o.1
+
+; Entries are pruned down to the maximum size.
+; RUN: %gold -plugin %llvmshlibdir/LLVMgold.so -m elf_x86_64 -shared \
+; RUN:    -plugin-opt=cache-dir=%t.cache -plugin-opt=cache-pruning-interval=0 \
+; RUN:    -plugin-opt=cache-max-size=1 -o %t3 %t.bc
+; RUN: ls %t.cache | count 1
+
+target triple = "x86_64-unknown-linux-gnu"
+
+define void @foo() {
+  call void @bar()
+  ret void
+}
+
+define void @bar() {
+  call void @foo()
+  ret void
+}
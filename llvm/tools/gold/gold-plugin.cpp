@@ -14,12 +14,14 @@
 
 #include "llvm/Config/config.h" // plugin-api.h requires HAVE_STDINT_H
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/Analysis.h"
 #include "llvm/CodeGen/CommandFlags.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/IR/AutoUpgrade.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DiagnosticInfo.h"
@@ -31,10 +33,14 @@
 #include "llvm/Linker/Linker.h"
 #include "llvm/MC/SubtargetFeature.h"
 #include "llvm/Object/IRObjectFile.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/FormattedStream.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Transforms/IPO.h"
@@ -92,7 +98,15 @@ namespace options {
   static bool generate_api_file = false;
   static OutputType TheOutputType = OT_NORMAL;
   static unsigned OptLevel = 2;
+  // Number of partitions (and threads) used for code generation.
+  static unsigned Parallelism = 1;
   static std::string obj_path;
+  // Directory in which to cache the generated object files, and its pruning
+  // policy. See CachePruning.
+  static std::string cache_dir;
+  static int cache_pruning_interval = 1200;
+  static unsigned cache_entry_expiration = 7 * 24 * 3600;
+  static uint64_t cache_max_size = 0;
   static std::string extra_library_path;
   static std::string triple;
   static std::string mcpu;
@@ -119,6 +133,23 @@ namespace options {
       triple = opt.substr(strlen("mtriple="));
     } else if (opt.startswith("obj-path=")) {
       obj_path = opt.substr(strlen("obj-path="));
+    } else if (opt.startswith("cache-dir=")) {
+      cache_dir = opt.substr(strlen("cache-dir="));
+    } else if (opt.startswith("cache-pruning-interval=")) {
+      if (opt.substr(strlen("cache-pruning-interval="))
+              .getAsInteger(10, cache_pruning_interval))
+        message(LDPL_FATAL, "Invalid cache pruning interval: %s",
+                opt_ + strlen("cache-pruning-interval="));
+    } else if (opt.startswith("cache-entry-expiration=")) {
+      if (opt.substr(strlen("cache-entry-expiration="))
+              .getAsInteger(10, cache_entry_expiration))
+        message(LDPL_FATAL, "Invalid cache entry expiration: %s",
+                opt_ + strlen("cache-entry-expiration="));
+    } else if (opt.startswith("cache-max-size=")) {
+      if (opt.substr(strlen("cache-max-size="))
+              .getAsInteger(10, cache_max_size))
+        message(LDPL_FATAL, "Invalid cache size: %s",
+                opt_ + strlen("cache-max-size="));
     } else if (opt == "emit-llvm") {
       TheOutputType = OT_BC_ONLY;
     } else if (opt == "save-temps") {
@@ -129,6 +160,11 @@ namespace options {
       if (opt[1] < '0' || opt[1] > '3')
         report_fatal_error("Optimization level must be between 0 and 3");
       OptLevel = opt[1] - '0';
+    } else if (opt.startswith("jobs=")) {
+      if (opt.substr(strlen("jobs=")).getAsInteger(10, Parallelism) ||
+          Parallelism == 0)
+        message(LDPL_FATAL, "Invalid parallelism level: %s",
+                opt_ + strlen("jobs="));
     } else {
       // Save this option to pass to the code generator.
       // ParseCommandLineOptions() expects argv[0] to be program name. Lazily
@@ -742,6 +778,151 @@ static void saveBCFile(StringRef Path, Module &M) {
   WriteBitcodeToFile(&M, OS);
 }
 
+/// Returns the name of the cache entries holding the object files generated
+/// from \p M, before optimization, with the current options.
+static std::string computeCacheKey(Module &M, StringRef Features) {
+  MD5 Hasher;
+  auto AddString = [&](StringRef Str) {
+    // Terminate every string so that consecutive strings can't alias.
+    Hasher.update(Str);
+    const uint8_t Terminator = 0;
+    Hasher.update(makeArrayRef(Terminator));
+  };
+
+  AddString(PACKAGE_VERSION);
+
+  SmallVector<char, 0> Bitcode;
+  {
+    raw_svector_ostream OS(Bitcode);
+    WriteBitcodeToFile(&M, OS);
+  }
+  Hasher.update(ArrayRef<uint8_t>(
+      reinterpret_cast<const uint8_t *>(Bitcode.data()), Bitcode.size()));
+
+  // The target options are derived from the extra options, which also hold
+  // the options of the passes.
+  AddString(M.getTargetTriple());
+  AddString(options::mcpu);
+  AddString(Features);
+  AddString(utostr(options::OptLevel));
+  AddString(utostr(RelocationModel));
+  AddString(utostr(options::Parallelism));
+  AddString(utostr(options::extra.size()));
+  for (const char *Option : options::extra)
+    AddString(Option);
+
+  MD5::MD5Result Result;
+  Hasher.final(Result);
+  SmallString<32> Hash;
+  MD5::stringifyResult(Result, Hash);
+  return ("llvm-gold-" + Hash).str();
+}
+
+static std::string getCacheEntryPath(StringRef Key, unsigned Partition) {
+  SmallString<128> Path(options::cache_dir);
+  sys::path::append(Path, Key + "." + utostr(Partition) + ".o");
+  return Path.str();
+}
+
+/// Returns the path of the object file of partition \p Partition, and opens
+/// it in \p FD if it is non-null.
+static std::string getObjectFilename(unsigned Partition, int *FD) {
+  SmallString<128> Filename;
+  int TempFD;
+  if (!FD)
+    FD = &TempFD;
+  if (options::obj_path.empty()) {
+    std::error_code EC =
+        sys::fs::createTemporaryFile("lto-llvm", "o", *FD, Filename);
+    if (EC)
+      message(LDPL_FATAL, "Could not create temporary file: %s",
+              EC.message().c_str());
+  } else {
+    Filename = options::obj_path;
+    if (Partition != 0)
+      Filename += "." + utostr(Partition);
+    std::error_code EC =
+        sys::fs::openFileForWrite(Filename.c_str(), *FD, sys::fs::F_None);
+    if (EC)
+      message(LDPL_FATAL, "Could not open file: %s", EC.message().c_str());
+  }
+  if (FD == &TempFD)
+    sys::Process::SafelyCloseFileDescriptor(TempFD);
+  return Filename.str();
+}
+
+/// Copies the cache entries of \p Key to the object files of the link.
+/// Returns false, leaving \p Filenames empty, if one of them is missing.
+static bool loadFromCache(StringRef Key, std::vector<std::string> &Filenames) {
+  std::vector<std::string> Entries;
+  for (unsigned I = 0; I != options::Parallelism; ++I) {
+    Entries.push_back(getCacheEntryPath(Key, I));
+    if (!sys::fs::exists(Entries.back()))
+      return false;
+  }
+
+  for (unsigned I = 0; I != options::Parallelism; ++I) {
+    std::string Filename = getObjectFilename(I, nullptr);
+    Filenames.push_back(Filename);
+    if (sys::fs::copy_file(Entries[I], Filename)) {
+      // The entry may have been pruned concurrently; fall back to compiling.
+      if (options::obj_path.empty())
+        for (const std::string &Name : Filenames)
+          sys::fs::remove(Name);
+      Filenames.clear();
+      return false;
+    }
+
+    // Mark the entry as used for the pruning.
+    int FD;
+    if (!sys::fs::openFileForRead(Entries[I], FD)) {
+      sys::fs::setLastModificationAndAccessTime(FD, sys::TimeValue::now());
+      sys::Process::SafelyCloseFileDescriptor(FD);
+    }
+  }
+  return true;
+}
+
+/// Stores \p Filenames as the cache entries of \p Key and prunes the cache.
+/// Failures are ignored: the cache is only an optimization.
+static void storeInCache(StringRef Key, ArrayRef<std::string> Filenames) {
+  if (sys::fs::create_directories(options::cache_dir))
+    return;
+
+  for (unsigned I = 0, E = Filenames.size(); I != E; ++I) {
+    // Write the entry under a temporary name first, so that concurrent links
+    // never see a partial file.
+    SmallString<128> TempPath;
+    SmallString<128> Model(options::cache_dir);
+    sys::path::append(Model, "llvm-gold-tmp-%%%%%%%%.o");
+    if (sys::fs::createUniqueFile(Model, TempPath))
+      return;
+    if (sys::fs::copy_file(Filenames[I], TempPath) ||
+        sys::fs::rename(TempPath, getCacheEntryPath(Key, I))) {
+      sys::fs::remove(TempPath);
+      return;
+    }
+  }
+
+  CachePruning(options::cache_dir)
+      .setPruningInterval(options::cache_pruning_interval)
+      .setEntryExpiration(options::cache_entry_expiration)
+      .setMaxSize(options::cache_max_size)
+      .prune();
+}
+
+static void addObjectFiles(ArrayRef<std::string> Filenames) {
+  for (const std::string &Filename : Filenames) {
+    if (add_input_file(Filename.c_str()) != LDPS_OK)
+      message(LDPL_FATAL,
+              "Unable to add .o file to the link. File left behind in: %s",
+              Filename.c_str());
+
+    if (options::obj_path.empty())
+      Cleanup.push_back(Filename);
+  }
+}
+
 static void codegen(Module &M) {
   const std::string &TripleStr = M.getTargetTriple();
   Triple TheTriple(TripleStr);
@@ -779,46 +960,43 @@ static void codegen(Module &M) {
       TripleStr, options::mcpu, Features.getString(), Options, RelocationModel,
       CodeModel::Default, CGOptLevel));
 
+  // The key is computed before the module is optimized, so that a hit skips
+  // both the optimization and the code generation. The cache is not used
+  // with save-temps, which needs the optimized module.
+  std::string CacheKey;
+  if (!options::cache_dir.empty() &&
+      options::TheOutputType != options::OT_SAVE_TEMPS) {
+    CacheKey = computeCacheKey(M, Features.getString());
+    std::vector<std::string> Filenames;
+    if (loadFromCache(CacheKey, Filenames)) {
+      addObjectFiles(Filenames);
+      return;
+    }
+  }
+
   runLTOPasses(M, *TM);
 
   if (options::TheOutputType == options::OT_SAVE_TEMPS)
     saveBCFile(output_name + ".opt.bc", M);
 
-  legacy::PassManager CodeGenPasses;
-
-  SmallString<128> Filename;
-  int FD;
-  if (options::obj_path.empty()) {
-    std::error_code EC =
-        sys::fs::createTemporaryFile("lto-llvm", "o", FD, Filename);
-    if (EC)
-      message(LDPL_FATAL, "Could not create temporary file: %s",
-              EC.message().c_str());
-  } else {
-    Filename = options::obj_path;
-    std::error_code EC =
-        sys::fs::openFileForWrite(Filename.c_str(), FD, sys::fs::F_None);
-    if (EC)
-      message(LDPL_FATAL, "Could not open file: %s", EC.message().c_str());
+  std::vector<std::string> Filenames;
+  std::list<raw_fd_ostream> OSs;
+  std::vector<raw_ostream *> OSPtrs;
+  for (unsigned I = 0; I != options::Parallelism; ++I) {
+    int FD;
+    Filenames.push_back(getObjectFilename(I, &FD));
+    OSs.emplace_back(FD, true);
+    OSPtrs.push_back(&OSs.back());
   }
 
-  {
-    raw_fd_ostream OS(FD, true);
-    formatted_raw_ostream FOS(OS);
-
-    if (TM->addPassesToEmitFile(CodeGenPasses, FOS,
-                                TargetMachine::CGFT_ObjectFile))
-      message(LDPL_FATAL, "Failed to setup codegen");
-    CodeGenPasses.run(M);
-  }
+  splitCodeGen(M, OSPtrs, options::mcpu, Features.getString(), Options,
+               RelocationModel, CodeModel::Default, CGOptLevel);
+  OSs.clear();
 
-  if (add_input_file(Filename.c_str()) != LDPS_OK)
-    message(LDPL_FATAL,
-            "Unable to add .o file to the link. File left behind in: %s",
-            Filename.c_str());
+  if (!CacheKey.empty())
+    storeInCache(CacheKey, Filenames);
 
-  if (options::obj_path.empty())
-    Cleanup.push_back(Filename.c_str());
+  addObjectFiles(Filenames);
 }
 
 /// gold informs us that all symbols have been read. At this point, we use
@@ -44,6 +44,15 @@ Force("f", cl::desc("Enable binary output on terminals"));
 static cl::opt<bool>
 DisableOutput("disable-output", cl::desc("Disable output"), cl::init(false));
 
+static cl::opt<bool>
+EmitFunctionSummary("function-summary",
+                    cl::desc("Emit function summary index"), cl::init(false));
+
+static cl::opt<bool>
+EmitSymbolTable("symbol-table",
+                cl::desc("Emit a symbol table for linkers and archivers"),
+                cl::init(false));
+
 static cl::opt<bool>
 DumpAsm("d", cl::desc("Print assembly as parsed"), cl::Hidden);
 
@@ -78,7 +87,7 @@ static void WriteOutputFile(const Module *M) {
   }
 
   if (Force || !CheckBitcodeOutputToConsole(Out->os(), true))
-    WriteBitcodeToFile(M, Out->os());
+    WriteBitcodeToFile(M, Out->os(), EmitFunctionSummary, EmitSymbolTable);
 
   // Declare success.
   Out->keep();
@@ -14,6 +14,7 @@
 
 #include "llvm/Linker/Linker.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/AutoUpgrade.h"
 #include "llvm/IR/DiagnosticInfo.h"
@@ -25,11 +26,15 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/SystemUtils.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include <memory>
 using namespace llvm;
@@ -59,16 +64,29 @@ static cl::opt<bool>
 SuppressWarnings("suppress-warnings", cl::desc("Suppress all linking warnings"),
                  cl::init(false));
 
+static cl::opt<unsigned>
+Threads("j", cl::Prefix,
+        cl::desc("Number of threads used to link the input files"),
+        cl::init(1));
+
+static cl::opt<bool>
+TimeLink("time-link", cl::desc("Time each phase of the link"));
+
+static const char *const TimerGroupName = "llvm-link phases";
+
 // Read the specified bitcode file in and return it. This routine searches the
 // link path for the specified file to try to find it...
 //
 static std::unique_ptr<Module>
-loadFile(const char *argv0, const std::string &FN, LLVMContext &Context) {
+loadFile(const char *argv0, const std::string &FN, LLVMContext &Context,
+         raw_ostream &OS) {
   SMDiagnostic Err;
-  if (Verbose) errs() << "Loading '" << FN << "'\n";
+  if (Verbose) OS << "Loading '" << FN << "'\n";
   std::unique_ptr<Module> Result = getLazyIRFileModule(FN, Err, Context);
-  if (!Result)
-    Err.print(argv0, errs());
+  if (!Result) {
+    Err.print(argv0, OS);
+    return nullptr;
+  }
 
   Result->materializeMetadata();
   UpgradeDebugInfo(*Result);
@@ -76,25 +94,148 @@ loadFile(const char *argv0, const std::string &FN, LLVMContext &Context) {
   return Result;
 }
 
-static void diagnosticHandler(const DiagnosticInfo &DI) {
+static void printDiagnostic(const DiagnosticInfo &DI, raw_ostream &OS) {
   unsigned Severity = DI.getSeverity();
   switch (Severity) {
   case DS_Error:
-    errs() << "ERROR: ";
+    OS << "ERROR: ";
     break;
   case DS_Warning:
     if (SuppressWarnings)
       return;
-    errs() << "WARNING: ";
+    OS << "WARNING: ";
     break;
   case DS_Remark:
   case DS_Note:
     llvm_unreachable("Only expecting warnings and errors");
   }
 
-  DiagnosticPrinterRawOStream DP(errs());
+  DiagnosticPrinterRawOStream DP(OS);
   DI.print(DP);
-  errs() << '\n';
+  OS << '\n';
+}
+
+static void diagnosticHandler(const DiagnosticInfo &DI) {
+  printDiagnostic(DI, errs());
+}
+
+/// Load the input files [Begin, End) and link them into the composite module
+/// of \p L with \p Flags, reporting problems to \p OS. Returns true on error.
+static bool linkFiles(const char *argv0, Linker &L, unsigned Begin,
+                      unsigned End, raw_ostream &OS,
+                      unsigned Flags = Linker::None) {
+  LLVMContext &Context = L.getModule()->getContext();
+  for (unsigned i = Begin; i != End; ++i) {
+    std::unique_ptr<Module> M =
+        loadFile(argv0, InputFilenames[i], Context, OS);
+    if (!M.get()) {
+      OS << argv0 << ": error loading file '" << InputFilenames[i] << "'\n";
+      return true;
+    }
+
+    if (verifyModule(*M, &OS)) {
+      OS << argv0 << ": " << InputFilenames[i]
+         << ": error: input module is broken!\n";
+      return true;
+    }
+
+    if (Verbose) OS << "Linking in '" << InputFilenames[i] << "'\n";
+
+    if (L.linkInModule(M.get(), Flags))
+      return true;
+  }
+  return false;
+}
+
+/// A contiguous range of input files that is linked on its own thread and
+/// LLVMContext, and then spliced into the composite module as bitcode.
+struct Partition {
+  unsigned Begin, End;
+  SmallString<0> BC;
+  std::string Diags;
+  bool Failed;
+  Partition(unsigned Begin, unsigned End)
+      : Begin(Begin), End(End), Failed(false) {}
+};
+
+/// Link the input files into \p Composite using several threads.
+///
+/// The inputs are cut into one contiguous range per thread. The first range is
+/// linked straight into the composite on this thread, while each of the others
+/// is linked into a private module on a pool thread, since an LLVMContext must
+/// only be used by one thread at a time. The private modules are then written
+/// to bitcode and linked into the composite in input order. Linking the ranges
+/// in order preserves the symbol resolution and the order of appending
+/// globals of a serial link. The private links keep the linkonce definitions
+/// nothing refers to yet, as a later range may need them, so a linkonce
+/// symbol can get its definition from an earlier input than in a serial link.
+/// The private links also merge the isomorphic types
+/// of their inputs, so the final splice only has to map one set of types per
+/// range instead of one per input.
+static bool linkFilesInParallel(const char *argv0, Linker &L,
+                                unsigned NumThreads) {
+  unsigned NumInputs = InputFilenames.size();
+  std::vector<Partition> Parts;
+  for (unsigned I = 0; I != NumThreads; ++I)
+    Parts.emplace_back(uint64_t(NumInputs) * I / NumThreads,
+                       uint64_t(NumInputs) * (I + 1) / NumThreads);
+
+  auto LinkPartition = [&](unsigned I) {
+    Partition &P = Parts[I];
+    raw_string_ostream OS(P.Diags);
+    LLVMContext Context;
+    Module M("llvm-link", Context);
+    Linker PL(&M, [&OS](const DiagnosticInfo &DI) {
+      printDiagnostic(DI, OS);
+    });
+    P.Failed =
+        linkFiles(argv0, PL, P.Begin, P.End, OS, Linker::LinkAllLinkOnce);
+    if (!P.Failed) {
+      raw_svector_ostream BCOS(P.BC);
+      WriteBitcodeToFile(&M, BCOS);
+    }
+  };
+
+  {
+    NamedRegionTimer T("Link input files", TimerGroupName, TimeLink);
+    ThreadPool Pool(NumThreads - 1);
+    for (unsigned I = 1; I != NumThreads; ++I)
+      Pool.async(LinkPartition, I);
+    // The calling thread takes the first range.
+    bool Failed = linkFiles(argv0, L, Parts[0].Begin, Parts[0].End, errs());
+    Pool.wait();
+
+    // Report the diagnostics of the pool threads in input order.
+    for (unsigned I = 1; I != NumThreads && !Failed; ++I) {
+      errs() << Parts[I].Diags;
+      Failed = Parts[I].Failed;
+    }
+    if (Failed)
+      return true;
+  }
+
+  NamedRegionTimer T("Link partial modules", TimerGroupName, TimeLink);
+  LLVMContext &Context = L.getModule()->getContext();
+  for (unsigned I = 1; I != NumThreads; ++I) {
+    if (Verbose)
+      errs() << "Linking in inputs " << Parts[I].Begin << " to "
+             << Parts[I].End - 1 << "\n";
+    ErrorOr<Module *> MOrErr = getLazyBitcodeModule(
+        MemoryBuffer::getMemBuffer(StringRef(Parts[I].BC.data(),
+                                             Parts[I].BC.size()),
+                                   "<partial-link>", false),
+        Context);
+    if (std::error_code EC = MOrErr.getError()) {
+      errs() << argv0 << ": error reading partial link: " << EC.message()
+             << "\n";
+      return true;
+    }
+    std::unique_ptr<Module> M(*MOrErr);
+    M->materializeMetadata();
+    if (L.linkInModule(M.get()))
+      return true;
+  }
+  return false;
 }
 
 int main(int argc, char **argv) {
@@ -109,23 +250,15 @@ int main(int argc, char **argv) {
   auto Composite = make_unique<Module>("llvm-link", Context);
   Linker L(Composite.get(), diagnosticHandler);
 
-  for (unsigned i = 0; i < InputFilenames.size(); ++i) {
-    std::unique_ptr<Module> M = loadFile(argv[0], InputFilenames[i], Context);
-    if (!M.get()) {
-      errs() << argv[0] << ": error loading file '" <<InputFilenames[i]<< "'\n";
-      return 1;
-    }
-
-    if (verifyModule(*M, &errs())) {
-      errs() << argv[0] << ": " << InputFilenames[i]
-             << ": error: input module is broken!\n";
-      return 1;
-    }
-
-    if (Verbose) errs() << "Linking in '" << InputFilenames[i] << "'\n";
-
-    if (L.linkInModule(M.get()))
+  unsigned NumThreads = std::min<unsigned>(Threads, InputFilenames.size());
+  if (NumThreads == 0 || !llvm_is_multithreaded())
+    NumThreads = 1;
+  if (NumThreads == 1) {
+    NamedRegionTimer T("Link input files", TimerGroupName, TimeLink);
+    if (linkFiles(argv[0], L, 0, InputFilenames.size(), errs()))
       return 1;
+  } else if (linkFilesInParallel(argv[0], L, NumThreads)) {
+    return 1;
   }
 
   if (DumpAsm) errs() << "Here's the assembly:\n" << *Composite;
@@ -143,6 +276,7 @@ int main(int argc, char **argv) {
   }
 
   if (Verbose) errs() << "Writing bitcode...\n";
+  NamedRegionTimer T("Write output", TimerGroupName, TimeLink);
   if (OutputAssembly) {
     Out.os() << *Composite;
   } else if (Force || !CheckBitcodeOutputToConsole(Out.os(), true))
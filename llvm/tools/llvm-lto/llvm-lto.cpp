@@ -12,8 +12,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
+#include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/CommandFlags.h"
+#include "llvm/IR/FunctionInfo.h"
+#include "llvm/IR/LLVMContext.h"
 #include "llvm/LTO/LTOCodeGenerator.h"
 #include "llvm/LTO/LTOModule.h"
 #include "llvm/Support/CommandLine.h"
@@ -22,7 +26,9 @@
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
+#include <list>
 
 using namespace llvm;
 
@@ -46,6 +52,34 @@ static cl::opt<bool>
 DisableLTOVectorization("disable-lto-vectorization", cl::init(false),
   cl::desc("Do not run loop or slp vectorization during LTO"));
 
+static cl::opt<unsigned>
+Parallelism("j", cl::Prefix, cl::init(1),
+  cl::desc("Number of partitions to split the module into for parallel "
+           "code generation. Each partition is written to its own object "
+           "file, named by appending .N to the output filename"));
+
+static cl::opt<std::string>
+CacheDir("cache-dir", cl::init(""),
+  cl::desc("Directory in which to cache the generated object files"),
+  cl::value_desc("directory"));
+
+static cl::opt<int>
+CachePruningInterval("cache-pruning-interval", cl::init(1200),
+  cl::desc("Minimum time between two prunings of the cache, in seconds"));
+
+static cl::opt<unsigned>
+CacheEntryExpiration("cache-entry-expiration", cl::init(7 * 24 * 3600),
+  cl::desc("Time after which an unused cache entry is removed, in seconds "
+           "(0 to disable)"));
+
+static cl::opt<unsigned long long>
+CacheMaxSize("cache-max-size", cl::init(0),
+  cl::desc("Maximum size of the cache, in bytes (0 for no limit)"));
+
+static cl::opt<bool>
+ThinLTO("thinlto", cl::init(false),
+  cl::desc("Only write combined global index for ThinLTO backends"));
+
 static cl::opt<bool>
 UseDiagnosticHandler("use-diagnostic-handler", cl::init(false),
   cl::desc("Use a diagnostic handler to test the handler interface"));
@@ -142,6 +176,50 @@ static int listSymbols(StringRef Command, const TargetOptions &Options) {
   return 0;
 }
 
+/// Create a combined index file from the input IR files and write it.
+///
+/// The combined index holds the function summaries of all the inputs, which
+/// must have been written with one. It is written to the output filename with
+/// .thinlto.bc appended, for use by the -function-import pass.
+static int createCombinedFunctionInfo(StringRef Command) {
+  FunctionInfoIndex CombinedIndex;
+  uint64_t NextModuleId = 0;
+  for (auto &Filename : InputFilenames) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> BufferOrErr =
+        MemoryBuffer::getFile(Filename);
+    if (std::error_code EC = BufferOrErr.getError()) {
+      errs() << Command << ": error loading file '" << Filename
+             << "': " << EC.message() << "\n";
+      return 1;
+    }
+    LLVMContext Context;
+    ErrorOr<std::unique_ptr<FunctionInfoIndex>> IndexOrErr =
+        getFunctionInfoIndex((*BufferOrErr)->getMemBufferRef(), Context);
+    if (std::error_code EC = IndexOrErr.getError()) {
+      errs() << Command << ": error reading the function summary of '"
+             << Filename << "': " << EC.message() << "\n";
+      return 1;
+    }
+    uint64_t NumModules = (*IndexOrErr)->modulePaths().size();
+    CombinedIndex.mergeFrom(std::move(*IndexOrErr), NextModuleId);
+    NextModuleId += NumModules;
+  }
+
+  if (OutputFilename.empty()) {
+    errs() << Command << ": -thinlto requires an output filename\n";
+    return 1;
+  }
+  std::error_code EC;
+  raw_fd_ostream OS(OutputFilename + ".thinlto.bc", EC, sys::fs::F_None);
+  if (EC) {
+    errs() << Command << ": error opening the file '" << OutputFilename
+           << ".thinlto.bc': " << EC.message() << "\n";
+    return 1;
+  }
+  WriteFunctionSummaryToFile(CombinedIndex, OS);
+  return 0;
+}
+
 int main(int argc, char **argv) {
   // Print a stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal();
@@ -167,6 +245,9 @@ int main(int argc, char **argv) {
   if (ListSymbolsOnly)
     return listSymbols(argv[0], Options);
 
+  if (ThinLTO)
+    return createCombinedFunctionInfo(argv[0]);
+
   unsigned BaseArg = 0;
 
   LTOCodeGenerator CodeGen;
@@ -252,7 +333,61 @@ int main(int argc, char **argv) {
   if (!attrs.empty())
     CodeGen.setAttr(attrs.c_str());
 
-  if (!OutputFilename.empty()) {
+  CodeGen.setCacheDir(CacheDir.c_str());
+  CodeGen.setCachePruningInterval(CachePruningInterval);
+  CodeGen.setCacheEntryExpiration(CacheEntryExpiration);
+  CodeGen.setCacheMaxSize(CacheMaxSize);
+
+  if (Parallelism == 0) {
+    errs() << argv[0] << ": -j must be at least 1\n";
+    return 1;
+  }
+
+  if (Parallelism > 1) {
+    std::string ErrorInfo;
+    if (!CodeGen.optimize(DisableInline, DisableGVNLoadPRE,
+                          DisableLTOVectorization, ErrorInfo)) {
+      errs() << argv[0] << ": error optimizing the code: " << ErrorInfo
+             << "\n";
+      return 1;
+    }
+
+    if (OutputFilename.empty()) {
+      const char **OutputNames = nullptr;
+      if (!CodeGen.compileOptimizedToFiles(Parallelism, &OutputNames,
+                                           ErrorInfo)) {
+        errs() << argv[0] << ": error compiling the code: " << ErrorInfo
+               << "\n";
+        return 1;
+      }
+      for (unsigned I = 0; I != Parallelism; ++I)
+        outs() << "Wrote native object file '" << OutputNames[I] << "'\n";
+      return 0;
+    }
+
+    std::list<tool_output_file> OSs;
+    std::vector<raw_ostream *> OSPtrs;
+    for (unsigned I = 0; I != Parallelism; ++I) {
+      std::string PartFilename = OutputFilename + "." + utostr(I);
+      std::error_code EC;
+      OSs.emplace_back(PartFilename, EC, sys::fs::F_None);
+      if (EC) {
+        errs() << argv[0] << ": error opening the file '" << PartFilename
+               << "': " << EC.message() << "\n";
+        return 1;
+      }
+      OSPtrs.push_back(&OSs.back().os());
+    }
+
+    if (!CodeGen.compileOptimized(OSPtrs, ErrorInfo)) {
+      errs() << argv[0] << ": error compiling the code: " << ErrorInfo
+             << "\n";
+      return 1;
+    }
+
+    for (tool_output_file &OS : OSs)
+      OS.keep();
+  } else if (!OutputFilename.empty()) {
     size_t len = 0;
     std::string ErrorInfo;
     const void *Code =
@@ -24,6 +24,7 @@
 #include "llvm/Object/COFF.h"
 #include "llvm/Object/ELFObjectFile.h"
 #include "llvm/Object/IRObjectFile.h"
+#include "llvm/Object/IRSymtabFile.h"
 #include "llvm/Object/MachO.h"
 #include "llvm/Object/MachOUniversal.h"
 #include "llvm/Object/ObjectFile.h"
@@ -244,7 +245,7 @@ static bool compareSymbolName(const NMSymbol &A, const NMSymbol &B) {
 }
 
 static char isSymbolList64Bit(SymbolicFile &Obj) {
-  if (isa<IRObjectFile>(Obj))
+  if (isa<IRObjectFile>(Obj) || isa<IRSymtabFile>(Obj))
     return false;
   if (isa<COFFObjectFile>(Obj))
     return false;
@@ -784,6 +785,11 @@ static char getSymbolNMTypeChar(IRObjectFile &Obj, basic_symbol_iterator I) {
   return getSymbolNMTypeChar(*GV);
 }
 
+static char getSymbolNMTypeChar(IRSymtabFile &Obj, basic_symbol_iterator I) {
+  // Like getSymbolNMTypeChar(const GlobalValue &).
+  return Obj.getSymbol(I->getRawDataRefImpl()).isFunction() ? 't' : 'd';
+}
+
 template <class ELFT>
 static bool isELFObject(ELFObjectFile<ELFT> &Obj, symbol_iterator I) {
   typedef typename ELFObjectFile<ELFT>::Elf_Sym Elf_Sym;
@@ -826,6 +832,8 @@ static char getNMTypeChar(SymbolicFile &Obj, basic_symbol_iterator I) {
     Ret = 'a';
   else if (IRObjectFile *IR = dyn_cast<IRObjectFile>(&Obj))
     Ret = getSymbolNMTypeChar(*IR, I);
+  else if (IRSymtabFile *IR = dyn_cast<IRSymtabFile>(&Obj))
+    Ret = getSymbolNMTypeChar(*IR, I);
   else if (COFFObjectFile *COFF = dyn_cast<COFFObjectFile>(&Obj))
     Ret = getSymbolNMTypeChar(*COFF, I);
   else if (MachOObjectFile *MachO = dyn_cast<MachOObjectFile>(&Obj))
@@ -923,6 +931,9 @@ static void dumpSymbolNamesFromObject(SymbolicFile &Obj, bool printName,
         if (GV && isa<GlobalAlias>(GV))
           continue;
       }
+      if (IRSymtabFile *IR = dyn_cast<IRSymtabFile>(&Obj))
+        if (IR->getSymbol(I->getRawDataRefImpl()).isAlias())
+          continue;
     }
     // If a "-s segname sectname" option was specified and this is a Mach-O
     // file and this section appears in this file, Nsect will be non-zero then
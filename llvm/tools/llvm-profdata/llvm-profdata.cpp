@@ -11,6 +11,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/ProfileData/InstrProfReader.h"
@@ -26,6 +28,7 @@
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 using namespace llvm;
 
@@ -57,8 +60,7 @@ static void mergeInstrProfile(const cl::list<std::string> &Inputs,
 
     auto Reader = std::move(ReaderOrErr.get());
     for (const auto &I : *Reader)
-      if (std::error_code EC =
-              Writer.addFunctionCounts(I.Name, I.Hash, I.Counts))
+      if (std::error_code EC = Writer.addRecord(I))
         errs() << Filename << ": " << I.Name << ": " << EC.message() << "\n";
     if (Reader->hasError())
       exitWithError(Reader->getError().message(), Filename);
@@ -131,9 +133,26 @@ static int merge_main(int argc, const char *argv[]) {
   return 0;
 }
 
+/// Return the names of the functions of the profile, by name hash, to name
+/// the targets of indirect calls.
+static DenseMap<uint64_t, std::string> getFunctionNames(std::string Filename) {
+  DenseMap<uint64_t, std::string> Names;
+  auto ReaderOrErr = InstrProfReader::create(Filename);
+  if (std::error_code EC = ReaderOrErr.getError())
+    exitWithError(EC.message(), Filename);
+  for (const auto &Func : *ReaderOrErr.get())
+    Names[getInstrProfNameHash(Func.Name)] = Func.Name;
+  return Names;
+}
+
 static int showInstrProfile(std::string Filename, bool ShowCounts,
+                            bool ShowIndirectCallTargets,
                             bool ShowAllFunctions, std::string ShowFunction,
                             raw_fd_ostream &OS) {
+  DenseMap<uint64_t, std::string> FunctionNames;
+  if (ShowIndirectCallTargets)
+    FunctionNames = getFunctionNames(Filename);
+
   auto ReaderOrErr = InstrProfReader::create(Filename);
   if (std::error_code EC = ReaderOrErr.getError())
     exitWithError(EC.message(), Filename);
@@ -141,6 +160,7 @@ static int showInstrProfile(std::string Filename, bool ShowCounts,
   auto Reader = std::move(ReaderOrErr.get());
   uint64_t MaxFunctionCount = 0, MaxBlockCount = 0;
   size_t ShownFunctions = 0, TotalFunctions = 0;
+  uint64_t TotalIndirectCallSites = 0;
   for (const auto &Func : *Reader) {
     bool Show =
         ShowAllFunctions || (!ShowFunction.empty() &&
@@ -151,6 +171,9 @@ static int showInstrProfile(std::string Filename, bool ShowCounts,
     if (Func.Counts[0] > MaxFunctionCount)
       MaxFunctionCount = Func.Counts[0];
 
+    uint32_t NumCallSites = Func.getNumValueSites(IPVK_IndirectCallTarget);
+    TotalIndirectCallSites += NumCallSites;
+
     if (Show) {
       if (!ShownFunctions)
         OS << "Counters:\n";
@@ -160,6 +183,8 @@ static int showInstrProfile(std::string Filename, bool ShowCounts,
          << "    Hash: " << format("0x%016" PRIx64, Func.Hash) << "\n"
          << "    Counters: " << Func.Counts.size() << "\n"
          << "    Function count: " << Func.Counts[0] << "\n";
+      if (ShowIndirectCallTargets)
+        OS << "    Indirect Call Site Count: " << NumCallSites << "\n";
     }
 
     if (Show && ShowCounts)
@@ -172,6 +197,21 @@ static int showInstrProfile(std::string Filename, bool ShowCounts,
     }
     if (Show && ShowCounts)
       OS << "]\n";
+
+    if (Show && ShowIndirectCallTargets && NumCallSites) {
+      OS << "    Indirect Target Results:\n";
+      const auto &Sites = Func.ValueSites[IPVK_IndirectCallTarget];
+      for (size_t I = 0, E = Sites.size(); I < E; ++I)
+        for (const InstrProfValueData &VD : Sites[I].ValueData) {
+          OS << "\t[ " << I << ", ";
+          auto Name = FunctionNames.find(VD.Value);
+          if (Name != FunctionNames.end())
+            OS << Name->second;
+          else
+            OS << format("0x%016" PRIx64, VD.Value);
+          OS << ", " << VD.Count << " ]\n";
+        }
+    }
   }
   if (Reader->hasError())
     exitWithError(Reader->getError().message(), Filename);
@@ -181,6 +221,9 @@ static int showInstrProfile(std::string Filename, bool ShowCounts,
   OS << "Total functions: " << TotalFunctions << "\n";
   OS << "Maximum function count: " << MaxFunctionCount << "\n";
   OS << "Maximum internal block count: " << MaxBlockCount << "\n";
+  if (ShowIndirectCallTargets)
+    OS << "Total number of indirect call sites: " << TotalIndirectCallSites
+       << "\n";
   return 0;
 }
 
@@ -208,6 +251,9 @@ static int show_main(int argc, const char *argv[]) {
 
   cl::opt<bool> ShowCounts("counts", cl::init(false),
                            cl::desc("Show counter values for shown functions"));
+  cl::opt<bool> ShowIndirectCallTargets(
+      "ic-targets", cl::init(false),
+      cl::desc("Show indirect call site target values for shown functions"));
   cl::opt<bool> ShowAllFunctions("all-functions", cl::init(false),
                                  cl::desc("Details for every function"));
   cl::opt<std::string> ShowFunction("function",
@@ -236,13 +282,224 @@ static int show_main(int argc, const char *argv[]) {
     errs() << "warning: -function argument ignored: showing all functions\n";
 
   if (ProfileKind == instr)
-    return showInstrProfile(Filename, ShowCounts, ShowAllFunctions,
-                            ShowFunction, OS);
+    return showInstrProfile(Filename, ShowCounts, ShowIndirectCallTargets,
+                            ShowAllFunctions, ShowFunction, OS);
   else
     return showSampleProfile(Filename, ShowCounts, ShowAllFunctions,
                              ShowFunction, OS);
 }
 
+namespace {
+/// A function of the profile and the cluster it is placed in.
+struct OrderNode {
+  std::string Name;
+  uint64_t Weight;  // How often the function runs: its entry count or samples.
+  uint64_t Size;    // An estimate of the code size of the function.
+  unsigned Caller;  // The most frequent caller, or ~0U if unknown.
+  uint64_t CallerCount;
+  unsigned Cluster;
+};
+
+/// A sequence of functions that are laid out next to each other.
+struct OrderCluster {
+  std::vector<unsigned> Nodes;
+  uint64_t Weight;
+  uint64_t Size;
+  double getDensity() const { return double(Weight) / double(Size); }
+};
+
+/// The call graph that llvm-profdata order lays out: the functions with
+/// profile data, and for each of them the caller that calls it most often.
+class OrderGraph {
+  std::vector<OrderNode> Nodes;
+  StringMap<unsigned> NodeIndex;
+
+public:
+  /// Add the function \p Name, or profile data for it if it is already known.
+  unsigned addFunction(StringRef Name, uint64_t Weight, uint64_t Size) {
+    auto Ins = NodeIndex.insert(std::make_pair(Name, Nodes.size()));
+    if (Ins.second) {
+      OrderNode N = {Name, 0, 0, ~0U, 0, 0};
+      Nodes.push_back(N);
+    }
+    OrderNode &N = Nodes[Ins.first->second];
+    N.Weight += Weight;
+    N.Size = std::max(N.Size, Size);
+    return Ins.first->second;
+  }
+
+  /// Record that \p Caller called \p Callee \p Count times.
+  void addCall(unsigned Caller, StringRef Callee, uint64_t Count) {
+    unsigned CalleeIdx = addFunction(Callee, 0, 0);
+    if (Caller == CalleeIdx)
+      return;
+    // The profiles only give a handful of call sites per caller; keeping the
+    // edge with the largest single count is precise enough for the layout.
+    OrderNode &N = Nodes[CalleeIdx];
+    if (Count > N.CallerCount) {
+      N.Caller = Caller;
+      N.CallerCount = Count;
+    }
+  }
+
+  void computeOrder(uint64_t MaxClusterSize, raw_ostream &OS);
+};
+} // end anonymous namespace
+
+/// Print the functions with profile data in the order the linker should lay
+/// them out, following the call-chain clustering (C3) heuristic: functions are
+/// visited hottest first and their cluster is appended to the cluster of their
+/// most frequent caller, as long as the result stays small and nearly as dense
+/// as the caller's cluster.  The clusters are then emitted densest first.
+void OrderGraph::computeOrder(uint64_t MaxClusterSize, raw_ostream &OS) {
+  // Functions that never ran are left for the linker to place after the
+  // ordered ones.
+  std::vector<OrderCluster> Clusters;
+  std::vector<unsigned> Sorted;
+  for (unsigned I = 0, E = Nodes.size(); I != E; ++I) {
+    OrderNode &N = Nodes[I];
+    N.Size = std::max<uint64_t>(N.Size, 1);
+    N.Cluster = Clusters.size();
+    OrderCluster C = {std::vector<unsigned>(1, I), N.Weight, N.Size};
+    Clusters.push_back(C);
+    if (N.Weight)
+      Sorted.push_back(I);
+  }
+
+  std::stable_sort(Sorted.begin(), Sorted.end(), [&](unsigned L, unsigned R) {
+    return Nodes[L].Weight > Nodes[R].Weight;
+  });
+
+  // Merging a cluster must not make its caller's cluster much less dense than
+  // it was, or the hot code of the caller gets diluted by lukewarm code.
+  const double MaxDensityDegradation = 8.0;
+  for (unsigned I : Sorted) {
+    OrderNode &N = Nodes[I];
+    if (N.Caller == ~0U || !Nodes[N.Caller].Weight)
+      continue;
+    unsigned From = N.Cluster, To = Nodes[N.Caller].Cluster;
+    if (From == To)
+      continue;
+    OrderCluster &Callee = Clusters[From], &Caller = Clusters[To];
+    if (Caller.Size + Callee.Size > MaxClusterSize)
+      continue;
+    double NewDensity = double(Caller.Weight + Callee.Weight) /
+                        double(Caller.Size + Callee.Size);
+    if (NewDensity < Caller.getDensity() / MaxDensityDegradation)
+      continue;
+
+    for (unsigned Member : Callee.Nodes)
+      Nodes[Member].Cluster = To;
+    Caller.Nodes.insert(Caller.Nodes.end(), Callee.Nodes.begin(),
+                        Callee.Nodes.end());
+    Caller.Weight += Callee.Weight;
+    Caller.Size += Callee.Size;
+    Callee.Nodes.clear();
+    Callee.Weight = 0;
+  }
+
+  std::vector<OrderCluster *> Order;
+  for (OrderCluster &C : Clusters)
+    if (C.Weight)
+      Order.push_back(&C);
+  std::stable_sort(Order.begin(), Order.end(),
+                   [](const OrderCluster *L, const OrderCluster *R) {
+                     return L->getDensity() > R->getDensity();
+                   });
+
+  for (const OrderCluster *C : Order)
+    for (unsigned I : C->Nodes) {
+      if (!Nodes[I].Weight)
+        continue;
+      // The profile names local functions "<file>:<name>"; the linker only
+      // knows the symbol.
+      StringRef Name = Nodes[I].Name;
+      OS << Name.substr(Name.rfind(':') + 1) << "\n";
+    }
+}
+
+static void buildInstrOrderGraph(std::string Filename, OrderGraph &G) {
+  DenseMap<uint64_t, std::string> FunctionNames = getFunctionNames(Filename);
+
+  auto ReaderOrErr = InstrProfReader::create(Filename);
+  if (std::error_code EC = ReaderOrErr.getError())
+    exitWithError(EC.message(), Filename);
+
+  // The instrumentation only counts the entries of the functions and the
+  // targets of their indirect calls.  The number of counters stands in for
+  // the size of the function.
+  auto Reader = std::move(ReaderOrErr.get());
+  for (const auto &Func : *Reader) {
+    unsigned Caller = G.addFunction(Func.Name, Func.Counts[0],
+                                    Func.Counts.size());
+    if (!Func.getNumValueSites(IPVK_IndirectCallTarget))
+      continue;
+    for (const auto &Site : Func.ValueSites[IPVK_IndirectCallTarget])
+      for (const InstrProfValueData &VD : Site.ValueData) {
+        auto Name = FunctionNames.find(VD.Value);
+        if (Name != FunctionNames.end())
+          G.addCall(Caller, Name->second, VD.Count);
+      }
+  }
+  if (Reader->hasError())
+    exitWithError(Reader->getError().message(), Filename);
+}
+
+static void buildSampleOrderGraph(std::string Filename, OrderGraph &G) {
+  using namespace sampleprof;
+  auto ReaderOrErr = SampleProfileReader::create(Filename, getGlobalContext());
+  if (std::error_code EC = ReaderOrErr.getError())
+    exitWithError(EC.message(), Filename);
+
+  auto Reader = std::move(ReaderOrErr.get());
+  if (std::error_code EC = Reader->read())
+    exitWithError(EC.message(), Filename);
+
+  // Samples record the targets of direct and indirect calls alike.  The
+  // number of sampled lines stands in for the size of the function.
+  for (const auto &I : Reader->getProfiles()) {
+    const FunctionSamples &Samples = I.second;
+    unsigned Caller = G.addFunction(I.first(), Samples.getTotalSamples(),
+                                    Samples.getBodySamples().size());
+    for (const auto &Body : Samples.getBodySamples())
+      for (const auto &Target : Body.second.getCallTargets())
+        G.addCall(Caller, Target.first(), Target.second);
+  }
+}
+
+static int order_main(int argc, const char *argv[]) {
+  cl::opt<std::string> Filename(cl::Positional, cl::Required,
+                                cl::desc("<profdata-file>"));
+
+  cl::opt<std::string> OutputFilename("output", cl::value_desc("output"),
+                                      cl::init("-"), cl::desc("Output file"));
+  cl::alias OutputFilenameA("o", cl::desc("Alias for --output"),
+                            cl::aliasopt(OutputFilename));
+  cl::opt<ProfileKinds> ProfileKind(
+      cl::desc("Profile kind:"), cl::init(instr),
+      cl::values(clEnumVal(instr, "Instrumentation profile (default)"),
+                 clEnumVal(sample, "Sample profile"), clEnumValEnd));
+  cl::opt<unsigned> MaxClusterSize(
+      "max-cluster-size", cl::init(1024),
+      cl::desc("Maximum size of a cluster of functions laid out together, in "
+               "counters (instr) or sampled lines (sample)"));
+
+  cl::ParseCommandLineOptions(argc, argv, "LLVM function order generator\n");
+
+  std::error_code EC;
+  raw_fd_ostream OS(OutputFilename.data(), EC, sys::fs::F_Text);
+  if (EC)
+    exitWithError(EC.message(), OutputFilename);
+
+  OrderGraph G;
+  if (ProfileKind == instr)
+    buildInstrOrderGraph(Filename, G);
+  else
+    buildSampleOrderGraph(Filename, G);
+  G.computeOrder(MaxClusterSize, OS);
+  return 0;
+}
+
 int main(int argc, const char *argv[]) {
   // Print a stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal();
@@ -257,6 +514,8 @@ int main(int argc, const char *argv[]) {
       func = merge_main;
     else if (strcmp(argv[1], "show") == 0)
       func = show_main;
+    else if (strcmp(argv[1], "order") == 0)
+      func = order_main;
 
     if (func) {
       std::string Invocation(ProgName.str() + " " + argv[1]);
@@ -271,7 +530,7 @@ int main(int argc, const char *argv[]) {
       errs() << "OVERVIEW: LLVM profile data tools\n\n"
              << "USAGE: " << ProgName << " <command> [args...]\n"
              << "USAGE: " << ProgName << " <command> -help\n\n"
-             << "Available commands: merge, show\n";
+             << "Available commands: merge, show, order\n";
       return 0;
     }
   }
@@ -281,6 +540,6 @@ int main(int argc, const char *argv[]) {
   else
     errs() << ProgName << ": Unknown command!\n";
 
-  errs() << "USAGE: " << ProgName << " <merge|show> [args...]\n";
+  errs() << "USAGE: " << ProgName << " <merge|show|order> [args...]\n";
   return 1;
 }
@@ -321,6 +321,36 @@ const void *lto_codegen_compile_optimized(lto_code_gen_t cg, size_t *length) {
   return unwrap(cg)->compileOptimized(length, sLastErrorString);
 }
 
+bool lto_codegen_compile_optimized_to_files(lto_code_gen_t cg,
+                                            unsigned parallelism,
+                                            const char ***names) {
+  maybeParseOptions(cg);
+  if (parallelism == 0) {
+    sLastErrorString = "parallelism must be at least 1";
+    return true;
+  }
+  return !unwrap(cg)->compileOptimizedToFiles(parallelism, names,
+                                              sLastErrorString);
+}
+
+void lto_codegen_set_cache_dir(lto_code_gen_t cg, const char *cache_dir) {
+  unwrap(cg)->setCacheDir(cache_dir ? cache_dir : "");
+}
+
+void lto_codegen_set_cache_pruning_interval(lto_code_gen_t cg, int interval) {
+  unwrap(cg)->setCachePruningInterval(interval);
+}
+
+void lto_codegen_set_cache_entry_expiration(lto_code_gen_t cg,
+                                            unsigned expiration) {
+  unwrap(cg)->setCacheEntryExpiration(expiration);
+}
+
+void lto_codegen_set_cache_size_bytes(lto_code_gen_t cg,
+                                      unsigned long long max_size_bytes) {
+  unwrap(cg)->setCacheMaxSize(max_size_bytes);
+}
+
 bool lto_codegen_compile_to_file(lto_code_gen_t cg, const char **name) {
   maybeParseOptions(cg);
   return !unwrap(cg)->compile_to_file(
@@ -26,6 +26,7 @@
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DebugInfo.h"
+#include "llvm/IR/IRMemoryUsage.h"
 #include "llvm/IR/IRPrintingPasses.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassNameParser.h"
@@ -175,6 +176,16 @@ static cl::opt<bool>
 PrintBreakpoints("print-breakpoints-for-testing",
                  cl::desc("Print select breakpoints location for testing"));
 
+static cl::opt<bool>
+DiscardValueNames("discard-value-names",
+                  cl::desc("Discard the names of the values other than "
+                           "GlobalValues"));
+
+static cl::opt<bool>
+PrintIRMemoryUsage("ir-memory-usage",
+                   cl::desc("Print the memory used by the IR of the module "
+                            "after running the passes"));
+
 static cl::opt<std::string>
 DefaultDataLayout("default-data-layout",
           cl::desc("data layout string to use if not specified by module"),
@@ -182,6 +193,27 @@ DefaultDataLayout("default-data-layout",
 
 
 
+/// Drop the names of the values of \p M other than GlobalValues.
+static void discardValueNames(Module &M) {
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    for (Argument &A : F.args())
+      A.setName("");
+    for (BasicBlock &BB : F) {
+      BB.setName("");
+      for (Instruction &I : BB)
+        I.setName("");
+    }
+  }
+}
+
+static void printIRMemoryUsage(const Module &M) {
+  IRMemoryUsage Usage;
+  Usage.addModule(M);
+  Usage.print(errs());
+}
+
 static inline void addPass(legacy::PassManagerBase &PM, Pass *P) {
   // Add the pass to the pass manager...
   PM.add(P);
@@ -366,6 +398,13 @@ int main(int argc, char **argv) {
   if (StripDebug)
     StripDebugInfo(*M);
 
+  // The assembly parser needs the names to resolve references, so they are
+  // only dropped once the module is read.
+  if (DiscardValueNames) {
+    Context.setDiscardValueNames(true);
+    discardValueNames(*M);
+  }
+
   // Immediately run the verifier to catch any problems before starting up the
   // pass pipelines.  Otherwise we can crash on broken code during
   // doInitialization().
@@ -425,10 +464,11 @@ int main(int argc, char **argv) {
     // The user has asked to use the new pass manager and provided a pipeline
     // string. Hand off the rest of the functionality to the new code for that
     // layer.
-    return runPassPipeline(argv[0], Context, *M, TM.get(), Out.get(),
-                           PassPipeline, OK, VK)
-               ? 0
-               : 1;
+    bool Success = runPassPipeline(argv[0], Context, *M, TM.get(), Out.get(),
+                                   PassPipeline, OK, VK);
+    if (PrintIRMemoryUsage)
+      printIRMemoryUsage(*M);
+    return Success ? 0 : 1;
   }
 
   // Create a PassManager to hold and optimize the collection of passes we are
@@ -598,6 +638,9 @@ int main(int argc, char **argv) {
   // Now that we have all of the passes ready, run them.
   Passes.run(*M);
 
+  if (PrintIRMemoryUsage)
+    printIRMemoryUsage(*M);
+
   // Declare success.
   if (!NoOutput || PrintBreakpoints)
     Out->keep();
@@ -0,0 +1,204 @@
+//===- MemorySSATest.cpp - Memory SSA unit tests --------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/Analysis/Passes.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/ValueSymbolTable.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+#include <functional>
+
+using namespace llvm;
+
+namespace {
+
+/// MemorySSATestPass - Hands the memory SSA of each function to a callback.
+struct MemorySSATestPass : public FunctionPass {
+  static char ID;
+  std::function<void(Function &, MemorySSA &)> Check;
+
+  explicit MemorySSATestPass(std::function<void(Function &, MemorySSA &)> Check)
+      : FunctionPass(ID), Check(Check) {}
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<MemorySSAWrapperPass>();
+    AU.setPreservesAll();
+  }
+
+  bool runOnFunction(Function &F) override {
+    Check(F, getAnalysis<MemorySSAWrapperPass>().getMSSA());
+    return false;
+  }
+};
+char MemorySSATestPass::ID = 0;
+
+class MemorySSATest : public testing::Test {
+protected:
+  void run(const char *Assembly,
+           std::function<void(Function &, MemorySSA &)> Check) {
+    PassRegistry &Registry = *PassRegistry::getPassRegistry();
+    initializeCore(Registry);
+    initializeAnalysis(Registry);
+
+    SMDiagnostic Err;
+    M = parseAssemblyString(Assembly, Err, C);
+    ASSERT_TRUE(M != nullptr) << Err.getMessage().str();
+
+    bool Ran = false;
+    legacy::PassManager PM;
+    PM.add(createBasicAliasAnalysisPass());
+    PM.add(new MemorySSATestPass([&](Function &F, MemorySSA &MSSA) {
+      Ran = true;
+      Check(F, MSSA);
+    }));
+    PM.run(*M);
+    EXPECT_TRUE(Ran);
+  }
+
+  static Instruction *getInst(Function &F, StringRef Name) {
+    return cast<Instruction>(F.getValueSymbolTable().lookup(Name));
+  }
+
+  LLVMContext C;
+  std::unique_ptr<Module> M;
+};
+
+TEST_F(MemorySSATest, WalkerSkipsNoAliasWrites) {
+  run("define i32 @f(i32* noalias %p, i32* noalias %q, i1 %c) {\n"
+      "entry:\n"
+      "  store i32 0, i32* %p\n"
+      "  store i32 1, i32* %q\n"
+      "  br i1 %c, label %left, label %right\n"
+      "left:\n"
+      "  store i32 2, i32* %q\n"
+      "  br label %merge\n"
+      "right:\n"
+      "  store i32 3, i32* %q\n"
+      "  br label %merge\n"
+      "merge:\n"
+      "  %v = load i32, i32* %p\n"
+      "  %w = load i32, i32* %q\n"
+      "  %r = add i32 %v, %w\n"
+      "  ret i32 %r\n"
+      "}\n",
+      [](Function &F, MemorySSA &MSSA) {
+        MSSA.verifyMemorySSA();
+        BasicBlock &Entry = F.getEntryBlock();
+        Instruction *StoreP = &Entry.front();
+        Instruction *V = getInst(F, "v");
+        Instruction *W = getInst(F, "w");
+        MemorySSAWalker *Walker = MSSA.getWalker();
+
+        // The load of %v is linked to the MemoryPhi, but it is clobbered by
+        // the store to %p only.
+        EXPECT_TRUE(isa<MemoryPhi>(MSSA.getMemoryAccess(V)->getDefiningAccess()));
+        EXPECT_EQ(MSSA.getMemoryAccess(StoreP),
+                  Walker->getClobberingMemoryAccess(V));
+        // The paths disagree about %q.
+        EXPECT_EQ(MSSA.getMemoryAccess(W->getParent()),
+                  Walker->getClobberingMemoryAccess(W));
+        // Asking again gives the same answers.
+        EXPECT_EQ(MSSA.getMemoryAccess(StoreP),
+                  Walker->getClobberingMemoryAccess(V));
+      });
+}
+
+TEST_F(MemorySSATest, WalkerGoesAroundLoops) {
+  run("define void @f(i32* noalias %p, i32* noalias %q, i32 %n) {\n"
+      "entry:\n"
+      "  store i32 0, i32* %p\n"
+      "  br label %header\n"
+      "header:\n"
+      "  %i = phi i32 [ 0, %entry ], [ %i.next, %body ]\n"
+      "  %cmp = icmp slt i32 %i, %n\n"
+      "  br i1 %cmp, label %body, label %exit\n"
+      "body:\n"
+      "  %v = load i32, i32* %p\n"
+      "  store i32 %v, i32* %q\n"
+      "  %i.next = add i32 %i, 1\n"
+      "  br label %header\n"
+      "exit:\n"
+      "  %w = load i32, i32* %q\n"
+      "  ret void\n"
+      "}\n",
+      [](Function &F, MemorySSA &MSSA) {
+        MSSA.verifyMemorySSA();
+        Instruction *StoreP = &F.getEntryBlock().front();
+        MemorySSAWalker *Walker = MSSA.getWalker();
+
+        // Nothing in the loop writes %p.
+        EXPECT_EQ(MSSA.getMemoryAccess(StoreP),
+                  Walker->getClobberingMemoryAccess(getInst(F, "v")));
+        // The loop writes %q, so the header MemoryPhi is the answer.
+        MemoryPhi *Phi = MSSA.getMemoryAccess(getInst(F, "i")->getParent());
+        ASSERT_TRUE(Phi != nullptr);
+        EXPECT_EQ(Phi, Walker->getClobberingMemoryAccess(getInst(F, "w")));
+      });
+}
+
+TEST_F(MemorySSATest, RemoveAndCreateAccesses) {
+  run("define i32 @f(i32* noalias %p, i32* noalias %q) {\n"
+      "entry:\n"
+      "  store i32 0, i32* %p\n"
+      "  store i32 1, i32* %q\n"
+      "  %v = load i32, i32* %p\n"
+      "  ret i32 %v\n"
+      "}\n",
+      [](Function &F, MemorySSA &MSSA) {
+        BasicBlock &Entry = F.getEntryBlock();
+        BasicBlock::iterator It = Entry.begin();
+        Instruction *StoreP = It++;
+        Instruction *StoreQ = It++;
+        Instruction *V = It;
+        MemorySSAWalker *Walker = MSSA.getWalker();
+        MemoryUseOrDef *LoadAccess = MSSA.getMemoryAccess(V);
+
+        EXPECT_EQ(MSSA.getMemoryAccess(StoreQ), LoadAccess->getDefiningAccess());
+        EXPECT_EQ(MSSA.getMemoryAccess(StoreP),
+                  Walker->getClobberingMemoryAccess(V));
+
+        // Removing the store to %q links the load to the store to %p.
+        MSSA.removeMemoryAccess(MSSA.getMemoryAccess(StoreQ));
+        StoreQ->eraseFromParent();
+        MSSA.verifyMemorySSA();
+        EXPECT_EQ(MSSA.getMemoryAccess(StoreP), LoadAccess->getDefiningAccess());
+
+        // Removing the store to %p leaves the load clobbered by nothing; the
+        // cached answer must be gone.
+        MSSA.removeMemoryAccess(MSSA.getMemoryAccess(StoreP));
+        StoreP->eraseFromParent();
+        MSSA.verifyMemorySSA();
+        EXPECT_TRUE(MSSA.isLiveOnEntryDef(LoadAccess->getDefiningAccess()));
+        EXPECT_TRUE(
+            MSSA.isLiveOnEntryDef(Walker->getClobberingMemoryAccess(V)));
+
+        // A new store to %p before the load clobbers it.
+        StoreInst *NewStore = new StoreInst(
+            ConstantInt::get(Type::getInt32Ty(F.getContext()), 2),
+            F.arg_begin(), V);
+        MemoryUseOrDef *NewDef = MSSA.createMemoryAccessBefore(
+            NewStore, MSSA.getLiveOnEntryDef(), LoadAccess);
+        LoadAccess->setDefiningAccess(NewDef);
+        MSSA.verifyMemorySSA();
+        EXPECT_TRUE(isa<MemoryDef>(NewDef));
+        EXPECT_TRUE(MSSA.locallyDominates(NewDef, LoadAccess));
+        EXPECT_FALSE(MSSA.locallyDominates(LoadAccess, NewDef));
+        EXPECT_EQ(NewDef, Walker->getClobberingMemoryAccess(V));
+      });
+}
+
+} // end anonymous namespace
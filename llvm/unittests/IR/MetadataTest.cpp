@@ -2113,6 +2113,45 @@ TEST_F(TrackingMDRefTest, UpdatesOnDeletion) {
   EXPECT_TRUE(!MD);
 }
 
+typedef MetadataTest InstructionAttachmentsTest;
+
+TEST_F(InstructionAttachmentsTest, AddRemoveAndTrack) {
+  std::unique_ptr<Instruction> I(new UnreachableInst(Context));
+  auto Temp = MDTuple::getTemporary(Context, None);
+  MDNode *N = getNode();
+
+  // Enough attachments to grow the list a few times.
+  I->setMetadata("a", Temp.get());
+  I->setMetadata("b", N);
+  I->setMetadata("c", N);
+  I->setMetadata("d", N);
+  I->setMetadata("e", N);
+  EXPECT_EQ(Temp.get(), I->getMetadata("a"));
+  EXPECT_EQ(N, I->getMetadata("e"));
+
+  // The attachments are still tracked after they moved.
+  MDNode *Distinct = getTuple();
+  Temp->replaceAllUsesWith(Distinct);
+  EXPECT_EQ(Distinct, I->getMetadata("a"));
+
+  I->setMetadata("b", nullptr);
+  I->setMetadata("d", nullptr);
+  SmallVector<std::pair<unsigned, MDNode *>, 4> MDs;
+  I->getAllMetadata(MDs);
+  ASSERT_EQ(3u, MDs.size());
+  EXPECT_EQ(Distinct, MDs[0].second);
+  EXPECT_EQ(Context.getMDKindID("c"), MDs[1].first);
+  EXPECT_EQ(Context.getMDKindID("e"), MDs[2].first);
+
+  I->dropUnknownMetadata(Context.getMDKindID("e"));
+  I->getAllMetadata(MDs);
+  ASSERT_EQ(1u, MDs.size());
+  EXPECT_EQ(N, MDs[0].second);
+
+  I->setMetadata("e", nullptr);
+  EXPECT_FALSE(I->hasMetadata());
+}
+
 TEST(NamedMDNodeTest, Search) {
   LLVMContext Context;
   ConstantAsMetadata *C =
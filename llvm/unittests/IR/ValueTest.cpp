@@ -43,6 +43,39 @@ TEST(ValueTest, UsedInBasicBlock) {
   EXPECT_TRUE(F->arg_begin()->isUsedInBasicBlock(F->begin()));
 }
 
+TEST(ValueTest, DiscardValueNames) {
+  LLVMContext C;
+
+  const char *ModuleString = "define i32 @f(i32 %x) {\n"
+                             "entry:\n"
+                             "  %y = add i32 %x, 1\n"
+                             "  ret i32 %y\n"
+                             "}\n";
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M = parseAssemblyString(ModuleString, Err, C);
+  C.setDiscardValueNames(true);
+
+  // Names set before are kept, and can still be changed or cleared.
+  Function *F = M->getFunction("f");
+  Instruction *Add = F->front().begin();
+  EXPECT_EQ("y", Add->getName());
+  Add->setName("z");
+  EXPECT_EQ("z", Add->getName());
+  Add->setName("");
+  EXPECT_FALSE(Add->hasName());
+
+  // New local values aren't named.
+  Add->setName("y");
+  EXPECT_FALSE(Add->hasName());
+  BasicBlock *BB = BasicBlock::Create(C, "bb", F);
+  EXPECT_FALSE(BB->hasName());
+
+  // Global values always are.
+  Function *G = Function::Create(F->getFunctionType(),
+                                 GlobalValue::ExternalLinkage, "g", M.get());
+  EXPECT_EQ("g", G->getName());
+}
+
 TEST(GlobalTest, CreateAddressSpace) {
   LLVMContext &Ctx = getGlobalContext();
   std::unique_ptr<Module> M(new Module("TestModule", Ctx));
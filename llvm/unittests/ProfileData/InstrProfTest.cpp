@@ -7,6 +7,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
 #include "llvm/ProfileData/InstrProfReader.h"
 #include "llvm/ProfileData/InstrProfWriter.h"
 #include "gtest/gtest.h"
@@ -95,4 +99,96 @@ TEST_F(InstrProfTest, get_max_function_count) {
   ASSERT_EQ(1ULL << 63, Reader->getMaximumFunctionCount());
 }
 
+static InstrProfRecord makeRecordWithValues(
+    StringRef Name, ArrayRef<std::vector<InstrProfValueData>> Sites) {
+  static const uint64_t Counts[] = {1, 2};
+  InstrProfRecord Record(Name, 0x1234, Counts);
+  for (const std::vector<InstrProfValueData> &Values : Sites) {
+    InstrProfValueSiteRecord Site;
+    Site.ValueData = Values;
+    Record.ValueSites[IPVK_IndirectCallTarget].push_back(Site);
+  }
+  return Record;
+}
+
+TEST_F(InstrProfTest, get_function_record_with_values) {
+  ASSERT_TRUE(NoError(Writer.addRecord(makeRecordWithValues(
+      "foo", {{{0x10, 5}, {0x20, 7}}, {}, {{0x30, 1}}}))));
+  Writer.addFunctionCounts("bar", 0x1234, {1, 2});
+  auto Profile = Writer.writeBuffer();
+  readProfile(std::move(Profile));
+
+  InstrProfRecord Record;
+  ASSERT_TRUE(NoError(Reader->getFunctionRecord("foo", 0x1234, Record)));
+  ASSERT_EQ(2U, Record.Counts.size());
+  ASSERT_EQ(3U, Record.getNumValueSites(IPVK_IndirectCallTarget));
+  ASSERT_EQ(0U, Record.getNumValueSites(IPVK_MemOPSize));
+  const auto &Sites = Record.ValueSites[IPVK_IndirectCallTarget];
+  ASSERT_EQ(2U, Sites[0].ValueData.size());
+  ASSERT_EQ(0x10U, Sites[0].ValueData[0].Value);
+  ASSERT_EQ(5U, Sites[0].ValueData[0].Count);
+  ASSERT_EQ(0x20U, Sites[0].ValueData[1].Value);
+  ASSERT_EQ(7U, Sites[0].ValueData[1].Count);
+  ASSERT_TRUE(Sites[1].ValueData.empty());
+  ASSERT_EQ(1U, Sites[2].ValueData.size());
+  ASSERT_EQ(0x30U, Sites[2].ValueData[0].Value);
+
+  ASSERT_TRUE(NoError(Reader->getFunctionRecord("bar", 0x1234, Record)));
+  ASSERT_FALSE(Record.hasValueSites());
+}
+
+TEST_F(InstrProfTest, merge_values) {
+  ASSERT_TRUE(NoError(Writer.addRecord(
+      makeRecordWithValues("foo", {{{0x10, 5}, {0x20, 7}}}))));
+  ASSERT_TRUE(NoError(Writer.addRecord(
+      makeRecordWithValues("foo", {{{0x20, 1}, {0x30, 2}}}))));
+  ASSERT_TRUE(ErrorEquals(instrprof_error::value_site_count_mismatch,
+                          Writer.addRecord(makeRecordWithValues(
+                              "foo", {{{0x10, 1}}, {{0x10, 1}}}))));
+  auto Profile = Writer.writeBuffer();
+  readProfile(std::move(Profile));
+
+  InstrProfRecord Record;
+  ASSERT_TRUE(NoError(Reader->getFunctionRecord("foo", 0x1234, Record)));
+  ASSERT_EQ(2U, Record.Counts[0]);
+  ASSERT_EQ(1U, Record.getNumValueSites(IPVK_IndirectCallTarget));
+  InstrProfValueSiteRecord Site = Record.ValueSites[IPVK_IndirectCallTarget][0];
+  Site.sortByCount();
+  ASSERT_EQ(3U, Site.ValueData.size());
+  ASSERT_EQ(0x20U, Site.ValueData[0].Value);
+  ASSERT_EQ(8U, Site.ValueData[0].Count);
+  ASSERT_EQ(0x10U, Site.ValueData[1].Value);
+  ASSERT_EQ(5U, Site.ValueData[1].Count);
+  ASSERT_EQ(0x30U, Site.ValueData[2].Value);
+  ASSERT_EQ(2U, Site.ValueData[2].Count);
+  ASSERT_EQ(15U, Site.getTotalCount());
+}
+
+TEST(InstrProfValueSiteTest, annotate_and_read) {
+  LLVMContext Ctx;
+  Module M("m", Ctx);
+  auto *FTy = FunctionType::get(Type::getVoidTy(Ctx), false);
+  Function *F = Function::Create(FTy, Function::ExternalLinkage, "f", &M);
+  IRBuilder<> Builder(BasicBlock::Create(Ctx, "", F));
+  Instruction *Ret = Builder.CreateRetVoid();
+
+  InstrProfValueSiteRecord Site;
+  Site.ValueData = {{1, 10}, {2, 30}, {3, 20}, {4, 5}};
+  annotateValueSite(*Ret, Site, IPVK_IndirectCallTarget);
+
+  SmallVector<InstrProfValueData, 4> Values;
+  uint64_t TotalCount;
+  ASSERT_FALSE(getValueProfDataFromInst(*Ret, IPVK_MemOPSize, Values,
+                                        TotalCount));
+  ASSERT_TRUE(getValueProfDataFromInst(*Ret, IPVK_IndirectCallTarget, Values,
+                                       TotalCount));
+  // Only the three hottest values are kept, but the total counts them all.
+  ASSERT_EQ(65U, TotalCount);
+  ASSERT_EQ(3U, Values.size());
+  ASSERT_EQ(2U, Values[0].Value);
+  ASSERT_EQ(30U, Values[0].Count);
+  ASSERT_EQ(3U, Values[1].Value);
+  ASSERT_EQ(1U, Values[2].Value);
+}
+
 } // end anonymous namespace
@@ -0,0 +1,91 @@
+//===- llvm/unittest/Support/ParallelTest.cpp - Parallel algorithm tests --===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/Parallel.h"
+#include "gtest/gtest.h"
+#include <array>
+#include <random>
+
+using namespace llvm;
+
+namespace {
+
+TEST(ParallelTest, sort) {
+  std::mt19937 randEngine;
+  std::uniform_int_distribution<uint32_t> dist;
+
+  std::vector<uint32_t> array(100000);
+  for (auto &v : array)
+    v = dist(randEngine);
+
+  std::vector<uint32_t> expected = array;
+  std::sort(expected.begin(), expected.end());
+  parallel_sort(array.begin(), array.end());
+  ASSERT_EQ(expected, array);
+
+  parallel_sort(array.begin(), array.end(), std::greater<uint32_t>());
+  ASSERT_TRUE(std::is_sorted(array.begin(), array.end(),
+                             std::greater<uint32_t>()));
+}
+
+TEST(ParallelTest, parallel_for_each) {
+  std::vector<std::atomic_int> visited(10000);
+  for (auto &v : visited)
+    v = 0;
+
+  parallel_for_each(visited.begin(), visited.end(),
+                    [](std::atomic_int &v) { ++v; });
+  for (auto &v : visited)
+    ASSERT_EQ(1, v);
+
+  parallel_for_each_n(size_t(0), visited.size(),
+                      [&](size_t i) { visited[i] += int(i); });
+  for (size_t i = 0; i != visited.size(); ++i)
+    ASSERT_EQ(int(i) + 1, visited[i]);
+}
+
+TEST(ParallelTest, parallel_for_each_empty) {
+  std::vector<int> empty;
+  parallel_for_each(empty.begin(), empty.end(), [](int) { FAIL(); });
+  parallel_for_each_n(0, 0, [](int) { FAIL(); });
+}
+
+TEST(ParallelTest, parallel_transform_reduce) {
+  // Sum the lengths of these strings in parallel.
+  const char *strs[] = {"a", "ab", "abc", "abcd", "abcde", "abcdef"};
+  size_t lenSum =
+      parallel_transform_reduce(std::begin(strs), std::end(strs), size_t(0),
+                                std::plus<size_t>(),
+                                [](const char *s) { return strlen(s); });
+  ASSERT_EQ(21U, lenSum);
+
+  // Check that we handle non-divisible task sizes as above.
+  std::vector<uint32_t> range(10000);
+  for (size_t i = 0; i != range.size(); ++i)
+    range[i] = uint32_t(i);
+  uint64_t sum = parallel_transform_reduce(
+      range.begin(), range.end(), uint64_t(0), std::plus<uint64_t>(),
+      [](uint32_t v) { return uint64_t(v); });
+  ASSERT_EQ(uint64_t(10000) * 9999 / 2, sum);
+
+  // The chunks are reduced in order, so non-commutative reductions work.
+  std::vector<std::string> words = {"the", " ", "quick", " ", "fox"};
+  std::string sentence = parallel_transform_reduce(
+      words.begin(), words.end(), std::string(),
+      [](const std::string &a, const std::string &b) { return a + b; },
+      [](const std::string &w) { return w; });
+  ASSERT_EQ("the quick fox", sentence);
+
+  std::vector<int> empty;
+  ASSERT_EQ(7, parallel_transform_reduce(empty.begin(), empty.end(), 7,
+                                         std::plus<int>(),
+                                         [](int v) { return v; }));
+}
+
+}
@@ -0,0 +1,101 @@
+//===- SplitModuleTest.cpp - Unit tests for SplitModule -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+const char *ModuleString =
+    "$cd = comdat any\n"
+    "@g = internal global i32 0\n"
+    "@c1 = linkonce_odr global i32 1, comdat($cd)\n"
+    "@c2 = linkonce_odr global i32 2, comdat($cd)\n"
+    "@a = alias i32* @c1\n"
+    "@jt = global i8* blockaddress(@ba, %bb)\n"
+    "define internal i32 @local() {\n"
+    "  %v = load i32, i32* @g\n"
+    "  ret i32 %v\n"
+    "}\n"
+    "define i32 @f0() {\n"
+    "  %v = call i32 @local()\n"
+    "  ret i32 %v\n"
+    "}\n"
+    "define i32 @f1() { ret i32 1 }\n"
+    "define i32 @f2() { ret i32 2 }\n"
+    "define i32 @f3() { ret i32 3 }\n"
+    "define void @ba() {\n"
+    "  br label %bb\n"
+    "bb:\n"
+    "  ret void\n"
+    "}\n"
+    "define i8* @bauser() {\n"
+    "  ret i8* blockaddress(@ba, %bb)\n"
+    "}\n";
+
+const char *const DefinedNames[] = {"g",  "c1", "c2", "a",  "jt",    "local",
+                                    "f0", "f1", "f2", "f3", "ba", "bauser"};
+
+// Splits ModuleString N ways, recording in which partition each global value
+// is defined.
+std::vector<std::map<std::string, bool>> split(unsigned N) {
+  LLVMContext C;
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M = parseAssemblyString(ModuleString, Err, C);
+  EXPECT_TRUE(M != nullptr);
+
+  std::vector<std::map<std::string, bool>> Defined;
+  SplitModule(*M, N, [&](std::unique_ptr<Module> MPart) {
+    EXPECT_FALSE(verifyModule(*MPart));
+    Defined.emplace_back();
+    for (const char *Name : DefinedNames) {
+      GlobalValue *GV = MPart->getNamedValue(Name);
+      EXPECT_TRUE(GV != nullptr);
+      EXPECT_FALSE(GV->hasLocalLinkage());
+      Defined.back()[Name] = !GV->isDeclaration();
+    }
+  });
+  return Defined;
+}
+
+TEST(SplitModuleTest, EveryDefinitionInOnePartition) {
+  std::vector<std::map<std::string, bool>> Defined = split(4);
+  ASSERT_EQ(4u, Defined.size());
+  for (const char *Name : DefinedNames) {
+    unsigned NumDefs = 0;
+    for (auto &Part : Defined)
+      NumDefs += Part[Name];
+    EXPECT_EQ(1u, NumDefs) << Name;
+  }
+}
+
+TEST(SplitModuleTest, KeepsClustersTogether) {
+  for (unsigned N = 2; N != 9; ++N) {
+    for (auto &Part : split(N)) {
+      EXPECT_EQ(Part["c1"], Part["c2"]);
+      EXPECT_EQ(Part["c1"], Part["a"]);
+      EXPECT_EQ(Part["ba"], Part["bauser"]);
+      EXPECT_EQ(Part["ba"], Part["jt"]);
+    }
+  }
+}
+
+TEST(SplitModuleTest, Deterministic) {
+  for (unsigned N = 1; N != 9; ++N)
+    EXPECT_EQ(split(N), split(N));
+}
+
+}
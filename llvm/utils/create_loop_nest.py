@@ -0,0 +1,95 @@
+#!/usr/bin/env python
+
+"""Generate a deep loop nest to measure the time spent in ScalarEvolution.
+
+The nest looks like the state machines some code generators produce: every
+loop is guarded by, and exits on, a conjunction of comparisons against the
+induction variables of all the loops around it. Computing the trip count of
+an inner loop makes ScalarEvolution look at every condition that dominates it,
+and the passes that use trip counts ask for them again whenever they change
+a loop.
+
+Pipe the output to opt to measure how compile time grows with the size of the
+nest, e.g.
+
+  create_loop_nest.py --depth 16 --conditions 8 | \\
+      opt -indvars -loop-reduce -time-passes -disable-output
+
+and compare against -scalar-evolution-max-backedge-taken-cost to see what the
+budget buys.
+"""
+
+import argparse
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__,
+      formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('--depth', type=int, default=8,
+                      help='Number of loops in the nest')
+  parser.add_argument('--conditions', type=int, default=4,
+                      help='Number of comparisons in each guard and exit')
+  args = parser.parse_args()
+
+  depth = args.depth
+  conds = args.conditions
+  lines = []
+  emit = lines.append
+
+  emit('@sink = global i32 0')
+  emit('')
+  emit('define void @nest(i32 %n) {')
+  emit('entry:')
+  emit('  br label %L0.guard')
+
+  def conjunction(prefix, values):
+    # Compare each value against %n, or against a value of an enclosing loop,
+    # and fold the comparisons with 'and'.
+    result = None
+    for k in range(conds):
+      lhs = values[k % len(values)]
+      rhs = values[(k + 1) % len(values)] if k % 2 else '%n'
+      if rhs == lhs:
+        rhs = '%n'
+      emit('  %%%s.c%d = icmp slt i32 %s, %s' % (prefix, k, lhs, rhs))
+      cur = '%%%s.c%d' % (prefix, k)
+      if result:
+        emit('  %%%s.a%d = and i1 %s, %s' % (prefix, k, result, cur))
+        cur = '%%%s.a%d' % (prefix, k)
+      result = cur
+    return result
+
+  for d in range(depth):
+    outer = ['%%i%d' % j for j in range(d)]
+    emit('')
+    emit('L%d.guard:' % d)
+    guard = conjunction('L%d.g' % d, outer + ['0'])
+    emit('  br i1 %s, label %%L%d.header, label %%L%d.done' % (guard, d, d))
+    emit('')
+    emit('L%d.header:' % d)
+    emit('  %%i%d = phi i32 [ 0, %%L%d.guard ], [ %%i%d.next, %%L%d.latch ]' %
+         (d, d, d, d))
+    if d + 1 < depth:
+      emit('  br label %%L%d.guard' % (d + 1))
+    else:
+      emit('  store volatile i32 %%i%d, i32* @sink' % d)
+      emit('  br label %%L%d.latch' % d)
+
+  for d in reversed(range(depth)):
+    emit('')
+    emit('L%d.latch:' % d)
+    emit('  %%i%d.next = add nsw i32 %%i%d, 1' % (d, d))
+    values = ['%%i%d.next' % d] + ['%%i%d' % j for j in range(d)]
+    latch = conjunction('L%d.l' % d, values)
+    emit('  br i1 %s, label %%L%d.header, label %%L%d.done' % (latch, d, d))
+    emit('')
+    emit('L%d.done:' % d)
+    if d:
+      emit('  br label %%L%d.latch' % (d - 1))
+    else:
+      emit('  ret void')
+
+  emit('}')
+  print('\n'.join(lines))
+
+if __name__ == '__main__':
+  main()